@@ -13,6 +13,10 @@ extern "C" {
 #include <string.h>
 #include <stdint.h>
 
+#include "slog_sink.h"
+#include "slog_site.h"
+#include "slog_stats.h"
+
 /* -------------------------------------------------------------------------- */
 /* -------------- PUBLIC MACROS --------------------------------------------- */
 
@@ -22,6 +26,18 @@ extern "C" {
 /* Log storage file name */
 #define SLOG_FILE_NAME              "slog.log"
 
+/* Binary log storage file name, decoded by slog-decode */
+#define SLOG_FILE_BIN_NAME          "slog.bin"
+
+/* Text file a fatal signal writes the pending logs to when the log file is binary */
+#define SLOG_CRASH_FILE_NAME        "slog.crash.log"
+
+/* File the logs the main ring had no room for wait in, suffixed with the pid */
+#define SLOG_SPILL_FILE_NAME        "slog.spill"
+
+/* File the output thread appends a stats line to every STATS_INTERVAL seconds */
+#define SLOG_STATS_FILE_NAME        "slog.stats"
+
 /* Filename without path */
 #define __FILENAME__                (strrchr(__FILE__, '/') ? (strrchr(__FILE__, '/') + 1) : (__FILE__))
 
@@ -33,6 +49,9 @@ extern "C" {
 #define DEBUG                       4
 #define VERBOSE                     5
 
+/* slog_scope_begin() flags, an ERROR or ASSERT log commits the scope */
+#define SLOG_SCOPE_COMMIT_ON_ERROR  0x1
+
 
 /* -------------------------------------------------------------------------- */
 /* -------------- PUBLIC FUNCTIONS PROTOTYPES ------------------------------- */
@@ -47,6 +66,34 @@ int log_init(void);
  */
 void log_fini(void);
 
+/**
+ * wait until the logs put before the call reached every sink
+ *
+ * @return 0 written, -1 not within timeout_ms
+ */
+int slog_flush(unsigned int timeout_ms);
+
+/**
+ * copy the logging pipeline's counters, from any thread
+ *
+ * @return 0 copied, -1 log not initialized
+ */
+int slog_get_stats(slog_stats_t *stats);
+
+/**
+ * dump the flight recorder's history to the log file
+ */
+void slog_flight_dump(void);
+
+/**
+ * per-thread log scope, its DEBUG and VERBOSE logs are output on commit only
+ */
+int slog_scope_begin(unsigned int flags);
+
+void slog_scope_commit(void);
+
+void slog_scope_discard(void);
+
 #define slog_assert(tag, fmt, ...)   do \
 {\
         slog(ASSERT, (const char *)tag, sizeof(tag) - 1, __FILENAME__, strlen(__FILENAME__), \
@@ -83,10 +130,92 @@ void log_fini(void);
         __func__, sizeof(__func__) - 1, __LINE__, (const char*)fmt, ##__VA_ARGS__); \
 }while(0)
 
+/*
+ * per call site rate limiting and sampling, the site keeps its own state. A
+ * skipped call is not formatted, the next line output from the site tells
+ * how many were skipped before it.
+ */
+
+/* at most burst logs back to back, refilled at burst per interval_ms */
+#define slog_ratelimited(level, tag, burst, interval_ms, fmt, ...)   do \
+{\
+        static slog_site_t _slog_site; \
+        if (slog_site_ratelimit(&_slog_site, burst, interval_ms)) { \
+            slog_site_log(&_slog_site, level, (const char *)tag, sizeof(tag) - 1, __FILENAME__, strlen(__FILENAME__), \
+            __func__, sizeof(__func__) - 1, __LINE__, (const char*)fmt, ##__VA_ARGS__); \
+        } \
+}while(0)
+
+/* the 1st log and every n-th after it */
+#define slog_every_n(level, tag, n, fmt, ...)   do \
+{\
+        static slog_site_t _slog_site; \
+        if (slog_site_every_n(&_slog_site, n)) { \
+            slog_site_log(&_slog_site, level, (const char *)tag, sizeof(tag) - 1, __FILENAME__, strlen(__FILENAME__), \
+            __func__, sizeof(__func__) - 1, __LINE__, (const char*)fmt, ##__VA_ARGS__); \
+        } \
+}while(0)
+
+/* the first n logs only */
+#define slog_first_n(level, tag, n, fmt, ...)   do \
+{\
+        static slog_site_t _slog_site; \
+        if (slog_site_first_n(&_slog_site, n)) { \
+            slog_site_log(&_slog_site, level, (const char *)tag, sizeof(tag) - 1, __FILENAME__, strlen(__FILENAME__), \
+            __func__, sizeof(__func__) - 1, __LINE__, (const char*)fmt, ##__VA_ARGS__); \
+        } \
+}while(0)
+
+/* a log with probability p, 0.0 to 1.0 */
+#define slog_sample(level, tag, p, fmt, ...)   do \
+{\
+        static slog_site_t _slog_site; \
+        if (slog_site_sample(&_slog_site, p)) { \
+            slog_site_log(&_slog_site, level, (const char *)tag, sizeof(tag) - 1, __FILENAME__, strlen(__FILENAME__), \
+            __func__, sizeof(__func__) - 1, __LINE__, (const char*)fmt, ##__VA_ARGS__); \
+        } \
+}while(0)
+
+#define slog_error_ratelimited(tag, burst, interval_ms, fmt, ...)   slog_ratelimited(ERROR, tag, burst, interval_ms, fmt, ##__VA_ARGS__)
+#define slog_warn_ratelimited(tag, burst, interval_ms, fmt, ...)    slog_ratelimited(WARN, tag, burst, interval_ms, fmt, ##__VA_ARGS__)
+#define slog_info_ratelimited(tag, burst, interval_ms, fmt, ...)    slog_ratelimited(INFO, tag, burst, interval_ms, fmt, ##__VA_ARGS__)
+#define slog_debug_ratelimited(tag, burst, interval_ms, fmt, ...)   slog_ratelimited(DEBUG, tag, burst, interval_ms, fmt, ##__VA_ARGS__)
+
+#define slog_error_every_n(tag, n, fmt, ...)   slog_every_n(ERROR, tag, n, fmt, ##__VA_ARGS__)
+#define slog_warn_every_n(tag, n, fmt, ...)    slog_every_n(WARN, tag, n, fmt, ##__VA_ARGS__)
+#define slog_info_every_n(tag, n, fmt, ...)    slog_every_n(INFO, tag, n, fmt, ##__VA_ARGS__)
+#define slog_debug_every_n(tag, n, fmt, ...)   slog_every_n(DEBUG, tag, n, fmt, ##__VA_ARGS__)
+
+#define slog_error_first_n(tag, n, fmt, ...)   slog_first_n(ERROR, tag, n, fmt, ##__VA_ARGS__)
+#define slog_warn_first_n(tag, n, fmt, ...)    slog_first_n(WARN, tag, n, fmt, ##__VA_ARGS__)
+#define slog_info_first_n(tag, n, fmt, ...)    slog_first_n(INFO, tag, n, fmt, ##__VA_ARGS__)
+#define slog_debug_first_n(tag, n, fmt, ...)   slog_first_n(DEBUG, tag, n, fmt, ##__VA_ARGS__)
+
+#define slog_info_sample(tag, p, fmt, ...)      slog_sample(INFO, tag, p, fmt, ##__VA_ARGS__)
+#define slog_debug_sample(tag, p, fmt, ...)     slog_sample(DEBUG, tag, p, fmt, ##__VA_ARGS__)
+#define slog_verbose_sample(tag, p, fmt, ...)   slog_sample(VERBOSE, tag, p, fmt, ##__VA_ARGS__)
+
+/**
+ * log from a signal handler, async-signal-safe. The format takes %d %i %u
+ * %x %X %p %s %c and %% only, with the 0 flag, a width and l, ll, z, h.
+ */
+#define slog_signal(level, tag, fmt, ...)   do \
+{\
+        slog_signal_safe(level, (const char *)tag, sizeof(tag) - 1, __FILENAME__, strlen(__FILENAME__), \
+        __func__, sizeof(__func__) - 1, __LINE__, (const char*)fmt, ##__VA_ARGS__); \
+}while(0)
+
 
 void slog(uint8_t level, const char *tag, size_t tag_len, const char *file, size_t file_len, \
           const char *func, size_t func_len, long line, const char *format, ...);
 
+/* slog() of a rate limited or sampled site */
+void slog_site_log(slog_site_t *site, uint8_t level, const char *tag, size_t tag_len, const char *file, size_t file_len, \
+                   const char *func, size_t func_len, long line, const char *format, ...);
+
+void slog_signal_safe(uint8_t level, const char *tag, size_t tag_len, const char *file, size_t file_len, \
+                      const char *func, size_t func_len, long line, const char *format, ...);
+
 
 #ifdef __cplusplus
 }
@@ -2,6 +2,11 @@
 #ifndef __SLOG_ASYNC_H
 #define __SLOG_ASYNC_H
 
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <time.h>
+
 
 /* -------------------------------------------------------------------------- */
 /* -------------- PUBLIC MACROS --------------------------------------------- */
@@ -14,6 +19,10 @@
 
 int slog_async_init(void);
 
+int slog_async_flush(const struct timespec *deadline);
+
+void slog_async_deinit(void);
+
 
 #endif  /* __SLOG_ASYNC_H */
 /* ============== EOF ======================================================= */
\ No newline at end of file
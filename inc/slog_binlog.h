@@ -0,0 +1,101 @@
+
+#ifndef __SLOG_BINLOG_H
+#define __SLOG_BINLOG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/uio.h>
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC MACROS --------------------------------------------- */
+
+/*
+ * binary log file, all integers little endian:
+ *
+ * file head  magic "SLOGBIN1" | version u16 | head size u16 | reserved u32
+ * block head magic "SLBK" | payload length u32 | record count u32 | crc32 u32
+ *            | min time i64 | max time i64 | gmtoff i32 | level mask u8
+ *            | reserved u8[3]
+ * record     time delta varint | level u8 | tag len u8 | file len u8
+ *            | func len u8 | line varint | message len varint
+ *            | tag | file | func | message
+ *
+ * times are microseconds since the epoch, a record's time delta is zigzag
+ * encoded from the record before it, the first record's from 0. gmtoff is
+ * the writer's UTC offset in seconds, level mask has bit (1 << level) set
+ * for each level in the block. The crc covers the block head, its crc
+ * field zeroed, and the payload.
+ */
+#define SLOG_BINLOG_MAGIC                    "SLOGBIN1"
+#define SLOG_BINLOG_VERSION                  1
+#define SLOG_BINLOG_FILE_HEAD_SIZE           16
+
+#define SLOG_BINLOG_BLOCK_MAGIC              "SLBK"
+#define SLOG_BINLOG_BLOCK_HEAD_SIZE          40
+
+/* payload bytes of one block at most */
+#define SLOG_BINLOG_BLOCK_MAX                (128 * 1024)
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC TYPES ---------------------------------------------- */
+
+/* parsed block head */
+typedef struct slog_binlog_block_s {
+    uint32_t length;                         /* payload bytes */
+    uint32_t count;                          /* records */
+    int64_t min_time;                        /* us */
+    int64_t max_time;                        /* us */
+    int32_t gmtoff;                          /* s */
+    uint8_t level_mask;
+    const uint8_t *payload;
+} slog_binlog_block_t;
+
+/* decoded record, strings point into the block */
+typedef struct slog_binlog_record_s {
+    int64_t time;                            /* us */
+    uint8_t level;
+    uint32_t line;
+    uint8_t tag_len;
+    uint8_t file_len;
+    uint8_t func_len;
+    uint32_t msg_len;
+    const char *tag;
+    const char *file;
+    const char *func;
+    const char *msg;
+} slog_binlog_record_t;
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC FUNCTIONS PROTOTYPES ------------------------------- */
+
+void slog_binlog_file_head(char *head);
+
+int slog_binlog_file_check(const char *head, size_t len);
+
+size_t slog_binlog_block_encode(char *block, const struct iovec *events, int count, int *done);
+
+int slog_binlog_block_parse(const char *data, size_t len, slog_binlog_block_t *block);
+
+int slog_binlog_record_next(const slog_binlog_block_t *block, size_t *pos, int64_t *time,
+                            slog_binlog_record_t *record);
+
+size_t slog_binlog_record_event(const slog_binlog_record_t *record, char *slog_event_buf);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif  /* __SLOG_BINLOG_H */
+/* ============== EOF ======================================================= */
\ No newline at end of file
@@ -0,0 +1,106 @@
+
+#ifndef __SLOG_BLOOM_H
+#define __SLOG_BLOOM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "slog_index.h"
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC MACROS --------------------------------------------- */
+
+/*
+ * bloom filters of one log file segment, the segment's name + ".bloom", one
+ * record per index entry, all integers little endian:
+ *
+ * head    magic "SLOGBLM1" | version u16 | head size u16 | filter size u32
+ * record  offset u64 | length u32 | flags u8 | reserved u8[3] | filter
+ * trailer magic "SLBLFIN1" | record count u32 | crc32 u32
+ *
+ * a record's filter holds the tag of every log in [offset, offset + length)
+ * and the tokens of their messages: runs of letters, digits, '_' and '-' of
+ * SLOG_BLOOM_TOKEN_MIN bytes or more. Only the first SLOG_BLOOM_SCAN_MAX
+ * bytes and SLOG_BLOOM_TOKEN_MAX tokens of a message are hashed, a record
+ * with a longer message is SLOG_BLOOM_FLAG_PARTIAL and rules out tags only.
+ */
+#define SLOG_BLOOM_MAGIC                     "SLOGBLM1"
+#define SLOG_BLOOM_VERSION                   1
+#define SLOG_BLOOM_HEAD_SIZE                 16
+#define SLOG_BLOOM_RECORD_HEAD_SIZE          16
+
+#define SLOG_BLOOM_TRAILER_MAGIC             "SLBLFIN1"
+#define SLOG_BLOOM_TRAILER_SIZE              16
+
+#define SLOG_BLOOM_SUFFIX                    ".bloom"
+
+#define SLOG_BLOOM_FLAG_PARTIAL              0x01  /* some message tokens were not hashed */
+
+/* bits set per tag or token */
+#define SLOG_BLOOM_HASHES                    3
+
+/* bytes of logs per filter byte, 16 keeps false positives near 1% at 4 new tokens per log */
+#define SLOG_BLOOM_RATIO                     16
+
+/* hashing bounds per log */
+#define SLOG_BLOOM_TOKEN_MIN                 3
+#define SLOG_BLOOM_TOKEN_MAX                 32
+#define SLOG_BLOOM_SCAN_MAX                  512
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC TYPES ---------------------------------------------- */
+
+typedef struct slog_bloom_record_s {
+    uint64_t offset;                         /* segment bytes before the record */
+    uint32_t length;                         /* segment bytes */
+    uint8_t flags;                           /* SLOG_BLOOM_FLAG_xxx */
+    const uint8_t *filter;
+} slog_bloom_record_t;
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC FUNCTIONS PROTOTYPES ------------------------------- */
+
+static inline int slog_bloom_token_char(char c)
+{
+    return ((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z')) || ((c >= '0') && (c <= '9')) ||
+           ('_' == c) || ('-' == c);
+}
+
+void slog_bloom_head(char *head, uint32_t size);
+
+int slog_bloom_check(const char *data, size_t len, size_t *count, int *final);
+
+void slog_bloom_record_encode(char *data, const slog_bloom_record_t *record, size_t size);
+
+void slog_bloom_record_decode(const char *data, slog_bloom_record_t *record);
+
+void slog_bloom_trailer(char *trailer, uint32_t count, uint32_t crc);
+
+int slog_bloom_add_log(uint8_t *filter, size_t size, const char *tag, size_t tag_len,
+                       const char *msg, size_t msg_len);
+
+int slog_bloom_test(const slog_bloom_record_t *record, size_t size, const char *tag, size_t tag_len,
+                    const char *term, size_t term_len);
+
+int slog_bloom_select(const char *data, size_t len, uint64_t file_size, uint64_t file_head,
+                      const char *tag, size_t tag_len, const char *term, size_t term_len,
+                      slog_index_range_cb cb, void *arg);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif  /* __SLOG_BLOOM_H */
+/* ============== EOF ======================================================= */
\ No newline at end of file
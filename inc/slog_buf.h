@@ -2,18 +2,59 @@
 #ifndef __SLOG_BUF_H
 #define __SLOG_BUF_H
 
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "slog_ring.h"
+#include "slog_event.h"
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC MACROS --------------------------------------------- */
+
+/* bytes one event takes in the main ring at most */
+#define SLOG_BUFFER_RECORD_MAXLEN            (SLOG_RING_RECORD_HEAD_SIZE + SLOG_EVENT_BUF_MAXLEN)
+
+/* lanes of the main ring, ERROR and ASSERT logs have their own */
+#define SLOG_BUFFER_LANE_BULK                0
+#define SLOG_BUFFER_LANE_URGENT              1
+#define SLOG_BUFFER_LANES                    2
+
 
 /* -------------------------------------------------------------------------- */
 /* -------------- PUBLIC FUNCTIONS PROTOTYPES ------------------------------- */
 
 int slog_buffer_init(void);
 
-void slog_buffer_put(void *slog_event_buf);
+int slog_buffer_put(void *slog_event_buf);
+
+uint32_t slog_buffer_record_set(void *record, const void *slog_event_buf);
+
+void *slog_buffer_record_event(void *record, uint32_t *size);
+
+int slog_buffer_put_records(const void *records, uint32_t len);
 
 size_t slog_buffer_get(void *slog_event_buf);
 
 bool slog_buffer_is_empty(void);
 
+uint32_t slog_buffer_size(void);
+
+unsigned int slog_buffer_usage(void);
+
+uint32_t slog_buffer_used(void);
+
+unsigned int slog_buffer_in(int lane);
+
+unsigned int slog_buffer_out(int lane);
+
+void slog_buffer_freeze(void);
+
+void slog_buffer_walk(void *slog_event_buf, slog_event_walk_t walk, void *arg);
+
 void slog_buffer_deinit(void);
 
 
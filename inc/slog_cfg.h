@@ -26,6 +26,83 @@ extern "C" {
 #define SLOG_REMOTE_PORT_MAX_LEN             5
 #define SLOG_CPU_CORE_MAX_LEN                3
 
+/* path of the file backing the main ring, empty for a heap ring */
+#define SLOG_BUFFER_FILE_MAX_LEN             112
+
+/* remote datagram size range, bytes */
+#define SLOG_REMOTE_MTU_DEFAULT              1400
+#define SLOG_REMOTE_MTU_MIN                  512
+#define SLOG_REMOTE_MTU_MAX                  65507
+
+/* remote transport */
+#define SLOG_REMOTE_PROTO_UDP                0
+#define SLOG_REMOTE_PROTO_TCP                1
+
+/* remote tcp stream compression */
+#define SLOG_REMOTE_COMPRESS_NONE            0
+#define SLOG_REMOTE_COMPRESS_LZ4             1
+
+/* tcp spool file size range, MB */
+#define SLOG_REMOTE_SPOOL_DEFAULT            64
+#define SLOG_REMOTE_SPOOL_MAX                4096
+
+/* log file format */
+#define SLOG_FILE_FORMAT_TEXT                0
+#define SLOG_FILE_FORMAT_BINARY              1
+
+/* log file bytes per sparse index entry, KB, default 0 no index, 64 is a suggested value */
+#define SLOG_FILE_INDEX_DEFAULT              0
+#define SLOG_FILE_INDEX_MIN                  4
+#define SLOG_FILE_INDEX_MAX                  4096
+
+/* flight recorder ring size range, MB */
+#define SLOG_FLIGHT_SIZE_DEFAULT             8
+#define SLOG_FLIGHT_SIZE_MAX                 1024
+
+/* seconds of history a flight recorder dump writes at most, 0 all */
+#define SLOG_FLIGHT_SPAN_MAX                 3600
+
+/* KB of the ERROR and ASSERT lane of the main ring, default 0 one lane for all, 256 is a suggested value */
+#define SLOG_PRIORITY_LANE_DEFAULT           0
+#define SLOG_PRIORITY_LANE_MAX               16384
+
+/* main ring usage percent the throttle raises the level at, 0 no throttle, and lowers it below, 0 half the high mark */
+#define SLOG_THROTTLE_HIGH_DEFAULT           0
+#define SLOG_THROTTLE_LOW_DEFAULT            0
+
+/* ms of output lag the throttle raises the level at, 0 ring usage only */
+#define SLOG_THROTTLE_LAG_DEFAULT            0
+#define SLOG_THROTTLE_LAG_MAX                3600000
+
+/* ms a repeated log is collapsed for, 0 no collapsing */
+#define SLOG_DEDUP_WINDOW_DEFAULT            0
+#define SLOG_DEDUP_WINDOW_MAX                3600000
+
+/* dedup level mask bit of a level, all levels by default */
+#define SLOG_DEDUP_LEVEL(level)              (1U << (level))
+#define SLOG_DEDUP_LEVELS_ALL                0x3fU
+
+/* MB the spill file of the logs the main ring had no room for grows to, 0 they are dropped */
+#define SLOG_SPILL_SIZE_DEFAULT              0
+#define SLOG_SPILL_SIZE_MAX                  4096
+
+/* seconds between two lines of the stats file, 0 no stats file */
+#define SLOG_STATS_INTERVAL_DEFAULT          0
+#define SLOG_STATS_INTERVAL_MAX              86400
+
+/* one slog() call in it is timed when built with SLOG_LATENCY_STATS, 0 none */
+#define SLOG_LATENCY_SAMPLE_DEFAULT          0
+#define SLOG_LATENCY_SAMPLE_MAX              1000000
+
+/* tags with a quota of the main ring */
+#define SLOG_TAG_QUOTA_MAX                   16
+
+/* built-in output sinks */
+#define SLOG_SINK_TERMINAL                   0
+#define SLOG_SINK_FILE                       1
+#define SLOG_SINK_REMOTE                     2
+#define SLOG_SINK_MAX                        3
+
 
 /* -------------------------------------------------------------------------- */
 /* -------------- PUBLIC TYPES ---------------------------------------------- */
@@ -42,15 +119,54 @@ typedef struct slog_remote_s {
     int socket_fd;
     char host[SLOG_REMOTE_HOST_MAX_LEN];
     unsigned int port;
+    unsigned int mtu;
+    uint8_t proto;               /* SLOG_REMOTE_PROTO_xxx */
+    unsigned int spool_size;     /* MB spooled while the tcp collector is unreachable */
+    uint8_t compress;            /* SLOG_REMOTE_COMPRESS_xxx */
 } slog_remote_t;
 
+/* a tag's share of the main ring, over it its logs are dropped or sampled */
+typedef struct slog_tag_quota_s {
+    char tag[SLOG_FILTER_TAG_MAX_LEN + 1];
+    unsigned int share;          /* percent of the main ring the tag's logs may fill, 0 no limit */
+    unsigned int rate;           /* bytes per second, 0 no limit */
+    unsigned int sample;         /* one in sample logs over the quota is kept, 0 none */
+} slog_tag_quota_t;
+
+/* output sink's queue policy */
+typedef struct slog_sink_cfg_s {
+    uint8_t drop_policy;     /* which log is dropped when the queue is full */
+    uint8_t shed_level;      /* levels above it are shed when the sink lags */
+} slog_sink_cfg_t;
+
 typedef struct slog_cfg_s {
     bool output_enabled;
     bool output_file_enabled;
     bool output_terminal_enabled;
+    uint8_t output_file_format;
+    unsigned int output_file_index;  /* KB per index entry, 0 no index */
+    bool output_file_bloom;          /* bloom filters of tags and tokens per index entry */
+    bool output_file_archive;        /* columnar archive of each rotated segment */
     int cpu_core;
+    char buffer_file[SLOG_BUFFER_FILE_MAX_LEN];  /* main ring kept for slog-recover */
+    uint8_t flight_level;            /* levels above it are kept for a flight recorder dump only */
+    unsigned int flight_size;        /* MB of the flight recorder's ring */
+    unsigned int flight_span;        /* s of history a dump writes, 0 all the ring holds */
+    bool crash_flush;                /* fatal signals write the logs not output yet first */
+    unsigned int priority_lane;      /* KB of the ERROR and ASSERT lane, 0 none */
+    unsigned int throttle_high;      /* ring usage percent raising the level, 0 no throttle */
+    unsigned int throttle_low;       /* ring usage percent the level comes down below */
+    unsigned int throttle_lag;       /* ms of output lag raising the level, 0 none */
+    unsigned int dedup_window;       /* ms a repeated log is collapsed for, 0 none */
+    unsigned int dedup_levels;       /* SLOG_DEDUP_LEVEL() of the levels collapsed */
+    unsigned int spill_size;         /* MB of the spill file, 0 no spill */
+    unsigned int stats_interval;     /* seconds between two stats lines, 0 none */
+    unsigned int latency_sample;     /* one slog() call in it is timed, 0 none */
+    slog_tag_quota_t tag_quota[SLOG_TAG_QUOTA_MAX];
+    unsigned int tag_quotas;
     slog_filter_t filter;
     slog_remote_t remoter;
+    slog_sink_cfg_t sink[SLOG_SINK_MAX];
 } slog_cfg_t;
 
 /* -------------------------------------------------------------------------- */
@@ -62,6 +178,18 @@ bool slog_get_output_enabled(void);
 void slog_set_output_file_enabled(bool enabled);
 bool slog_get_output_file_enabled(void);
 
+void slog_set_output_file_format(uint8_t format);
+uint8_t slog_get_output_file_format(void);
+
+void slog_set_output_file_index(unsigned int interval);
+unsigned int slog_get_output_file_index(void);
+
+void slog_set_output_file_bloom(bool enabled);
+bool slog_get_output_file_bloom(void);
+
+void slog_set_output_file_archive(bool enabled);
+bool slog_get_output_file_archive(void);
+
 void slog_set_output_terminal_enabled(bool enabled);
 bool slog_get_output_terminal_enabled(void);
 
@@ -82,12 +210,71 @@ void slog_get_output_remote_host(char *host);
 void slog_set_output_remote_port(unsigned int port);
 unsigned int slog_get_output_remote_port(void);
 
+void slog_set_output_remote_mtu(unsigned int mtu);
+unsigned int slog_get_output_remote_mtu(void);
+
+void slog_set_output_remote_proto(uint8_t proto);
+uint8_t slog_get_output_remote_proto(void);
+
+void slog_set_output_remote_spool_size(unsigned int size);
+unsigned int slog_get_output_remote_spool_size(void);
+
+void slog_set_output_remote_compress(uint8_t compress);
+uint8_t slog_get_output_remote_compress(void);
+
 void slog_set_output_remote_socket(int fd);
 int slog_get_output_remote_socket(void);
 
 void slog_set_cpu_core(int core_number);
 int slog_get_cpu_core(void);
 
+void slog_set_buffer_file(const char *path);
+const char *slog_get_buffer_file(void);
+
+void slog_set_flight_level(uint8_t level);
+uint8_t slog_get_flight_level(void);
+
+void slog_set_flight_size(unsigned int size);
+unsigned int slog_get_flight_size(void);
+
+void slog_set_flight_span(unsigned int span);
+unsigned int slog_get_flight_span(void);
+
+void slog_set_crash_flush(bool enabled);
+bool slog_get_crash_flush(void);
+
+void slog_set_priority_lane(unsigned int size);
+unsigned int slog_get_priority_lane(void);
+
+void slog_set_throttle(unsigned int high, unsigned int low, unsigned int lag);
+unsigned int slog_get_throttle_high(void);
+unsigned int slog_get_throttle_low(void);
+unsigned int slog_get_throttle_lag(void);
+
+void slog_set_dedup(unsigned int window, unsigned int levels);
+unsigned int slog_get_dedup_window(void);
+unsigned int slog_get_dedup_levels(void);
+
+void slog_set_spill_size(unsigned int size);
+unsigned int slog_get_spill_size(void);
+
+void slog_set_stats_interval(unsigned int interval);
+unsigned int slog_get_stats_interval(void);
+
+void slog_set_latency_sample(unsigned int sample);
+unsigned int slog_get_latency_sample(void);
+
+int slog_set_tag_quota(const char *tag, unsigned int share, unsigned int rate, unsigned int sample);
+void slog_clear_tag_quota(void);
+unsigned int slog_get_tag_quotas(void);
+const slog_tag_quota_t *slog_get_tag_quota(unsigned int index);
+
+void slog_set_sink_drop_policy(int sink, uint8_t policy);
+uint8_t slog_get_sink_drop_policy(int sink);
+
+void slog_set_sink_shed_level(int sink, uint8_t level);
+uint8_t slog_get_sink_shed_level(int sink);
+
 void slog_set_config_default();
 
 int slog_config_parse(void);
@@ -0,0 +1,159 @@
+
+#ifndef __SLOG_COLUMN_H
+#define __SLOG_COLUMN_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "slog_lz.h"
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC MACROS --------------------------------------------- */
+
+/*
+ * columnar archive of one log file segment, the segment's name + ".col", all
+ * integers little endian:
+ *
+ * file head  magic "SLOGCOL1" | version u16 | head size u16 | reserved u32
+ * group head magic "SLCG" | row count u32 | crc32 u32 | gmtoff i32
+ *            | min time i64 | max time i64 | level mask u8 | reserved u8[7]
+ *            | per column: stored length u32 | raw length u32
+ *
+ * a group holds up to SLOG_COLUMN_GROUP_ROWS logs, its columns follow its
+ * head in SLOG_COLUMN_xxx order. Each column is a run of slog_lz frames
+ * linked to each other only, so one column decodes without the others:
+ *
+ * time       time delta from the row before, the first from 0, zigzag varint
+ * level      u8
+ * tag        id in the tag dictionary, varint
+ * tag dict   tag len u8 | tag
+ * site       id in the site dictionary, varint
+ * site dict  file len u8 | file | func len u8 | func | line varint
+ * msg len    varint
+ * msg        messages back to back
+ *
+ * dictionaries are the group's own, at most SLOG_COLUMN_DICT_MAX entries
+ * each. The crc covers the group head, its crc field zeroed, and the stored
+ * columns.
+ */
+#define SLOG_COLUMN_MAGIC                    "SLOGCOL1"
+#define SLOG_COLUMN_VERSION                  1
+#define SLOG_COLUMN_FILE_HEAD_SIZE           16
+
+#define SLOG_COLUMN_GROUP_MAGIC              "SLCG"
+#define SLOG_COLUMN_GROUP_HEAD_SIZE          (40 + SLOG_COLUMN_COUNT * 8)
+
+#define SLOG_COLUMN_SUFFIX                   ".col"
+
+/* group bounds */
+#define SLOG_COLUMN_GROUP_ROWS               65536
+#define SLOG_COLUMN_GROUP_BYTES              (4 * 1024 * 1024)  /* of messages */
+#define SLOG_COLUMN_DICT_MAX                 4096
+
+/* message bytes kept of one log, and raw bytes of one column at most */
+#define SLOG_COLUMN_MSG_MAX                  8192
+#define SLOG_COLUMN_RAW_MAX                  SLOG_COLUMN_GROUP_BYTES
+
+/* columns of a group */
+#define SLOG_COLUMN_TIME                     0
+#define SLOG_COLUMN_LEVEL                    1
+#define SLOG_COLUMN_TAG                      2
+#define SLOG_COLUMN_TAG_DICT                 3
+#define SLOG_COLUMN_SITE                     4
+#define SLOG_COLUMN_SITE_DICT                5
+#define SLOG_COLUMN_MSG_LEN                  6
+#define SLOG_COLUMN_MSG                      7
+#define SLOG_COLUMN_COUNT                    8
+
+/* what a cursor decodes, the columns of a row's fields */
+#define SLOG_COLUMN_READ_TIME                (1 << SLOG_COLUMN_TIME)
+#define SLOG_COLUMN_READ_LEVEL               (1 << SLOG_COLUMN_LEVEL)
+#define SLOG_COLUMN_READ_TAG                 ((1 << SLOG_COLUMN_TAG) | (1 << SLOG_COLUMN_TAG_DICT))
+#define SLOG_COLUMN_READ_SITE                ((1 << SLOG_COLUMN_SITE) | (1 << SLOG_COLUMN_SITE_DICT))
+#define SLOG_COLUMN_READ_MSG                 ((1 << SLOG_COLUMN_MSG_LEN) | (1 << SLOG_COLUMN_MSG))
+#define SLOG_COLUMN_READ_ALL                 ((1 << SLOG_COLUMN_COUNT) - 1)
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC TYPES ---------------------------------------------- */
+
+/* parsed group head */
+typedef struct slog_column_group_s {
+    uint32_t rows;
+    int32_t gmtoff;                          /* s */
+    int64_t min_time;                        /* us */
+    int64_t max_time;                        /* us */
+    uint8_t level_mask;
+    uint32_t stored[SLOG_COLUMN_COUNT];      /* column bytes in the file */
+    uint32_t raw[SLOG_COLUMN_COUNT];         /* column bytes decoded */
+    const char *column[SLOG_COLUMN_COUNT];
+} slog_column_group_t;
+
+/* decoded row, fields of columns not read are 0 and NULL */
+typedef struct slog_column_row_s {
+    int64_t time;                            /* us */
+    uint8_t level;
+    uint32_t tag_id;                         /* in the group's dictionary */
+    uint32_t site_id;
+    const char *tag;
+    uint8_t tag_len;
+    const char *file;
+    uint8_t file_len;
+    const char *func;
+    uint8_t func_len;
+    uint32_t line;
+    const char *msg;
+    uint32_t msg_len;
+} slog_column_row_t;
+
+/* dictionary of a group decoded, entry i is data[offset[i], offset[i + 1]) */
+typedef struct slog_column_dict_s {
+    uint32_t count;
+    uint32_t *offset;
+} slog_column_dict_t;
+
+/* rows of one group being read */
+typedef struct slog_column_cursor_s {
+    const slog_column_group_t *group;
+    unsigned int columns;                    /* SLOG_COLUMN_READ_xxx */
+    char *raw[SLOG_COLUMN_COUNT];
+    size_t pos[SLOG_COLUMN_COUNT];
+    slog_column_dict_t tags;
+    slog_column_dict_t sites;
+    uint32_t row;
+    int64_t time;
+} slog_column_cursor_t;
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC FUNCTIONS PROTOTYPES ------------------------------- */
+
+int slog_column_convert(const char *segment, const char *archive);
+
+int slog_column_file_check(const char *data, size_t len);
+
+int slog_column_group_parse(const char *data, size_t len, slog_column_group_t *group);
+
+int slog_column_cursor_open(slog_column_cursor_t *cursor, const slog_column_group_t *group,
+                            unsigned int columns, slog_lz_t *lz);
+
+int slog_column_row_next(slog_column_cursor_t *cursor, slog_column_row_t *row);
+
+void slog_column_cursor_close(slog_column_cursor_t *cursor);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif  /* __SLOG_COLUMN_H */
+/* ============== EOF ======================================================= */
\ No newline at end of file
@@ -0,0 +1,14 @@
+
+#ifndef __SLOG_CRASH_H
+#define __SLOG_CRASH_H
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC FUNCTIONS PROTOTYPES ------------------------------- */
+
+int slog_crash_init(void);
+
+void slog_crash_deinit(void);
+
+
+#endif  /* __SLOG_CRASH_H */
+/* ============== EOF ======================================================= */
\ No newline at end of file
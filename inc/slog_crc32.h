@@ -0,0 +1,21 @@
+
+#ifndef __SLOG_CRC32_H
+#define __SLOG_CRC32_H
+
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC FUNCTIONS PROTOTYPES ------------------------------- */
+
+uint32_t slog_crc32(uint32_t crc, const void *buf, size_t len);
+
+uint32_t slog_crc32c(uint32_t crc, const void *buf, size_t len);
+
+
+#endif  /* __SLOG_CRC32_H */
+/* ============== EOF ======================================================= */
\ No newline at end of file
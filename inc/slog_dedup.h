@@ -0,0 +1,22 @@
+
+#ifndef __SLOG_DEDUP_H
+#define __SLOG_DEDUP_H
+
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <stdbool.h>
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC FUNCTIONS PROTOTYPES ------------------------------- */
+
+void slog_dedup_init(void);
+
+bool slog_dedup_repeat(const void *slog_event_buf);
+
+void slog_dedup_poll(bool end);
+
+
+#endif  /* __SLOG_DEDUP_H */
+/* ============== EOF ======================================================= */
\ No newline at end of file
@@ -33,6 +33,9 @@ typedef struct slog_event_head
 	struct timeval slog_time;
 }__attribute__((packed)) slog_event_head_t;
 
+/* called by slog_event_fifo_walk() for each event */
+typedef void (*slog_event_walk_t)(const void *slog_event_buf, void *arg);
+
 typedef struct slog_event
 {
     struct slog_event_head slog_head;
@@ -50,10 +53,20 @@ void slog_event_buf_set(void *slog_buf, const char *tag, uint8_t tag_len,
 			const char *file, uint8_t file_len, const char *func, uint8_t func_len, 
 			uint32_t line, uint8_t level, const char *format, va_list args);
 
-void slog_event_fifo_put(struct kfifo *fifo, void *slog_event_buf);
+void slog_event_buf_append(void *slog_buf, const char *format, ...);
+
+int slog_event_fifo_put(struct kfifo *fifo, void *slog_event_buf);
+
+int slog_event_fifo_put_raw(struct kfifo *fifo, const void *data, uint32_t len);
 
 size_t slog_event_fifo_get(struct kfifo *fifo, void *slog_event_buf);
 
+void slog_event_fifo_walk(struct kfifo *fifo, uint32_t frame_len, void *slog_event_buf,
+			slog_event_walk_t walk, void *arg);
+
+void slog_event_fifo_merge_walk(struct kfifo *fifo, uint32_t frame_len, struct kfifo *other,
+				uint32_t other_frame_len, void *slog_event_buf, slog_event_walk_t walk, void *arg);
+
 
 #endif /* __SLOG_EVENT_H */
 /* ============== EOF ======================================================= */
\ No newline at end of file
@@ -3,13 +3,22 @@
 #ifndef __SLOG_FILE_H
 #define __SLOG_FILE_H
 
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <sys/uio.h>
+
 
 /* -------------------------------------------------------------------------- */
 /* -------------- PUBLIC FUNCTIONS PROTOTYPES ------------------------------- */
 
 int slog_file_init(void);
 
-void slog_file_write(const char *log, size_t size);
+int slog_file_write_batch(struct iovec *iov, int iovcnt);
+
+void slog_file_flush(void);
+
+int slog_file_text_fd(void);
 
 void slog_file_deinit(void);
 
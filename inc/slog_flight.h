@@ -0,0 +1,28 @@
+
+#ifndef __SLOG_FLIGHT_H
+#define __SLOG_FLIGHT_H
+
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <stdbool.h>
+
+#include "slog_event.h"
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC FUNCTIONS PROTOTYPES ------------------------------- */
+
+int slog_flight_init(void);
+
+bool slog_flight_record(const void *slog_event_buf);
+
+void slog_flight_poll(void);
+
+void slog_flight_walk(void *slog_event_buf, slog_event_walk_t walk, void *arg);
+
+void slog_flight_deinit(void);
+
+
+#endif  /* __SLOG_FLIGHT_H */
+/* ============== EOF ======================================================= */
\ No newline at end of file
@@ -0,0 +1,107 @@
+
+#ifndef __SLOG_INDEX_H
+#define __SLOG_INDEX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC MACROS --------------------------------------------- */
+
+/*
+ * sparse index of one log file segment, the segment's name + ".idx", all
+ * integers little endian:
+ *
+ * head    magic "SLOGIDX1" | version u16 | head size u16 | interval KB u32
+ * entry   offset u64 | length u32 | log count u32 | min time i64
+ *         | max time i64 | level mask u8 | reserved u8[7]
+ * trailer magic "SLIXFIN1" | entry count u32 | crc32 u32
+ *
+ * an entry covers the logs written in [offset, offset + length) of the
+ * segment, a new one starts at the first log past the interval. Times are
+ * microseconds since the epoch, level mask has bit (1 << level) set for each
+ * level in the entry. Bytes no entry covers, such as the tail still being
+ * written, are unindexed and must be scanned. The trailer is written when
+ * the segment is rotated, its crc covers all the entries.
+ */
+#define SLOG_INDEX_MAGIC                     "SLOGIDX1"
+#define SLOG_INDEX_VERSION                   1
+#define SLOG_INDEX_HEAD_SIZE                 16
+#define SLOG_INDEX_ENTRY_SIZE                40
+
+#define SLOG_INDEX_TRAILER_MAGIC             "SLIXFIN1"
+#define SLOG_INDEX_TRAILER_SIZE              16
+
+#define SLOG_INDEX_SUFFIX                    ".idx"
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC TYPES ---------------------------------------------- */
+
+typedef struct slog_index_entry_s {
+    uint64_t offset;                         /* segment bytes before the entry */
+    uint32_t length;                         /* segment bytes */
+    uint32_t count;                          /* logs */
+    int64_t min_time;                        /* us */
+    int64_t max_time;                        /* us */
+    uint8_t level_mask;
+} slog_index_entry_t;
+
+/* what slog_index_select() looks for */
+typedef struct slog_index_query_s {
+    int64_t start;                           /* us */
+    int64_t end;                             /* us */
+    uint8_t level_mask;                      /* any of these levels */
+} slog_index_query_t;
+
+/* called with each byte range of the segment to read, in file order */
+typedef void (*slog_index_range_cb)(uint64_t offset, uint64_t length, void *arg);
+
+/* ranges a query reads, adjacent ones merged before cb gets them */
+typedef struct slog_index_ranges_s {
+    uint64_t start;
+    uint64_t end;
+    int found;                               /* ranges passed to cb */
+    slog_index_range_cb cb;
+    void *arg;
+} slog_index_ranges_t;
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC FUNCTIONS PROTOTYPES ------------------------------- */
+
+void slog_index_head(char *head, uint32_t interval);
+
+int slog_index_check(const char *data, size_t len, size_t *count, int *final);
+
+void slog_index_entry_encode(char *data, const slog_index_entry_t *entry);
+
+void slog_index_entry_decode(const char *data, slog_index_entry_t *entry);
+
+void slog_index_trailer(char *trailer, uint32_t count, uint32_t crc);
+
+int slog_index_select(const char *data, size_t len, uint64_t file_size, uint64_t file_head,
+                      const slog_index_query_t *query, slog_index_range_cb cb, void *arg);
+
+void slog_index_range_add(slog_index_ranges_t *ranges, uint64_t offset, uint64_t length);
+
+int slog_index_range_done(slog_index_ranges_t *ranges);
+
+char *slog_index_read(const char *segment, const char *suffix, size_t *len);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif  /* __SLOG_INDEX_H */
+/* ============== EOF ======================================================= */
\ No newline at end of file
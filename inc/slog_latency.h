@@ -0,0 +1,43 @@
+
+#ifndef __SLOG_LATENCY_H
+#define __SLOG_LATENCY_H
+
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <stdint.h>
+
+#include "slog_stats.h"
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC MACROS --------------------------------------------- */
+
+/* time a slog() call, nothing is left of it without SLOG_LATENCY_STATS */
+#ifdef SLOG_LATENCY_STATS
+#define SLOG_LATENCY_BEGIN(start)            uint64_t start = slog_latency_begin()
+#define SLOG_LATENCY_END(start)              slog_latency_end(start)
+#else
+#define SLOG_LATENCY_BEGIN(start)
+#define SLOG_LATENCY_END(start)
+#endif
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC FUNCTIONS PROTOTYPES ------------------------------- */
+
+void slog_latency_init(void);
+
+#ifdef SLOG_LATENCY_STATS
+uint64_t slog_latency_begin(void);
+
+void slog_latency_end(uint64_t start);
+#endif
+
+void slog_latency_get(slog_call_stats_t *stats);
+
+void slog_latency_deinit(void);
+
+
+#endif  /* __SLOG_LATENCY_H */
+/* ============== EOF ======================================================= */
\ No newline at end of file
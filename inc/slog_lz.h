@@ -0,0 +1,74 @@
+
+#ifndef __SLOG_LZ_H
+#define __SLOG_LZ_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/uio.h>
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC MACROS --------------------------------------------- */
+
+/*
+ * compressed remote stream, a sequence of frames:
+ *
+ *   magic "SLZ1" | flags u8 | reserved u8[3] | raw_len u32 | comp_len u32 | payload
+ *
+ * lengths are big endian. A compressed payload is one LZ4 block, a linked
+ * frame's matches may reach into the last 64KB of raw bytes of the frames
+ * before it (the LZ4 streaming dictionary), so a linked stream is decoded
+ * in order with one slog_lz_t. A frame without SLOG_LZ_FLAG_LINKED starts
+ * a new dictionary.
+ */
+#define SLOG_LZ_MAGIC                        "SLZ1"
+#define SLOG_LZ_HEAD_SIZE                    16
+
+#define SLOG_LZ_FLAG_COMPRESSED              0x01  /* payload is an LZ4 block, else raw bytes */
+#define SLOG_LZ_FLAG_LINKED                  0x02  /* payload uses the previous frames as dictionary */
+
+/* dictionary bytes, and raw bytes of one frame at most */
+#define SLOG_LZ_WINDOW                       (64 * 1024)
+#define SLOG_LZ_BLOCK_MAX                    (128 * 1024)
+
+/* biggest frame, an incompressible block is stored raw */
+#define SLOG_LZ_FRAME_MAX                    (SLOG_LZ_HEAD_SIZE + SLOG_LZ_BLOCK_MAX)
+
+#define SLOG_LZ_HASH_LOG                     14
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC TYPES ---------------------------------------------- */
+
+/* one side of a compressed stream, holds the dictionary of the frames so far */
+typedef struct slog_lz_s {
+    char buf[SLOG_LZ_WINDOW + SLOG_LZ_BLOCK_MAX];
+    size_t len;                                  /* raw bytes kept in buf */
+    uint32_t table[1 << SLOG_LZ_HASH_LOG];       /* encoder match positions + 1, 0 empty */
+} slog_lz_t;
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC FUNCTIONS PROTOTYPES ------------------------------- */
+
+void slog_lz_reset(slog_lz_t *lz);
+
+int slog_lz_frame_encode(slog_lz_t *lz, const struct iovec *iov, int iovcnt, char *frame);
+
+int slog_lz_frame_decode(slog_lz_t *lz, const char *data, size_t len, const char **raw, size_t *raw_len);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif  /* __SLOG_LZ_H */
+/* ============== EOF ======================================================= */
\ No newline at end of file
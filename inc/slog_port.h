@@ -5,6 +5,7 @@
 /* -------------------------------------------------------------------------- */
 /* -------------- DEPENDANCIES ---------------------------------------------- */
 
+#include <time.h>
 #include <stddef.h>
 
 
@@ -15,7 +16,11 @@ int slog_port_init(void);
 
 void slog_port_deinit(void);
 
-void slog_port_output(uint8_t level, const char *log, size_t size);
+void slog_port_output(const void *slog_event_buf);
+
+int slog_port_dump(const void *slog_event_buf, const struct timespec *deadline);
+
+void slog_port_walk_file(void *slog_event_buf, void (*walk)(const void *slog_event_buf, void *arg), void *arg);
 
 
 #endif  /* __SLOG_PORT_H */
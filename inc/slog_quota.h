@@ -0,0 +1,26 @@
+
+#ifndef __SLOG_QUOTA_H
+#define __SLOG_QUOTA_H
+
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <stdbool.h>
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC FUNCTIONS PROTOTYPES ------------------------------- */
+
+void slog_quota_init(void);
+
+bool slog_quota_charge(const void *slog_event_buf);
+
+void slog_quota_release(const void *slog_event_buf);
+
+void slog_quota_poll(void);
+
+unsigned long slog_quota_get_dropped(void);
+
+
+#endif  /* __SLOG_QUOTA_H */
+/* ============== EOF ======================================================= */
\ No newline at end of file
@@ -0,0 +1,81 @@
+
+#ifndef __SLOG_RING_H
+#define __SLOG_RING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC MACROS --------------------------------------------- */
+
+/*
+ * main ring kept in the file BUFFER_FILE names, so the logs a crashed
+ * process had not output yet can be recovered. Integers are in the writer's
+ * byte order, slog-recover reads the file on the writer's host:
+ *
+ * head    magic "SLOGRNG1" | version u16 | head size u16 | event head size u16
+ *         | reserved u16 | data size u32 | pid u32 | start time i64
+ *         | reserved up to SLOG_RING_FIFO_OFFSET
+ *         | in u32 | out u32 | the rest of the writer's kfifo
+ * data    at head size, data size bytes, a power of 2
+ * record  magic u32 | crc32c u32 | event
+ *
+ * in and out are the kfifo's own indices, free running: the ring's byte i is
+ * data[i & (data size - 1)] and records wrap around its end. Records from
+ * out up to in are unconsumed, the ones before out were handed to the sinks
+ * and are still there until overwritten. The crc covers the event, a
+ * slog_event_head_t then tag, file, func and message.
+ */
+#define SLOG_RING_MAGIC                      "SLOGRNG1"
+#define SLOG_RING_VERSION                    1
+#define SLOG_RING_HEAD_SIZE                  4096  /* data page aligned */
+#define SLOG_RING_FIFO_OFFSET                64
+
+#define SLOG_RING_RECORD_MAGIC               0x4b524c53U  /* "SLRK" */
+#define SLOG_RING_RECORD_HEAD_SIZE           8
+
+/* a ring file holding unconsumed records is moved aside at startup */
+#define SLOG_RING_PREV_SUFFIX                ".prev"
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC TYPES ---------------------------------------------- */
+
+/* parsed ring file */
+typedef struct slog_ring_s {
+    const uint8_t *data;
+    uint32_t size;                           /* data bytes */
+    uint32_t in;
+    uint32_t out;
+    uint32_t pid;                            /* writer */
+    int64_t start_time;                      /* us, the writer's log_init() */
+} slog_ring_t;
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC FUNCTIONS PROTOTYPES ------------------------------- */
+
+void slog_ring_head_set(void *head, uint32_t size, uint16_t event_head_size);
+
+void slog_ring_record_set(void *record, const void *event, uint32_t event_len);
+
+int slog_ring_file_check(const void *file, size_t len, uint16_t event_head_size, slog_ring_t *ring);
+
+int slog_ring_record_read(const slog_ring_t *ring, uint32_t pos, uint32_t end, void *event);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif  /* __SLOG_RING_H */
+/* ============== EOF ======================================================= */
\ No newline at end of file
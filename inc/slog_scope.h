@@ -0,0 +1,20 @@
+
+#ifndef __SLOG_SCOPE_H
+#define __SLOG_SCOPE_H
+
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <stdbool.h>
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC FUNCTIONS PROTOTYPES ------------------------------- */
+
+bool slog_scope_is_open(void);
+
+bool slog_scope_keep(const void *slog_event_buf);
+
+
+#endif  /* __SLOG_SCOPE_H */
+/* ============== EOF ======================================================= */
\ No newline at end of file
@@ -0,0 +1,33 @@
+
+#ifndef __SLOG_SIGNAL_H
+#define __SLOG_SIGNAL_H
+
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <stdint.h>
+#include <stdarg.h>
+#include <stddef.h>
+
+#include "slog_event.h"
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC FUNCTIONS PROTOTYPES ------------------------------- */
+
+void slog_signal_init(void);
+
+void slog_signal_event_put(uint8_t level, const char *tag, uint8_t tag_len, const char *file, uint8_t file_len,
+                           const char *func, uint8_t func_len, uint32_t line, const char *format, va_list args);
+
+size_t slog_signal_event_get(void *slog_event_buf);
+
+unsigned int slog_signal_in(void);
+
+unsigned int slog_signal_out(void);
+
+void slog_signal_walk(void *slog_event_buf, slog_event_walk_t walk, void *arg);
+
+
+#endif  /* __SLOG_SIGNAL_H */
+/* ============== EOF ======================================================= */
\ No newline at end of file
@@ -0,0 +1,88 @@
+
+#ifndef __SLOG_SINK_H
+#define __SLOG_SINK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/uio.h>
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC MACROS --------------------------------------------- */
+
+/* max registered sinks, built-in ones included */
+#define SLOG_SINK_REGISTER_MAX               8
+
+/* sink filter's tag max length */
+#define SLOG_SINK_TAG_MAX_LEN                16
+
+/* sink formatter */
+#define SLOG_SINK_FORMAT_TEXT                0   /* plain text line */
+#define SLOG_SINK_FORMAT_COLOR               1   /* text line in its level's ANSI color */
+#define SLOG_SINK_FORMAT_RAW                 2   /* unformatted slog event, head and payload */
+
+/* sink queue full policy */
+#define SLOG_SINK_DROP_NEWEST                0
+#define SLOG_SINK_DROP_OLDEST                1
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC TYPES ---------------------------------------------- */
+
+/**
+ * sink callbacks, all of them get the ctx given at registration.
+ *
+ * open runs once in slog_sink_register(), close once after the sink queue
+ * drained in slog_sink_unregister() or log_fini(). write_batch and flush
+ * run on the sink's own thread: write_batch gets one iovec per formatted
+ * log and may modify the iovecs, flush follows every batch and, with a
+ * flush_interval, also runs while the sink is idle. enabled is part of the
+ * sink's filter and runs on the dispatching thread for each log, a sink it
+ * returns 0 for takes no log until it returns 1 again, it must not block.
+ * Only write_batch is mandatory.
+ */
+typedef struct slog_sink_ops_s {
+    int (*open)(void *ctx);
+    int (*write_batch)(void *ctx, struct iovec *iov, int iovcnt);
+    int (*flush)(void *ctx);
+    void (*close)(void *ctx);
+    int (*enabled)(void *ctx);
+} slog_sink_ops_t;
+
+/* sink description given to slog_sink_register() */
+typedef struct slog_sink_desc_s {
+    const char *name;                        /* sink name, also names its thread */
+    slog_sink_ops_t ops;
+    void *ctx;
+    uint8_t level;                           /* logs above this level are filtered */
+    char tag[SLOG_SINK_TAG_MAX_LEN + 1];     /* only logs of this tag, empty means all */
+    uint8_t format;                          /* SLOG_SINK_FORMAT_xxx */
+    size_t queue_size;                       /* queue bytes, 0 means default */
+    uint8_t drop_policy;                     /* SLOG_SINK_DROP_NEWEST or SLOG_SINK_DROP_OLDEST */
+    uint8_t shed_level;                      /* levels above it are shed when the sink lags */
+    uint32_t flush_interval;                 /* ms, flush runs when idle this long, 0 never */
+} slog_sink_desc_t;
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC FUNCTIONS PROTOTYPES ------------------------------- */
+
+int slog_sink_register(const slog_sink_desc_t *desc);
+
+int slog_sink_unregister(int sink_id);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif  /* __SLOG_SINK_H */
+/* ============== EOF ======================================================= */
\ No newline at end of file
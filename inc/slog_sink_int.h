@@ -0,0 +1,34 @@
+
+#ifndef __SLOG_SINK_INT_H
+#define __SLOG_SINK_INT_H
+
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <time.h>
+
+#include "slog_sink.h"
+#include "slog_stats.h"
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC FUNCTIONS PROTOTYPES ------------------------------- */
+
+void slog_sink_dispatch(const void *slog_event_buf);
+
+int slog_sink_post_wait(int sink_id, const void *slog_event_buf, const struct timespec *deadline);
+
+int slog_sink_flush(const struct timespec *deadline);
+
+void slog_sink_freeze(void);
+
+void slog_sink_walk(int sink_id, void *slog_event_buf,
+                    void (*walk)(const void *slog_event_buf, void *arg), void *arg);
+
+int slog_sink_stats(slog_sink_stats_t *stats);
+
+void slog_sink_unregister_all(void);
+
+
+#endif  /* __SLOG_SINK_INT_H */
+/* ============== EOF ======================================================= */
\ No newline at end of file
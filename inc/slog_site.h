@@ -0,0 +1,50 @@
+#ifndef __SLOG_SITE_H
+#define __SLOG_SITE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC TYPES ---------------------------------------------- */
+
+/**
+ * state of one rate limited or sampled log site, a static at the site
+ * zeroed by the compiler
+ */
+typedef struct slog_site_s {
+    uint64_t tat;                            /* token bucket's next free time, us */
+    unsigned long count;                     /* calls counted, or the sampler's sequence */
+    unsigned long suppressed;                /* calls skipped since the last output */
+} slog_site_t;
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC FUNCTIONS PROTOTYPES ------------------------------- */
+
+/*
+ * gates of the site macros, true the call is output, false it is counted
+ * as suppressed and not formatted at all
+ */
+bool slog_site_ratelimit(slog_site_t *site, unsigned int burst, unsigned int interval_ms);
+
+bool slog_site_every_n(slog_site_t *site, unsigned long n);
+
+bool slog_site_first_n(slog_site_t *site, unsigned long n);
+
+bool slog_site_sample(slog_site_t *site, double p);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __SLOG_SITE_H */
+/* ============== EOF ======================================================= */
\ No newline at end of file
@@ -8,12 +8,19 @@
 
 #define SLOG_TIME_FORMAT_LEN                 128
 
+/* extra bytes the color escape sequences take around a formatted log */
+#define SLOG_FORMAT_COLOR_LEN                32
+
 
 /* -------------------------------------------------------------------------- */
 /* -------------- PUBLIC FUNCTIONS PROTOTYPES ------------------------------- */
 
 int format_log(char *slog_format_buf, const void *slog_event_buf);
 
+int format_log_color(char *slog_format_buf, const void *slog_event_buf);
+
+int format_log_safe(char *slog_format_buf, const void *slog_event_buf, long gmtoff);
+
 
 #endif  /* __SLOG_SPEC_H */
 /* ============== EOF ======================================================= */
\ No newline at end of file
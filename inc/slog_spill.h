@@ -0,0 +1,40 @@
+
+#ifndef __SLOG_SPILL_H
+#define __SLOG_SPILL_H
+
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <stddef.h>
+#include <stdbool.h>
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC TYPES ---------------------------------------------- */
+
+/* puts an event into the main ring, 0 put, -1 no room */
+typedef int (*slog_spill_ring_put_t)(void *slog_event_buf);
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC FUNCTIONS PROTOTYPES ------------------------------- */
+
+int slog_spill_init(void);
+
+bool slog_spill_active(void);
+
+int slog_spill_put(void *slog_event_buf, slog_spill_ring_put_t ring_put);
+
+size_t slog_spill_get(void *slog_event_buf);
+
+unsigned int slog_spill_in(void);
+
+unsigned int slog_spill_out(void);
+
+unsigned long slog_spill_get_dropped(void);
+
+void slog_spill_deinit(void);
+
+
+#endif  /* __SLOG_SPILL_H */
+/* ============== EOF ======================================================= */
\ No newline at end of file
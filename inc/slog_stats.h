@@ -0,0 +1,111 @@
+#ifndef __SLOG_STATS_H
+#define __SLOG_STATS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <stdint.h>
+
+#include "slog_sink.h"
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC MACROS --------------------------------------------- */
+
+/* ASSERT to VERBOSE */
+#define SLOG_STATS_LEVELS                    6
+
+#define SLOG_STATS_NAME_LEN                  16
+
+/* write latency buckets, bucket i counts writes under 2^i us, the last the rest */
+#define SLOG_STATS_LATENCY_BUCKETS           24
+
+/*
+ * slog() call latency buckets, log-linear: ns under 8 have a bucket each,
+ * then each power of two up to 2^40ns is split into 8 buckets
+ */
+#define SLOG_STATS_CALL_SUB_BITS             3
+#define SLOG_STATS_CALL_BUCKETS              304
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC TYPES ---------------------------------------------- */
+
+/* an output sink's counters since it was registered */
+typedef struct slog_sink_stats_s {
+    char name[SLOG_STATS_NAME_LEN];
+    unsigned long written;                   /* logs handed to write_batch */
+    unsigned long batches;                   /* write_batch calls */
+    unsigned long errors;                    /* write_batch calls failed */
+    unsigned long dropped;                   /* logs the full or lagging queue dropped */
+    unsigned long latency[SLOG_STATS_LATENCY_BUCKETS];  /* write_batch calls by duration */
+} slog_sink_stats_t;
+
+/* slog() calls' latency, sampled when built with SLOG_LATENCY_STATS */
+typedef struct slog_call_stats_s {
+    unsigned long count;                     /* calls sampled */
+    uint64_t sum;                            /* ns */
+    uint64_t max;                            /* ns */
+    uint64_t p50;                            /* ns, the bucket's highest value */
+    uint64_t p90;
+    uint64_t p99;
+    uint64_t p999;
+    unsigned long buckets[SLOG_STATS_CALL_BUCKETS];
+} slog_call_stats_t;
+
+/* the logging pipeline's counters since log_init(), by level where they have one */
+typedef struct slog_stats_s {
+    unsigned long enqueued[SLOG_STATS_LEVELS];   /* logs put into the main ring or the spill */
+    uint64_t bytes[SLOG_STATS_LEVELS];           /* their event bytes */
+    unsigned long dropped[SLOG_STATS_LEVELS];    /* logs a full ring or a tag quota dropped */
+    unsigned long throttled[SLOG_STATS_LEVELS];  /* logs the throttle filtered out */
+    unsigned long quota_dropped;             /* of dropped, by the tag quotas */
+    unsigned long spilled;                   /* logs put into the spill */
+    unsigned long spill_dropped;             /* spilled logs beyond its cap */
+    unsigned long remote_dropped;            /* logs the remote output dropped */
+    uint32_t ring_size;                      /* bytes of the main ring's bulk lane */
+    uint32_t ring_used;                      /* bytes in use now */
+    uint32_t ring_high;                      /* most bytes in use the output thread saw */
+    unsigned long consumed;                  /* logs the output thread took */
+    unsigned long batches;                   /* its passes draining the ring */
+    unsigned long batch_max;                 /* most logs of one pass */
+    unsigned int lag;                        /* ms the last log sampled waited in the ring */
+    uint8_t throttle_level;                  /* level the throttle lets through now */
+    int sinks;
+    slog_sink_stats_t sink[SLOG_SINK_REGISTER_MAX];
+    slog_call_stats_t call;
+} slog_stats_t;
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC FUNCTIONS PROTOTYPES ------------------------------- */
+
+void slog_stats_init(void);
+
+void slog_stats_enqueued(uint8_t level, uint32_t bytes);
+
+void slog_stats_dropped(uint8_t level);
+
+void slog_stats_lost(uint8_t level, uint32_t bytes);
+
+void slog_stats_throttled(uint8_t level);
+
+void slog_stats_consumed(void);
+
+void slog_stats_poll(const void *slog_event_buf);
+
+void slog_stats_get(slog_stats_t *stats);
+
+void slog_stats_deinit(void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __SLOG_STATS_H */
+/* ============== EOF ======================================================= */
\ No newline at end of file
@@ -3,6 +3,11 @@
 #ifndef __SLOG_TCP_H
 #define __SLOG_TCP_H
 
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <sys/uio.h>
+
 
 /* -------------------------------------------------------------------------- */
 /* -------------- PUBLIC FUNCTIONS PROTOTYPES ------------------------------- */
@@ -11,7 +16,11 @@ int slog_remote_init(void);
 
 void slog_remote_deinit(void);
 
-int slog_remote_write(const char *log, size_t size);
+int slog_remote_write_batch(struct iovec *iov, int iovcnt);
+
+int slog_remote_flush(void);
+
+unsigned long slog_remote_get_dropped(void);
 
 
 #endif  /* __SLOG_TCP_H */
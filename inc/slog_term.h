@@ -0,0 +1,25 @@
+
+#ifndef __SLOG_TERM_H
+#define __SLOG_TERM_H
+
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <stdbool.h>
+#include <sys/uio.h>
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC FUNCTIONS PROTOTYPES ------------------------------- */
+
+int slog_term_init(void);
+
+bool slog_term_is_color(void);
+
+int slog_term_write_batch(struct iovec *iov, int iovcnt);
+
+void slog_term_deinit(void);
+
+
+#endif  /* __SLOG_TERM_H */
+/* ============== EOF ======================================================= */
\ No newline at end of file
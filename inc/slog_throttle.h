@@ -0,0 +1,22 @@
+
+#ifndef __SLOG_THROTTLE_H
+#define __SLOG_THROTTLE_H
+
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <stdint.h>
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC FUNCTIONS PROTOTYPES ------------------------------- */
+
+void slog_throttle_init(void);
+
+uint8_t slog_throttle_level(void);
+
+void slog_throttle_poll(const void *slog_event_buf);
+
+
+#endif  /* __SLOG_THROTTLE_H */
+/* ============== EOF ======================================================= */
\ No newline at end of file
@@ -2,19 +2,32 @@
 /* -------------------------------------------------------------------------- */
 /* -------------- DEPENDANCIES ---------------------------------------------- */
 
+#include <time.h>
 #include <stdio.h>
 #include <errno.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
 #include <stdbool.h>
+#include <sched.h>
 #include <pthread.h>
 
 #include "logger.h"
 #include "slog_cfg.h"
 #include "slog_buf.h"
 #include "slog_port.h"
+#include "slog_sink_int.h"
+#include "slog_crash.h"
 #include "slog_event.h"
+#include "slog_dedup.h"
+#include "slog_flight.h"
+#include "slog_quota.h"
+#include "slog_scope.h"
+#include "slog_spill.h"
+#include "slog_stats.h"
+#include "slog_latency.h"
+#include "slog_signal.h"
+#include "slog_throttle.h"
 #include "slog_async.h"
 #include "slog_inner.h"
 #include "slog_compiler.h"
@@ -24,6 +37,9 @@
 
 static int slog_is_init = 0;
 
+/* calls past the init check, log_fini frees nothing before they left */
+static int slog_producers = 0;
+
 
 /* -------------------------------------------------------------------------- */
 /* -------------- PUBLIC FUNCTIONS DEFINITION ------------------------------- */
@@ -34,29 +50,54 @@ int log_init(void)
         return 0;
     }
 
-    /* initialize slog resources */
-    if (0 != slog_buffer_init()) {
-        slog_error_inner("slog_buffer_init error");
-        return -1;
-    }
-
     /* set default log config */
     slog_set_config_default();
 
     /* parse and set log config */
     slog_config_parse();
 
+    /* initialize slog resources, after the config names the ring's file */
+    if (0 != slog_buffer_init()) {
+        slog_error_inner("slog_buffer_init error");
+        return -1;
+    }
+
+    if (0 != slog_spill_init()) {
+        slog_error_inner("slog_spill_init error");
+        return -1;
+    }
+
     /* port initialize */
     if (0 != slog_port_init()) {
         slog_error_inner("slog_port_init error");
         return -1;
     }
 
+    slog_signal_init();
+
+    slog_throttle_init();
+
+    slog_dedup_init();
+
+    slog_quota_init();
+
+    slog_stats_init();
+
+    slog_latency_init();
+
+    if (0 != slog_flight_init()) {
+        slog_error_inner("slog_flight_init error");
+        return -1;
+    }
+
     if (0 != slog_async_init()) {
         slog_error_inner("slog_async_init error");
         return -1;
     }
 
+    /* last, the handler walks what the above set up */
+    slog_crash_init();
+
     slog_is_init = 1;
 
     return 0;
@@ -71,19 +112,93 @@ void log_fini(void)
     /* set slog_is_init to 0 */
     __sync_sub_and_fetch(&slog_is_init, 1);
 
+    /* a producer in flight still puts to the ring, wait for it to leave before the last drain */
+    while (0 != __atomic_load_n(&slog_producers, __ATOMIC_SEQ_CST)) {
+        sched_yield();
+    }
+
+    slog_crash_deinit();
+
+    /* the output thread drains the ring and exits before it is freed */
+    slog_async_deinit();
+
+    slog_stats_deinit();
+
+    slog_latency_deinit();
+
     slog_buffer_deinit();
 
+    slog_spill_deinit();
+
+    slog_flight_deinit();
+
     slog_port_deinit();
 }
 
-void slog(uint8_t level, const char *tag, size_t tag_len, const char *file, size_t file_len, \
-          const char *func, size_t func_len, long line, const char *format, ...)
+int slog_flush(unsigned int timeout_ms)
 {
+    struct timespec deadline;
+
     if (unlikely(!slog_is_init)) {
-        slog_error_inner("slog has not init");
-        return;
+        return -1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000;
+    if (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+
+    /* out of the main ring first, then out of every sink queue */
+    if (0 != slog_async_flush(&deadline)) {
+        return -1;
+    }
+
+    return slog_sink_flush(&deadline);
+}
+
+int slog_get_stats(slog_stats_t *stats)
+{
+    if (unlikely(!slog_is_init) || (NULL == stats)) {
+        return -1;
     }
 
+    slog_stats_get(stats);
+
+    return 0;
+}
+
+/*
+ * enter the calls log_fini waits for
+ *
+ * @return true entered, false log is not init and the call did not
+ */
+static bool slog_enter(void)
+{
+    __atomic_add_fetch(&slog_producers, 1, __ATOMIC_SEQ_CST);
+    if (likely(slog_is_init)) {
+        return true;
+    }
+
+    __atomic_sub_fetch(&slog_producers, 1, __ATOMIC_SEQ_CST);
+    return false;
+}
+
+static void slog_leave(void)
+{
+    __atomic_sub_fetch(&slog_producers, 1, __ATOMIC_SEQ_CST);
+}
+
+/*
+ * the body of slog(), site NULL or the rate limited site the log is of
+ */
+static void slog_vlog(slog_site_t *site, uint8_t level, const char *tag, size_t tag_len, const char *file, size_t file_len, \
+                      const char *func, size_t func_len, long line, const char *format, va_list args)
+{
+    unsigned long suppressed = 0;
+
     /* check output enabled */
     if (!slog_get_output_enabled()) {
         return;
@@ -93,6 +208,12 @@ void slog(uint8_t level, const char *tag, size_t tag_len, const char *file, size
         return;
     }
 
+    /* raised while the ring or the output thread is under pressure, an open scope keeps its trail still */
+    if ((level > slog_throttle_level()) && !slog_scope_is_open()) {
+        slog_stats_throttled(level);
+        return;
+    }
+
     // char filter_tag[SLOG_FILTER_TAG_MAX_LEN] = { 0 };
     // slog_get_filter_tag(filter_tag);
     // if ( (strlen(filter_tag) >= 1) && !strstr(tag, filter_tag)) {
@@ -105,16 +226,106 @@ void slog(uint8_t level, const char *tag, size_t tag_len, const char *file, size
         return;
     }
 
-    va_list args;
     char slog_event_buf[SLOG_EVENT_BUF_MAXLEN] = { 0 };
 
-    va_start(args, format);
     slog_event_buf_set(slog_event_buf, tag, tag_len,
 			file, file_len, func, func_len, line, level,
 			format, args);
+
+    /* taken once the log is sure to be output, a filtered one keeps the count */
+    if (NULL != site) {
+        suppressed = __atomic_exchange_n(&site->suppressed, 0, __ATOMIC_RELAXED);
+    }
+    if (0 != suppressed) {
+        slog_event_buf_append(slog_event_buf, " (suppressed %lu)", suppressed);
+    }
+
+    /* debug trail of an open scope, output when it commits */
+    if (slog_scope_keep(slog_event_buf)) {
+        return;
+    }
+
+    /* the trail is kept, the log itself is throttled as the others, its site keeps the count */
+    if (level > slog_throttle_level()) {
+        if (0 != suppressed) {
+            __atomic_add_fetch(&site->suppressed, suppressed, __ATOMIC_RELAXED);
+        }
+        slog_stats_throttled(level);
+        return;
+    }
+
+    /* a tag over its quota drops its own logs, the others keep their room */
+    if (!slog_quota_charge(slog_event_buf)) {
+        slog_stats_dropped(level);
+        return;
+    }
+
+    if (0 != slog_buffer_put(slog_event_buf)) {
+        slog_quota_release(slog_event_buf);
+        slog_stats_dropped(level);
+    } else {
+        slog_stats_enqueued(level, ((slog_event_head_t *)slog_event_buf)->slog_event_length);
+    }
+}
+
+void slog(uint8_t level, const char *tag, size_t tag_len, const char *file, size_t file_len, \
+          const char *func, size_t func_len, long line, const char *format, ...)
+{
+    va_list args;
+
+    if (unlikely(!slog_enter())) {
+        slog_error_inner("slog has not init");
+        return;
+    }
+    SLOG_LATENCY_BEGIN(start);
+
+    va_start(args, format);
+    slog_vlog(NULL, level, tag, tag_len, file, file_len, func, func_len, line, format, args);
     va_end(args);
 
-    slog_buffer_put(slog_event_buf);
+    SLOG_LATENCY_END(start);
+    slog_leave();
+}
+
+void slog_site_log(slog_site_t *site, uint8_t level, const char *tag, size_t tag_len, const char *file, size_t file_len, \
+                   const char *func, size_t func_len, long line, const char *format, ...)
+{
+    va_list args;
+
+    if (unlikely(!slog_enter())) {
+        slog_error_inner("slog has not init");
+        return;
+    }
+    SLOG_LATENCY_BEGIN(start);
+
+    va_start(args, format);
+    slog_vlog(site, level, tag, tag_len, file, file_len, func, func_len, line, format, args);
+    va_end(args);
+
+    SLOG_LATENCY_END(start);
+    slog_leave();
+}
+
+void slog_signal_safe(uint8_t level, const char *tag, size_t tag_len, const char *file, size_t file_len, \
+                      const char *func, size_t func_len, long line, const char *format, ...)
+{
+    va_list args;
+
+    if (tag_len >= 255 || file_len >= 255 || func_len >= 255) {
+        return;
+    }
+
+    /* nothing here may lock, slog_error_inner() included */
+    if (unlikely(!slog_enter())) {
+        return;
+    }
+
+    if (slog_get_output_enabled() && (level <= slog_get_filter_level())) {
+        va_start(args, format);
+        slog_signal_event_put(level, tag, tag_len, file, file_len, func, func_len, line, format, args);
+        va_end(args);
+    }
+    slog_leave();
 }
 
 
@@ -5,31 +5,157 @@
 
 #define _GNU_SOURCE
 
+#include <time.h>
 #include <stdio.h>
+#include <errno.h>
 #include <stdint.h>
 #include <string.h>
 #include <unistd.h>
 #include <signal.h>
+#include <stdbool.h>
 #include <pthread.h>
 
 #include "slog_cfg.h"
 #include "slog_buf.h"
-#include "slog_spec.h"
 #include "slog_port.h"
 #include "slog_inner.h"
 #include "slog_async.h"
 #include "slog_event.h"
+#include "slog_dedup.h"
+#include "slog_flight.h"
+#include "slog_quota.h"
+#include "slog_spill.h"
+#include "slog_stats.h"
+#include "slog_signal.h"
+#include "slog_throttle.h"
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE MACROS -------------------------------------------- */
+
+/* ms the output thread sleeps once the ring is drained */
+#define SLOG_ASYNC_IDLE_WAIT                 3
+
+/* records between two throttle samples while the ring is not drained */
+#define SLOG_ASYNC_THROTTLE_EVERY            256
+
+/* positions slog_flush() waits for, the main ring's lanes, the spill's and the signal ring's */
+#define SLOG_ASYNC_SPILL                     SLOG_BUFFER_LANES
+#define SLOG_ASYNC_SIGNAL                    (SLOG_BUFFER_LANES + 1)
+#define SLOG_ASYNC_POSITIONS                 (SLOG_BUFFER_LANES + 2)
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE TYPES --------------------------------------------- */
+
+/* the output thread, and how far it dispatched for slog_flush() */
+typedef struct slog_async_s {
+    pthread_t thread;
+    bool running;                            /* created, not joined yet, under the lock */
+    int stop;                                /* drain the ring and exit */
+    unsigned int done[SLOG_ASYNC_POSITIONS];  /* positions dispatched up to */
+    int flushers;                            /* slog_async_flush() callers waiting */
+    unsigned int wakes;                      /* slog_async_flush() calls, under the lock */
+    pthread_mutex_t lock;                    /* never destroyed, a late slog_flush() takes it */
+    pthread_cond_t wake;                     /* ends the idle wait */
+    pthread_cond_t dispatched;               /* done moved */
+} slog_async_t;
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE VARIABLES ----------------------------------------- */
+
+static slog_async_t slog_async = { .lock = PTHREAD_MUTEX_INITIALIZER };
 
 
 /* -------------------------------------------------------------------------- */
 /* -------------- PRIVATE FUNCTIONS DEFINITION ------------------------------ */
 
+static unsigned int slog_async_in(int pos)
+{
+    if (SLOG_ASYNC_SIGNAL == pos) {
+        return slog_signal_in();
+    }
+
+    return (SLOG_ASYNC_SPILL == pos) ? slog_spill_in() : slog_buffer_in(pos);
+}
+
+static unsigned int slog_async_out(int pos)
+{
+    if (SLOG_ASYNC_SIGNAL == pos) {
+        return slog_signal_out();
+    }
+
+    return (SLOG_ASYNC_SPILL == pos) ? slog_spill_out() : slog_buffer_out(pos);
+}
+
+/*
+ * publish the positions dispatched up to, waking slog_async_flush()
+ * callers. done and flushers are sequentially consistent, a flusher either
+ * sees the new positions or is woken.
+ */
+static void slog_async_publish(void)
+{
+    int pos;
+
+    for (pos = 0; pos < SLOG_ASYNC_POSITIONS; ++pos) {
+        __atomic_store_n(&slog_async.done[pos], slog_async_out(pos), __ATOMIC_SEQ_CST);
+    }
+
+    if (0 != __atomic_load_n(&slog_async.flushers, __ATOMIC_SEQ_CST)) {
+        pthread_mutex_lock(&slog_async.lock);
+        pthread_cond_broadcast(&slog_async.dispatched);
+        pthread_mutex_unlock(&slog_async.lock);
+    }
+}
+
+/*
+ * whether a position is still short of its slog_async_flush() target
+ */
+static bool slog_async_behind(const unsigned int *target)
+{
+    int pos;
+
+    for (pos = 0; pos < SLOG_ASYNC_POSITIONS; ++pos) {
+        if ((int)(target[pos] - __atomic_load_n(&slog_async.done[pos], __ATOMIC_SEQ_CST)) > 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*
+ * sleep SLOG_ASYNC_IDLE_WAIT ms, or until slog_async_flush() or
+ * slog_async_deinit() wakes the thread. A flush called since the pass
+ * began ends it at once, its logs may have come after the drain.
+ *
+ * @param wakes slog_async.wakes as the pass began
+ */
+static void slog_async_idle(unsigned int wakes)
+{
+    struct timespec deadline;
+
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_nsec += SLOG_ASYNC_IDLE_WAIT * 1000000L;
+    if (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+
+    pthread_mutex_lock(&slog_async.lock);
+    if (!slog_async.stop && (wakes == slog_async.wakes)) {
+        pthread_cond_timedwait(&slog_async.wake, &slog_async.lock, &deadline);
+    }
+    pthread_mutex_unlock(&slog_async.lock);
+}
+
 static void *async_output(void *arg)
 {
     int ret = -1;
-    uint8_t log_level;
-    size_t slog_event_buf_len, slog_format_log_len;
-    char slog_format_buf[SLOG_FORMAT_BUF_SIZE] = { 0 };
+    int stop = 0;
+    unsigned int records = 0, wakes;
+    size_t slog_event_buf_len;
     char slog_event_buf[SLOG_EVENT_BUF_MAXLEN] = { 0 };
 
     /* block sig */
@@ -66,26 +192,66 @@ static void *async_output(void *arg)
         slog_error_inner("set log output thread name to log_output error");
     }
 
-    while (1) {
-        /* gets and outputs the log */
-        while (!slog_buffer_is_empty()) {
-            memset(slog_format_buf, 0, sizeof(slog_format_buf));
+    while (!stop) {
+        /* seen before the last drain, logs put ahead of the stop are output */
+        stop = __atomic_load_n(&slog_async.stop, __ATOMIC_ACQUIRE);
+        wakes = __atomic_load_n(&slog_async.wakes, __ATOMIC_ACQUIRE);
+
+        /* gets and outputs the log, the signal handlers' ones go first */
+        while (1) {
             memset(slog_event_buf, 0, sizeof(slog_event_buf));
 
-            slog_event_buf_len = slog_buffer_get(slog_event_buf);
+            slog_event_buf_len = slog_signal_event_get(slog_event_buf);
+            if ((0 == slog_event_buf_len) && !slog_buffer_is_empty()) {
+                slog_event_buf_len = slog_buffer_get(slog_event_buf);
+                if (0 != slog_event_buf_len) {
+                    slog_quota_release(slog_event_buf);
+                }
+            }
+            /* the spilled logs once the ring drained, the ring's are older */
+            if ((0 == slog_event_buf_len) && slog_buffer_is_empty()) {
+                slog_event_buf_len = slog_spill_get(slog_event_buf);
+                if (0 != slog_event_buf_len) {
+                    slog_quota_release(slog_event_buf);
+                }
+            }
             if (0 == slog_event_buf_len) {
                 break;
             }
+            slog_stats_consumed();
 
-            slog_format_log_len = format_log(slog_format_buf, slog_event_buf);
-            if (slog_format_log_len > 0) {
-                log_level = ((slog_event_head_t*)slog_event_buf)->slog_level;
-                slog_port_output(log_level, slog_format_buf, slog_format_log_len);
+            /* a pass under steady load has no end, the flushers hear of it meanwhile */
+            if (0 == (++records % SLOG_ASYNC_THROTTLE_EVERY)) {
+                slog_async_publish();
+                slog_throttle_poll(slog_event_buf);
+                slog_quota_poll();
+                slog_stats_poll(slog_event_buf);
             }
+
+            /* a repeat of the log before it is counted only */
+            if (slog_dedup_repeat(slog_event_buf)) {
+                continue;
+            }
+
+            /* logs the flight recorder keeps are not output */
+            if (slog_flight_record(slog_event_buf)) {
+                continue;
+            }
+
+            /* formatted and written by the sinks' own threads */
+            slog_port_output(slog_event_buf);
         }
 
-        /* check every 3ms */
-        usleep(3000);
+        slog_dedup_poll(stop);
+        slog_flight_poll();
+        slog_async_publish();
+        slog_throttle_poll(NULL);
+        slog_quota_poll();
+        slog_stats_poll(NULL);
+
+        if (!stop) {
+            slog_async_idle(wakes);
+        }
     }
     return NULL;
 }
@@ -99,35 +265,107 @@ static void *async_output(void *arg)
  */
 int slog_async_init(void)
 {
-    int ret = -1;
-    pthread_t async_output_thread;
-    pthread_attr_t thread_attr;
+    int ret = -1, pos;
+    pthread_condattr_t cond_attr;
 
-    ret = pthread_attr_init(&thread_attr);
-    if (0 != ret) {
-        slog_error_inner("log output thread pthread_attr_init error: %s", strerror(ret));
-        return -1;
-    }
+    /* idle and flush deadlines are monotonic */
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&slog_async.wake, &cond_attr);
+    pthread_cond_init(&slog_async.dispatched, &cond_attr);
+    pthread_condattr_destroy(&cond_attr);
 
-    ret = pthread_attr_setdetachstate(&thread_attr, PTHREAD_CREATE_DETACHED);
-    if (0 != ret) {
-        slog_error_inner("log output thread pthread_attr_setdetachstate error: %s", strerror(ret));
-        return -1;
+    slog_async.stop = 0;
+    slog_async.flushers = 0;
+    for (pos = 0; pos < SLOG_ASYNC_POSITIONS; ++pos) {
+        slog_async.done[pos] = slog_async_out(pos);
     }
 
-    ret = pthread_create(&async_output_thread, &thread_attr, async_output, NULL);
+    /* joined by slog_async_deinit(), before the ring is freed */
+    ret = pthread_create(&slog_async.thread, NULL, async_output, NULL);
     if (0 != ret) {
         slog_error_inner("log output thread pthread_create error: %s", strerror(ret));
+        pthread_cond_destroy(&slog_async.dispatched);
+        pthread_cond_destroy(&slog_async.wake);
         return -1;
     }
 
-    ret = pthread_attr_destroy(&thread_attr);
-    if (0 != ret) {
-        slog_error_inner("log output thread pthread_attr_destroy error: %s", strerror(ret));
+    pthread_mutex_lock(&slog_async.lock);
+    slog_async.running = true;
+    pthread_mutex_unlock(&slog_async.lock);
+
+    return 0;
+}
+
+/**
+ * wait until the output thread dispatched the logs put before the call to
+ * the sinks
+ *
+ * @param deadline CLOCK_MONOTONIC time to give up at
+ *
+ * @return 0 dispatched, -1 not in time or no output thread
+ */
+int slog_async_flush(const struct timespec *deadline)
+{
+    int ret = 0, result, pos;
+    unsigned int target[SLOG_ASYNC_POSITIONS];
+
+    /* running is false once slog_async_deinit() joined the thread, the rings may be gone */
+    pthread_mutex_lock(&slog_async.lock);
+    if (!slog_async.running) {
+        pthread_mutex_unlock(&slog_async.lock);
         return -1;
     }
 
-    return 0;
+    for (pos = 0; pos < SLOG_ASYNC_POSITIONS; ++pos) {
+        target[pos] = slog_async_in(pos);
+    }
+
+    __atomic_add_fetch(&slog_async.flushers, 1, __ATOMIC_SEQ_CST);
+    __atomic_add_fetch(&slog_async.wakes, 1, __ATOMIC_RELEASE);
+    pthread_cond_signal(&slog_async.wake);
+    while (slog_async.running && slog_async_behind(target) && (ETIMEDOUT != ret)) {
+        ret = pthread_cond_timedwait(&slog_async.dispatched, &slog_async.lock, deadline);
+    }
+    result = slog_async_behind(target) ? -1 : 0;
+    __atomic_sub_fetch(&slog_async.flushers, 1, __ATOMIC_SEQ_CST);
+
+    /* slog_async_deinit() waits for the last flusher before it destroys the conds */
+    if (!slog_async.running) {
+        pthread_cond_broadcast(&slog_async.dispatched);
+    }
+    pthread_mutex_unlock(&slog_async.lock);
+
+    return result;
+}
+
+/**
+ * stop the output thread once it drained the ring, and join it
+ */
+void slog_async_deinit(void)
+{
+    pthread_mutex_lock(&slog_async.lock);
+    if (!slog_async.running) {
+        pthread_mutex_unlock(&slog_async.lock);
+        return;
+    }
+    __atomic_store_n(&slog_async.stop, 1, __ATOMIC_RELEASE);
+    pthread_cond_signal(&slog_async.wake);
+    pthread_mutex_unlock(&slog_async.lock);
+
+    pthread_join(slog_async.thread, NULL);
+
+    /* flushers still waiting give up, the last one out wakes this */
+    pthread_mutex_lock(&slog_async.lock);
+    slog_async.running = false;
+    pthread_cond_broadcast(&slog_async.dispatched);
+    while (0 != __atomic_load_n(&slog_async.flushers, __ATOMIC_SEQ_CST)) {
+        pthread_cond_wait(&slog_async.dispatched, &slog_async.lock);
+    }
+    pthread_mutex_unlock(&slog_async.lock);
+
+    pthread_cond_destroy(&slog_async.dispatched);
+    pthread_cond_destroy(&slog_async.wake);
 }
 
 
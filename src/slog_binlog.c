@@ -0,0 +1,360 @@
+
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <time.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "logger.h"
+#include "slog_event.h"
+#include "slog_crc32.h"
+#include "slog_binlog.h"
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE MACROS -------------------------------------------- */
+
+/* record bytes besides its strings: time delta, level, 3 lengths, line, message length */
+#define SLOG_BINLOG_RECORD_FIXED_MAX         (10 + 1 + 3 + 5 + 5)
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE FUNCTIONS DEFINITION ------------------------------ */
+
+static void slog_binlog_put16(char *p, uint16_t v)
+{
+    p[0] = (char)v;
+    p[1] = (char)(v >> 8);
+}
+
+static void slog_binlog_put32(char *p, uint32_t v)
+{
+    p[0] = (char)v;
+    p[1] = (char)(v >> 8);
+    p[2] = (char)(v >> 16);
+    p[3] = (char)(v >> 24);
+}
+
+static void slog_binlog_put64(char *p, uint64_t v)
+{
+    slog_binlog_put32(p, (uint32_t)v);
+    slog_binlog_put32(p + 4, (uint32_t)(v >> 32));
+}
+
+static uint16_t slog_binlog_get16(const char *p)
+{
+    const uint8_t *u = (const uint8_t *)p;
+
+    return (uint16_t)(u[0] | (u[1] << 8));
+}
+
+static uint32_t slog_binlog_get32(const char *p)
+{
+    const uint8_t *u = (const uint8_t *)p;
+
+    return (uint32_t)u[0] | ((uint32_t)u[1] << 8) | ((uint32_t)u[2] << 16) | ((uint32_t)u[3] << 24);
+}
+
+static uint64_t slog_binlog_get64(const char *p)
+{
+    return (uint64_t)slog_binlog_get32(p) | ((uint64_t)slog_binlog_get32(p + 4) << 32);
+}
+
+static char *slog_binlog_put_varint(char *p, uint64_t v)
+{
+    while (v >= 0x80) {
+        *p++ = (char)(v | 0x80);
+        v >>= 7;
+    }
+    *p++ = (char)v;
+
+    return p;
+}
+
+/*
+ * @return -1 truncated or too long
+ */
+static int slog_binlog_get_varint(const uint8_t *p, const uint8_t *end, size_t *pos, uint64_t *v)
+{
+    int shift;
+
+    *v = 0;
+    for (shift = 0; shift < 64; shift += 7) {
+        if (p + *pos >= end) {
+            return -1;
+        }
+        *v |= (uint64_t)(p[*pos] & 0x7f) << shift;
+        if (!(p[(*pos)++] & 0x80)) {
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+static int64_t slog_binlog_event_time(const slog_event_head_t *head)
+{
+    return (int64_t)head->slog_time.tv_sec * 1000000 + head->slog_time.tv_usec;
+}
+
+static uint32_t slog_binlog_crc(const char *block, const char *payload, size_t len)
+{
+    uint32_t crc = slog_crc32(0, block, 12);
+
+    crc = slog_crc32(crc, block + 16, SLOG_BINLOG_BLOCK_HEAD_SIZE - 16);
+
+    return slog_crc32(crc, payload, len);
+}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC FUNCTIONS DEFINITION ------------------------------- */
+
+/**
+ * build the file head, SLOG_BINLOG_FILE_HEAD_SIZE bytes
+ */
+void slog_binlog_file_head(char *head)
+{
+    memcpy(head, SLOG_BINLOG_MAGIC, 8);
+    slog_binlog_put16(head + 8, SLOG_BINLOG_VERSION);
+    slog_binlog_put16(head + 10, SLOG_BINLOG_FILE_HEAD_SIZE);
+    slog_binlog_put32(head + 12, 0);
+}
+
+/**
+ * check a binary log file head
+ *
+ * @return head size, -1 not a binary log file this version reads
+ */
+int slog_binlog_file_check(const char *head, size_t len)
+{
+    if ((len < SLOG_BINLOG_FILE_HEAD_SIZE) || (0 != memcmp(head, SLOG_BINLOG_MAGIC, 8))) {
+        return -1;
+    }
+
+    if ((SLOG_BINLOG_VERSION != slog_binlog_get16(head + 8)) ||
+        (slog_binlog_get16(head + 10) < SLOG_BINLOG_FILE_HEAD_SIZE)) {
+        return -1;
+    }
+
+    return slog_binlog_get16(head + 10);
+}
+
+/**
+ * encode log events into one block, as many as fit.
+ *
+ * @param block output, SLOG_BINLOG_BLOCK_HEAD_SIZE + SLOG_BINLOG_BLOCK_MAX bytes
+ * @param events one slog event per iovec
+ * @param count event count
+ * @param done events encoded, at least one
+ *
+ * @return block length
+ */
+size_t slog_binlog_block_encode(char *block, const struct iovec *events, int count, int *done)
+{
+    int i;
+    char *p = block + SLOG_BINLOG_BLOCK_HEAD_SIZE;
+    char *end = p + SLOG_BINLOG_BLOCK_MAX;
+    uint8_t level_mask = 0;
+    int64_t min_time = INT64_MAX, max_time = INT64_MIN, prev_time = 0, time_us, delta;
+    uint32_t strings_len, msg_len;
+    const slog_event_head_t *head = NULL;
+    struct tm tm;
+    time_t sec;
+
+    for (i = 0; i < count; ++i) {
+        head = (const slog_event_head_t *)events[i].iov_base;
+        strings_len = sizeof(slog_event_head_t) + head->slog_tag_len + head->slog_file_len + head->slog_func_len;
+        msg_len = (head->slog_event_length > strings_len) ? head->slog_event_length - strings_len : 0;
+
+        if ((i > 0) && ((size_t)(end - p) < SLOG_BINLOG_RECORD_FIXED_MAX + strings_len + msg_len)) {
+            break;
+        }
+
+        time_us = slog_binlog_event_time(head);
+        delta = time_us - prev_time;
+        prev_time = time_us;
+        if (time_us < min_time) {
+            min_time = time_us;
+        }
+        if (time_us > max_time) {
+            max_time = time_us;
+        }
+
+        p = slog_binlog_put_varint(p, ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63));
+        *p++ = (char)head->slog_level;
+        *p++ = (char)head->slog_tag_len;
+        *p++ = (char)head->slog_file_len;
+        *p++ = (char)head->slog_func_len;
+        p = slog_binlog_put_varint(p, head->slog_line);
+        p = slog_binlog_put_varint(p, msg_len);
+        memcpy(p, (const char *)head + sizeof(slog_event_head_t), strings_len - sizeof(slog_event_head_t) + msg_len);
+        p += strings_len - sizeof(slog_event_head_t) + msg_len;
+
+        level_mask |= (uint8_t)(1 << (head->slog_level & 7));
+    }
+    *done = i;
+
+    /* offset of the writer's zone, the decoder renders its local time */
+    sec = (time_t)(min_time / 1000000);
+    memset(&tm, 0, sizeof(tm));
+    localtime_r(&sec, &tm);
+
+    memcpy(block, SLOG_BINLOG_BLOCK_MAGIC, 4);
+    slog_binlog_put32(block + 4, (uint32_t)(p - block - SLOG_BINLOG_BLOCK_HEAD_SIZE));
+    slog_binlog_put32(block + 8, (uint32_t)i);
+    slog_binlog_put32(block + 12, 0);
+    slog_binlog_put64(block + 16, (uint64_t)min_time);
+    slog_binlog_put64(block + 24, (uint64_t)max_time);
+    slog_binlog_put32(block + 32, (uint32_t)tm.tm_gmtoff);
+    block[36] = (char)level_mask;
+    block[37] = block[38] = block[39] = 0;
+
+    slog_binlog_put32(block + 12, slog_binlog_crc(block, block + SLOG_BINLOG_BLOCK_HEAD_SIZE,
+                                                  p - block - SLOG_BINLOG_BLOCK_HEAD_SIZE));
+
+    return p - block;
+}
+
+/**
+ * parse and verify the block at data
+ *
+ * @param data file bytes from a block head
+ * @param len bytes available
+ * @param block parsed head
+ *
+ * @return block length, 0 block incomplete, -1 not a valid block
+ */
+int slog_binlog_block_parse(const char *data, size_t len, slog_binlog_block_t *block)
+{
+    if (len < SLOG_BINLOG_BLOCK_HEAD_SIZE) {
+        return 0;
+    }
+
+    if (0 != memcmp(data, SLOG_BINLOG_BLOCK_MAGIC, 4)) {
+        return -1;
+    }
+
+    block->length = slog_binlog_get32(data + 4);
+    block->count = slog_binlog_get32(data + 8);
+    block->min_time = (int64_t)slog_binlog_get64(data + 16);
+    block->max_time = (int64_t)slog_binlog_get64(data + 24);
+    block->gmtoff = (int32_t)slog_binlog_get32(data + 32);
+    block->level_mask = (uint8_t)data[36];
+    block->payload = (const uint8_t *)data + SLOG_BINLOG_BLOCK_HEAD_SIZE;
+
+    if (block->length > SLOG_BINLOG_BLOCK_MAX) {
+        return -1;
+    }
+    if (len < SLOG_BINLOG_BLOCK_HEAD_SIZE + block->length) {
+        return 0;
+    }
+
+    if (slog_binlog_get32(data + 12) != slog_binlog_crc(data, data + SLOG_BINLOG_BLOCK_HEAD_SIZE, block->length)) {
+        return -1;
+    }
+
+    return SLOG_BINLOG_BLOCK_HEAD_SIZE + block->length;
+}
+
+/**
+ * decode the next record of a block
+ *
+ * @param block parsed block
+ * @param pos payload offset, 0 for the first record
+ * @param time previous record's time, 0 for the first record
+ * @param record decoded record
+ *
+ * @return 1 decoded, 0 block end, -1 corrupt
+ */
+int slog_binlog_record_next(const slog_binlog_block_t *block, size_t *pos, int64_t *time,
+                            slog_binlog_record_t *record)
+{
+    uint64_t v;
+    size_t strings_len;
+    const uint8_t *p = block->payload;
+    const uint8_t *end = block->payload + block->length;
+
+    if (*pos >= block->length) {
+        return 0;
+    }
+
+    if (0 != slog_binlog_get_varint(p, end, pos, &v)) {
+        return -1;
+    }
+    *time += (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+    record->time = *time;
+
+    if (block->length - *pos < 4) {
+        return -1;
+    }
+    record->level = p[(*pos)++];
+    if (record->level > VERBOSE) {
+        return -1;
+    }
+    record->tag_len = p[(*pos)++];
+    record->file_len = p[(*pos)++];
+    record->func_len = p[(*pos)++];
+
+    if (0 != slog_binlog_get_varint(p, end, pos, &v)) {
+        return -1;
+    }
+    record->line = (uint32_t)v;
+
+    if ((0 != slog_binlog_get_varint(p, end, pos, &v)) || (v > SLOG_BINLOG_BLOCK_MAX)) {
+        return -1;
+    }
+    record->msg_len = (uint32_t)v;
+
+    strings_len = (size_t)record->tag_len + record->file_len + record->func_len + record->msg_len;
+    if (block->length - *pos < strings_len) {
+        return -1;
+    }
+
+    record->tag = (const char *)p + *pos;
+    record->file = record->tag + record->tag_len;
+    record->func = record->file + record->file_len;
+    record->msg = record->func + record->func_len;
+    *pos += strings_len;
+
+    return 1;
+}
+
+/**
+ * rebuild the slog event of a record, so the text formatters render it
+ *
+ * @param record decoded record
+ * @param slog_event_buf output, SLOG_EVENT_BUF_MAXLEN bytes, a longer message is cut
+ *
+ * @return event length
+ */
+size_t slog_binlog_record_event(const slog_binlog_record_t *record, char *slog_event_buf)
+{
+    slog_event_head_t *head = (slog_event_head_t *)slog_event_buf;
+    size_t len = sizeof(slog_event_head_t);
+    size_t msg_len = record->msg_len;
+    size_t strings_len = (size_t)record->tag_len + record->file_len + record->func_len;
+
+    if (len + strings_len + msg_len > SLOG_EVENT_BUF_MAXLEN) {
+        msg_len = SLOG_EVENT_BUF_MAXLEN - len - strings_len;
+    }
+
+    head->slog_level = record->level;
+    head->slog_tag_len = record->tag_len;
+    head->slog_file_len = record->file_len;
+    head->slog_func_len = record->func_len;
+    head->slog_line = record->line;
+    head->slog_time.tv_sec = (time_t)(record->time / 1000000);
+    head->slog_time.tv_usec = (suseconds_t)(record->time % 1000000);
+
+    /* tag, file, func and message are stored back to back, as in the event */
+    memcpy(slog_event_buf + len, record->tag, strings_len + msg_len);
+    len += strings_len + msg_len;
+    head->slog_event_length = (uint32_t)len;
+
+    return len;
+}
+
+
+/* ============== EOF ======================================================= */
\ No newline at end of file
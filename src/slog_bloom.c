@@ -0,0 +1,328 @@
+
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <string.h>
+
+#include "slog_crc32.h"
+#include "slog_bloom.h"
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE MACROS -------------------------------------------- */
+
+/* FNV-1a, tags and tokens hash from different bases */
+#define SLOG_BLOOM_FNV_PRIME                 0x100000001b3ULL
+#define SLOG_BLOOM_SEED_TOKEN                0xcbf29ce484222325ULL
+#define SLOG_BLOOM_SEED_TAG                  0x84222325cbf29ce4ULL
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE FUNCTIONS DEFINITION ------------------------------ */
+
+static void slog_bloom_put16(char *p, uint16_t v)
+{
+    p[0] = (char)v;
+    p[1] = (char)(v >> 8);
+}
+
+static void slog_bloom_put32(char *p, uint32_t v)
+{
+    p[0] = (char)v;
+    p[1] = (char)(v >> 8);
+    p[2] = (char)(v >> 16);
+    p[3] = (char)(v >> 24);
+}
+
+static uint16_t slog_bloom_get16(const char *p)
+{
+    const uint8_t *u = (const uint8_t *)p;
+
+    return (uint16_t)(u[0] | (u[1] << 8));
+}
+
+static uint32_t slog_bloom_get32(const char *p)
+{
+    const uint8_t *u = (const uint8_t *)p;
+
+    return (uint32_t)u[0] | ((uint32_t)u[1] << 8) | ((uint32_t)u[2] << 16) | ((uint32_t)u[3] << 24);
+}
+
+/*
+ * FNV-1a with a final mix, the filter takes bits from both halves
+ */
+static uint64_t slog_bloom_hash(const char *s, size_t len, uint64_t seed)
+{
+    size_t i;
+    uint64_t h = seed;
+
+    for (i = 0; i < len; ++i) {
+        h ^= (uint8_t)s[i];
+        h *= SLOG_BLOOM_FNV_PRIME;
+    }
+
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+
+    return h;
+}
+
+static void slog_bloom_set(uint8_t *filter, size_t size, uint64_t h)
+{
+    int i;
+    uint32_t h1 = (uint32_t)h, h2 = (uint32_t)(h >> 32) | 1;
+    uint64_t bit;
+
+    for (i = 0; i < SLOG_BLOOM_HASHES; ++i) {
+        bit = (h1 + (uint64_t)i * h2) % (size * 8);
+        filter[bit >> 3] |= (uint8_t)(1 << (bit & 7));
+    }
+}
+
+/*
+ * @return 0 the filter does not hold the hash
+ */
+static int slog_bloom_get(const uint8_t *filter, size_t size, uint64_t h)
+{
+    int i;
+    uint32_t h1 = (uint32_t)h, h2 = (uint32_t)(h >> 32) | 1;
+    uint64_t bit;
+
+    for (i = 0; i < SLOG_BLOOM_HASHES; ++i) {
+        bit = (h1 + (uint64_t)i * h2) % (size * 8);
+        if (!(filter[bit >> 3] & (1 << (bit & 7)))) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/*
+ * next token of SLOG_BLOOM_TOKEN_MIN bytes or more
+ *
+ * @return token length, 0 no more, *p moves past the token
+ */
+static size_t slog_bloom_next_token(const char **p, const char *end, const char **token)
+{
+    const char *q = *p;
+
+    while (q < end) {
+        while ((q < end) && !slog_bloom_token_char(*q)) {
+            q++;
+        }
+        *token = q;
+        while ((q < end) && slog_bloom_token_char(*q)) {
+            q++;
+        }
+        if ((size_t)(q - *token) >= SLOG_BLOOM_TOKEN_MIN) {
+            *p = q;
+            return q - *token;
+        }
+    }
+
+    *p = end;
+    return 0;
+}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC FUNCTIONS DEFINITION ------------------------------- */
+
+/**
+ * build the filters file head, SLOG_BLOOM_HEAD_SIZE bytes
+ *
+ * @param size filter bytes of each record
+ */
+void slog_bloom_head(char *head, uint32_t size)
+{
+    memcpy(head, SLOG_BLOOM_MAGIC, 8);
+    slog_bloom_put16(head + 8, SLOG_BLOOM_VERSION);
+    slog_bloom_put16(head + 10, SLOG_BLOOM_HEAD_SIZE);
+    slog_bloom_put32(head + 12, size);
+}
+
+/**
+ * check a filters file read whole, as slog_index_check()
+ *
+ * @return head size, -1 not a filters file
+ */
+int slog_bloom_check(const char *data, size_t len, size_t *count, int *final)
+{
+    size_t head, rest, record;
+
+    if ((len < SLOG_BLOOM_HEAD_SIZE) || (0 != memcmp(data, SLOG_BLOOM_MAGIC, 8)) ||
+        (SLOG_BLOOM_VERSION != slog_bloom_get16(data + 8))) {
+        return -1;
+    }
+
+    head = slog_bloom_get16(data + 10);
+    record = SLOG_BLOOM_RECORD_HEAD_SIZE + slog_bloom_get32(data + 12);
+    if ((head < SLOG_BLOOM_HEAD_SIZE) || (head > len) || (record == SLOG_BLOOM_RECORD_HEAD_SIZE)) {
+        return -1;
+    }
+
+    rest = len - head;
+    *count = rest / record;
+    *final = 0;
+
+    if ((SLOG_BLOOM_TRAILER_SIZE == rest % record) &&
+        (0 == memcmp(data + len - SLOG_BLOOM_TRAILER_SIZE, SLOG_BLOOM_TRAILER_MAGIC, 8)) &&
+        (*count == slog_bloom_get32(data + len - 8)) &&
+        (slog_crc32(0, data + head, *count * record) == slog_bloom_get32(data + len - 4))) {
+        *final = 1;
+    }
+
+    return (int)head;
+}
+
+/**
+ * encode one record, SLOG_BLOOM_RECORD_HEAD_SIZE + size bytes
+ *
+ * @param size filter bytes
+ */
+void slog_bloom_record_encode(char *data, const slog_bloom_record_t *record, size_t size)
+{
+    slog_bloom_put32(data, (uint32_t)record->offset);
+    slog_bloom_put32(data + 4, (uint32_t)(record->offset >> 32));
+    slog_bloom_put32(data + 8, record->length);
+    memset(data + 12, 0, 4);
+    data[12] = (char)record->flags;
+    memcpy(data + SLOG_BLOOM_RECORD_HEAD_SIZE, record->filter, size);
+}
+
+void slog_bloom_record_decode(const char *data, slog_bloom_record_t *record)
+{
+    record->offset = (uint64_t)slog_bloom_get32(data) | ((uint64_t)slog_bloom_get32(data + 4) << 32);
+    record->length = slog_bloom_get32(data + 8);
+    record->flags = (uint8_t)data[12];
+    record->filter = (const uint8_t *)data + SLOG_BLOOM_RECORD_HEAD_SIZE;
+}
+
+/**
+ * build the trailer of a finalized filters file, SLOG_BLOOM_TRAILER_SIZE bytes
+ */
+void slog_bloom_trailer(char *trailer, uint32_t count, uint32_t crc)
+{
+    memcpy(trailer, SLOG_BLOOM_TRAILER_MAGIC, 8);
+    slog_bloom_put32(trailer + 8, count);
+    slog_bloom_put32(trailer + 12, crc);
+}
+
+/**
+ * add the tag and message tokens of one log to a filter
+ *
+ * @param filter filter bits
+ * @param size filter bytes
+ *
+ * @return 0, -1 the message was not hashed whole
+ */
+int slog_bloom_add_log(uint8_t *filter, size_t size, const char *tag, size_t tag_len,
+                       const char *msg, size_t msg_len)
+{
+    int tokens = 0;
+    size_t len;
+    const char *p = msg, *end = msg + ((msg_len > SLOG_BLOOM_SCAN_MAX) ? SLOG_BLOOM_SCAN_MAX : msg_len);
+    const char *token = NULL;
+
+    slog_bloom_set(filter, size, slog_bloom_hash(tag, tag_len, SLOG_BLOOM_SEED_TAG));
+
+    while (0 != (len = slog_bloom_next_token(&p, end, &token))) {
+        if (SLOG_BLOOM_TOKEN_MAX == tokens++) {
+            return -1;
+        }
+        slog_bloom_set(filter, size, slog_bloom_hash(token, len, SLOG_BLOOM_SEED_TOKEN));
+    }
+
+    return (msg_len > SLOG_BLOOM_SCAN_MAX) ? -1 : 0;
+}
+
+/**
+ * check whether a record may hold logs of a tag whose message has a term,
+ * the term matched as whole tokens
+ *
+ * @param tag NULL any tag
+ * @param term NULL any message
+ *
+ * @return 0 the record has no such log, 1 it may have
+ */
+int slog_bloom_test(const slog_bloom_record_t *record, size_t size, const char *tag, size_t tag_len,
+                    const char *term, size_t term_len)
+{
+    size_t len;
+    const char *p = term, *token = NULL;
+
+    if ((NULL != tag) && !slog_bloom_get(record->filter, size, slog_bloom_hash(tag, tag_len, SLOG_BLOOM_SEED_TAG))) {
+        return 0;
+    }
+
+    if ((NULL == term) || (record->flags & SLOG_BLOOM_FLAG_PARTIAL)) {
+        return 1;
+    }
+
+    while (0 != (len = slog_bloom_next_token(&p, term + term_len, &token))) {
+        if (!slog_bloom_get(record->filter, size, slog_bloom_hash(token, len, SLOG_BLOOM_SEED_TOKEN))) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * find the parts of a segment a lookup has to read: the records that may
+ * hold the tag and term, and every range no record covers
+ *
+ * @param data filters file bytes
+ * @param len filters file length
+ * @param file_size segment size
+ * @param file_head segment bytes before the first log
+ * @param tag NULL any tag
+ * @param term NULL any message
+ * @param cb called with each range, adjacent ones merged
+ * @param arg passed to cb
+ *
+ * @return ranges found, -1 the filters do not match the segment
+ */
+int slog_bloom_select(const char *data, size_t len, uint64_t file_size, uint64_t file_head,
+                      const char *tag, size_t tag_len, const char *term, size_t term_len,
+                      slog_index_range_cb cb, void *arg)
+{
+    int head, final;
+    size_t i, count, size;
+    uint64_t pos = file_head;
+    slog_bloom_record_t record;
+    slog_index_ranges_t ranges = { .cb = cb, .arg = arg };
+
+    head = slog_bloom_check(data, len, &count, &final);
+    if (head < 0) {
+        return -1;
+    }
+    size = slog_bloom_get32(data + 12);
+
+    /* records in file order, inside the segment */
+    for (i = 0; i < count; ++i) {
+        slog_bloom_record_decode(data + head + i * (SLOG_BLOOM_RECORD_HEAD_SIZE + size), &record);
+        if ((record.offset < pos) || (record.offset + record.length > file_size)) {
+            return -1;
+        }
+        pos = record.offset + record.length;
+    }
+
+    pos = file_head;
+    for (i = 0; i < count; ++i) {
+        slog_bloom_record_decode(data + head + i * (SLOG_BLOOM_RECORD_HEAD_SIZE + size), &record);
+        slog_index_range_add(&ranges, pos, record.offset - pos);
+        if (slog_bloom_test(&record, size, tag, tag_len, term, term_len)) {
+            slog_index_range_add(&ranges, record.offset, record.length);
+        }
+        pos = record.offset + record.length;
+    }
+    slog_index_range_add(&ranges, pos, file_size - pos);
+
+    return slog_index_range_done(&ranges);
+}
+
+
+/* ============== EOF ======================================================= */
\ No newline at end of file
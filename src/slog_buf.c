@@ -3,22 +3,33 @@
 /* -------------------------------------------------------------------------- */
 /* -------------- DEPENDANCIES ---------------------------------------------- */
 
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <stddef.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
 
 #include "log2.h"
 #include "slog_buf.h"
+#include "slog_cfg.h"
 #include "slog_fifo.h"
+#include "slog_ring.h"
 #include "slog_event.h"
 #include "slog_inner.h"
+#include "slog_spill.h"
 
 
 /* -------------------------------------------------------------------------- */
 /* -------------- PRIVATE MACROS -------------------------------------------- */
 
 #define SLOG_BUF_SIZE                   (1024 * 1024 * 16)  /* 16MB */
-#define SLOG_BUF_FREE_WAIT_TIME         (1000)  /* 50ms each time, 50s total */
+
+/* us an urgent event waits for older bulk ones, beyond it goes ahead of them */
+#define SLOG_BUF_REORDER_WINDOW         (1000)  /* 1ms */
 
 
 /* -------------------------------------------------------------------------- */
@@ -28,6 +39,13 @@ typedef struct slog_buf_s {
 	char *log_buf;
 	size_t log_buf_size;
 	struct kfifo *log_fifo;
+	char *ring_map;          /* mapped BUFFER_FILE, NULL a heap ring */
+	size_t ring_map_size;
+	int ring_fd;             /* locked while mapped */
+	char ring_path[SLOG_BUFFER_FILE_MAX_LEN];
+	int frozen;              /* a fatal signal handler walks the ring, nothing is taken */
+	char *urgent_buf;        /* ERROR and ASSERT lane, NULL one lane for all */
+	struct kfifo urgent_fifo;
 } slog_buf_t;
 
 
@@ -37,6 +55,176 @@ typedef struct slog_buf_s {
 static slog_buf_t slog_buf;
 
 
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE FUNCTIONS DEFINITION ------------------------------ */
+
+/*
+ * a ring file left with unconsumed records by a crashed process
+ */
+static bool slog_buffer_ring_unconsumed(int fd)
+{
+    char head[SLOG_RING_FIFO_OFFSET + 8];
+    uint32_t in, out;
+
+    if ((sizeof(head) != pread(fd, head, sizeof(head), 0)) || (0 != memcmp(head, SLOG_RING_MAGIC, 8))) {
+        return false;
+    }
+    memcpy(&in, head + SLOG_RING_FIFO_OFFSET, 4);
+    memcpy(&out, head + SLOG_RING_FIFO_OFFSET + 4, 4);
+
+    return in != out;
+}
+
+/*
+ * open and lock the ring file, one left by a crash is moved aside for
+ * slog-recover first
+ *
+ * @return fd, -1 error
+ */
+static int slog_buffer_ring_open(const char *path)
+{
+    int fd;
+    char prev[SLOG_BUFFER_FILE_MAX_LEN + sizeof(SLOG_RING_PREV_SUFFIX)];
+
+    fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if ((-1 != fd) && (0 != flock(fd, LOCK_EX | LOCK_NB))) {
+        slog_error_inner("ring file %s is in use by another process", path);
+        close(fd);
+        return -1;
+    }
+
+    if ((-1 != fd) && slog_buffer_ring_unconsumed(fd)) {
+        snprintf(prev, sizeof(prev), "%s%s", path, SLOG_RING_PREV_SUFFIX);
+        if (0 != rename(path, prev)) {
+            slog_error_inner("rename ring file %s error: %s", path, strerror(errno));
+            close(fd);
+            return -1;
+        }
+        slog_warn_inner("ring file %s holds logs of a crashed process, moved to %s for slog-recover", path, prev);
+        close(fd);
+
+        fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if ((-1 != fd) && (0 != flock(fd, LOCK_EX | LOCK_NB))) {
+            slog_error_inner("ring file %s is in use by another process", path);
+            close(fd);
+            return -1;
+        }
+    }
+
+    if (-1 == fd) {
+        slog_error_inner("open ring file %s error: %s", path, strerror(errno));
+    }
+
+    return fd;
+}
+
+/*
+ * back the main ring with a shared mapping of the file, a crash leaves its
+ * head and records in the page cache
+ *
+ * @return result
+ */
+static int slog_buffer_ring_map(const char *path, size_t log_size)
+{
+    int fd;
+    char *map = NULL;
+    size_t map_size = SLOG_RING_HEAD_SIZE + log_size;
+
+    fd = slog_buffer_ring_open(path);
+    if (-1 == fd) {
+        return -1;
+    }
+
+    /* truncated first, the records of the last run are gone */
+    if ((0 != ftruncate(fd, 0)) || (0 != ftruncate(fd, map_size))) {
+        slog_error_inner("truncate ring file %s error: %s", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    map = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (MAP_FAILED == map) {
+        slog_error_inner("mmap ring file %s error: %s", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    slog_ring_head_set(map, (uint32_t)log_size, sizeof(slog_event_head_t));
+
+    slog_buf.ring_map = map;
+    slog_buf.ring_map_size = map_size;
+    slog_buf.ring_fd = fd;
+    snprintf(slog_buf.ring_path, sizeof(slog_buf.ring_path), "%s", path);
+
+    return 0;
+}
+
+/*
+ * the lane's fifo, NULL without it
+ */
+static struct kfifo *slog_buffer_lane(int lane)
+{
+    if (SLOG_BUFFER_LANE_URGENT == lane) {
+        return (NULL != slog_buf.urgent_buf) ? &slog_buf.urgent_fifo : NULL;
+    }
+
+    return slog_buf.log_fifo;
+}
+
+/*
+ * ERROR and ASSERT lane initialize, by the configured PRIORITY_LANE
+ */
+static int slog_buffer_urgent_init(void)
+{
+    size_t size = (size_t)slog_get_priority_lane() * 1024;
+
+    if (0 == size) {
+        return 0;
+    }
+
+    size = roundup_pow_of_two(size);
+    slog_buf.urgent_buf = (char *)calloc(1, size);
+    if (NULL == slog_buf.urgent_buf) {
+        slog_error_inner("priority lane calloc error");
+        return -1;
+    }
+
+    return kfifo_init(&slog_buf.urgent_fifo, slog_buf.urgent_buf, size);
+}
+
+/*
+ * whether the urgent lane's oldest event goes ahead of the bulk lane's, it
+ * waits for bulk events older than it within the reorder window only
+ */
+static bool slog_buffer_urgent_first(void)
+{
+    int64_t age;
+    slog_event_head_t urgent, bulk;
+
+    if ((sizeof(urgent) != kfifo_out_peek(&slog_buf.urgent_fifo, &urgent, sizeof(urgent))) ||
+        (sizeof(bulk) != kfifo_out_peek(slog_buf.log_fifo, &bulk, sizeof(bulk)))) {
+        return true;
+    }
+
+    age = ((int64_t)urgent.slog_time.tv_sec - bulk.slog_time.tv_sec) * 1000000 +
+          (urgent.slog_time.tv_usec - bulk.slog_time.tv_usec);
+
+    return (age < 0) || (age > SLOG_BUF_REORDER_WINDOW);
+}
+
+static void slog_buffer_ring_unmap(bool drained)
+{
+    munmap(slog_buf.ring_map, slog_buf.ring_map_size);
+    slog_buf.ring_map = NULL;
+
+    /* a ring file left behind means logs were lost */
+    if (drained) {
+        unlink(slog_buf.ring_path);
+    }
+    close(slog_buf.ring_fd);
+    slog_buf.ring_fd = -1;
+}
+
+
 /* -------------------------------------------------------------------------- */
 /* -------------- PUBLIC FUNCTIONS DEFINITION ------------------------------- */
 
@@ -58,6 +246,13 @@ int slog_buffer_init(void)
 	}
 	slog_buf.log_buf_size = log_size;
 
+    /* the kfifo's in and out live in the ring file's head */
+    if (('\0' != slog_get_buffer_file()[0]) && (0 == slog_buffer_ring_map(slog_get_buffer_file(), log_size))) {
+        slog_buf.log_buf = slog_buf.ring_map + SLOG_RING_HEAD_SIZE;
+        slog_buf.log_fifo = (struct kfifo *)(slog_buf.ring_map + SLOG_RING_FIFO_OFFSET);
+        return kfifo_init(slog_buf.log_fifo, slog_buf.log_buf, slog_buf.log_buf_size);
+    }
+
 	slog_buf.log_buf = (char *)calloc(1, slog_buf.log_buf_size);
     if (NULL == slog_buf.log_buf) {
 		slog_error_inner("calloc error");
@@ -71,17 +266,126 @@ int slog_buffer_init(void)
     }
 
 	result = kfifo_init(slog_buf.log_fifo, slog_buf.log_buf, slog_buf.log_buf_size);
+    if (0 == result) {
+        result = slog_buffer_urgent_init();
+    }
 
 	return result;
 }
 
-void slog_buffer_put(void *slog_event_buf)
+/*
+ * put an event into the bulk lane, as the ring lays it out
+ */
+static int slog_buffer_put_bulk(void *slog_event_buf)
+{
+    uint32_t length;
+    char record[SLOG_BUFFER_RECORD_MAXLEN];
+
+    if (NULL != slog_buf.ring_map) {
+        /* crc out of the producers' lock */
+        length = slog_buffer_record_set(record, slog_event_buf);
+        return slog_event_fifo_put_raw(slog_buf.log_fifo, record, length);
+    }
+
+    return slog_event_fifo_put(slog_buf.log_fifo, slog_event_buf);
+}
+
+/**
+ * put an event into the main ring, or the spill when it is full
+ *
+ * @return 0 put, -1 the ring is full and it is dropped
+ */
+int slog_buffer_put(void *slog_event_buf)
 {
-    slog_event_fifo_put(slog_buf.log_fifo, slog_event_buf);
+    /* ERROR and ASSERT take their lane, the bulk one when it is full */
+    if ((NULL != slog_buf.urgent_buf) && (((slog_event_head_t *)slog_event_buf)->slog_level <= ERROR) &&
+        (0 == slog_event_fifo_put(&slog_buf.urgent_fifo, slog_event_buf))) {
+        return 0;
+    }
+
+    /* while logs wait in the spill, the later ones queue up behind them */
+    if (!slog_spill_active() && (0 == slog_buffer_put_bulk(slog_event_buf))) {
+        return 0;
+    }
+
+    return slog_spill_put(slog_event_buf, slog_buffer_put_bulk);
+}
+
+/**
+ * lay an event out as the main ring holds it, framed with its crc so
+ * slog-recover can tell a whole record when the ring is a file
+ *
+ * @param record SLOG_BUFFER_RECORD_MAXLEN bytes
+ * @param slog_event_buf log event
+ *
+ * @return record bytes
+ */
+uint32_t slog_buffer_record_set(void *record, const void *slog_event_buf)
+{
+    uint32_t length = ((const slog_event_head_t *)slog_event_buf)->slog_event_length;
+
+    if (NULL != slog_buf.ring_map) {
+        slog_ring_record_set(record, slog_event_buf, length);
+        return SLOG_RING_RECORD_HEAD_SIZE + length;
+    }
+
+    memcpy(record, slog_event_buf, length);
+    return length;
+}
+
+/**
+ * the log event of a record of slog_buffer_record_set()
+ *
+ * @param record record
+ * @param size set to the record's bytes
+ */
+void *slog_buffer_record_event(void *record, uint32_t *size)
+{
+    void *slog_event_buf = (NULL != slog_buf.ring_map) ? (char *)record + SLOG_RING_RECORD_HEAD_SIZE : record;
+
+    *size = ((slog_event_head_t *)slog_event_buf)->slog_event_length +
+            ((NULL != slog_buf.ring_map) ? SLOG_RING_RECORD_HEAD_SIZE : 0);
+
+    return slog_event_buf;
+}
+
+/**
+ * put records of slog_buffer_record_set() back to back, all of them or none.
+ * While logs wait in the spill none are put, they would overtake them.
+ *
+ * @param records records
+ * @param len bytes
+ *
+ * @return 0 put, -1 no room
+ */
+int slog_buffer_put_records(const void *records, uint32_t len)
+{
+    if (slog_spill_active()) {
+        return -1;
+    }
+
+    return slog_event_fifo_put_raw(slog_buf.log_fifo, records, len);
 }
 
 size_t slog_buffer_get(void *slog_event_buf)
 {
+    char record_head[SLOG_RING_RECORD_HEAD_SIZE];
+
+    if (__atomic_load_n(&slog_buf.frozen, __ATOMIC_ACQUIRE)) {
+        return 0;
+    }
+
+    /* the urgent lane has no ring file, the bulk lane is unframed beside it */
+    if ((NULL != slog_buf.urgent_buf) && !kfifo_is_empty(&slog_buf.urgent_fifo) && slog_buffer_urgent_first()) {
+        return slog_event_fifo_get(&slog_buf.urgent_fifo, slog_event_buf);
+    }
+
+    /* the consumer skips the framing, a record was put whole */
+    if ((NULL != slog_buf.ring_map) &&
+        (SLOG_RING_RECORD_HEAD_SIZE != kfifo_out(slog_buf.log_fifo, record_head, SLOG_RING_RECORD_HEAD_SIZE))) {
+        return 0;
+    }
+
 	return slog_event_fifo_get(slog_buf.log_fifo, slog_event_buf);
 }
 
@@ -91,19 +395,108 @@ bool slog_buffer_is_empty(void)
 		return true;
 	}
 
-	return kfifo_is_empty(slog_buf.log_fifo);
+	return kfifo_is_empty(slog_buf.log_fifo) &&
+	       ((NULL == slog_buf.urgent_buf) || kfifo_is_empty(&slog_buf.urgent_fifo));
 }
 
+/**
+ * bytes of the bulk lane, for the tag quotas
+ */
+uint32_t slog_buffer_size(void)
+{
+    return (NULL == slog_buf.log_fifo) ? 0 : kfifo_size(slog_buf.log_fifo);
+}
+
+/**
+ * percent of the bulk lane in use, for the throttle
+ */
+unsigned int slog_buffer_usage(void)
+{
+    if (NULL == slog_buf.log_fifo) {
+        return 0;
+    }
+
+    return (unsigned int)((uint64_t)kfifo_len(slog_buf.log_fifo) * 100 / kfifo_size(slog_buf.log_fifo));
+}
+
+/**
+ * bytes of the bulk lane in use, for the stats
+ */
+uint32_t slog_buffer_used(void)
+{
+    return (NULL == slog_buf.log_fifo) ? 0 : kfifo_len(slog_buf.log_fifo);
+}
+
+/**
+ * lane position the producers put up to, for slog_flush()
+ *
+ * @param lane SLOG_BUFFER_LANE_xxx
+ */
+unsigned int slog_buffer_in(int lane)
+{
+    struct kfifo *fifo = slog_buffer_lane(lane);
+
+    return (NULL == fifo) ? 0 : __atomic_load_n(&fifo->kfifo.in, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * lane position the output thread took events up to
+ *
+ * @param lane SLOG_BUFFER_LANE_xxx
+ */
+unsigned int slog_buffer_out(int lane)
+{
+    struct kfifo *fifo = slog_buffer_lane(lane);
+
+    return (NULL == fifo) ? 0 : __atomic_load_n(&fifo->kfifo.out, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * stop the output thread taking events, for the fatal signal handler to
+ * walk them as they are
+ */
+void slog_buffer_freeze(void)
+{
+    __atomic_store_n(&slog_buf.frozen, 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * walk the events not output yet, without taking them out or locking, for
+ * the fatal signal handler. The lanes are merged by the events' time.
+ *
+ * @param slog_event_buf SLOG_EVENT_BUF_MAXLEN bytes each event is copied to
+ * @param walk called for each event
+ * @param arg passed to walk
+ */
+void slog_buffer_walk(void *slog_event_buf, slog_event_walk_t walk, void *arg)
+{
+    if (NULL == slog_buf.log_fifo) {
+        return;
+    }
+
+    slog_event_fifo_merge_walk(slog_buf.log_fifo, (NULL != slog_buf.ring_map) ? SLOG_RING_RECORD_HEAD_SIZE : 0,
+                               (NULL != slog_buf.urgent_buf) ? &slog_buf.urgent_fifo : NULL, 0,
+                               slog_event_buf, walk, arg);
+}
+
+/**
+ * free the ring, after slog_async_deinit() joined the output thread
+ */
 void slog_buffer_deinit(void)
 {
-    int count = 0;
+    if (NULL != slog_buf.urgent_buf) {
+        free(slog_buf.urgent_buf);
+        slog_buf.urgent_buf = NULL;
+    }
 
-	while (!slog_buffer_is_empty()) {
-		usleep(50000);
-		if (++count >= SLOG_BUF_FREE_WAIT_TIME) {
-			break;
-		}
-	}
+    if (NULL != slog_buf.ring_map) {
+        bool drained = slog_buffer_is_empty();
+
+        slog_buf.log_fifo = NULL;
+        slog_buf.log_buf = NULL;
+        slog_buffer_ring_unmap(drained);
+        return;
+    }
 
     if (NULL != slog_buf.log_buf) {
 		free(slog_buf.log_buf);
@@ -10,6 +10,7 @@
 
 #include "logger.h"
 #include "slog_cfg.h"
+#include "slog_sink.h"
 #include "slog_inner.h"
 
 
@@ -17,7 +18,7 @@
 /* -------------- PRIVATE MACROS -------------------------------------------- */
 
 #define LOG_CONF_LINE_LEN                   128
-#define LOG_CONF_VALUE_MAX                  32
+#define LOG_CONF_VALUE_MAX                  LOG_CONF_LINE_LEN
 
 
 /* -------------------------------------------------------------------------- */
@@ -39,6 +40,10 @@ static void slog_set_remote_default()
     slog_set_output_remote_socket(-1);
     memset(slog_cfg.remoter.host, 0, sizeof(slog_cfg.remoter.host) / sizeof(slog_cfg.remoter.host[0]));
     slog_set_output_remote_port(0);
+    slog_set_output_remote_mtu(SLOG_REMOTE_MTU_DEFAULT);
+    slog_set_output_remote_proto(SLOG_REMOTE_PROTO_UDP);
+    slog_set_output_remote_spool_size(SLOG_REMOTE_SPOOL_DEFAULT);
+    slog_set_output_remote_compress(SLOG_REMOTE_COMPRESS_NONE);
 }
 
 /**
@@ -51,6 +56,21 @@ static void slog_set_filter_default(void)
     slog_set_filter_kw("");
 }
 
+/**
+ * set output sinks queue policy default value
+ */
+static void slog_set_sink_default(void)
+{
+    slog_set_sink_drop_policy(SLOG_SINK_TERMINAL, SLOG_SINK_DROP_NEWEST);
+    slog_set_sink_shed_level(SLOG_SINK_TERMINAL, INFO);
+
+    slog_set_sink_drop_policy(SLOG_SINK_FILE, SLOG_SINK_DROP_NEWEST);
+    slog_set_sink_shed_level(SLOG_SINK_FILE, VERBOSE);
+
+    slog_set_sink_drop_policy(SLOG_SINK_REMOTE, SLOG_SINK_DROP_OLDEST);
+    slog_set_sink_shed_level(SLOG_SINK_REMOTE, INFO);
+}
+
 static int slog_get_config(char *ptr, char *linedata, char *result, int len)
 {
     char *tmp = NULL, *end = NULL;
@@ -60,10 +80,16 @@ static int slog_get_config(char *ptr, char *linedata, char *result, int len)
         tmp = strchr(linedata, '=');
         if (NULL != tmp) {
             end = strchr(tmp, ';');
+            if (NULL == end) {
+                return -1;
+            }
             cplen = end - tmp;
+            if (cplen > len) {
+                cplen = len;
+            }
             if (cplen != 1) {
                 strncpy(result, tmp + 1, cplen - 1);
-                result[cplen] = '\0';
+                result[cplen - 1] = '\0';
             }
             return 0;
         }
@@ -101,6 +127,74 @@ static int level_value_trans(const char *value)
     return level;
 }
 
+/*
+ * level list, as "ERROR,WARN", to a SLOG_DEDUP_LEVEL() mask
+ */
+static unsigned int level_mask_trans(const char *value)
+{
+    unsigned int mask = 0;
+    const char *level = value;
+
+    while ('\0' != *level) {
+        mask |= SLOG_DEDUP_LEVEL(level_value_trans(level));
+        level = strchr(level, ',');
+        if (NULL == level) {
+            break;
+        }
+        level++;
+    }
+
+    return mask;
+}
+
+static int drop_policy_value_trans(const char *value)
+{
+    if (!strncasecmp(value, "NEWEST", 6)) {
+        return SLOG_SINK_DROP_NEWEST;
+    } else if (!strncasecmp(value, "OLDEST", 6)) {
+        return SLOG_SINK_DROP_OLDEST;
+    }
+
+    slog_error_inner("log config parameter drop policy %s invalid, set default NEWEST.", value);
+    return SLOG_SINK_DROP_NEWEST;
+}
+
+static int file_format_value_trans(const char *value)
+{
+    if (!strncasecmp(value, "TEXT", 4)) {
+        return SLOG_FILE_FORMAT_TEXT;
+    } else if (!strncasecmp(value, "BINARY", 6)) {
+        return SLOG_FILE_FORMAT_BINARY;
+    }
+
+    slog_error_inner("log config parameter file format %s invalid, set default TEXT.", value);
+    return SLOG_FILE_FORMAT_TEXT;
+}
+
+static int remote_proto_value_trans(const char *value)
+{
+    if (!strncasecmp(value, "UDP", 3)) {
+        return SLOG_REMOTE_PROTO_UDP;
+    } else if (!strncasecmp(value, "TCP", 3)) {
+        return SLOG_REMOTE_PROTO_TCP;
+    }
+
+    slog_error_inner("log config parameter remote proto %s invalid, set default UDP.", value);
+    return SLOG_REMOTE_PROTO_UDP;
+}
+
+static int remote_compress_value_trans(const char *value)
+{
+    if (!strncasecmp(value, "NONE", 4) || '\0' == value[0]) {
+        return SLOG_REMOTE_COMPRESS_NONE;
+    } else if (!strncasecmp(value, "LZ4", 3)) {
+        return SLOG_REMOTE_COMPRESS_LZ4;
+    }
+
+    slog_error_inner("log config parameter remote compress %s invalid, set default NONE.", value);
+    return SLOG_REMOTE_COMPRESS_NONE;
+}
+
 /**
  * check parameter remote host ip address is valid or not.
  *
@@ -177,6 +271,80 @@ static int slog_config_remote_port_check(const char *value)
     return 0;
 }
 
+/**
+ * check a numeric parameter, digits only and from min to max
+ *
+ * @param value the parameter
+ * @param min lowest valid
+ * @param max highest valid
+ *
+ * @return -1 invalid, 0 valid
+ */
+static int slog_config_uint_check(const char *value, unsigned long min, unsigned long max)
+{
+    unsigned long number;
+    size_t i, len;
+
+    if (NULL == value) {
+        return -1;
+    }
+
+    /* 10 digits hold any unsigned int */
+    len = strlen(value);
+    if (len == 0 || len > 10) {
+        return -1;
+    }
+
+    for (i = 0; i < len; ++i) {
+        if (0 == isdigit(value[i])) {
+            return -1;
+        }
+    }
+
+    number = strtoul(value, NULL, 10);
+    if (number < min || number > max) {
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * parse parameter tag quota, tag:share[:rate[:sample]], share in percent
+ */
+static int slog_config_tag_quota_parse(const char *value)
+{
+    char tag[SLOG_FILTER_TAG_MAX_LEN + 1] = { 0 };
+    unsigned int share = 0, rate = 0, sample = 0;
+
+    if (sscanf(value, "%16[^:]:%u:%u:%u", tag, &share, &rate, &sample) < 2) {
+        return -1;
+    }
+
+    if (share > 100) {
+        return -1;
+    }
+
+    return slog_set_tag_quota(tag, share, rate, sample);
+}
+
+/**
+ * check parameter file index interval, 0 or from SLOG_FILE_INDEX_MIN to SLOG_FILE_INDEX_MAX
+ *
+ * @param value KB per index entry
+ * 
+ * @return -1 invalid, 0 valid
+ */
+static int slog_config_file_index_check(const char *value)
+{
+    /* 0 no index */
+    if (0 == slog_config_uint_check(value, 0, 0)) {
+        return 0;
+    }
+
+    return slog_config_uint_check(value, SLOG_FILE_INDEX_MIN, SLOG_FILE_INDEX_MAX);
+}
+
 /**
  * check parameter cpu core, only numeric is valid, range from 0 to 999
  *
@@ -239,6 +407,69 @@ bool slog_get_output_file_enabled(void)
     return slog_cfg.output_file_enabled;
 }
 
+/**
+ * set log file format, a binary file keeps the raw events for slog-decode
+ *
+ * @param format SLOG_FILE_FORMAT_TEXT or SLOG_FILE_FORMAT_BINARY
+ */
+void slog_set_output_file_format(uint8_t format)
+{
+    slog_cfg.output_file_format = format;
+}
+
+uint8_t slog_get_output_file_format(void)
+{
+    return slog_cfg.output_file_format;
+}
+
+/**
+ * set log file index interval, the file sink writes a sparse index entry
+ * beside the segment every interval KB, read by slog-index and slog-decode.
+ *
+ * @param interval KB per entry, 0 no index
+ */
+void slog_set_output_file_index(unsigned int interval)
+{
+    slog_cfg.output_file_index = interval;
+}
+
+unsigned int slog_get_output_file_index(void)
+{
+    return slog_cfg.output_file_index;
+}
+
+/**
+ * set log file bloom filters, each index entry gets a filter of the tags
+ * and message tokens it covers, for slog-grep -w and -t lookups.
+ *
+ * @param enabled needs the file index
+ */
+void slog_set_output_file_bloom(bool enabled)
+{
+    slog_cfg.output_file_bloom = enabled;
+}
+
+bool slog_get_output_file_bloom(void)
+{
+    return slog_cfg.output_file_bloom;
+}
+
+/**
+ * set log file archiving, a rotated segment is converted into a columnar
+ * archive beside it for slog-query.
+ *
+ * @param enabled converted on the file sink's thread as it rotates
+ */
+void slog_set_output_file_archive(bool enabled)
+{
+    slog_cfg.output_file_archive = enabled;
+}
+
+bool slog_get_output_file_archive(void)
+{
+    return slog_cfg.output_file_archive;
+}
+
 void slog_set_output_terminal_enabled(bool enabled)
 {
     slog_cfg.output_terminal_enabled = enabled;
@@ -346,6 +577,78 @@ unsigned int slog_get_output_remote_port(void)
     return slog_cfg.remoter.port;
 }
 
+/**
+ * set log output remote datagram size, lines are packed up to it.
+ *
+ * @param mtu datagram max bytes
+ */
+void slog_set_output_remote_mtu(unsigned int mtu)
+{
+    slog_cfg.remoter.mtu = mtu;
+}
+
+/**
+ * get log output remote datagram size.
+ */
+unsigned int slog_get_output_remote_mtu(void)
+{
+    return slog_cfg.remoter.mtu;
+}
+
+/**
+ * set log output remote transport.
+ *
+ * @param proto SLOG_REMOTE_PROTO_UDP or SLOG_REMOTE_PROTO_TCP
+ */
+void slog_set_output_remote_proto(uint8_t proto)
+{
+    slog_cfg.remoter.proto = proto;
+}
+
+/**
+ * get log output remote transport.
+ */
+uint8_t slog_get_output_remote_proto(void)
+{
+    return slog_cfg.remoter.proto;
+}
+
+/**
+ * set log output remote spool size, logs are kept in it while the tcp collector is unreachable.
+ *
+ * @param size spool max MB
+ */
+void slog_set_output_remote_spool_size(unsigned int size)
+{
+    slog_cfg.remoter.spool_size = size;
+}
+
+/**
+ * get log output remote spool size.
+ */
+unsigned int slog_get_output_remote_spool_size(void)
+{
+    return slog_cfg.remoter.spool_size;
+}
+
+/**
+ * set log output remote tcp stream compression.
+ *
+ * @param compress SLOG_REMOTE_COMPRESS_NONE or SLOG_REMOTE_COMPRESS_LZ4
+ */
+void slog_set_output_remote_compress(uint8_t compress)
+{
+    slog_cfg.remoter.compress = compress;
+}
+
+/**
+ * get log output remote tcp stream compression.
+ */
+uint8_t slog_get_output_remote_compress(void)
+{
+    return slog_cfg.remoter.compress;
+}
+
 /**
  * set log output remote socket fd.
  *
@@ -383,17 +686,326 @@ int slog_get_cpu_core(void)
     return slog_cfg.cpu_core;
 }
 
+/**
+ * set the file backing the main ring, its records outlive a crash of the
+ * process and slog-recover extracts them. Read once by log_init().
+ *
+ * @param path file in /dev/shm or on disk, empty for a heap ring
+ */
+void slog_set_buffer_file(const char *path)
+{
+    strncpy(slog_cfg.buffer_file, path, SLOG_BUFFER_FILE_MAX_LEN - 1);
+    slog_cfg.buffer_file[SLOG_BUFFER_FILE_MAX_LEN - 1] = '\0';
+}
+
+const char *slog_get_buffer_file(void)
+{
+    return slog_cfg.buffer_file;
+}
+
+/**
+ * set the flight recorder level, logs above it are not output but kept in an
+ * overwrite-oldest ring, dumped to the file sink by an ERROR or ASSERT log or
+ * slog_flight_dump(). Read once by log_init().
+ *
+ * @param level VERBOSE for no flight recorder
+ */
+void slog_set_flight_level(uint8_t level)
+{
+    slog_cfg.flight_level = level;
+}
+
+uint8_t slog_get_flight_level(void)
+{
+    return slog_cfg.flight_level;
+}
+
+/**
+ * set the flight recorder's ring size
+ *
+ * @param size MB
+ */
+void slog_set_flight_size(unsigned int size)
+{
+    slog_cfg.flight_size = size;
+}
+
+unsigned int slog_get_flight_size(void)
+{
+    return slog_cfg.flight_size;
+}
+
+/**
+ * set the history a flight recorder dump writes, older logs in its ring are
+ * discarded
+ *
+ * @param span seconds before the trigger, 0 all the ring holds
+ */
+void slog_set_flight_span(unsigned int span)
+{
+    slog_cfg.flight_span = span;
+}
+
+unsigned int slog_get_flight_span(void)
+{
+    return slog_cfg.flight_span;
+}
+
+/**
+ * set the fatal signal flush, SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT and
+ * SIGTERM write the logs not output yet to the log file before the process
+ * dies. Read once by log_init(), signals with a handler of their own are
+ * left alone.
+ *
+ * @param enabled true install the handler
+ */
+void slog_set_crash_flush(bool enabled)
+{
+    slog_cfg.crash_flush = enabled;
+}
+
+bool slog_get_crash_flush(void)
+{
+    return slog_cfg.crash_flush;
+}
+
+/**
+ * set the lane ERROR and ASSERT logs take apart from the others' main ring,
+ * a flood of lower levels neither drops them nor holds them back. Read once
+ * by log_init(), a ring kept in BUFFER_FILE has one lane.
+ *
+ * @param size KB, 0 one lane for all levels
+ */
+void slog_set_priority_lane(unsigned int size)
+{
+    slog_cfg.priority_lane = size;
+}
+
+unsigned int slog_get_priority_lane(void)
+{
+    return slog_cfg.priority_lane;
+}
+
+/**
+ * set the throttle, a filled main ring or a lagging output thread raises
+ * the filter level step by step, VERBOSE to INFO to WARN, and it comes back
+ * down once they recover. Read once by log_init().
+ *
+ * @param high ring usage percent raising the level, 0 no throttle
+ * @param low ring usage percent the level comes down below, under high, 0 half of high
+ * @param lag ms of output lag raising the level too, 0 ring usage only
+ */
+void slog_set_throttle(unsigned int high, unsigned int low, unsigned int lag)
+{
+    slog_cfg.throttle_high = high;
+    slog_cfg.throttle_low = low;
+    slog_cfg.throttle_lag = lag;
+}
+
+unsigned int slog_get_throttle_high(void)
+{
+    return slog_cfg.throttle_high;
+}
+
+unsigned int slog_get_throttle_low(void)
+{
+    return slog_cfg.throttle_low;
+}
+
+unsigned int slog_get_throttle_lag(void)
+{
+    return slog_cfg.throttle_lag;
+}
+
+/**
+ * set the collapsing of repeated logs, a log the same as the one output
+ * before it, site and message, within window ms of the first is counted
+ * only and summed up in one line. Read once by log_init().
+ *
+ * @param window ms, 0 no collapsing
+ * @param levels SLOG_DEDUP_LEVEL() of the levels collapsed
+ */
+void slog_set_dedup(unsigned int window, unsigned int levels)
+{
+    slog_cfg.dedup_window = window;
+    slog_cfg.dedup_levels = levels;
+}
+
+unsigned int slog_get_dedup_window(void)
+{
+    return slog_cfg.dedup_window;
+}
+
+unsigned int slog_get_dedup_levels(void)
+{
+    return slog_cfg.dedup_levels;
+}
+
+/**
+ * set the spill of the logs the main ring has no room for, they are
+ * appended to a file of the process's and output once the ring drained,
+ * the logs after them queue up behind them. Read once by log_init().
+ *
+ * @param size MB the file grows to, logs beyond are dropped, 0 no spill
+ */
+void slog_set_spill_size(unsigned int size)
+{
+    slog_cfg.spill_size = size;
+}
+
+unsigned int slog_get_spill_size(void)
+{
+    return slog_cfg.spill_size;
+}
+
+/**
+ * set the stats file, the output thread appends a line of slog_get_stats()
+ * to it every interval. Read once by log_init().
+ *
+ * @param interval seconds between two lines, 0 no stats file
+ */
+void slog_set_stats_interval(unsigned int interval)
+{
+    slog_cfg.stats_interval = interval;
+}
+
+unsigned int slog_get_stats_interval(void)
+{
+    return slog_cfg.stats_interval;
+}
+
+/**
+ * set the slog() calls timed into the stats' latency histogram, the library
+ * must be built with SLOG_LATENCY_STATS. Read once by log_init().
+ *
+ * @param sample one call in it is timed, 1 all, 0 none
+ */
+void slog_set_latency_sample(unsigned int sample)
+{
+    slog_cfg.latency_sample = sample;
+}
+
+unsigned int slog_get_latency_sample(void)
+{
+    return slog_cfg.latency_sample;
+}
+
+/**
+ * set a tag's quota of the main ring, its logs beyond it are dropped but
+ * one in sample, ERROR and ASSERT ones excepted. Read once by log_init().
+ *
+ * @param tag the tag as logs give it
+ * @param share percent of the main ring the tag's logs may fill, 0 no limit
+ * @param rate bytes per second, a second's worth in a burst, 0 no limit
+ * @param sample one in sample logs over the quota is kept, 0 none
+ *
+ * @return result, -1 too many tags or the tag too long
+ */
+int slog_set_tag_quota(const char *tag, unsigned int share, unsigned int rate, unsigned int sample)
+{
+    unsigned int i;
+
+    if (strlen(tag) > SLOG_FILTER_TAG_MAX_LEN) {
+        return -1;
+    }
+
+    for (i = 0; i < slog_cfg.tag_quotas; ++i) {
+        if (0 == strcmp(slog_cfg.tag_quota[i].tag, tag)) {
+            break;
+        }
+    }
+    if (SLOG_TAG_QUOTA_MAX == i) {
+        return -1;
+    }
+
+    strcpy(slog_cfg.tag_quota[i].tag, tag);
+    slog_cfg.tag_quota[i].share = share;
+    slog_cfg.tag_quota[i].rate = rate;
+    slog_cfg.tag_quota[i].sample = sample;
+    if (i == slog_cfg.tag_quotas) {
+        slog_cfg.tag_quotas++;
+    }
+
+    return 0;
+}
+
+void slog_clear_tag_quota(void)
+{
+    slog_cfg.tag_quotas = 0;
+}
+
+unsigned int slog_get_tag_quotas(void)
+{
+    return slog_cfg.tag_quotas;
+}
+
+const slog_tag_quota_t *slog_get_tag_quota(unsigned int index)
+{
+    return (index < slog_cfg.tag_quotas) ? &slog_cfg.tag_quota[index] : NULL;
+}
+
+/**
+ * set output sink's queue full policy
+ *
+ * @param sink sink index
+ * @param policy SLOG_SINK_DROP_NEWEST or SLOG_SINK_DROP_OLDEST
+ */
+void slog_set_sink_drop_policy(int sink, uint8_t policy)
+{
+    slog_cfg.sink[sink].drop_policy = policy;
+}
+
+uint8_t slog_get_sink_drop_policy(int sink)
+{
+    return slog_cfg.sink[sink].drop_policy;
+}
+
+/**
+ * set output sink's shed level, logs above it are dropped while the sink lags
+ *
+ * @param sink sink index
+ * @param level level
+ */
+void slog_set_sink_shed_level(int sink, uint8_t level)
+{
+    slog_cfg.sink[sink].shed_level = level;
+}
+
+uint8_t slog_get_sink_shed_level(int sink)
+{
+    return slog_cfg.sink[sink].shed_level;
+}
+
 void slog_set_config_default()
 {
     slog_set_output_enabled(true);
     slog_set_output_file_enabled(true);
+    slog_set_output_file_format(SLOG_FILE_FORMAT_TEXT);
+    slog_set_output_file_index(SLOG_FILE_INDEX_DEFAULT);
+    slog_set_output_file_bloom(false);
+    slog_set_output_file_archive(false);
     slog_set_output_terminal_enabled(true);
 
     slog_set_cpu_core(-1);
+    slog_set_buffer_file("");
+
+    slog_set_flight_level(VERBOSE);
+    slog_set_flight_size(SLOG_FLIGHT_SIZE_DEFAULT);
+    slog_set_flight_span(0);
+    slog_set_crash_flush(false);
+    slog_set_priority_lane(SLOG_PRIORITY_LANE_DEFAULT);
+    slog_set_throttle(SLOG_THROTTLE_HIGH_DEFAULT, SLOG_THROTTLE_LOW_DEFAULT, SLOG_THROTTLE_LAG_DEFAULT);
+    slog_set_dedup(SLOG_DEDUP_WINDOW_DEFAULT, SLOG_DEDUP_LEVELS_ALL);
+    slog_set_spill_size(SLOG_SPILL_SIZE_DEFAULT);
+    slog_set_stats_interval(SLOG_STATS_INTERVAL_DEFAULT);
+    slog_set_latency_sample(SLOG_LATENCY_SAMPLE_DEFAULT);
+    slog_clear_tag_quota();
 
     slog_set_filter_default();
 
     slog_set_remote_default();
+
+    slog_set_sink_default();
 }
 
 int slog_config_parse(void)
@@ -434,6 +1046,39 @@ int slog_config_parse(void)
             }
             slog_set_output_file_enabled(enable);
         }
+        if (0 == slog_get_config("OUTPUT_FILE_FORMAT", linedata, value, LOG_CONF_VALUE_MAX)) {
+            slog_set_output_file_format(file_format_value_trans(value));
+        }
+        if (0 == slog_get_config("OUTPUT_FILE_INDEX", linedata, value, LOG_CONF_VALUE_MAX)) {
+            if (slog_config_file_index_check(value) == 0) {
+                slog_set_output_file_index(atoi(value));
+            } else {
+                slog_error_inner("log config parameter OUTPUT_FILE_INDEX: %s invalid, set default %d.",
+                                 value, SLOG_FILE_INDEX_DEFAULT);
+            }
+        }
+        if (0 == slog_get_config("OUTPUT_FILE_BLOOM", linedata, value, LOG_CONF_VALUE_MAX)) {
+            if (0 == strncasecmp(value, "false", 5)) {
+                enable = 0;
+            } else if (0 == strncasecmp(value, "true", 4)) {
+                enable = 1;
+            } else {
+                slog_error_inner("log config get parameter OUTPUT_FILE_BLOOM error, set default false.");
+                enable = 0;
+            }
+            slog_set_output_file_bloom(enable);
+        }
+        if (0 == slog_get_config("OUTPUT_FILE_ARCHIVE", linedata, value, LOG_CONF_VALUE_MAX)) {
+            if (0 == strncasecmp(value, "false", 5)) {
+                enable = 0;
+            } else if (0 == strncasecmp(value, "true", 4)) {
+                enable = 1;
+            } else {
+                slog_error_inner("log config get parameter OUTPUT_FILE_ARCHIVE error, set default false.");
+                enable = 0;
+            }
+            slog_set_output_file_archive(enable);
+        }
         if (0 == slog_get_config("OUTPUT_TERMINAL_ENABLE", linedata, value, LOG_CONF_VALUE_MAX)) {
             if (0 == strncasecmp(value, "false", 5)) {
                 enable = 0;
@@ -445,6 +1090,118 @@ int slog_config_parse(void)
             }
             slog_set_output_terminal_enabled(enable);
         }
+        if (0 == slog_get_config("BUFFER_FILE", linedata, value, LOG_CONF_VALUE_MAX)) {
+            if (strlen(value) >= SLOG_BUFFER_FILE_MAX_LEN) {
+                slog_error_inner("log config parameter BUFFER_FILE is too long, use a heap ring.");
+                value[0] = '\0';
+            }
+            slog_set_buffer_file(value);
+        }
+        // flight recorder setting
+        if (0 == slog_get_config("FLIGHT_LEVEL", linedata, value, LOG_CONF_VALUE_MAX)) {
+            slog_set_flight_level(level_value_trans(value));
+        }
+        if (0 == slog_get_config("FLIGHT_SIZE", linedata, value, LOG_CONF_VALUE_MAX)) {
+            if (slog_config_uint_check(value, 1, SLOG_FLIGHT_SIZE_MAX) == 0) {
+                slog_set_flight_size(atoi(value));
+            } else {
+                slog_error_inner("log config parameter FLIGHT_SIZE: %s invalid, set default %d.",
+                                 value, SLOG_FLIGHT_SIZE_DEFAULT);
+            }
+        }
+        if (0 == slog_get_config("FLIGHT_SPAN", linedata, value, LOG_CONF_VALUE_MAX)) {
+            if (slog_config_uint_check(value, 0, SLOG_FLIGHT_SPAN_MAX) == 0) {
+                slog_set_flight_span(atoi(value));
+            } else {
+                slog_error_inner("log config parameter FLIGHT_SPAN: %s invalid, dump all the ring holds.", value);
+            }
+        }
+        if (0 == slog_get_config("CRASH_FLUSH", linedata, value, LOG_CONF_VALUE_MAX)) {
+            if (0 == strncasecmp(value, "false", 5)) {
+                enable = 0;
+            } else if (0 == strncasecmp(value, "true", 4)) {
+                enable = 1;
+            } else {
+                slog_error_inner("log config get parameter CRASH_FLUSH error, set default false.");
+                enable = 0;
+            }
+            slog_set_crash_flush(enable);
+        }
+        if (0 == slog_get_config("PRIORITY_LANE", linedata, value, LOG_CONF_VALUE_MAX)) {
+            if (slog_config_uint_check(value, 0, SLOG_PRIORITY_LANE_MAX) == 0) {
+                slog_set_priority_lane(atoi(value));
+            } else {
+                slog_error_inner("log config parameter PRIORITY_LANE: %s invalid, set default %d.",
+                                 value, SLOG_PRIORITY_LANE_DEFAULT);
+            }
+        }
+        // throttle setting
+        if (0 == slog_get_config("THROTTLE_HIGH", linedata, value, LOG_CONF_VALUE_MAX)) {
+            if (slog_config_uint_check(value, 0, 100) == 0) {
+                slog_set_throttle(atoi(value), slog_get_throttle_low(), slog_get_throttle_lag());
+            } else {
+                slog_error_inner("log config parameter THROTTLE_HIGH: %s invalid, set default %d.",
+                                 value, SLOG_THROTTLE_HIGH_DEFAULT);
+            }
+        }
+        if (0 == slog_get_config("THROTTLE_LOW", linedata, value, LOG_CONF_VALUE_MAX)) {
+            if (slog_config_uint_check(value, 0, 100) == 0) {
+                slog_set_throttle(slog_get_throttle_high(), atoi(value), slog_get_throttle_lag());
+            } else {
+                slog_error_inner("log config parameter THROTTLE_LOW: %s invalid, set default %d.",
+                                 value, SLOG_THROTTLE_LOW_DEFAULT);
+            }
+        }
+        if (0 == slog_get_config("THROTTLE_LAG", linedata, value, LOG_CONF_VALUE_MAX)) {
+            if (0 == slog_config_uint_check(value, 0, SLOG_THROTTLE_LAG_MAX)) {
+                slog_set_throttle(slog_get_throttle_high(), slog_get_throttle_low(), atoi(value));
+            } else {
+                slog_error_inner("log config parameter THROTTLE_LAG: %s invalid, set default %d.",
+                                 value, SLOG_THROTTLE_LAG_DEFAULT);
+            }
+        }
+        // repeated log setting
+        if (0 == slog_get_config("DEDUP_WINDOW", linedata, value, LOG_CONF_VALUE_MAX)) {
+            if (0 == slog_config_uint_check(value, 0, SLOG_DEDUP_WINDOW_MAX)) {
+                slog_set_dedup(atoi(value), slog_get_dedup_levels());
+            } else {
+                slog_error_inner("log config parameter DEDUP_WINDOW: %s invalid, set default %d.",
+                                 value, SLOG_DEDUP_WINDOW_DEFAULT);
+            }
+        }
+        if (0 == slog_get_config("DEDUP_LEVELS", linedata, value, LOG_CONF_VALUE_MAX)) {
+            slog_set_dedup(slog_get_dedup_window(), level_mask_trans(value));
+        }
+        if (0 == slog_get_config("SPILL_SIZE", linedata, value, LOG_CONF_VALUE_MAX)) {
+            if (slog_config_uint_check(value, 0, SLOG_SPILL_SIZE_MAX) == 0) {
+                slog_set_spill_size(atoi(value));
+            } else {
+                slog_error_inner("log config parameter SPILL_SIZE: %s invalid, set default %d.",
+                                 value, SLOG_SPILL_SIZE_DEFAULT);
+            }
+        }
+        if (0 == slog_get_config("STATS_INTERVAL", linedata, value, LOG_CONF_VALUE_MAX)) {
+            if (slog_config_uint_check(value, 0, SLOG_STATS_INTERVAL_MAX) == 0) {
+                slog_set_stats_interval(atoi(value));
+            } else {
+                slog_error_inner("log config parameter STATS_INTERVAL: %s invalid, set default %d.",
+                                 value, SLOG_STATS_INTERVAL_DEFAULT);
+            }
+        }
+        if (0 == slog_get_config("LATENCY_SAMPLE", linedata, value, LOG_CONF_VALUE_MAX)) {
+            if (slog_config_uint_check(value, 0, SLOG_LATENCY_SAMPLE_MAX) == 0) {
+                slog_set_latency_sample(atoi(value));
+            } else {
+                slog_error_inner("log config parameter LATENCY_SAMPLE: %s invalid, set default %d.",
+                                 value, SLOG_LATENCY_SAMPLE_DEFAULT);
+            }
+        }
+        // a line per tag with a quota
+        if (0 == slog_get_config("TAG_QUOTA", linedata, value, LOG_CONF_VALUE_MAX)) {
+            if ((strlen(value) != 0) && (slog_config_tag_quota_parse(value) != 0)) {
+                slog_error_inner("log config parameter TAG_QUOTA: %s invalid, the tag has no quota.", value);
+            }
+        }
         // filter setting
         if (0 == slog_get_config("FILTER_KEYWORD", linedata, value, LOG_CONF_VALUE_MAX)) {
             if (strlen(value) > SLOG_FILTER_KW_MAX_LEN) {
@@ -500,6 +1257,47 @@ int slog_config_parse(void)
                 slog_set_output_remote_enabled(false);
             }
         }
+        if (0 == slog_get_config("OUTPUT_REMOTE_MTU", linedata, value, LOG_CONF_VALUE_MAX)) {
+            if (slog_config_uint_check(value, SLOG_REMOTE_MTU_MIN, SLOG_REMOTE_MTU_MAX) == 0) {
+                slog_set_output_remote_mtu(atoi(value));
+            } else {
+                slog_error_inner("log config parameter OUTPUT_REMOTE_MTU: %s invalid, set default %d.",
+                                 value, SLOG_REMOTE_MTU_DEFAULT);
+            }
+        }
+        if (0 == slog_get_config("OUTPUT_REMOTE_PROTO", linedata, value, LOG_CONF_VALUE_MAX)) {
+            slog_set_output_remote_proto(remote_proto_value_trans(value));
+        }
+        if (0 == slog_get_config("OUTPUT_REMOTE_COMPRESS", linedata, value, LOG_CONF_VALUE_MAX)) {
+            slog_set_output_remote_compress(remote_compress_value_trans(value));
+        }
+        if (0 == slog_get_config("OUTPUT_REMOTE_SPOOL", linedata, value, LOG_CONF_VALUE_MAX)) {
+            if (slog_config_uint_check(value, 1, SLOG_REMOTE_SPOOL_MAX) == 0) {
+                slog_set_output_remote_spool_size(atoi(value));
+            } else {
+                slog_error_inner("log config parameter OUTPUT_REMOTE_SPOOL: %s invalid, set default %d.",
+                                 value, SLOG_REMOTE_SPOOL_DEFAULT);
+            }
+        }
+        // sink queue setting
+        if (0 == slog_get_config("OUTPUT_TERMINAL_DROP", linedata, value, LOG_CONF_VALUE_MAX)) {
+            slog_set_sink_drop_policy(SLOG_SINK_TERMINAL, drop_policy_value_trans(value));
+        }
+        if (0 == slog_get_config("OUTPUT_TERMINAL_SHED_LEVEL", linedata, value, LOG_CONF_VALUE_MAX)) {
+            slog_set_sink_shed_level(SLOG_SINK_TERMINAL, level_value_trans(value));
+        }
+        if (0 == slog_get_config("OUTPUT_FILE_DROP", linedata, value, LOG_CONF_VALUE_MAX)) {
+            slog_set_sink_drop_policy(SLOG_SINK_FILE, drop_policy_value_trans(value));
+        }
+        if (0 == slog_get_config("OUTPUT_FILE_SHED_LEVEL", linedata, value, LOG_CONF_VALUE_MAX)) {
+            slog_set_sink_shed_level(SLOG_SINK_FILE, level_value_trans(value));
+        }
+        if (0 == slog_get_config("OUTPUT_REMOTE_DROP", linedata, value, LOG_CONF_VALUE_MAX)) {
+            slog_set_sink_drop_policy(SLOG_SINK_REMOTE, drop_policy_value_trans(value));
+        }
+        if (0 == slog_get_config("OUTPUT_REMOTE_SHED_LEVEL", linedata, value, LOG_CONF_VALUE_MAX)) {
+            slog_set_sink_shed_level(SLOG_SINK_REMOTE, level_value_trans(value));
+        }
     }
 
     if (fp) {
@@ -0,0 +1,939 @@
+
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "logger.h"
+#include "slog_crc32.h"
+#include "slog_binlog.h"
+#include "slog_column.h"
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE MACROS -------------------------------------------- */
+
+/* hash slots of a dictionary being written */
+#define SLOG_COLUMN_DICT_SLOTS               (2 * SLOG_COLUMN_DICT_MAX)
+
+/* site dictionary entry at most: 2 lengths, file, func, line */
+#define SLOG_COLUMN_SITE_MAX                 (2 + 255 + 255 + 5)
+
+/* stored bytes of one column at most, a frame head per SLOG_LZ_BLOCK_MAX raw bytes */
+#define SLOG_COLUMN_STORED_MAX               (SLOG_COLUMN_RAW_MAX + \
+                                              (SLOG_COLUMN_RAW_MAX / SLOG_LZ_BLOCK_MAX + 1) * SLOG_LZ_HEAD_SIZE)
+
+/*
+ * format_log() line: '[' time "] " level column "| " tag " (" file ' ' func
+ * ':' line ") " message, the time "YYYY-MM-DD HH:MM:SS.uuuuuu" is fixed width
+ * and the level column is padded to 7
+ */
+#define SLOG_COLUMN_TEXT_TIME_LEN            26
+#define SLOG_COLUMN_TEXT_LEVEL               (SLOG_COLUMN_TEXT_TIME_LEN + 3)
+#define SLOG_COLUMN_TEXT_TAG                 (SLOG_COLUMN_TEXT_LEVEL + 9)
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE TYPES --------------------------------------------- */
+
+/* growing column of the group being written */
+typedef struct slog_column_buf_s {
+    char *data;
+    size_t len;
+    size_t cap;
+} slog_column_buf_t;
+
+/* dictionary being written, entry i is its column [offset[i], offset[i + 1]) */
+typedef struct slog_column_keys_s {
+    uint32_t slot[SLOG_COLUMN_DICT_SLOTS];   /* entry id + 1, 0 empty */
+    uint32_t offset[SLOG_COLUMN_DICT_MAX + 1];
+    uint32_t count;
+} slog_column_keys_t;
+
+/* archive being written, one group at a time */
+typedef struct slog_column_writer_s {
+    FILE *fp;
+    int failed;                              /* out of memory or write error */
+    slog_column_buf_t col[SLOG_COLUMN_COUNT];
+    slog_column_buf_t out;                   /* stored columns of the group */
+    slog_column_keys_t tags;
+    slog_column_keys_t sites;
+    uint32_t rows;
+    int32_t gmtoff;
+    int64_t min_time;
+    int64_t max_time;
+    int64_t last_time;
+    uint8_t level_mask;
+    char minute[16];                         /* text time cache, "YYYY-MM-DD HH:MM" */
+    int64_t minute_sec;
+    int32_t minute_gmtoff;
+    slog_lz_t lz;
+    char frame[SLOG_LZ_FRAME_MAX];
+} slog_column_writer_t;
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE VARIABLES ----------------------------------------- */
+
+/* level columns of text lines */
+static const char *level_column[] = {
+        [ASSERT]  = "ASSERT",
+        [ERROR]   = "ERROR ",
+        [WARN]    = "WARN  ",
+        [INFO]    = "INFO  ",
+        [DEBUG]   = "DEBUG ",
+        [VERBOSE] = "VERBOSE",
+};
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE FUNCTIONS DEFINITION ------------------------------ */
+
+static void slog_column_put16(char *p, uint16_t v)
+{
+    p[0] = (char)v;
+    p[1] = (char)(v >> 8);
+}
+
+static void slog_column_put32(char *p, uint32_t v)
+{
+    p[0] = (char)v;
+    p[1] = (char)(v >> 8);
+    p[2] = (char)(v >> 16);
+    p[3] = (char)(v >> 24);
+}
+
+static void slog_column_put64(char *p, uint64_t v)
+{
+    slog_column_put32(p, (uint32_t)v);
+    slog_column_put32(p + 4, (uint32_t)(v >> 32));
+}
+
+static uint16_t slog_column_get16(const char *p)
+{
+    const uint8_t *u = (const uint8_t *)p;
+
+    return (uint16_t)(u[0] | (u[1] << 8));
+}
+
+static uint32_t slog_column_get32(const char *p)
+{
+    const uint8_t *u = (const uint8_t *)p;
+
+    return (uint32_t)u[0] | ((uint32_t)u[1] << 8) | ((uint32_t)u[2] << 16) | ((uint32_t)u[3] << 24);
+}
+
+static uint64_t slog_column_get64(const char *p)
+{
+    return (uint64_t)slog_column_get32(p) | ((uint64_t)slog_column_get32(p + 4) << 32);
+}
+
+static char *slog_column_put_varint(char *p, uint64_t v)
+{
+    while (v >= 0x80) {
+        *p++ = (char)(v | 0x80);
+        v >>= 7;
+    }
+    *p++ = (char)v;
+
+    return p;
+}
+
+/*
+ * @return -1 truncated or too long
+ */
+static int slog_column_get_varint(const char *data, size_t len, size_t *pos, uint64_t *v)
+{
+    int shift;
+    const uint8_t *p = (const uint8_t *)data;
+
+    *v = 0;
+    for (shift = 0; shift < 64; shift += 7) {
+        if (*pos >= len) {
+            return -1;
+        }
+        *v |= (uint64_t)(p[*pos] & 0x7f) << shift;
+        if (!(p[(*pos)++] & 0x80)) {
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+static uint32_t slog_column_crc(const char *head, const char *columns, size_t len)
+{
+    uint32_t crc = slog_crc32(0, head, 8);
+
+    crc = slog_crc32(crc, head + 12, SLOG_COLUMN_GROUP_HEAD_SIZE - 12);
+
+    return slog_crc32(crc, columns, len);
+}
+
+static void slog_column_append(slog_column_writer_t *w, slog_column_buf_t *buf, const void *data, size_t len)
+{
+    size_t cap = buf->cap ? buf->cap : 4096;
+    char *grown = NULL;
+
+    if (buf->len + len > buf->cap) {
+        while (cap < buf->len + len) {
+            cap *= 2;
+        }
+        grown = (char *)realloc(buf->data, cap);
+        if (NULL == grown) {
+            w->failed = 1;
+            return;
+        }
+        buf->data = grown;
+        buf->cap = cap;
+    }
+
+    memcpy(buf->data + buf->len, data, len);
+    buf->len += len;
+}
+
+static void slog_column_append_varint(slog_column_writer_t *w, slog_column_buf_t *buf, uint64_t v)
+{
+    char tmp[10];
+
+    slog_column_append(w, buf, tmp, slog_column_put_varint(tmp, v) - tmp);
+}
+
+/*
+ * @return id of a dictionary entry, added when it is new
+ */
+static uint32_t slog_column_key_id(slog_column_writer_t *w, slog_column_keys_t *keys, slog_column_buf_t *dict,
+                                   const char *key, size_t len)
+{
+    size_t i;
+    uint32_t id, hash = 2166136261U;
+
+    for (i = 0; i < len; ++i) {
+        hash = (hash ^ (uint8_t)key[i]) * 16777619U;
+    }
+
+    for (i = hash % SLOG_COLUMN_DICT_SLOTS; 0 != keys->slot[i]; i = (i + 1) % SLOG_COLUMN_DICT_SLOTS) {
+        id = keys->slot[i] - 1;
+        if ((keys->offset[id + 1] - keys->offset[id] == len) && (0 == memcmp(dict->data + keys->offset[id], key, len))) {
+            return id;
+        }
+    }
+
+    /* the group is closed before a dictionary fills */
+    id = keys->count++;
+    keys->slot[i] = id + 1;
+    slog_column_append(w, dict, key, len);
+    keys->offset[id + 1] = (uint32_t)dict->len;
+
+    return id;
+}
+
+/*
+ * compress one column of the group into out, SLOG_LZ_BLOCK_MAX raw bytes
+ * per frame
+ *
+ * @return stored length
+ */
+static uint32_t slog_column_encode(slog_column_writer_t *w, const slog_column_buf_t *buf)
+{
+    int ret;
+    size_t pos = 0, start = w->out.len;
+    struct iovec iov;
+
+    slog_lz_reset(&w->lz);
+    while (pos < buf->len) {
+        iov.iov_base = buf->data + pos;
+        iov.iov_len = (buf->len - pos > SLOG_LZ_BLOCK_MAX) ? SLOG_LZ_BLOCK_MAX : buf->len - pos;
+
+        ret = slog_lz_frame_encode(&w->lz, &iov, 1, w->frame);
+        if (ret < 0) {
+            w->failed = 1;
+            break;
+        }
+        slog_column_append(w, &w->out, w->frame, ret);
+        pos += iov.iov_len;
+    }
+
+    return (uint32_t)(w->out.len - start);
+}
+
+/*
+ * write the group being filled and start a new one
+ */
+static void slog_column_flush(slog_column_writer_t *w)
+{
+    int i;
+    char head[SLOG_COLUMN_GROUP_HEAD_SIZE];
+
+    if (0 == w->rows) {
+        return;
+    }
+
+    memset(head, 0, sizeof(head));
+    memcpy(head, SLOG_COLUMN_GROUP_MAGIC, 4);
+    slog_column_put32(head + 4, w->rows);
+    slog_column_put32(head + 12, (uint32_t)w->gmtoff);
+    slog_column_put64(head + 16, (uint64_t)w->min_time);
+    slog_column_put64(head + 24, (uint64_t)w->max_time);
+    head[32] = (char)w->level_mask;
+
+    w->out.len = 0;
+    for (i = 0; i < SLOG_COLUMN_COUNT; ++i) {
+        slog_column_put32(head + 40 + i * 8, slog_column_encode(w, &w->col[i]));
+        slog_column_put32(head + 44 + i * 8, (uint32_t)w->col[i].len);
+        w->col[i].len = 0;
+    }
+    slog_column_put32(head + 8, slog_column_crc(head, w->out.data, w->out.len));
+
+    if (!w->failed && ((1 != fwrite(head, sizeof(head), 1, w->fp)) ||
+                       ((w->out.len > 0) && (1 != fwrite(w->out.data, w->out.len, 1, w->fp))))) {
+        w->failed = 1;
+    }
+
+    memset(w->tags.slot, 0, sizeof(w->tags.slot));
+    memset(w->sites.slot, 0, sizeof(w->sites.slot));
+    w->tags.count = 0;
+    w->sites.count = 0;
+    w->rows = 0;
+}
+
+static void slog_column_add(slog_column_writer_t *w, const slog_binlog_record_t *record, int32_t gmtoff)
+{
+    char key[SLOG_COLUMN_SITE_MAX], *p = key;
+    uint32_t msg_len = (record->msg_len > SLOG_COLUMN_MSG_MAX) ? SLOG_COLUMN_MSG_MAX : record->msg_len;
+    int64_t delta;
+
+    if ((w->rows > 0) &&
+        ((w->rows == SLOG_COLUMN_GROUP_ROWS) || (gmtoff != w->gmtoff) ||
+         (w->col[SLOG_COLUMN_MSG].len + msg_len > SLOG_COLUMN_GROUP_BYTES) ||
+         (w->tags.count == SLOG_COLUMN_DICT_MAX) || (w->sites.count == SLOG_COLUMN_DICT_MAX))) {
+        slog_column_flush(w);
+    }
+
+    if (0 == w->rows) {
+        w->gmtoff = gmtoff;
+        w->min_time = INT64_MAX;
+        w->max_time = INT64_MIN;
+        w->last_time = 0;
+        w->level_mask = 0;
+        w->tags.offset[0] = 0;
+        w->sites.offset[0] = 0;
+    }
+
+    w->min_time = (record->time < w->min_time) ? record->time : w->min_time;
+    w->max_time = (record->time > w->max_time) ? record->time : w->max_time;
+    w->level_mask |= (uint8_t)(1 << record->level);
+
+    delta = record->time - w->last_time;
+    slog_column_append_varint(w, &w->col[SLOG_COLUMN_TIME], ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63));
+    w->last_time = record->time;
+
+    slog_column_append(w, &w->col[SLOG_COLUMN_LEVEL], &record->level, 1);
+
+    /* dictionary keys are the entries as stored */
+    *p++ = (char)record->tag_len;
+    memcpy(p, record->tag, record->tag_len);
+    p += record->tag_len;
+    slog_column_append_varint(w, &w->col[SLOG_COLUMN_TAG],
+                              slog_column_key_id(w, &w->tags, &w->col[SLOG_COLUMN_TAG_DICT], key, p - key));
+
+    p = key;
+    *p++ = (char)record->file_len;
+    memcpy(p, record->file, record->file_len);
+    p += record->file_len;
+    *p++ = (char)record->func_len;
+    memcpy(p, record->func, record->func_len);
+    p += record->func_len;
+    p = slog_column_put_varint(p, record->line);
+    slog_column_append_varint(w, &w->col[SLOG_COLUMN_SITE],
+                              slog_column_key_id(w, &w->sites, &w->col[SLOG_COLUMN_SITE_DICT], key, p - key));
+
+    slog_column_append_varint(w, &w->col[SLOG_COLUMN_MSG_LEN], msg_len);
+    slog_column_append(w, &w->col[SLOG_COLUMN_MSG], record->msg, msg_len);
+
+    w->rows++;
+}
+
+/*
+ * @return 1 a head line in format_log() layout, 0 a continuation line
+ */
+static int slog_column_text_head(const char *p, const char *end)
+{
+    return (end - p > SLOG_COLUMN_TEXT_TAG) && ('[' == p[0]) && (']' == p[SLOG_COLUMN_TEXT_TIME_LEN + 1]) &&
+           ('|' == p[SLOG_COLUMN_TEXT_LEVEL + 7]);
+}
+
+/*
+ * @return end of the log starting at p, its continuation lines included
+ */
+static const char *slog_column_text_end(const char *p, const char *end)
+{
+    const char *eol = NULL;
+
+    do {
+        eol = memchr(p, '\n', end - p);
+        p = (NULL == eol) ? end : eol + 1;
+    } while ((p < end) && !slog_column_text_head(p, end));
+
+    return p;
+}
+
+static int slog_column_digits(const char *p, int n)
+{
+    int v = 0;
+
+    while (n-- > 0) {
+        if ((*p < '0') || (*p > '9')) {
+            return -1;
+        }
+        v = v * 10 + (*p++ - '0');
+    }
+
+    return v;
+}
+
+/*
+ * parse the local time of a head line, mktime() once per minute
+ *
+ * @return -1 invalid
+ */
+static int slog_column_text_time(slog_column_writer_t *w, const char *p, int64_t *time, int32_t *gmtoff)
+{
+    struct tm tm;
+    time_t sec;
+    int usec = slog_column_digits(p + 20, 6), second = slog_column_digits(p + 17, 2);
+
+    if ((usec < 0) || (second < 0)) {
+        return -1;
+    }
+
+    if (0 != memcmp(p, w->minute, sizeof(w->minute))) {
+        memset(&tm, 0, sizeof(tm));
+        tm.tm_year = slog_column_digits(p, 4) - 1900;
+        tm.tm_mon = slog_column_digits(p + 5, 2) - 1;
+        tm.tm_mday = slog_column_digits(p + 8, 2);
+        tm.tm_hour = slog_column_digits(p + 11, 2);
+        tm.tm_min = slog_column_digits(p + 14, 2);
+        if ((tm.tm_year < 0) || (tm.tm_mon < 0) || (tm.tm_mday < 0) || (tm.tm_hour < 0) || (tm.tm_min < 0)) {
+            return -1;
+        }
+        tm.tm_isdst = -1;
+
+        sec = mktime(&tm);
+        if ((time_t)-1 == sec) {
+            return -1;
+        }
+        memcpy(w->minute, p, sizeof(w->minute));
+        w->minute_sec = sec;
+        w->minute_gmtoff = (int32_t)tm.tm_gmtoff;
+    }
+
+    *time = (w->minute_sec + second) * 1000000 + usec;
+    *gmtoff = w->minute_gmtoff;
+
+    return 0;
+}
+
+/*
+ * parse one text log into a record, its message without the last newline
+ *
+ * @return -1 not a log of format_log() layout
+ */
+static int slog_column_text_log(slog_column_writer_t *w, const char *p, const char *end, slog_binlog_record_t *record,
+                                int32_t *gmtoff)
+{
+    int i;
+    const char *q = p + SLOG_COLUMN_TEXT_TAG, *eol = memchr(q, '\n', end - q);
+    const char *paren = NULL, *space = NULL, *close = NULL, *colon = NULL;
+
+    memset(record, 0, sizeof(slog_binlog_record_t));
+    record->level = 0xff;
+    for (i = ASSERT; i <= VERBOSE; ++i) {
+        if (0 == memcmp(p + SLOG_COLUMN_TEXT_LEVEL, level_column[i], strlen(level_column[i]))) {
+            record->level = (uint8_t)i;
+            break;
+        }
+    }
+    if ((0xff == record->level) || (0 != slog_column_text_time(w, p + 1, &record->time, gmtoff))) {
+        return -1;
+    }
+
+    eol = (NULL == eol) ? end : eol;
+    paren = memmem(q, eol - q, " (", 2);
+    if ((NULL == paren) || (paren - q > 255)) {
+        return -1;
+    }
+    record->tag = q;
+    record->tag_len = (uint8_t)(paren - q);
+
+    paren += 2;
+    space = memchr(paren, ' ', eol - paren);
+    close = (NULL == space) ? NULL : memmem(space, eol - space, ") ", 2);
+    colon = (NULL == close) ? NULL : memrchr(space, ':', close - space);
+    if ((NULL == colon) || (space - paren > 255) || (colon - space - 1 > 255)) {
+        return -1;
+    }
+    record->file = paren;
+    record->file_len = (uint8_t)(space - paren);
+    record->func = space + 1;
+    record->func_len = (uint8_t)(colon - space - 1);
+    record->line = (uint32_t)strtoul(colon + 1, NULL, 10);
+
+    record->msg = close + 2;
+    record->msg_len = (uint32_t)(end - record->msg);
+    if ((record->msg_len > 0) && ('\n' == end[-1])) {
+        record->msg_len--;
+    }
+
+    return 0;
+}
+
+static void slog_column_convert_text(slog_column_writer_t *w, const char *data, size_t size)
+{
+    int32_t gmtoff;
+    const char *p = data, *end = data + size, *next = NULL;
+    slog_binlog_record_t record;
+
+    /* lines before the first head line belong to a log of the segment before */
+    if (!slog_column_text_head(p, end)) {
+        p = slog_column_text_end(p, end);
+    }
+
+    while (p < end) {
+        next = slog_column_text_end(p, end);
+        if (0 == slog_column_text_log(w, p, next, &record, &gmtoff)) {
+            slog_column_add(w, &record, gmtoff);
+        }
+        p = next;
+    }
+}
+
+static void slog_column_convert_binary(slog_column_writer_t *w, const char *data, size_t size, size_t pos)
+{
+    int ret;
+    size_t rpos;
+    int64_t time;
+    const char *next = NULL;
+    slog_binlog_block_t block;
+    slog_binlog_record_t record;
+
+    while (pos < size) {
+        ret = slog_binlog_block_parse(data + pos, size - pos, &block);
+        if (0 == ret) {
+            break;
+        }
+        if (ret < 0) {
+            /* a corrupt block is skipped, as slog-decode does */
+            next = memmem(data + pos + 1, size - pos - 1, SLOG_BINLOG_BLOCK_MAGIC, 4);
+            if (NULL == next) {
+                break;
+            }
+            pos = next - data;
+            continue;
+        }
+
+        rpos = 0;
+        time = 0;
+        while (1 == slog_binlog_record_next(&block, &rpos, &time, &record)) {
+            slog_column_add(w, &record, block.gmtoff);
+        }
+        pos += ret;
+    }
+}
+
+/*
+ * @return result, -1 the row column is corrupt
+ */
+static int slog_column_decode(slog_lz_t *lz, const char *data, size_t stored, char *out, size_t raw_len)
+{
+    int ret;
+    size_t pos = 0, len = 0, n;
+    const char *raw = NULL;
+
+    slog_lz_reset(lz);
+    while (pos < stored) {
+        ret = slog_lz_frame_decode(lz, data + pos, stored - pos, &raw, &n);
+        if ((ret <= 0) || (n > raw_len - len)) {
+            return -1;
+        }
+        memcpy(out + len, raw, n);
+        len += n;
+        pos += ret;
+    }
+
+    return (len == raw_len) ? 0 : -1;
+}
+
+/*
+ * @return bytes of the dictionary entry at pos, -1 corrupt
+ */
+static int slog_column_dict_entry(const char *data, size_t len, size_t pos, int site)
+{
+    uint64_t line;
+    size_t p = pos;
+
+    if (p >= len) {
+        return -1;
+    }
+    p += 1 + (uint8_t)data[p];
+    if (site) {
+        if (p >= len) {
+            return -1;
+        }
+        p += 1 + (uint8_t)data[p];
+        if (0 != slog_column_get_varint(data, len, &p, &line)) {
+            return -1;
+        }
+    }
+
+    return (p <= len) ? (int)(p - pos) : -1;
+}
+
+/*
+ * @return result, -1 corrupt or out of memory
+ */
+static int slog_column_dict_load(slog_column_dict_t *dict, const char *data, size_t len, int site)
+{
+    int ret;
+    size_t pos;
+    uint32_t count = 0;
+
+    for (pos = 0; pos < len; pos += ret, ++count) {
+        if ((ret = slog_column_dict_entry(data, len, pos, site)) < 0) {
+            return -1;
+        }
+    }
+
+    dict->offset = (uint32_t *)malloc((count + 1) * sizeof(uint32_t));
+    if (NULL == dict->offset) {
+        return -1;
+    }
+
+    dict->count = 0;
+    for (pos = 0; pos < len; pos += ret) {
+        ret = slog_column_dict_entry(data, len, pos, site);
+        dict->offset[dict->count++] = (uint32_t)pos;
+    }
+    dict->offset[dict->count] = (uint32_t)len;
+
+    return 0;
+}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC FUNCTIONS DEFINITION ------------------------------- */
+
+/**
+ * convert a text or binary log file segment into a columnar archive,
+ * written beside it and renamed into place once complete
+ *
+ * @param segment log file name
+ * @param archive archive file name, usually segment + SLOG_COLUMN_SUFFIX
+ *
+ * @return result
+ */
+int slog_column_convert(const char *segment, const char *archive)
+{
+    int fd, i, head = -1, result = -1;
+    size_t size;
+    struct stat statbuf;
+    char tmp[PATH_MAX], file_head[SLOG_COLUMN_FILE_HEAD_SIZE];
+    const char *data = NULL;
+    slog_column_writer_t *w = NULL;
+
+    if (snprintf(tmp, sizeof(tmp), "%s.tmp", archive) >= (int)sizeof(tmp)) {
+        return -1;
+    }
+
+    fd = open(segment, O_RDONLY);
+    if (-1 == fd) {
+        return -1;
+    }
+    if (0 != fstat(fd, &statbuf)) {
+        close(fd);
+        return -1;
+    }
+    size = statbuf.st_size;
+    if (size > 0) {
+        data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (MAP_FAILED == data) {
+        return -1;
+    }
+
+    w = (slog_column_writer_t *)calloc(1, sizeof(slog_column_writer_t));
+    if (NULL == w) {
+        goto out;
+    }
+    w->fp = fopen(tmp, "w");
+    if (NULL == w->fp) {
+        goto out;
+    }
+
+    memcpy(file_head, SLOG_COLUMN_MAGIC, 8);
+    slog_column_put16(file_head + 8, SLOG_COLUMN_VERSION);
+    slog_column_put16(file_head + 10, SLOG_COLUMN_FILE_HEAD_SIZE);
+    slog_column_put32(file_head + 12, 0);
+    if (1 != fwrite(file_head, sizeof(file_head), 1, w->fp)) {
+        w->failed = 1;
+    }
+
+    if (size > 0) {
+        head = slog_binlog_file_check(data, size);
+        if (head > 0) {
+            slog_column_convert_binary(w, data, size, head);
+        } else {
+            slog_column_convert_text(w, data, size);
+        }
+    }
+    slog_column_flush(w);
+
+    if ((0 != fflush(w->fp)) || (0 != fsync(fileno(w->fp)))) {
+        w->failed = 1;
+    }
+    if ((0 == fclose(w->fp)) && !w->failed && (0 == rename(tmp, archive))) {
+        result = 0;
+    }
+    w->fp = NULL;
+
+out:
+    if (0 != result) {
+        unlink(tmp);
+    }
+    if (NULL != w) {
+        for (i = 0; i < SLOG_COLUMN_COUNT; ++i) {
+            free(w->col[i].data);
+        }
+        free(w->out.data);
+        free(w);
+    }
+    if (NULL != data) {
+        munmap((void *)data, size);
+    }
+
+    return result;
+}
+
+/**
+ * check an archive's file head
+ *
+ * @return head size, -1 not an archive this version reads
+ */
+int slog_column_file_check(const char *data, size_t len)
+{
+    if ((len < SLOG_COLUMN_FILE_HEAD_SIZE) || (0 != memcmp(data, SLOG_COLUMN_MAGIC, 8))) {
+        return -1;
+    }
+
+    if ((SLOG_COLUMN_VERSION != slog_column_get16(data + 8)) ||
+        (slog_column_get16(data + 10) < SLOG_COLUMN_FILE_HEAD_SIZE)) {
+        return -1;
+    }
+
+    return slog_column_get16(data + 10);
+}
+
+/**
+ * parse and verify the group at data
+ *
+ * @param data archive bytes from a group head
+ * @param len bytes available
+ * @param group parsed head, its columns pointing into data
+ *
+ * @return group length, 0 truncated, -1 corrupt
+ */
+int slog_column_group_parse(const char *data, size_t len, slog_column_group_t *group)
+{
+    int i;
+    size_t total = SLOG_COLUMN_GROUP_HEAD_SIZE;
+
+    if (len < SLOG_COLUMN_GROUP_HEAD_SIZE) {
+        return 0;
+    }
+
+    if (0 != memcmp(data, SLOG_COLUMN_GROUP_MAGIC, 4)) {
+        return -1;
+    }
+
+    group->rows = slog_column_get32(data + 4);
+    group->gmtoff = (int32_t)slog_column_get32(data + 12);
+    group->min_time = (int64_t)slog_column_get64(data + 16);
+    group->max_time = (int64_t)slog_column_get64(data + 24);
+    group->level_mask = (uint8_t)data[32];
+
+    if (group->rows > SLOG_COLUMN_GROUP_ROWS) {
+        return -1;
+    }
+
+    for (i = 0; i < SLOG_COLUMN_COUNT; ++i) {
+        group->stored[i] = slog_column_get32(data + 40 + i * 8);
+        group->raw[i] = slog_column_get32(data + 44 + i * 8);
+        if ((group->stored[i] > SLOG_COLUMN_STORED_MAX) || (group->raw[i] > SLOG_COLUMN_RAW_MAX)) {
+            return -1;
+        }
+        group->column[i] = data + total;
+        total += group->stored[i];
+    }
+
+    if (len < total) {
+        return 0;
+    }
+
+    if (slog_column_get32(data + 8) !=
+        slog_column_crc(data, data + SLOG_COLUMN_GROUP_HEAD_SIZE, total - SLOG_COLUMN_GROUP_HEAD_SIZE)) {
+        return -1;
+    }
+
+    return (int)total;
+}
+
+/**
+ * decode the columns of a group a reader needs
+ *
+ * @param cursor rows of the group, closed with slog_column_cursor_close()
+ * @param group verified group
+ * @param columns SLOG_COLUMN_READ_xxx
+ * @param lz decoder stream, any state
+ *
+ * @return result, -1 corrupt or out of memory
+ */
+int slog_column_cursor_open(slog_column_cursor_t *cursor, const slog_column_group_t *group,
+                            unsigned int columns, slog_lz_t *lz)
+{
+    int i;
+
+    memset(cursor, 0, sizeof(slog_column_cursor_t));
+    cursor->group = group;
+    cursor->columns = columns;
+
+    for (i = 0; i < SLOG_COLUMN_COUNT; ++i) {
+        if (!(columns & (1U << i))) {
+            continue;
+        }
+        cursor->raw[i] = (char *)malloc(group->raw[i] + 1);
+        if ((NULL == cursor->raw[i]) ||
+            (0 != slog_column_decode(lz, group->column[i], group->stored[i], cursor->raw[i], group->raw[i]))) {
+            slog_column_cursor_close(cursor);
+            return -1;
+        }
+    }
+
+    if (((columns & SLOG_COLUMN_READ_TAG) &&
+         (0 != slog_column_dict_load(&cursor->tags, cursor->raw[SLOG_COLUMN_TAG_DICT], group->raw[SLOG_COLUMN_TAG_DICT], 0))) ||
+        ((columns & SLOG_COLUMN_READ_SITE) &&
+         (0 != slog_column_dict_load(&cursor->sites, cursor->raw[SLOG_COLUMN_SITE_DICT], group->raw[SLOG_COLUMN_SITE_DICT], 1)))) {
+        slog_column_cursor_close(cursor);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * decode the next row, strings point into the cursor
+ *
+ * @return 1 decoded, 0 group end, -1 corrupt
+ */
+int slog_column_row_next(slog_column_cursor_t *cursor, slog_column_row_t *row)
+{
+    uint64_t v;
+    size_t pos;
+    const char *entry = NULL;
+    const slog_column_group_t *group = cursor->group;
+
+    if (cursor->row >= group->rows) {
+        return 0;
+    }
+    memset(row, 0, sizeof(slog_column_row_t));
+
+    if (cursor->columns & SLOG_COLUMN_READ_TIME) {
+        if (0 != slog_column_get_varint(cursor->raw[SLOG_COLUMN_TIME], group->raw[SLOG_COLUMN_TIME],
+                                        &cursor->pos[SLOG_COLUMN_TIME], &v)) {
+            return -1;
+        }
+        cursor->time += (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+        row->time = cursor->time;
+    }
+
+    if (cursor->columns & SLOG_COLUMN_READ_LEVEL) {
+        if (cursor->pos[SLOG_COLUMN_LEVEL] >= group->raw[SLOG_COLUMN_LEVEL]) {
+            return -1;
+        }
+        row->level = (uint8_t)cursor->raw[SLOG_COLUMN_LEVEL][cursor->pos[SLOG_COLUMN_LEVEL]++];
+        if (row->level > VERBOSE) {
+            return -1;
+        }
+    }
+
+    if (cursor->columns & SLOG_COLUMN_READ_TAG) {
+        if ((0 != slog_column_get_varint(cursor->raw[SLOG_COLUMN_TAG], group->raw[SLOG_COLUMN_TAG],
+                                         &cursor->pos[SLOG_COLUMN_TAG], &v)) || (v >= cursor->tags.count)) {
+            return -1;
+        }
+        entry = cursor->raw[SLOG_COLUMN_TAG_DICT] + cursor->tags.offset[v];
+        row->tag_id = (uint32_t)v;
+        row->tag_len = (uint8_t)entry[0];
+        row->tag = entry + 1;
+    }
+
+    if (cursor->columns & SLOG_COLUMN_READ_SITE) {
+        if ((0 != slog_column_get_varint(cursor->raw[SLOG_COLUMN_SITE], group->raw[SLOG_COLUMN_SITE],
+                                         &cursor->pos[SLOG_COLUMN_SITE], &v)) || (v >= cursor->sites.count)) {
+            return -1;
+        }
+        entry = cursor->raw[SLOG_COLUMN_SITE_DICT] + cursor->sites.offset[v];
+        row->site_id = (uint32_t)v;
+        row->file_len = (uint8_t)entry[0];
+        row->file = entry + 1;
+        row->func_len = (uint8_t)entry[1 + row->file_len];
+        row->func = entry + 2 + row->file_len;
+
+        /* the entry was checked when the dictionary was loaded */
+        pos = 2 + row->file_len + row->func_len;
+        slog_column_get_varint(entry, cursor->sites.offset[v + 1] - cursor->sites.offset[v], &pos, &v);
+        row->line = (uint32_t)v;
+    }
+
+    if (cursor->columns & SLOG_COLUMN_READ_MSG) {
+        if ((0 != slog_column_get_varint(cursor->raw[SLOG_COLUMN_MSG_LEN], group->raw[SLOG_COLUMN_MSG_LEN],
+                                         &cursor->pos[SLOG_COLUMN_MSG_LEN], &v)) ||
+            (v > group->raw[SLOG_COLUMN_MSG] - cursor->pos[SLOG_COLUMN_MSG])) {
+            return -1;
+        }
+        row->msg = cursor->raw[SLOG_COLUMN_MSG] + cursor->pos[SLOG_COLUMN_MSG];
+        row->msg_len = (uint32_t)v;
+        cursor->pos[SLOG_COLUMN_MSG] += v;
+    }
+
+    cursor->row++;
+
+    return 1;
+}
+
+void slog_column_cursor_close(slog_column_cursor_t *cursor)
+{
+    int i;
+
+    for (i = 0; i < SLOG_COLUMN_COUNT; ++i) {
+        free(cursor->raw[i]);
+        cursor->raw[i] = NULL;
+    }
+    free(cursor->tags.offset);
+    free(cursor->sites.offset);
+    cursor->tags.offset = NULL;
+    cursor->sites.offset = NULL;
+}
+
+
+/* ============== EOF ======================================================= */
\ No newline at end of file
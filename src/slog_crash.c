@@ -0,0 +1,254 @@
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <unistd.h>
+
+#include "logger.h"
+#include "slog_buf.h"
+#include "slog_cfg.h"
+#include "slog_file.h"
+#include "slog_port.h"
+#include "slog_sink_int.h"
+#include "slog_spec.h"
+#include "slog_async.h"
+#include "slog_crash.h"
+#include "slog_event.h"
+#include "slog_inner.h"
+#include "slog_flight.h"
+#include "slog_signal.h"
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE MACROS -------------------------------------------- */
+
+/* ms the handler formats and writes for at most */
+#define SLOG_CRASH_BUDGET                    500
+
+/* s after which SIGALRM ends a handler blocked in write() */
+#define SLOG_CRASH_ALARM                     2
+
+/* bytes of formatted logs written at once */
+#define SLOG_CRASH_OUT_SIZE                  (64 * 1024)  /* 64KB */
+
+#define SLOG_CRASH_SIGNAL_NUM                (sizeof(slog_crash_signals) / sizeof(slog_crash_signals[0]))
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE TYPES --------------------------------------------- */
+
+/* the handler's output, all of it static, a handler may not allocate */
+typedef struct slog_crash_out_s {
+    int fd;
+    bool expired;                            /* the budget is spent, the walks skip the rest */
+    struct timespec deadline;
+    unsigned long written;
+    size_t len;
+    char buf[SLOG_CRASH_OUT_SIZE];
+} slog_crash_out_t;
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE VARIABLES ----------------------------------------- */
+
+static const int slog_crash_signals[] = { SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT, SIGTERM };
+
+/* dispositions replaced by slog_crash_init(), restored by slog_crash_deinit() */
+static struct sigaction slog_crash_old[SLOG_CRASH_SIGNAL_NUM];
+static bool slog_crash_installed[SLOG_CRASH_SIGNAL_NUM];
+
+/* seconds east of UTC, localtime_r() is no call for a handler */
+static long slog_crash_gmtoff;
+
+/* SIGALRM kills by default, a handler of the application's is not ours to trigger */
+static bool slog_crash_alarm;
+
+/* the first fatal signal flushes, one of another thread does not wait for it */
+static int slog_crash_running;
+
+static slog_crash_out_t slog_crash_out;
+static char slog_crash_event_buf[SLOG_EVENT_BUF_MAXLEN];
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE FUNCTIONS DEFINITION ------------------------------ */
+
+static void slog_crash_write(void)
+{
+    size_t done = 0;
+    ssize_t written;
+
+    while (done < slog_crash_out.len) {
+        written = write(slog_crash_out.fd, slog_crash_out.buf + done, slog_crash_out.len - done);
+        if (written < 0) {
+            if (EINTR == errno) {
+                continue;
+            }
+            slog_crash_out.expired = true;
+            break;
+        }
+        done += written;
+    }
+
+    slog_crash_out.len = 0;
+}
+
+/*
+ * format one pending event into the output, by slog_event_fifo_walk()
+ */
+static void slog_crash_event(const void *slog_event_buf, void *arg)
+{
+    int len;
+    struct timespec now;
+
+    (void)arg;
+
+    if (slog_crash_out.expired) {
+        return;
+    }
+
+    if (slog_crash_out.len + SLOG_FORMAT_BUF_SIZE > SLOG_CRASH_OUT_SIZE) {
+        slog_crash_write();
+    }
+
+    len = format_log_safe(slog_crash_out.buf + slog_crash_out.len, slog_event_buf, slog_crash_gmtoff);
+    if (len > 0) {
+        slog_crash_out.len += len;
+        slog_crash_out.written++;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if ((now.tv_sec > slog_crash_out.deadline.tv_sec) ||
+        ((now.tv_sec == slog_crash_out.deadline.tv_sec) && (now.tv_nsec >= slog_crash_out.deadline.tv_nsec))) {
+        slog_crash_out.expired = true;
+    }
+}
+
+/*
+ * write the logs not output yet, in the order the output thread would:
+ * those queued for the file sink, the flight recorder's history, the
+ * signal handlers' ring, then the main ring's lanes merged by time
+ */
+static void slog_crash_flush(void)
+{
+    slog_crash_out.fd = slog_file_text_fd();
+    if (-1 == slog_crash_out.fd) {
+        slog_crash_out.fd = open(SLOG_CRASH_FILE_NAME, O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (-1 == slog_crash_out.fd) {
+            return;
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &slog_crash_out.deadline);
+    slog_crash_out.deadline.tv_sec += SLOG_CRASH_BUDGET / 1000;
+    slog_crash_out.deadline.tv_nsec += (long)(SLOG_CRASH_BUDGET % 1000) * 1000000;
+    if (slog_crash_out.deadline.tv_nsec >= 1000000000) {
+        slog_crash_out.deadline.tv_sec++;
+        slog_crash_out.deadline.tv_nsec -= 1000000000;
+    }
+
+    /* the output thread and the sink workers leave the queues as they are */
+    slog_buffer_freeze();
+    slog_sink_freeze();
+
+    slog_port_walk_file(slog_crash_event_buf, slog_crash_event, NULL);
+    slog_flight_walk(slog_crash_event_buf, slog_crash_event, NULL);
+    slog_signal_walk(slog_crash_event_buf, slog_crash_event, NULL);
+    slog_buffer_walk(slog_crash_event_buf, slog_crash_event, NULL);
+    slog_crash_write();
+}
+
+/*
+ * fatal signal handler: flush within the budget, then die of the signal as
+ * the default disposition would. SA_RESETHAND restored it on entry, so a
+ * fault inside the flush ends the process too.
+ */
+static void slog_crash_handler(int sig)
+{
+    int saved_errno = errno;
+
+    if (!__sync_lock_test_and_set(&slog_crash_running, 1)) {
+        if (slog_crash_alarm) {
+            alarm(SLOG_CRASH_ALARM);
+        }
+        slog_crash_flush();
+        if (slog_crash_alarm) {
+            alarm(0);
+        }
+    }
+
+    errno = saved_errno;
+    raise(sig);
+}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC FUNCTIONS DEFINITION ------------------------------- */
+
+/**
+ * install the fatal signal flush, by the configured CRASH_FLUSH. Signals
+ * with a handler of the application's are left alone.
+ *
+ * @return result
+ */
+int slog_crash_init(void)
+{
+    size_t i;
+    time_t now = time(NULL);
+    struct tm local;
+    struct sigaction action, alarm_action;
+
+    if (!slog_get_crash_flush()) {
+        return 0;
+    }
+
+    if (NULL != localtime_r(&now, &local)) {
+        slog_crash_gmtoff = local.tm_gmtoff;
+    }
+
+    slog_crash_alarm = (0 == sigaction(SIGALRM, NULL, &alarm_action)) && (SIG_DFL == alarm_action.sa_handler) &&
+                       (0 == (alarm_action.sa_flags & SA_SIGINFO));
+
+    action.sa_handler = slog_crash_handler;
+    action.sa_flags = SA_RESETHAND;
+    sigfillset(&action.sa_mask);
+    sigdelset(&action.sa_mask, SIGALRM);
+
+    for (i = 0; i < SLOG_CRASH_SIGNAL_NUM; ++i) {
+        if ((0 != sigaction(slog_crash_signals[i], NULL, &slog_crash_old[i])) ||
+            (SIG_DFL != slog_crash_old[i].sa_handler) || (0 != (slog_crash_old[i].sa_flags & SA_SIGINFO))) {
+            slog_debug_inner("fatal signal %d has a handler, not flushed on it", slog_crash_signals[i]);
+            continue;
+        }
+        if (0 != sigaction(slog_crash_signals[i], &action, NULL)) {
+            slog_error_inner("fatal signal %d sigaction error", slog_crash_signals[i]);
+            continue;
+        }
+        slog_crash_installed[i] = true;
+    }
+
+    return 0;
+}
+
+/**
+ * restore the dispositions slog_crash_init() replaced, before the rings the
+ * handler walks are freed
+ */
+void slog_crash_deinit(void)
+{
+    size_t i;
+
+    for (i = 0; i < SLOG_CRASH_SIGNAL_NUM; ++i) {
+        if (slog_crash_installed[i]) {
+            sigaction(slog_crash_signals[i], &slog_crash_old[i], NULL);
+            slog_crash_installed[i] = false;
+        }
+    }
+}
+
+
+/* ============== EOF ======================================================= */
\ No newline at end of file
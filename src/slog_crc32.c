@@ -0,0 +1,152 @@
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <string.h>
+#include <pthread.h>
+
+#include "slog_crc32.h"
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE MACROS -------------------------------------------- */
+
+/* reflected IEEE 802.3 polynomial, the crc of zlib and gzip */
+#define SLOG_CRC32_POLY                      0xEDB88320U
+
+/* reflected Castagnoli polynomial, the crc of the SSE 4.2 crc32 instruction */
+#define SLOG_CRC32C_POLY                     0x82F63B78U
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define SLOG_CRC32C_HW                       1
+#endif
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE VARIABLES ----------------------------------------- */
+
+/* slicing by 8, table k advances a byte's crc by k more zero bytes */
+static uint32_t crc32_table[8][256];
+static uint32_t crc32c_table[8][256];
+static int crc32c_hw;
+static pthread_once_t crc32_once = PTHREAD_ONCE_INIT;
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE FUNCTIONS DEFINITION ------------------------------ */
+
+static void slog_crc32_table_fill(uint32_t table[8][256], uint32_t poly)
+{
+    uint32_t i, j, c;
+
+    for (i = 0; i < 256; ++i) {
+        c = i;
+        for (j = 0; j < 8; ++j) {
+            c = (c & 1) ? (c >> 1) ^ poly : (c >> 1);
+        }
+        table[0][i] = c;
+    }
+
+    for (i = 0; i < 256; ++i) {
+        c = table[0][i];
+        for (j = 1; j < 8; ++j) {
+            c = table[0][c & 0xff] ^ (c >> 8);
+            table[j][i] = c;
+        }
+    }
+}
+
+static void slog_crc32_table_init(void)
+{
+    slog_crc32_table_fill(crc32_table, SLOG_CRC32_POLY);
+    slog_crc32_table_fill(crc32c_table, SLOG_CRC32C_POLY);
+
+#ifdef SLOG_CRC32C_HW
+    crc32c_hw = __builtin_cpu_supports("sse4.2");
+#endif
+}
+
+/*
+ * @param crc crc so far, not inverted
+ */
+static uint32_t slog_crc32_slice(const uint32_t table[8][256], uint32_t crc, const uint8_t *p, size_t len)
+{
+    while (len >= 8) {
+        crc ^= (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+        crc = table[7][crc & 0xff] ^ table[6][(crc >> 8) & 0xff] ^
+              table[5][(crc >> 16) & 0xff] ^ table[4][crc >> 24] ^
+              table[3][p[4]] ^ table[2][p[5]] ^ table[1][p[6]] ^ table[0][p[7]];
+        p += 8;
+        len -= 8;
+    }
+    while (len-- > 0) {
+        crc = table[0][(crc ^ *p++) & 0xff] ^ (crc >> 8);
+    }
+
+    return crc;
+}
+
+#ifdef SLOG_CRC32C_HW
+__attribute__((target("sse4.2")))
+static uint32_t slog_crc32c_hw(uint32_t crc, const uint8_t *p, size_t len)
+{
+    uint64_t c = crc, v;
+
+    while (len >= 8) {
+        memcpy(&v, p, 8);
+        c = __builtin_ia32_crc32di(c, v);
+        p += 8;
+        len -= 8;
+    }
+    while (len-- > 0) {
+        c = __builtin_ia32_crc32qi((uint32_t)c, *p++);
+    }
+
+    return (uint32_t)c;
+}
+#endif
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC FUNCTIONS DEFINITION ------------------------------- */
+
+/**
+ * update a crc32, start with crc 0
+ *
+ * @param crc crc of the bytes before buf
+ * @param buf bytes
+ * @param len bytes length
+ *
+ * @return crc including buf
+ */
+uint32_t slog_crc32(uint32_t crc, const void *buf, size_t len)
+{
+    pthread_once(&crc32_once, slog_crc32_table_init);
+
+    return ~slog_crc32_slice(crc32_table, ~crc, (const uint8_t *)buf, len);
+}
+
+/**
+ * update a crc32c, start with crc 0. The cpu's crc32 instruction computes it
+ * where there is one, for the checksums on a hot path.
+ *
+ * @param crc crc of the bytes before buf
+ * @param buf bytes
+ * @param len bytes length
+ *
+ * @return crc including buf
+ */
+uint32_t slog_crc32c(uint32_t crc, const void *buf, size_t len)
+{
+    pthread_once(&crc32_once, slog_crc32_table_init);
+
+#ifdef SLOG_CRC32C_HW
+    if (crc32c_hw) {
+        return ~slog_crc32c_hw(~crc, (const uint8_t *)buf, len);
+    }
+#endif
+
+    return ~slog_crc32_slice(crc32c_table, ~crc, (const uint8_t *)buf, len);
+}
+
+
+/* ============== EOF ======================================================= */
\ No newline at end of file
@@ -0,0 +1,166 @@
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include <sys/time.h>
+
+#include "logger.h"
+#include "slog_cfg.h"
+#include "slog_port.h"
+#include "slog_event.h"
+#include "slog_crc32.h"
+#include "slog_flight.h"
+#include "slog_dedup.h"
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE TYPES --------------------------------------------- */
+
+/* the run of repeats of the last log output, the output thread's own */
+typedef struct slog_dedup_s {
+    int64_t window;                          /* us, 0 no collapsing */
+    unsigned int levels;                     /* SLOG_DEDUP_LEVEL() mask */
+    uint32_t hash;                           /* of the held event's site and message */
+    bool held;                               /* event holds the run's first log */
+    unsigned long repeats;                   /* counted since it, not output */
+    struct timeval last;                     /* time of the last repeat */
+} slog_dedup_t;
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE VARIABLES ----------------------------------------- */
+
+static slog_dedup_t slog_dedup;
+
+static char slog_dedup_event_buf[SLOG_EVENT_BUF_MAXLEN];
+
+static char slog_dedup_summary_buf[SLOG_EVENT_BUF_MAXLEN];
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE FUNCTIONS DEFINITION ------------------------------ */
+
+static int64_t slog_dedup_time(struct timeval time)
+{
+    return (int64_t)time.tv_sec * 1000000 + time.tv_usec;
+}
+
+/*
+ * hash of the level, line, and the tag, file, func and message bytes the
+ * event holds past its head
+ */
+static uint32_t slog_dedup_hash(const slog_event_head_t *head)
+{
+    uint32_t crc = slog_crc32c(0, &head->slog_level, sizeof(head->slog_level));
+
+    crc = slog_crc32c(crc, &head->slog_line, sizeof(head->slog_line));
+
+    return slog_crc32c(crc, head + 1, head->slog_event_length - sizeof(slog_event_head_t));
+}
+
+/*
+ * output "last message repeated N times" as a log of the run's site, at the
+ * time of the last repeat
+ */
+static void slog_dedup_summary(void)
+{
+    const slog_event_head_t *held = (const slog_event_head_t *)slog_dedup_event_buf;
+    slog_event_head_t *head = (slog_event_head_t *)slog_dedup_summary_buf;
+    uint32_t site_len = held->slog_tag_len + held->slog_file_len + held->slog_func_len;
+
+    memcpy(slog_dedup_summary_buf, slog_dedup_event_buf, sizeof(slog_event_head_t) + site_len);
+    head->slog_time = slog_dedup.last;
+    head->slog_event_length = sizeof(slog_event_head_t) + site_len;
+    slog_event_buf_append(slog_dedup_summary_buf, "last message repeated %lu times", slog_dedup.repeats);
+    slog_dedup.repeats = 0;
+
+    if (!slog_flight_record(slog_dedup_summary_buf)) {
+        slog_port_output(slog_dedup_summary_buf);
+    }
+}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC FUNCTIONS DEFINITION ------------------------------- */
+
+/**
+ * repeated log collapsing initialize, by the configured DEDUP_WINDOW
+ */
+void slog_dedup_init(void)
+{
+    memset(&slog_dedup, 0, sizeof(slog_dedup));
+    slog_dedup.window = (int64_t)slog_get_dedup_window() * 1000;
+    slog_dedup.levels = slog_get_dedup_levels();
+}
+
+/**
+ * count an event repeating the log output before it, on the output thread.
+ * An event ending a run outputs the run's summary ahead of itself.
+ *
+ * @param slog_event_buf log event
+ *
+ * @return true a repeat, counted only and not output
+ */
+bool slog_dedup_repeat(const void *slog_event_buf)
+{
+    const slog_event_head_t *head = (const slog_event_head_t *)slog_event_buf;
+    const slog_event_head_t *held = (const slog_event_head_t *)slog_dedup_event_buf;
+    uint32_t hash;
+
+    if (0 == slog_dedup.window) {
+        return false;
+    }
+
+    if (0 == (slog_dedup.levels & SLOG_DEDUP_LEVEL(head->slog_level))) {
+        slog_dedup_poll(true);
+        slog_dedup.held = false;
+        return false;
+    }
+
+    /* the bytes are compared on a hash match only, a collision is no repeat */
+    hash = slog_dedup_hash(head);
+    if (slog_dedup.held && (hash == slog_dedup.hash) &&
+        (head->slog_event_length == held->slog_event_length) &&
+        (slog_dedup_time(head->slog_time) - slog_dedup_time(held->slog_time) <= slog_dedup.window) &&
+        (0 == memcmp(head + 1, held + 1, head->slog_event_length - sizeof(slog_event_head_t)))) {
+        slog_dedup.repeats++;
+        slog_dedup.last = head->slog_time;
+        return true;
+    }
+
+    slog_dedup_poll(true);
+    memcpy(slog_dedup_event_buf, slog_event_buf, head->slog_event_length);
+    slog_dedup.hash = hash;
+    slog_dedup.held = true;
+
+    return false;
+}
+
+/**
+ * output the summary of a run, on the output thread once the ring is drained
+ *
+ * @param end the run ends, else only once the window closed it
+ */
+void slog_dedup_poll(bool end)
+{
+    const slog_event_head_t *held = (const slog_event_head_t *)slog_dedup_event_buf;
+    struct timeval now;
+
+    if (0 == slog_dedup.repeats) {
+        return;
+    }
+
+    if (!end) {
+        gettimeofday(&now, NULL);
+        if (slog_dedup_time(now) - slog_dedup_time(held->slog_time) <= slog_dedup.window) {
+            return;
+        }
+    }
+
+    slog_dedup_summary();
+}
+
+
+/* ============== EOF ======================================================= */
\ No newline at end of file
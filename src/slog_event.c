@@ -6,6 +6,7 @@
 #include <string.h>
 #include <stdarg.h>
 #include <pthread.h>
+#include <stdbool.h>
 
 #include "slog_event.h"
 
@@ -16,6 +17,84 @@
 static pthread_mutex_t fifo_lock = PTHREAD_MUTEX_INITIALIZER;
 
 
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE TYPES --------------------------------------------- */
+
+/* a walk's place in one fifo, the events from pos up to in are left */
+typedef struct slog_event_cursor_s {
+    const struct __kfifo *fifo;              /* NULL nothing left */
+    uint32_t frame_len;
+    unsigned int in;
+    unsigned int pos;
+    uint32_t length;                         /* of the event at pos */
+    int64_t time;                            /* us, of the event at pos */
+} slog_event_cursor_t;
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE FUNCTIONS DEFINITION ------------------------------ */
+
+/*
+ * copy n fifo bytes from pos on, wrapping around the data's end
+ */
+static void slog_event_fifo_copy(const struct __kfifo *fifo, unsigned int pos, void *dst, uint32_t n)
+{
+    unsigned int off = pos & fifo->mask;
+    unsigned int first = fifo->mask + 1 - off;
+
+    if (first >= n) {
+        memcpy(dst, (const char *)fifo->data + off, n);
+    } else {
+        memcpy(dst, (const char *)fifo->data + off, first);
+        memcpy((char *)dst + first, fifo->data, n - first);
+    }
+}
+
+/*
+ * read the head of the event at the cursor, the rest of a fifo torn by a
+ * producer in the middle of a put is skipped
+ *
+ * @return true an event is at the cursor
+ */
+static bool slog_event_cursor_peek(slog_event_cursor_t *cursor, void *slog_event_buf)
+{
+	const slog_event_head_t *head = (const slog_event_head_t *)slog_event_buf;
+
+	if ((NULL == cursor->fifo) ||
+	    (cursor->in - cursor->pos < cursor->frame_len + sizeof(slog_event_head_t))) {
+		cursor->fifo = NULL;
+		return false;
+	}
+
+	slog_event_fifo_copy(cursor->fifo, cursor->pos + cursor->frame_len, slog_event_buf, sizeof(slog_event_head_t));
+	cursor->length = head->slog_event_length;
+	if ((cursor->length < sizeof(slog_event_head_t)) || (cursor->length > SLOG_EVENT_BUF_MAXLEN) ||
+	    (cursor->length > cursor->in - cursor->pos - cursor->frame_len)) {
+		cursor->fifo = NULL;
+		return false;
+	}
+	cursor->time = (int64_t)head->slog_time.tv_sec * 1000000 + head->slog_time.tv_usec;
+
+	return true;
+}
+
+static void slog_event_cursor_init(slog_event_cursor_t *cursor, const struct kfifo *fifo, uint32_t frame_len,
+				   void *slog_event_buf)
+{
+	cursor->fifo = (NULL == fifo) ? NULL : &fifo->kfifo;
+	cursor->frame_len = frame_len;
+	if (NULL != cursor->fifo) {
+		cursor->in = __atomic_load_n(&cursor->fifo->in, __ATOMIC_ACQUIRE);
+		cursor->pos = __atomic_load_n(&cursor->fifo->out, __ATOMIC_ACQUIRE);
+		if (cursor->in - cursor->pos > cursor->fifo->mask + 1) {
+			cursor->fifo = NULL;
+		}
+	}
+
+	slog_event_cursor_peek(cursor, slog_event_buf);
+}
+
+
 /* -------------------------------------------------------------------------- */
 /* -------------- PUBLIC FUNCTIONS DEFINITION ------------------------------- */
 
@@ -49,6 +128,14 @@ void slog_event_buf_set(void *slog_buf, const char *tag, uint8_t tag_len,
     format_length = vsnprintf(((char *)slog_buf + sizeof(slog_event_head_t) + tag_len + file_len + func_len), \
                               SLOG_EVENT_BUF_MAXLEN - (sizeof(slog_event_head_t) + tag_len + file_len + func_len), \
                               format, args);
+    if (format_length < 0) {
+        format_length = 0;
+    }
+
+    /* vsnprintf counts what did not fit too */
+    if ((size_t)format_length >= SLOG_EVENT_BUF_MAXLEN - (sizeof(slog_event_head_t) + tag_len + file_len + func_len)) {
+        format_length = SLOG_EVENT_BUF_MAXLEN - (sizeof(slog_event_head_t) + tag_len + file_len + func_len) - 1;
+    }
 
     /* set total length */
 	total_length = sizeof(slog_event_head_t) + tag_len + file_len + func_len + format_length;
@@ -57,13 +144,55 @@ void slog_event_buf_set(void *slog_buf, const char *tag, uint8_t tag_len,
 	return;
 }
 
-void slog_event_fifo_put(struct kfifo *fifo, void *slog_event_buf)
+/**
+ * append to the message of an event slog_event_buf_set() set, cut at the
+ * buffer's end as the message is
+ */
+void slog_event_buf_append(void *slog_buf, const char *format, ...)
+{
+    va_list args;
+    int append_length = 0;
+    uint32_t total_length = ((slog_event_head_t*)slog_buf)->slog_event_length;
+
+    va_start(args, format);
+    append_length = vsnprintf((char *)slog_buf + total_length, SLOG_EVENT_BUF_MAXLEN - total_length, format, args);
+    va_end(args);
+    if (append_length < 0) {
+        return;
+    }
+
+    if ((uint32_t)append_length >= SLOG_EVENT_BUF_MAXLEN - total_length) {
+        append_length = SLOG_EVENT_BUF_MAXLEN - total_length - 1;
+    }
+    ((slog_event_head_t*)slog_buf)->slog_event_length = total_length + append_length;
+}
+
+int slog_event_fifo_put(struct kfifo *fifo, void *slog_event_buf)
+{
+    return slog_event_fifo_put_raw(fifo, slog_event_buf, ((slog_event_head_t*)slog_event_buf)->slog_event_length);
+}
+
+/**
+ * put len bytes whole or not at all, the consumer never sees a part of them
+ *
+ * @param fifo fifo
+ * @param data an event or an event framed as a record
+ * @param len bytes
+ *
+ * @return 0 put, -1 no room
+ */
+int slog_event_fifo_put_raw(struct kfifo *fifo, const void *data, uint32_t len)
 {
+    int result = -1;
+
     pthread_mutex_lock(&fifo_lock);
-    if (kfifo_avail(fifo) >= ((slog_event_head_t*)slog_event_buf)->slog_event_length) {
-        kfifo_in(fifo, slog_event_buf, ((slog_event_head_t*)slog_event_buf)->slog_event_length);
+    if (kfifo_avail(fifo) >= len) {
+        kfifo_in(fifo, data, len);
+        result = 0;
     }
     pthread_mutex_unlock(&fifo_lock);
+
+    return result;
 }
 
 size_t slog_event_fifo_get(struct kfifo *fifo, void *slog_event_buf)
@@ -83,5 +212,48 @@ size_t slog_event_fifo_get(struct kfifo *fifo, void *slog_event_buf)
 	return ((slog_event_head_t*)slog_event_buf)->slog_event_length;
 }
 
+/**
+ * walk the events of a fifo without taking them out and without its lock,
+ * for a fatal signal handler. Producers and the consumer may race the walk,
+ * it stops at the first event that does not look whole.
+ *
+ * @param fifo fifo of events
+ * @param frame_len bytes ahead of each event, SLOG_RING_RECORD_HEAD_SIZE in a ring file
+ * @param slog_event_buf SLOG_EVENT_BUF_MAXLEN bytes each event is copied to
+ * @param walk called for each event
+ * @param arg passed to walk
+ */
+void slog_event_fifo_walk(struct kfifo *fifo, uint32_t frame_len, void *slog_event_buf,
+			slog_event_walk_t walk, void *arg)
+{
+	slog_event_fifo_merge_walk(fifo, frame_len, NULL, 0, slog_event_buf, walk, arg);
+}
+
+/**
+ * walk the events of two fifos as one, the older of their next events first,
+ * without taking them out or locking
+ *
+ * @param other the second fifo, NULL none
+ */
+void slog_event_fifo_merge_walk(struct kfifo *fifo, uint32_t frame_len, struct kfifo *other,
+				uint32_t other_frame_len, void *slog_event_buf, slog_event_walk_t walk, void *arg)
+{
+	slog_event_cursor_t cursors[2], *next = NULL;
+
+	slog_event_cursor_init(&cursors[0], fifo, frame_len, slog_event_buf);
+	slog_event_cursor_init(&cursors[1], other, other_frame_len, slog_event_buf);
+
+	while ((NULL != cursors[0].fifo) || (NULL != cursors[1].fifo)) {
+		/* the first fifo's on a tie, its event was put first as far as anyone can tell */
+		next = ((NULL == cursors[1].fifo) ||
+			((NULL != cursors[0].fifo) && (cursors[0].time <= cursors[1].time))) ? &cursors[0] : &cursors[1];
+
+		slog_event_fifo_copy(next->fifo, next->pos + next->frame_len, slog_event_buf, next->length);
+		walk(slog_event_buf, arg);
+		next->pos += next->frame_len + next->length;
+		slog_event_cursor_peek(next, slog_event_buf);
+	}
+}
+
 
 /* ============== EOF ======================================================= */
\ No newline at end of file
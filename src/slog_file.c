@@ -6,6 +6,8 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <errno.h>
+#include <sys/uio.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
@@ -13,6 +15,15 @@
 #include "logger.h"
 #include "slog_cfg.h"
 #include "slog_file.h"
+#include "slog_spec.h"
+#include "slog_async.h"
+#include "slog_event.h"
+#include "slog_inner.h"
+#include "slog_crc32.h"
+#include "slog_index.h"
+#include "slog_bloom.h"
+#include "slog_column.h"
+#include "slog_binlog.h"
 #include "slog_compiler.h"
 
 
@@ -29,6 +40,12 @@
 
 #define FILE_PATH_SIZE                       512
 
+/* text formatted from one batch of events before it is written */
+#define SLOG_FILE_TEXT_SIZE                  (128 * 1024)  /* 128KB */
+
+/* index entries closed, and not written yet, at most */
+#define SLOG_FILE_INDEX_PENDING              64
+
 
 /* -------------------------------------------------------------------------- */
 /* -------------- PRIVATE TYPES --------------------------------------------- */
@@ -37,8 +54,46 @@ typedef struct slog_file_cfg_s {
     char *name;              /* file name */
     size_t max_size;         /* file max size */
     short max_rotate;        /* max rotate file count */
+    bool binary;             /* blocks of raw events instead of text lines */
+    size_t index_interval;   /* bytes per index entry, 0 no index */
+    bool bloom;              /* bloom filters beside the index */
+    bool archive;            /* columnar archive of each rotated segment */
 } slog_file_cfg_t;
 
+/* format of a file kept beside the segment */
+typedef struct slog_file_sidecar_ops_s {
+    const char *suffix;
+    size_t head_size;
+    size_t trailer_size;
+    void (*head)(char *head, uint32_t param);
+    int (*check)(const char *data, size_t len, size_t *count, int *final);
+    void (*trailer)(char *trailer, uint32_t count, uint32_t crc);
+} slog_file_sidecar_ops_t;
+
+/* file kept beside the segment, one record per index entry */
+typedef struct slog_file_sidecar_s {
+    const slog_file_sidecar_ops_t *ops;
+    int fd;                                  /* -1 not written */
+    size_t record_size;
+    uint32_t param;                          /* of its head */
+    uint32_t count;                          /* records in the file */
+    uint32_t crc;                            /* of the records in the file */
+    int pending;                             /* records closed, their logs not written yet */
+    char *pending_buf;
+} slog_file_sidecar_t;
+
+/* sparse index and bloom filters of the segment being written */
+typedef struct slog_file_index_s {
+    uint64_t size;                           /* segment bytes written */
+    slog_index_entry_t entry;                /* entry being filled */
+    uint8_t *filter;                         /* its bloom filter */
+    size_t filter_size;
+    uint8_t filter_flags;                    /* SLOG_BLOOM_FLAG_xxx */
+    int pending_max;                         /* records closed before their logs are written */
+    slog_file_sidecar_t index;
+    slog_file_sidecar_t bloom;
+} slog_file_index_t;
+
 
 /* -------------------------------------------------------------------------- */
 /* -------------- PRIVATE VARIABLES ----------------------------------------- */
@@ -47,6 +102,27 @@ static FILE *fp = NULL;
 static int fd = -1;
 static slog_file_cfg_t local_cfg;
 
+/* block being written in binary format */
+static char binlog_block[SLOG_BINLOG_BLOCK_HEAD_SIZE + SLOG_BINLOG_BLOCK_MAX];
+
+/* lines being written in text format */
+static char text_buf[SLOG_FILE_TEXT_SIZE];
+
+static const slog_file_sidecar_ops_t index_ops = {
+        SLOG_INDEX_SUFFIX, SLOG_INDEX_HEAD_SIZE, SLOG_INDEX_TRAILER_SIZE,
+        slog_index_head, slog_index_check, slog_index_trailer,
+};
+
+static const slog_file_sidecar_ops_t bloom_ops = {
+        SLOG_BLOOM_SUFFIX, SLOG_BLOOM_HEAD_SIZE, SLOG_BLOOM_TRAILER_SIZE,
+        slog_bloom_head, slog_bloom_check, slog_bloom_trailer,
+};
+
+/* the files kept beside each segment, renamed with it */
+static const char *sidecar_suffix[] = { SLOG_INDEX_SUFFIX, SLOG_BLOOM_SUFFIX, SLOG_COLUMN_SUFFIX };
+
+static slog_file_index_t file_index = { .index = { .fd = -1 }, .bloom = { .fd = -1 } };
+
 
 /* -------------------------------------------------------------------------- */
 /* -------------- PRIVATE FUNCTIONS DEFINITION ------------------------------ */
@@ -70,11 +146,442 @@ static char *get_self_directory(char *buf, int count)
     return buf;
 }
 
+/*
+ * write all the iovecs, short writes included
+ *
+ * @return result
+ */
+static int slog_file_writev(struct iovec *iov, int iovcnt)
+{
+    ssize_t written;
+
+    while (iovcnt > 0) {
+        written = writev(fd, iov, iovcnt);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            slog_error_inner("write log file error: %s", strerror(errno));
+            return -1;
+        }
+
+        /* skip what a short write took */
+        while ((iovcnt > 0) && ((size_t)written >= iov->iov_len)) {
+            written -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = (char *)iov->iov_base + written;
+            iov->iov_len -= written;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * a new binary file starts with its head, an existing one must have it
+ *
+ * @return false the file is no binary log of this version
+ */
+static bool slog_file_binary_head(void)
+{
+    char head[SLOG_BINLOG_FILE_HEAD_SIZE];
+    struct iovec iov = { .iov_base = head, .iov_len = SLOG_BINLOG_FILE_HEAD_SIZE };
+    struct stat statbuf;
+
+    if ((0 != fstat(fd, &statbuf)) || (0 == statbuf.st_size)) {
+        slog_binlog_file_head(head);
+        return 0 == slog_file_writev(&iov, 1);
+    }
+
+    return (SLOG_BINLOG_FILE_HEAD_SIZE == pread(fd, head, SLOG_BINLOG_FILE_HEAD_SIZE, 0)) &&
+           (slog_binlog_file_check(head, SLOG_BINLOG_FILE_HEAD_SIZE) > 0);
+}
+
+/*
+ * a sidecar record starts with offset u64 and length u32 of its logs
+ *
+ * @return segment offset after the record's logs
+ */
+static uint64_t slog_file_record_end(const char *record)
+{
+    const uint8_t *u = (const uint8_t *)record;
+    uint64_t offset = 0;
+    uint32_t length = 0;
+    int i;
+
+    for (i = 7; i >= 0; --i) {
+        offset = (offset << 8) | u[i];
+    }
+    for (i = 11; i >= 8; --i) {
+        length = (length << 8) | u[i];
+    }
+
+    return offset + length;
+}
+
+/*
+ * write all of a buffer to a sidecar
+ *
+ * @return result
+ */
+static int slog_file_sidecar_write(slog_file_sidecar_t *sidecar, const char *buf, size_t len)
+{
+    ssize_t written;
+
+    while (len > 0) {
+        written = write(sidecar->fd, buf, len);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            slog_error_inner("write log %s error: %s", sidecar->ops->suffix, strerror(errno));
+            return -1;
+        }
+        buf += written;
+        len -= written;
+    }
+
+    return 0;
+}
+
+/*
+ * stop writing a sidecar, readers scan what no record covers
+ */
+static void slog_file_sidecar_drop(slog_file_sidecar_t *sidecar)
+{
+    close(sidecar->fd);
+    sidecar->fd = -1;
+    sidecar->pending = 0;
+}
+
+/*
+ * keep the records of an earlier run when they all lie inside the segment
+ *
+ * @return result, -1 the sidecar has to start over
+ */
+static int slog_file_sidecar_resume(slog_file_sidecar_t *sidecar)
+{
+    char *data = NULL;
+    struct stat statbuf;
+    size_t count = 0;
+    int head, final = 0, result = -1;
+
+    if ((0 != fstat(sidecar->fd, &statbuf)) || ((size_t)statbuf.st_size < sidecar->ops->head_size)) {
+        return -1;
+    }
+
+    data = (char *)malloc(statbuf.st_size);
+    if (NULL == data) {
+        return -1;
+    }
+
+    if (statbuf.st_size == pread(sidecar->fd, data, statbuf.st_size, 0)) {
+        head = sidecar->ops->check(data, statbuf.st_size, &count, &final);
+
+        /* a finalized or torn sidecar, or one of other records, is not appended to */
+        if ((head >= 0) && !final && ((size_t)statbuf.st_size == head + count * sidecar->record_size) &&
+            ((0 == count) ||
+             (slog_file_record_end(data + head + (count - 1) * sidecar->record_size) <= file_index.size))) {
+            sidecar->count = count;
+            sidecar->crc = slog_crc32(0, data + head, count * sidecar->record_size);
+            result = 0;
+        }
+    }
+
+    free(data);
+
+    return result;
+}
+
+/*
+ * write the records closed so far, once the logs they cover are written
+ */
+static void slog_file_sidecar_flush(slog_file_sidecar_t *sidecar)
+{
+    size_t len = sidecar->pending * sidecar->record_size;
+
+    if ((-1 == sidecar->fd) || (0 == len)) {
+        return;
+    }
+
+    if (0 != slog_file_sidecar_write(sidecar, sidecar->pending_buf, len)) {
+        slog_file_sidecar_drop(sidecar);
+        return;
+    }
+
+    sidecar->crc = slog_crc32(sidecar->crc, sidecar->pending_buf, len);
+    sidecar->count += sidecar->pending;
+    sidecar->pending = 0;
+}
+
+/*
+ * close a sidecar. The sidecar of a full segment is finalized, the trailer
+ * marks it complete and it is synced before the rotation renames it
+ * beside its segment.
+ *
+ * @param final the segment is rotated
+ */
+static void slog_file_sidecar_close(slog_file_sidecar_t *sidecar, bool final)
+{
+    char trailer[SLOG_INDEX_TRAILER_SIZE];
+
+    slog_file_sidecar_flush(sidecar);
+
+    if (-1 == sidecar->fd) {
+        return;
+    }
+
+    if (final) {
+        sidecar->ops->trailer(trailer, sidecar->count, sidecar->crc);
+        if (0 == slog_file_sidecar_write(sidecar, trailer, sidecar->ops->trailer_size)) {
+            fsync(sidecar->fd);
+        }
+    }
+
+    slog_file_sidecar_drop(sidecar);
+}
+
+/*
+ * open a sidecar of the segment just opened
+ */
+static void slog_file_sidecar_open(slog_file_sidecar_t *sidecar)
+{
+    char path[FILE_PATH_SIZE];
+    char head[SLOG_INDEX_HEAD_SIZE];
+
+    snprintf(path, sizeof(path), "%s%s", local_cfg.name, sidecar->ops->suffix);
+    sidecar->fd = open(path, O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (-1 == sidecar->fd) {
+        slog_warn_inner("open log %s error: %s", path, strerror(errno));
+        return;
+    }
+
+    sidecar->pending = 0;
+
+    if (0 != slog_file_sidecar_resume(sidecar)) {
+        /* a new sidecar, or one that does not match its segment any more */
+        sidecar->ops->head(head, sidecar->param);
+        if ((0 != ftruncate(sidecar->fd, 0)) || (0 != slog_file_sidecar_write(sidecar, head, sidecar->ops->head_size))) {
+            slog_file_sidecar_drop(sidecar);
+            return;
+        }
+        sidecar->count = 0;
+        sidecar->crc = 0;
+    }
+}
+
+/*
+ * size the index and filters of the segments once, their intervals are fixed
+ *
+ * @return result
+ */
+static int slog_file_index_init(void)
+{
+    size_t interval = local_cfg.index_interval;
+
+    if (0 == interval) {
+        return 0;
+    }
+
+    /* one write of logs closes this many entries at most */
+    file_index.pending_max = (SLOG_BINLOG_BLOCK_HEAD_SIZE + SLOG_BINLOG_BLOCK_MAX) / interval + 2;
+    if (file_index.pending_max > SLOG_FILE_INDEX_PENDING) {
+        file_index.pending_max = SLOG_FILE_INDEX_PENDING;
+    }
+
+    file_index.index.ops = &index_ops;
+    file_index.index.record_size = SLOG_INDEX_ENTRY_SIZE;
+    file_index.index.param = (uint32_t)(interval / 1024);
+    file_index.index.pending_buf = (char *)malloc(file_index.pending_max * SLOG_INDEX_ENTRY_SIZE);
+    if (NULL == file_index.index.pending_buf) {
+        return -1;
+    }
+
+    if (local_cfg.bloom) {
+        file_index.filter_size = interval / SLOG_BLOOM_RATIO;
+        file_index.bloom.ops = &bloom_ops;
+        file_index.bloom.record_size = SLOG_BLOOM_RECORD_HEAD_SIZE + file_index.filter_size;
+        file_index.bloom.param = (uint32_t)file_index.filter_size;
+        file_index.bloom.pending_buf = (char *)malloc(file_index.pending_max * file_index.bloom.record_size);
+        file_index.filter = (uint8_t *)calloc(1, file_index.filter_size);
+        if ((NULL == file_index.bloom.pending_buf) || (NULL == file_index.filter)) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static void slog_file_index_deinit(void)
+{
+    free(file_index.index.pending_buf);
+    free(file_index.bloom.pending_buf);
+    free(file_index.filter);
+    file_index.index.pending_buf = NULL;
+    file_index.bloom.pending_buf = NULL;
+    file_index.filter = NULL;
+}
+
+/*
+ * write the entries and filters closed so far
+ */
+static void slog_file_index_flush(void)
+{
+    slog_file_sidecar_flush(&file_index.index);
+    slog_file_sidecar_flush(&file_index.bloom);
+}
+
+/*
+ * close the entry being filled, and its filter, at offset end
+ */
+static void slog_file_index_close_entry(uint64_t end)
+{
+    slog_index_entry_t *entry = &file_index.entry;
+    slog_file_sidecar_t *index = &file_index.index, *bloom = &file_index.bloom;
+    slog_bloom_record_t record;
+
+    if ((0 == entry->count) || (index->pending == file_index.pending_max) ||
+        (bloom->pending == file_index.pending_max)) {
+        return;
+    }
+
+    entry->length = (uint32_t)(end - entry->offset);
+    if (-1 != index->fd) {
+        slog_index_entry_encode(index->pending_buf + index->pending++ * index->record_size, entry);
+    }
+
+    if (-1 != bloom->fd) {
+        record.offset = entry->offset;
+        record.length = entry->length;
+        record.flags = file_index.filter_flags;
+        record.filter = file_index.filter;
+        slog_bloom_record_encode(bloom->pending_buf + bloom->pending++ * bloom->record_size, &record,
+                                 file_index.filter_size);
+    }
+
+    entry->count = 0;
+}
+
+/*
+ * close the index and filters, their last entry ends at the segment end
+ *
+ * @param final the segment is rotated
+ */
+static void slog_file_index_close(bool final)
+{
+    slog_file_index_flush();
+    slog_file_index_close_entry(file_index.size);
+
+    slog_file_sidecar_close(&file_index.index, final);
+    slog_file_sidecar_close(&file_index.bloom, final);
+}
+
+/*
+ * open the index and filters of the segment just opened, logs are indexed
+ * from the segment's current end
+ */
+static void slog_file_index_open(void)
+{
+    struct stat statbuf;
+
+    slog_file_index_close(false);
+
+    if ((0 == local_cfg.index_interval) || (0 != fstat(fd, &statbuf))) {
+        return;
+    }
+
+    file_index.size = statbuf.st_size;
+    file_index.entry.count = 0;
+
+    slog_file_sidecar_open(&file_index.index);
+    if (local_cfg.bloom) {
+        slog_file_sidecar_open(&file_index.bloom);
+    }
+}
+
+/*
+ * account one log written at offset off of the segment, the entry being
+ * filled is closed at the first log past the interval
+ */
+static void slog_file_index_add(uint64_t off, const slog_event_head_t *head)
+{
+    slog_index_entry_t *entry = &file_index.entry;
+    int64_t time = (int64_t)head->slog_time.tv_sec * 1000000 + head->slog_time.tv_usec;
+    const char *tag = (const char *)head + sizeof(slog_event_head_t);
+    size_t strings_len = sizeof(slog_event_head_t) + head->slog_tag_len + head->slog_file_len + head->slog_func_len;
+
+    if ((-1 == file_index.index.fd) && (-1 == file_index.bloom.fd)) {
+        return;
+    }
+
+    if ((entry->count > 0) && (off - entry->offset >= local_cfg.index_interval)) {
+        slog_file_index_close_entry(off);
+    }
+
+    if (0 == entry->count) {
+        entry->offset = off;
+        entry->min_time = time;
+        entry->max_time = time;
+        entry->level_mask = 0;
+        if (-1 != file_index.bloom.fd) {
+            memset(file_index.filter, 0, file_index.filter_size);
+            file_index.filter_flags = 0;
+        }
+    }
+
+    if (time < entry->min_time) {
+        entry->min_time = time;
+    }
+    if (time > entry->max_time) {
+        entry->max_time = time;
+    }
+    entry->level_mask |= (uint8_t)(1 << head->slog_level);
+    entry->count++;
+
+    /* hashing is bounded per log, a longer message leaves the filter partial */
+    if ((-1 != file_index.bloom.fd) && (head->slog_event_length >= strings_len) &&
+        (0 != slog_bloom_add_log(file_index.filter, file_index.filter_size, tag, head->slog_tag_len,
+                                 (const char *)head + strings_len, head->slog_event_length - strings_len))) {
+        file_index.filter_flags |= SLOG_BLOOM_FLAG_PARTIAL;
+    }
+}
+
+/*
+ * write a buffer of whole logs, then the index entries they complete
+ *
+ * @return result
+ */
+static int slog_file_write_logs(char *buf, size_t len)
+{
+    struct iovec iov = { .iov_base = buf, .iov_len = len };
+
+    if (0 != slog_file_writev(&iov, 1)) {
+        return -1;
+    }
+
+    file_index.size += len;
+    slog_file_index_flush();
+
+    return 0;
+}
+
 static int slog_file_config(slog_file_cfg_t *cfg)
 {
     local_cfg.name = cfg->name;
     local_cfg.max_size = cfg->max_size;
     local_cfg.max_rotate = cfg->max_rotate;
+    local_cfg.binary = cfg->binary;
+    local_cfg.index_interval = cfg->index_interval;
+    local_cfg.bloom = cfg->bloom;
+    local_cfg.archive = cfg->archive;
+
+    if (0 != slog_file_index_init()) {
+        slog_error_inner("log file index init failed, no index");
+        local_cfg.index_interval = 0;
+    }
 
     fp = fopen(local_cfg.name, "a+");
     if (fp) {
@@ -101,12 +608,76 @@ static bool slog_file_reopen(void)
 
         fp = tmp_fp;
         fd = fileno(fp);
+
+        if (local_cfg.binary && !slog_file_binary_head()) {
+            return false;
+        }
+
+        slog_file_index_open();
         return true;
     }
 
     return false;
 }
 
+/*
+ * encode the raw events into blocks and write them
+ *
+ * @return result
+ */
+static int slog_file_write_binary(const struct iovec *iov, int iovcnt)
+{
+    int i, done = 0;
+    size_t len;
+
+    while (iovcnt > 0) {
+        len = slog_binlog_block_encode(binlog_block, iov, iovcnt, &done);
+
+        /* an index entry starts at a block */
+        for (i = 0; i < done; ++i) {
+            slog_file_index_add(file_index.size, (const slog_event_head_t *)iov[i].iov_base);
+        }
+
+        if (0 != slog_file_write_logs(binlog_block, len)) {
+            return -1;
+        }
+        iov += done;
+        iovcnt -= done;
+    }
+
+    return 0;
+}
+
+/*
+ * format the raw events as text lines and write them
+ *
+ * @return result
+ */
+static int slog_file_write_text(const struct iovec *iov, int iovcnt)
+{
+    int i, len;
+    size_t text_len = 0;
+
+    for (i = 0; i < iovcnt; ++i) {
+        if (text_len + SLOG_FORMAT_BUF_SIZE > SLOG_FILE_TEXT_SIZE) {
+            if (0 != slog_file_write_logs(text_buf, text_len)) {
+                return -1;
+            }
+            text_len = 0;
+        }
+
+        len = format_log(text_buf + text_len, iov[i].iov_base);
+        if (len <= 0) {
+            continue;
+        }
+
+        slog_file_index_add(file_index.size + text_len, (const slog_event_head_t *)iov[i].iov_base);
+        text_len += len;
+    }
+
+    return (text_len > 0) ? slog_file_write_logs(text_buf, text_len) : 0;
+}
+
 /*
  * rotate the log file xxx.log.n-1 => xxx.log.n, and xxx.log => xxx.log.0
  */
@@ -114,8 +685,12 @@ static void slog_file_rotate(void)
 {
     /* mv xxx.log.n-1 => xxx.log.n, and xxx.log => xxx.log.0 */
     short n;
+    size_t i;
     char oldpath[256], newpath[256];
-    size_t base = strlen(local_cfg.name);
+    size_t base = strlen(local_cfg.name), old_len, new_len;
+
+    /* the index and filters of the full segment are complete before they are renamed */
+    slog_file_index_close(true);
 
     memcpy(oldpath, local_cfg.name, base);
     memcpy(newpath, local_cfg.name, base);
@@ -123,7 +698,28 @@ static void slog_file_rotate(void)
     for (n = local_cfg.max_rotate - 1; n >= 0; --n) {
         snprintf(oldpath + base, SUFFIX_LEN, n ? ".%hd" : "", n - 1);
         snprintf(newpath + base, SUFFIX_LEN, ".%hd", n);
-        rename(oldpath, newpath);
+        if (0 != rename(oldpath, newpath)) {
+            continue;
+        }
+
+        /* sidecars follow their segment, a segment without one drops the stale one */
+        old_len = strlen(oldpath);
+        new_len = strlen(newpath);
+        for (i = 0; i < sizeof(sidecar_suffix) / sizeof(sidecar_suffix[0]); ++i) {
+            snprintf(oldpath + old_len, SUFFIX_LEN, "%s", sidecar_suffix[i]);
+            snprintf(newpath + new_len, SUFFIX_LEN, "%s", sidecar_suffix[i]);
+            if (0 != rename(oldpath, newpath)) {
+                unlink(newpath);
+            }
+        }
+    }
+
+    if (local_cfg.archive) {
+        snprintf(oldpath + base, SUFFIX_LEN, ".0");
+        snprintf(newpath + base, SUFFIX_LEN, ".0%s", SLOG_COLUMN_SUFFIX);
+        if (0 != slog_column_convert(oldpath, newpath)) {
+            slog_warn_inner("log file %s archive failed", oldpath);
+        }
     }
 }
 
@@ -157,6 +753,7 @@ int slog_file_init(void)
 
     int result = 0;
     slog_file_cfg_t cfg;
+    bool binary = (SLOG_FILE_FORMAT_BINARY == slog_get_output_file_format());
     char path[FILE_PATH_SIZE] = { 0 };
     char *log_path = NULL;
 
@@ -168,25 +765,48 @@ int slog_file_init(void)
         cfg.name = SLOG_FILE_NAME;
     }
 
-    cfg.name = SLOG_FILE_NAME;
+    cfg.name = binary ? SLOG_FILE_BIN_NAME : SLOG_FILE_NAME;
     cfg.max_size = SLOG_FILE_MAX_SIZE;
     cfg.max_rotate = SLOG_FILE_MAX_ROTATE;
+    cfg.binary = binary;
+    cfg.index_interval = (size_t)slog_get_output_file_index() * 1024;
+    cfg.bloom = slog_get_output_file_bloom();
+    cfg.archive = slog_get_output_file_archive();
 
     result = slog_file_config(&cfg);
 
+    if ((0 == result) && binary && !slog_file_binary_head()) {
+        /* never append blocks to a file the decoder cannot read */
+        slog_warn_inner("log file %s is not a binary log, rotate it", local_cfg.name);
+        slog_file_rotate();
+        result = slog_file_reopen() ? 0 : -1;
+    } else if (0 == result) {
+        slog_file_index_open();
+    }
+
     return result;
 }
 
-void slog_file_write(const char *log, size_t size)
+/**
+ * write a batch of raw events as text lines, or in binary format as few
+ * blocks as possible, and index them
+ *
+ * @param iov one raw event per iovec
+ * @param iovcnt iovec count
+ *
+ * @return result
+ */
+int slog_file_write_batch(struct iovec *iov, int iovcnt)
 {
-    if (NULL == log) {
-        return;
+    if (NULL == fp) {
+        return -1;
     }
 
     struct stat statbuf;
     statbuf.st_size = 0;
 
     fstat(fd, &statbuf);
+    file_index.size = statbuf.st_size;
 
     if (unlikely((unsigned int)statbuf.st_size > local_cfg.max_size)) {
 #if SLOG_FILE_MAX_ROTATE > 0
@@ -196,28 +816,56 @@ void slog_file_write(const char *log, size_t size)
         }
 
         if (!slog_file_reopen()) {
-            return;
+            return -1;
         }
 #else
-        return ;
+        return -1;
 #endif
     }
 
-    fwrite(log, size, 1, fp);
+    if (local_cfg.binary) {
+        return slog_file_write_binary(iov, iovcnt);
+    }
+
+    return slog_file_write_text(iov, iovcnt);
+}
+
+/**
+ * flush and sync the logs written since the last flush, called once per batch
+ */
+void slog_file_flush(void)
+{
+    if (NULL == fp) {
+        return;
+    }
 
-    fflush(fp);
     fsync(fd);
 }
 
+/**
+ * descriptor of the text log file, for the fatal signal handler to write
+ * to directly
+ *
+ * @return fd, -1 no file or a binary one
+ */
+int slog_file_text_fd(void)
+{
+    return ((NULL == fp) || local_cfg.binary) ? -1 : fd;
+}
+
 void slog_file_deinit(void)
 {
     if (NULL != fp) {
+        slog_file_index_close(false);
+
         fflush(fp);
         fsync(fd);
 
         fclose(fp);
         fp = NULL;
     }
+
+    slog_file_index_deinit();
 }
 
 
@@ -0,0 +1,254 @@
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <time.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <sys/time.h>
+
+#include "log2.h"
+#include "logger.h"
+#include "slog_cfg.h"
+#include "slog_fifo.h"
+#include "slog_port.h"
+#include "slog_event.h"
+#include "slog_inner.h"
+#include "slog_flight.h"
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE MACROS -------------------------------------------- */
+
+/* ms a dump waits for room in the file sink, on the output thread, the rest is dropped after */
+#define SLOG_FLIGHT_DUMP_WAIT                1000
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE TYPES --------------------------------------------- */
+
+/* history of the logs not output, the output thread's own */
+typedef struct slog_flight_s {
+    char *ring_buf;                          /* NULL no flight recorder */
+    struct kfifo ring;
+    uint8_t level;                           /* levels above it are kept only */
+    int64_t span;                            /* us of history dumped, 0 all */
+} slog_flight_t;
+
+/* a fatal signal's walk of the history, the span before it only */
+typedef struct slog_flight_walk_s {
+    slog_event_walk_t walk;
+    void *arg;
+    int64_t since;                           /* us, older events are skipped */
+} slog_flight_walk_t;
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE VARIABLES ----------------------------------------- */
+
+static slog_flight_t slog_flight;
+
+/* set by slog_flight_dump(), taken by the output thread */
+static int slog_flight_requested;
+
+static char slog_flight_event_buf[SLOG_EVENT_BUF_MAXLEN];
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE FUNCTIONS DEFINITION ------------------------------ */
+
+static int64_t slog_flight_event_time(const slog_event_head_t *head)
+{
+    return (int64_t)head->slog_time.tv_sec * 1000000 + head->slog_time.tv_usec;
+}
+
+/*
+ * keep an event, the oldest ones make room
+ */
+static void slog_flight_keep(const void *slog_event_buf)
+{
+    uint32_t length = ((const slog_event_head_t *)slog_event_buf)->slog_event_length;
+    slog_event_head_t oldest;
+
+    while (kfifo_avail(&slog_flight.ring) < length) {
+        if (sizeof(oldest) != kfifo_out_peek(&slog_flight.ring, &oldest, sizeof(oldest))) {
+            kfifo_reset_out(&slog_flight.ring);
+            break;
+        }
+        slog_flight.ring.kfifo.out += oldest.slog_event_length;
+    }
+
+    kfifo_in(&slog_flight.ring, slog_event_buf, length);
+}
+
+/*
+ * dump the history to the file sink and empty the ring
+ *
+ * @param until us, the trigger's time, history older than the span before it is discarded
+ */
+static void slog_flight_flush(int64_t until)
+{
+    unsigned long dumped = 0, dropped = 0;
+    bool late = false;
+    struct timespec deadline;
+    const slog_event_head_t *head = (const slog_event_head_t *)slog_flight_event_buf;
+
+    /* one deadline for the whole dump, a stalled file sink holds the output thread that long at most */
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += SLOG_FLIGHT_DUMP_WAIT / 1000;
+    deadline.tv_nsec += (long)(SLOG_FLIGHT_DUMP_WAIT % 1000) * 1000000;
+    if (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+
+    while (!kfifo_is_empty(&slog_flight.ring)) {
+        if (0 == slog_event_fifo_get(&slog_flight.ring, slog_flight_event_buf)) {
+            kfifo_reset_out(&slog_flight.ring);
+            break;
+        }
+        if ((0 != slog_flight.span) && (slog_flight_event_time(head) < until - slog_flight.span)) {
+            continue;
+        }
+
+        if (late || (slog_port_dump(slog_flight_event_buf, &deadline) < 0)) {
+            late = true;
+            dropped++;
+            continue;
+        }
+        dumped++;
+    }
+
+    slog_debug_inner("flight recorder dumped %lu logs", dumped);
+    if (0 != dropped) {
+        slog_warn_inner("flight recorder dropped %lu logs the file sink had no room for in %dms",
+                        dropped, SLOG_FLIGHT_DUMP_WAIT);
+    }
+}
+
+static void slog_flight_walk_event(const void *slog_event_buf, void *arg)
+{
+    const slog_flight_walk_t *flight_walk = (const slog_flight_walk_t *)arg;
+
+    if (slog_flight_event_time((const slog_event_head_t *)slog_event_buf) >= flight_walk->since) {
+        flight_walk->walk(slog_event_buf, flight_walk->arg);
+    }
+}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC FUNCTIONS DEFINITION ------------------------------- */
+
+/**
+ * flight recorder initialize, by the configured FLIGHT_LEVEL
+ *
+ * @return result
+ */
+int slog_flight_init(void)
+{
+    size_t size = 0;
+
+    slog_flight.level = slog_get_flight_level();
+    slog_flight.span = (int64_t)slog_get_flight_span() * 1000000;
+    if (slog_flight.level >= VERBOSE) {
+        return 0;
+    }
+
+    size = roundup_pow_of_two((size_t)slog_get_flight_size() * 1024 * 1024);
+    slog_flight.ring_buf = (char *)calloc(1, size);
+    if (NULL == slog_flight.ring_buf) {
+        slog_error_inner("flight recorder calloc error");
+        return -1;
+    }
+
+    return kfifo_init(&slog_flight.ring, slog_flight.ring_buf, size);
+}
+
+/**
+ * route an event through the flight recorder, on the output thread. An
+ * ERROR or ASSERT log dumps the history before it is output itself.
+ *
+ * @param slog_event_buf log event
+ *
+ * @return true the event is kept only, not output
+ */
+bool slog_flight_record(const void *slog_event_buf)
+{
+    const slog_event_head_t *head = (const slog_event_head_t *)slog_event_buf;
+
+    if (NULL == slog_flight.ring_buf) {
+        return false;
+    }
+
+    if ((head->slog_level > slog_flight.level) && (head->slog_level > ERROR)) {
+        slog_flight_keep(slog_event_buf);
+        return true;
+    }
+
+    if ((head->slog_level <= ERROR) && !kfifo_is_empty(&slog_flight.ring)) {
+        slog_flight_flush(slog_flight_event_time(head));
+    }
+
+    return false;
+}
+
+/**
+ * dump the history slog_flight_dump() asked for, on the output thread once
+ * it output the logs before the ask
+ */
+void slog_flight_poll(void)
+{
+    struct timeval now;
+
+    if (!__sync_lock_test_and_set(&slog_flight_requested, 0) || (NULL == slog_flight.ring_buf)) {
+        return;
+    }
+
+    gettimeofday(&now, NULL);
+    slog_flight_flush((int64_t)now.tv_sec * 1000000 + now.tv_usec);
+}
+
+/**
+ * walk the history a dump would write, without taking it out or locking,
+ * for the fatal signal handler
+ *
+ * @param slog_event_buf SLOG_EVENT_BUF_MAXLEN bytes each event is copied to
+ * @param walk called for each event
+ * @param arg passed to walk
+ */
+void slog_flight_walk(void *slog_event_buf, slog_event_walk_t walk, void *arg)
+{
+    slog_flight_walk_t flight_walk = { .walk = walk, .arg = arg, .since = INT64_MIN };
+    struct timespec now;
+
+    if (NULL == slog_flight.ring_buf) {
+        return;
+    }
+
+    if (0 != slog_flight.span) {
+        clock_gettime(CLOCK_REALTIME, &now);
+        flight_walk.since = (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000 - slog_flight.span;
+    }
+
+    slog_event_fifo_walk(&slog_flight.ring, 0, slog_event_buf, slog_flight_walk_event, &flight_walk);
+}
+
+void slog_flight_deinit(void)
+{
+    if (NULL != slog_flight.ring_buf) {
+        free(slog_flight.ring_buf);
+        slog_flight.ring_buf = NULL;
+    }
+}
+
+/**
+ * dump the flight recorder's history to the file sink, as an ERROR log
+ * does. No-op without FLIGHT_LEVEL.
+ */
+void slog_flight_dump(void)
+{
+    __sync_lock_test_and_set(&slog_flight_requested, 1);
+}
+
+
+/* ============== EOF ======================================================= */
\ No newline at end of file
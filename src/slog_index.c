@@ -0,0 +1,277 @@
+
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <stdio.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "slog_crc32.h"
+#include "slog_index.h"
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE FUNCTIONS DEFINITION ------------------------------ */
+
+static void slog_index_put16(char *p, uint16_t v)
+{
+    p[0] = (char)v;
+    p[1] = (char)(v >> 8);
+}
+
+static void slog_index_put32(char *p, uint32_t v)
+{
+    p[0] = (char)v;
+    p[1] = (char)(v >> 8);
+    p[2] = (char)(v >> 16);
+    p[3] = (char)(v >> 24);
+}
+
+static void slog_index_put64(char *p, uint64_t v)
+{
+    slog_index_put32(p, (uint32_t)v);
+    slog_index_put32(p + 4, (uint32_t)(v >> 32));
+}
+
+static uint16_t slog_index_get16(const char *p)
+{
+    const uint8_t *u = (const uint8_t *)p;
+
+    return (uint16_t)(u[0] | (u[1] << 8));
+}
+
+static uint32_t slog_index_get32(const char *p)
+{
+    const uint8_t *u = (const uint8_t *)p;
+
+    return (uint32_t)u[0] | ((uint32_t)u[1] << 8) | ((uint32_t)u[2] << 16) | ((uint32_t)u[3] << 24);
+}
+
+static uint64_t slog_index_get64(const char *p)
+{
+    return (uint64_t)slog_index_get32(p) | ((uint64_t)slog_index_get32(p + 4) << 32);
+}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC FUNCTIONS DEFINITION ------------------------------- */
+
+/**
+ * build the index head, SLOG_INDEX_HEAD_SIZE bytes
+ *
+ * @param interval KB of logs per entry
+ */
+void slog_index_head(char *head, uint32_t interval)
+{
+    memcpy(head, SLOG_INDEX_MAGIC, 8);
+    slog_index_put16(head + 8, SLOG_INDEX_VERSION);
+    slog_index_put16(head + 10, SLOG_INDEX_HEAD_SIZE);
+    slog_index_put32(head + 12, interval);
+}
+
+/**
+ * check an index read whole, a torn entry at the end of a live index is
+ * not counted
+ *
+ * @param data index bytes
+ * @param len index length
+ * @param count complete entries
+ * @param final set when the trailer is there and matches the entries
+ *
+ * @return head size, the first entry's offset, -1 not an index
+ */
+int slog_index_check(const char *data, size_t len, size_t *count, int *final)
+{
+    size_t head, rest;
+
+    if ((len < SLOG_INDEX_HEAD_SIZE) || (0 != memcmp(data, SLOG_INDEX_MAGIC, 8)) ||
+        (SLOG_INDEX_VERSION != slog_index_get16(data + 8))) {
+        return -1;
+    }
+
+    head = slog_index_get16(data + 10);
+    if ((head < SLOG_INDEX_HEAD_SIZE) || (head > len)) {
+        return -1;
+    }
+
+    rest = len - head;
+    *count = rest / SLOG_INDEX_ENTRY_SIZE;
+    *final = 0;
+
+    if ((SLOG_INDEX_TRAILER_SIZE == rest % SLOG_INDEX_ENTRY_SIZE) &&
+        (0 == memcmp(data + len - SLOG_INDEX_TRAILER_SIZE, SLOG_INDEX_TRAILER_MAGIC, 8)) &&
+        (*count == slog_index_get32(data + len - 8)) &&
+        (slog_crc32(0, data + head, *count * SLOG_INDEX_ENTRY_SIZE) == slog_index_get32(data + len - 4))) {
+        *final = 1;
+    }
+
+    return (int)head;
+}
+
+/**
+ * encode one entry, SLOG_INDEX_ENTRY_SIZE bytes
+ */
+void slog_index_entry_encode(char *data, const slog_index_entry_t *entry)
+{
+    slog_index_put64(data, entry->offset);
+    slog_index_put32(data + 8, entry->length);
+    slog_index_put32(data + 12, entry->count);
+    slog_index_put64(data + 16, (uint64_t)entry->min_time);
+    slog_index_put64(data + 24, (uint64_t)entry->max_time);
+    memset(data + 32, 0, SLOG_INDEX_ENTRY_SIZE - 32);
+    data[32] = (char)entry->level_mask;
+}
+
+void slog_index_entry_decode(const char *data, slog_index_entry_t *entry)
+{
+    entry->offset = slog_index_get64(data);
+    entry->length = slog_index_get32(data + 8);
+    entry->count = slog_index_get32(data + 12);
+    entry->min_time = (int64_t)slog_index_get64(data + 16);
+    entry->max_time = (int64_t)slog_index_get64(data + 24);
+    entry->level_mask = (uint8_t)data[32];
+}
+
+/**
+ * build the trailer of a finalized index, SLOG_INDEX_TRAILER_SIZE bytes
+ *
+ * @param count entries in the index
+ * @param crc slog_crc32() of all the entries
+ */
+void slog_index_trailer(char *trailer, uint32_t count, uint32_t crc)
+{
+    memcpy(trailer, SLOG_INDEX_TRAILER_MAGIC, 8);
+    slog_index_put32(trailer + 8, count);
+    slog_index_put32(trailer + 12, crc);
+}
+
+/**
+ * find the parts of a segment a query has to read: the entries that may
+ * hold matching logs and every unindexed range. Adjacent ranges are merged.
+ *
+ * @param data index bytes
+ * @param len index length
+ * @param file_size segment size
+ * @param file_head segment bytes before the first log
+ * @param query time range and levels
+ * @param cb called with each range
+ * @param arg passed to cb
+ *
+ * @return ranges found, -1 the index does not match the segment
+ */
+int slog_index_select(const char *data, size_t len, uint64_t file_size, uint64_t file_head,
+                      const slog_index_query_t *query, slog_index_range_cb cb, void *arg)
+{
+    int head, final;
+    size_t i, count;
+    uint64_t pos = file_head;
+    slog_index_entry_t entry;
+    slog_index_ranges_t ranges = { .cb = cb, .arg = arg };
+
+    head = slog_index_check(data, len, &count, &final);
+    if (head < 0) {
+        return -1;
+    }
+
+    /* entries in file order, inside the segment */
+    for (i = 0; i < count; ++i) {
+        slog_index_entry_decode(data + head + i * SLOG_INDEX_ENTRY_SIZE, &entry);
+        if ((entry.offset < pos) || (entry.offset + entry.length > file_size)) {
+            return -1;
+        }
+        pos = entry.offset + entry.length;
+    }
+
+    /* unindexed bytes before each entry, then the entry when it may match */
+    pos = file_head;
+    for (i = 0; i < count; ++i) {
+        slog_index_entry_decode(data + head + i * SLOG_INDEX_ENTRY_SIZE, &entry);
+        slog_index_range_add(&ranges, pos, entry.offset - pos);
+        if ((entry.max_time >= query->start) && (entry.min_time <= query->end) &&
+            (0 != (entry.level_mask & query->level_mask))) {
+            slog_index_range_add(&ranges, entry.offset, entry.length);
+        }
+        pos = entry.offset + entry.length;
+    }
+    slog_index_range_add(&ranges, pos, file_size - pos);
+
+    return slog_index_range_done(&ranges);
+}
+
+/**
+ * add a range to read, merged with the one before when they touch
+ */
+void slog_index_range_add(slog_index_ranges_t *ranges, uint64_t offset, uint64_t length)
+{
+    if (0 == length) {
+        return;
+    }
+
+    if ((ranges->end == offset) && (ranges->end > ranges->start)) {
+        ranges->end += length;
+        return;
+    }
+
+    slog_index_range_done(ranges);
+    ranges->start = offset;
+    ranges->end = offset + length;
+}
+
+/**
+ * pass on the range being merged
+ *
+ * @return ranges passed to cb so far
+ */
+int slog_index_range_done(slog_index_ranges_t *ranges)
+{
+    if (ranges->end > ranges->start) {
+        ranges->cb(ranges->start, ranges->end - ranges->start, ranges->arg);
+        ranges->found++;
+        ranges->start = ranges->end;
+    }
+
+    return ranges->found;
+}
+
+/**
+ * read a file kept beside a segment whole, its index or filters, for the
+ * offline readers
+ *
+ * @param segment log file name
+ * @param suffix SLOG_INDEX_SUFFIX or SLOG_BLOOM_SUFFIX
+ * @param len file length
+ *
+ * @return file bytes to free(), NULL no such file
+ */
+char *slog_index_read(const char *segment, const char *suffix, size_t *len)
+{
+    int fd;
+    char path[PATH_MAX];
+    char *data = NULL;
+    struct stat statbuf;
+
+    snprintf(path, sizeof(path), "%s%s", segment, suffix);
+    fd = open(path, O_RDONLY);
+    if (-1 == fd) {
+        return NULL;
+    }
+
+    if ((0 == fstat(fd, &statbuf)) && (statbuf.st_size > 0)) {
+        data = (char *)malloc(statbuf.st_size);
+        if ((NULL != data) && (statbuf.st_size != read(fd, data, statbuf.st_size))) {
+            free(data);
+            data = NULL;
+        }
+        *len = statbuf.st_size;
+    }
+    close(fd);
+
+    return data;
+}
+
+
+/* ============== EOF ======================================================= */
\ No newline at end of file
@@ -0,0 +1,242 @@
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <time.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "slog_cfg.h"
+#include "slog_inner.h"
+#include "slog_stats.h"
+#include "slog_latency.h"
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE MACROS -------------------------------------------- */
+
+/* histograms, a thread has its own, threads beyond share them */
+#define SLOG_LATENCY_THREADS                 64
+
+#define SLOG_LATENCY_SUB_COUNT               (1U << SLOG_STATS_CALL_SUB_BITS)
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE TYPES --------------------------------------------- */
+
+#ifdef SLOG_LATENCY_STATS
+/* a thread's samples, a cache line apart from the others' */
+typedef struct slog_latency_hist_s {
+    unsigned long count;
+    uint64_t sum;
+    uint64_t max;
+    unsigned long buckets[SLOG_STATS_CALL_BUCKETS];
+} __attribute__((aligned(64))) slog_latency_hist_t;
+#endif
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE VARIABLES ----------------------------------------- */
+
+#ifdef SLOG_LATENCY_STATS
+static slog_latency_hist_t slog_latency_hists[SLOG_LATENCY_THREADS];
+static unsigned int slog_latency_next_hist;
+
+/* one call in it is sampled, 0 none */
+static unsigned int slog_latency_sample;
+
+static __thread slog_latency_hist_t *slog_latency_hist;
+static __thread unsigned int slog_latency_countdown;
+#endif
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE FUNCTIONS DEFINITION ------------------------------ */
+
+#ifdef SLOG_LATENCY_STATS
+static uint64_t slog_latency_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static unsigned int slog_latency_bucket(uint64_t ns)
+{
+    unsigned int exp, bucket;
+
+    if (ns < SLOG_LATENCY_SUB_COUNT) {
+        return (unsigned int)ns;
+    }
+
+    /* the top bits after the leading one pick the linear bucket */
+    exp = 63 - __builtin_clzll(ns);
+    bucket = ((exp - SLOG_STATS_CALL_SUB_BITS + 1) << SLOG_STATS_CALL_SUB_BITS) +
+             (unsigned int)((ns >> (exp - SLOG_STATS_CALL_SUB_BITS)) & (SLOG_LATENCY_SUB_COUNT - 1));
+
+    return (bucket < SLOG_STATS_CALL_BUCKETS) ? bucket : SLOG_STATS_CALL_BUCKETS - 1;
+}
+#endif
+
+/*
+ * highest ns of a bucket
+ */
+static uint64_t slog_latency_bucket_max(unsigned int bucket)
+{
+    unsigned int shift;
+
+    if (bucket < SLOG_LATENCY_SUB_COUNT) {
+        return bucket;
+    }
+
+    shift = (bucket >> SLOG_STATS_CALL_SUB_BITS) - 1;
+
+    return (((uint64_t)SLOG_LATENCY_SUB_COUNT + (bucket & (SLOG_LATENCY_SUB_COUNT - 1)) + 1) << shift) - 1;
+}
+
+/*
+ * ns the given permille of the samples are under or at
+ */
+static uint64_t slog_latency_quantile(const slog_call_stats_t *stats, unsigned int permille)
+{
+    unsigned long rank = (unsigned long)((stats->count * (uint64_t)permille + 999) / 1000);
+    unsigned long seen = 0;
+    unsigned int i;
+
+    for (i = 0; i < SLOG_STATS_CALL_BUCKETS; ++i) {
+        seen += stats->buckets[i];
+        if ((0 != seen) && (seen >= rank)) {
+            return slog_latency_bucket_max(i);
+        }
+    }
+
+    return stats->max;
+}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC FUNCTIONS DEFINITION ------------------------------- */
+
+/**
+ * call latency initialize, by the configured LATENCY_SAMPLE. No-op built
+ * without SLOG_LATENCY_STATS.
+ */
+void slog_latency_init(void)
+{
+#ifdef SLOG_LATENCY_STATS
+    memset(slog_latency_hists, 0, sizeof(slog_latency_hists));
+    __atomic_store_n(&slog_latency_sample, slog_get_latency_sample(), __ATOMIC_RELAXED);
+#endif
+}
+
+#ifdef SLOG_LATENCY_STATS
+/**
+ * start timing a slog() call, one in LATENCY_SAMPLE is
+ *
+ * @return ns the call started at, 0 it is not sampled
+ */
+uint64_t slog_latency_begin(void)
+{
+    unsigned int sample = __atomic_load_n(&slog_latency_sample, __ATOMIC_RELAXED);
+
+    if (0 == sample) {
+        return 0;
+    }
+
+    if (slog_latency_countdown > 1) {
+        slog_latency_countdown--;
+        return 0;
+    }
+    slog_latency_countdown = sample;
+
+    return slog_latency_now();
+}
+
+/**
+ * count a sampled call into the calling thread's histogram
+ *
+ * @param start slog_latency_begin()'s
+ */
+void slog_latency_end(uint64_t start)
+{
+    slog_latency_hist_t *hist = slog_latency_hist;
+    uint64_t ns;
+
+    if (0 == start) {
+        return;
+    }
+    ns = slog_latency_now() - start;
+
+    if (NULL == hist) {
+        hist = &slog_latency_hists[__atomic_fetch_add(&slog_latency_next_hist, 1, __ATOMIC_RELAXED) %
+                                   SLOG_LATENCY_THREADS];
+        slog_latency_hist = hist;
+    }
+
+    __atomic_add_fetch(&hist->buckets[slog_latency_bucket(ns)], 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&hist->sum, ns, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&hist->count, 1, __ATOMIC_RELAXED);
+    if (ns > __atomic_load_n(&hist->max, __ATOMIC_RELAXED)) {
+        __atomic_store_n(&hist->max, ns, __ATOMIC_RELAXED);
+    }
+}
+#endif
+
+/**
+ * merge the threads' histograms, from any thread. Zero built without
+ * SLOG_LATENCY_STATS.
+ */
+void slog_latency_get(slog_call_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+
+#ifdef SLOG_LATENCY_STATS
+    int i, bucket;
+    uint64_t max;
+
+    for (i = 0; i < SLOG_LATENCY_THREADS; ++i) {
+        for (bucket = 0; bucket < SLOG_STATS_CALL_BUCKETS; ++bucket) {
+            stats->buckets[bucket] += __atomic_load_n(&slog_latency_hists[i].buckets[bucket], __ATOMIC_RELAXED);
+        }
+        stats->sum += __atomic_load_n(&slog_latency_hists[i].sum, __ATOMIC_RELAXED);
+        max = __atomic_load_n(&slog_latency_hists[i].max, __ATOMIC_RELAXED);
+        if (max > stats->max) {
+            stats->max = max;
+        }
+    }
+    /* counted off the buckets, they agree with the percentiles then */
+    for (bucket = 0; bucket < SLOG_STATS_CALL_BUCKETS; ++bucket) {
+        stats->count += stats->buckets[bucket];
+    }
+#endif
+
+    if (0 != stats->count) {
+        stats->p50 = slog_latency_quantile(stats, 500);
+        stats->p90 = slog_latency_quantile(stats, 900);
+        stats->p99 = slog_latency_quantile(stats, 990);
+        stats->p999 = slog_latency_quantile(stats, 999);
+    }
+}
+
+/**
+ * report the calls' latency to the inner log, at log_fini()
+ */
+void slog_latency_deinit(void)
+{
+    slog_call_stats_t stats;
+
+    slog_latency_get(&stats);
+    if (0 == stats.count) {
+        return;
+    }
+
+    slog_debug_inner("log call latency of %lu calls sampled: mean %lluns p50 %lluns p90 %lluns p99 %lluns "
+                     "p99.9 %lluns max %lluns", stats.count, (unsigned long long)(stats.sum / stats.count),
+                     (unsigned long long)stats.p50, (unsigned long long)stats.p90,
+                     (unsigned long long)stats.p99, (unsigned long long)stats.p999,
+                     (unsigned long long)stats.max);
+}
+
+
+/* ============== EOF ======================================================= */
\ No newline at end of file
@@ -0,0 +1,380 @@
+
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <string.h>
+
+#include "slog_lz.h"
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE MACROS -------------------------------------------- */
+
+/* LZ4 block rules */
+#define SLOG_LZ_MINMATCH                     4
+#define SLOG_LZ_MFLIMIT                      12    /* last match starts this far from the end */
+#define SLOG_LZ_LASTLITERALS                 5     /* block always ends with literals */
+#define SLOG_LZ_MAX_DISTANCE                 65535
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE FUNCTIONS DEFINITION ------------------------------ */
+
+static inline uint32_t slog_lz_read32(const uint8_t *p)
+{
+    uint32_t v;
+
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t slog_lz_hash(const uint8_t *p)
+{
+    return (slog_lz_read32(p) * 2654435761U) >> (32 - SLOG_LZ_HASH_LOG);
+}
+
+static void slog_lz_put32(char *p, uint32_t v)
+{
+    p[0] = (char)(v >> 24);
+    p[1] = (char)(v >> 16);
+    p[2] = (char)(v >> 8);
+    p[3] = (char)v;
+}
+
+static uint32_t slog_lz_get32(const char *p)
+{
+    const uint8_t *u = (const uint8_t *)p;
+
+    return ((uint32_t)u[0] << 24) | ((uint32_t)u[1] << 16) | ((uint32_t)u[2] << 8) | u[3];
+}
+
+/*
+ * LZ4 length continuation bytes
+ */
+static uint8_t *slog_lz_put_len(uint8_t *op, size_t len)
+{
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = (uint8_t)len;
+
+    return op;
+}
+
+/*
+ * keep only the last SLOG_LZ_WINDOW bytes when len more do not fit
+ */
+static void slog_lz_slide(slog_lz_t *lz, size_t len)
+{
+    size_t i, shift;
+
+    if (lz->len + len <= sizeof(lz->buf)) {
+        return;
+    }
+
+    shift = lz->len - SLOG_LZ_WINDOW;
+    memmove(lz->buf, lz->buf + shift, SLOG_LZ_WINDOW);
+    lz->len = SLOG_LZ_WINDOW;
+
+    for (i = 0; i < (1 << SLOG_LZ_HASH_LOG); ++i) {
+        lz->table[i] = (lz->table[i] > shift) ? lz->table[i] - shift : 0;
+    }
+}
+
+/*
+ * compress buf[start, end) into one LZ4 block, matches may reach back into
+ * the dictionary before start
+ *
+ * @return block length, 0 when it does not fit in cap
+ */
+static size_t slog_lz_compress_block(slog_lz_t *lz, size_t start, size_t end, uint8_t *dst, size_t cap)
+{
+    const uint8_t *base = (const uint8_t *)lz->buf;
+    size_t ip = start, anchor = start, ref, mlen, llen;
+    uint32_t h, cand;
+    uint8_t *op = dst, *oend = dst + cap, *token = NULL;
+
+    while (ip + SLOG_LZ_MFLIMIT <= end) {
+        h = slog_lz_hash(base + ip);
+        cand = lz->table[h];
+        lz->table[h] = (uint32_t)ip + 1;
+
+        if (0 == cand) {
+            ip++;
+            continue;
+        }
+        ref = cand - 1;
+        if ((ip - ref > SLOG_LZ_MAX_DISTANCE) || (slog_lz_read32(base + ref) != slog_lz_read32(base + ip))) {
+            ip++;
+            continue;
+        }
+
+        while ((ip > anchor) && (ref > 0) && (base[ip - 1] == base[ref - 1])) {
+            ip--;
+            ref--;
+        }
+
+        mlen = SLOG_LZ_MINMATCH;
+        while ((ip + mlen < end - SLOG_LZ_LASTLITERALS) && (base[ip + mlen] == base[ref + mlen])) {
+            mlen++;
+        }
+
+        llen = ip - anchor;
+        if ((size_t)(oend - op) < 1 + llen + llen / 255 + 1 + 2 + mlen / 255 + 1) {
+            return 0;
+        }
+
+        token = op++;
+        if (llen >= 15) {
+            *token = 15 << 4;
+            op = slog_lz_put_len(op, llen - 15);
+        } else {
+            *token = (uint8_t)(llen << 4);
+        }
+        memcpy(op, base + anchor, llen);
+        op += llen;
+
+        *op++ = (uint8_t)(ip - ref);
+        *op++ = (uint8_t)((ip - ref) >> 8);
+
+        if (mlen - SLOG_LZ_MINMATCH >= 15) {
+            *token |= 15;
+            op = slog_lz_put_len(op, mlen - SLOG_LZ_MINMATCH - 15);
+        } else {
+            *token |= (uint8_t)(mlen - SLOG_LZ_MINMATCH);
+        }
+
+        ip += mlen;
+        anchor = ip;
+        if (ip + SLOG_LZ_MFLIMIT <= end) {
+            lz->table[slog_lz_hash(base + ip - 2)] = (uint32_t)(ip - 2) + 1;
+        }
+    }
+
+    llen = end - anchor;
+    if ((size_t)(oend - op) < 1 + llen + llen / 255 + 1) {
+        return 0;
+    }
+
+    token = op++;
+    if (llen >= 15) {
+        *token = 15 << 4;
+        op = slog_lz_put_len(op, llen - 15);
+    } else {
+        *token = (uint8_t)(llen << 4);
+    }
+    memcpy(op, base + anchor, llen);
+    op += llen;
+
+    return op - dst;
+}
+
+/*
+ * read an LZ4 length continuation
+ *
+ * @return -1 truncated
+ */
+static int slog_lz_get_len(const uint8_t **ip, const uint8_t *iend, size_t *len)
+{
+    uint8_t b;
+
+    do {
+        if (*ip >= iend) {
+            return -1;
+        }
+        b = *(*ip)++;
+        *len += b;
+    } while (255 == b);
+
+    return 0;
+}
+
+/*
+ * decode one LZ4 block behind the dictionary kept in buf
+ *
+ * @return result
+ */
+static int slog_lz_decompress_block(slog_lz_t *lz, const uint8_t *src, size_t len, size_t raw_len)
+{
+    const uint8_t *ip = src, *iend = src + len;
+    uint8_t *base = (uint8_t *)lz->buf;
+    uint8_t *op = base + lz->len, *oend = op + raw_len;
+    size_t llen, mlen, offset;
+    uint8_t token;
+
+    while (ip < iend) {
+        token = *ip++;
+
+        llen = token >> 4;
+        if ((15 == llen) && (0 != slog_lz_get_len(&ip, iend, &llen))) {
+            return -1;
+        }
+        if (((size_t)(iend - ip) < llen) || ((size_t)(oend - op) < llen)) {
+            return -1;
+        }
+        memcpy(op, ip, llen);
+        ip += llen;
+        op += llen;
+
+        if (ip == iend) {
+            /* last literals */
+            break;
+        }
+
+        if (iend - ip < 2) {
+            return -1;
+        }
+        offset = ip[0] | ((size_t)ip[1] << 8);
+        ip += 2;
+        if ((0 == offset) || (offset > (size_t)(op - base))) {
+            return -1;
+        }
+
+        mlen = token & 15;
+        if ((15 == mlen) && (0 != slog_lz_get_len(&ip, iend, &mlen))) {
+            return -1;
+        }
+        mlen += SLOG_LZ_MINMATCH;
+        if ((size_t)(oend - op) < mlen) {
+            return -1;
+        }
+
+        /* the match may overlap the bytes it produces */
+        while (mlen-- > 0) {
+            *op = *(op - offset);
+            op++;
+        }
+    }
+
+    return (op == oend) ? 0 : -1;
+}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC FUNCTIONS DEFINITION ------------------------------- */
+
+/**
+ * drop the dictionary, the next frame starts a new stream
+ */
+void slog_lz_reset(slog_lz_t *lz)
+{
+    lz->len = 0;
+    memset(lz->table, 0, sizeof(lz->table));
+}
+
+/**
+ * encode the iovecs as one frame, linked to the frames before it when the
+ * dictionary is not empty. An incompressible block is stored raw.
+ *
+ * @param lz encoder stream
+ * @param iov raw bytes, SLOG_LZ_BLOCK_MAX in total at most
+ * @param iovcnt iovec count
+ * @param frame output, SLOG_LZ_FRAME_MAX bytes
+ *
+ * @return frame length, -1 error
+ */
+int slog_lz_frame_encode(slog_lz_t *lz, const struct iovec *iov, int iovcnt, char *frame)
+{
+    int i;
+    uint8_t flags = 0;
+    size_t start, comp_len, raw_len = 0;
+
+    for (i = 0; i < iovcnt; ++i) {
+        raw_len += iov[i].iov_len;
+    }
+    if (raw_len > SLOG_LZ_BLOCK_MAX) {
+        return -1;
+    }
+
+    if (lz->len > 0) {
+        flags |= SLOG_LZ_FLAG_LINKED;
+    }
+
+    slog_lz_slide(lz, raw_len);
+    start = lz->len;
+    for (i = 0; i < iovcnt; ++i) {
+        memcpy(lz->buf + lz->len, iov[i].iov_base, iov[i].iov_len);
+        lz->len += iov[i].iov_len;
+    }
+
+    /* only worth it when smaller */
+    comp_len = (raw_len > 0) ? slog_lz_compress_block(lz, start, lz->len, (uint8_t *)frame + SLOG_LZ_HEAD_SIZE,
+                                                      raw_len - 1) : 0;
+    if (comp_len > 0) {
+        flags |= SLOG_LZ_FLAG_COMPRESSED;
+    } else {
+        memcpy(frame + SLOG_LZ_HEAD_SIZE, lz->buf + start, raw_len);
+        comp_len = raw_len;
+    }
+
+    memcpy(frame, SLOG_LZ_MAGIC, 4);
+    frame[4] = (char)flags;
+    frame[5] = frame[6] = frame[7] = 0;
+    slog_lz_put32(frame + 8, (uint32_t)raw_len);
+    slog_lz_put32(frame + 12, (uint32_t)comp_len);
+
+    return (int)(SLOG_LZ_HEAD_SIZE + comp_len);
+}
+
+/**
+ * reference decoder, decode the frame at the head of a received stream.
+ *
+ * @param lz decoder stream
+ * @param data received bytes
+ * @param len received bytes length
+ * @param raw decoded bytes, valid until the next call
+ * @param raw_len decoded bytes length
+ *
+ * @return frame length consumed, 0 frame incomplete, -1 corrupt stream
+ */
+int slog_lz_frame_decode(slog_lz_t *lz, const char *data, size_t len, const char **raw, size_t *raw_len)
+{
+    uint8_t flags;
+    size_t start;
+    uint32_t raw_size, comp_size;
+
+    if (len < SLOG_LZ_HEAD_SIZE) {
+        return 0;
+    }
+
+    if (0 != memcmp(data, SLOG_LZ_MAGIC, 4)) {
+        return -1;
+    }
+    flags = (uint8_t)data[4];
+    raw_size = slog_lz_get32(data + 8);
+    comp_size = slog_lz_get32(data + 12);
+    if ((raw_size > SLOG_LZ_BLOCK_MAX) || (comp_size > SLOG_LZ_BLOCK_MAX)) {
+        return -1;
+    }
+
+    if (len < SLOG_LZ_HEAD_SIZE + comp_size) {
+        return 0;
+    }
+
+    if (!(flags & SLOG_LZ_FLAG_LINKED)) {
+        lz->len = 0;
+    }
+    slog_lz_slide(lz, raw_size);
+    start = lz->len;
+
+    if (flags & SLOG_LZ_FLAG_COMPRESSED) {
+        if (0 != slog_lz_decompress_block(lz, (const uint8_t *)data + SLOG_LZ_HEAD_SIZE, comp_size, raw_size)) {
+            return -1;
+        }
+    } else {
+        if (comp_size != raw_size) {
+            return -1;
+        }
+        memcpy(lz->buf + start, data + SLOG_LZ_HEAD_SIZE, raw_size);
+    }
+    lz->len += raw_size;
+
+    *raw = lz->buf + start;
+    *raw_len = raw_size;
+
+    return (int)(SLOG_LZ_HEAD_SIZE + comp_size);
+}
+
+
+/* ============== EOF ======================================================= */
\ No newline at end of file
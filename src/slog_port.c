@@ -4,6 +4,7 @@
 /* -------------- DEPENDANCIES ---------------------------------------------- */
 
 #include <stdio.h>
+#include <string.h>
 #include <unistd.h>
 #include <pthread.h>
 #include <stdbool.h>
@@ -15,79 +16,117 @@
 #include "slog_port.h"
 #include "slog_file.h"
 #include "slog_tcp.h"
+#include "slog_term.h"
+#include "slog_sink_int.h"
 
 
 /* -------------------------------------------------------------------------- */
 /* -------------- PRIVATE MACROS -------------------------------------------- */
 
-/**
- * CSI(Control Sequence Introducer/Initiator) sign
- */
-#define CSI_START                      "\033["
-#define CSI_END                        "\033[0m"
-
-/* output log front color */
-#define F_BLACK                        "30;"
-#define F_RED                          "31;"
-#define F_GREEN                        "32;"
-#define F_YELLOW                       "33;"
-#define F_BLUE                         "34;"
-#define F_MAGENTA                      "35;"
-#define F_CYAN                         "36;"
-#define F_WHITE                        "37;"
-
-/* output log background color */
-#define B_NULL
-#define B_BLACK                        "40;"
-#define B_RED                          "41;"
-#define B_GREEN                        "42;"
-#define B_YELLOW                       "43;"
-#define B_BLUE                         "44;"
-#define B_MAGENTA                      "45;"
-#define B_CYAN                         "46;"
-#define B_WHITE                        "47;"
-
-/* output log fonts style */
-#define S_BOLD                         "1m"
-#define S_UNDERLINE                    "4m"
-#define S_BLINK                        "5m"
-#define S_NORMAL                       "22m"
-/* output log default color definition: [front color] + [background color] + [show style] */
-
-#define SLOG_COLOR_ASSERT              (F_MAGENTA B_NULL S_BOLD)
-#define SLOG_COLOR_ERROR               (F_RED B_NULL S_BOLD)
-#define SLOG_COLOR_WARN                (F_YELLOW B_NULL S_NORMAL)
-#define SLOG_COLOR_INFO                (F_CYAN B_NULL S_NORMAL)
-#define SLOG_COLOR_DEBUG               (F_GREEN B_NULL S_NORMAL)
-#define SLOG_COLOR_VERBOSE             (F_BLUE B_NULL S_NORMAL)
+/* queue size of each built-in sink */
+#define SLOG_TERMINAL_QUEUE_SIZE             (1024 * 1024)      /* 1MB */
+#define SLOG_FILE_QUEUE_SIZE                 (8 * 1024 * 1024)  /* 8MB */
+#define SLOG_REMOTE_QUEUE_SIZE               (1024 * 1024)      /* 1MB */
+
+/* idle tick of the tcp remote sink, it reconnects and replays its spool */
+#define SLOG_REMOTE_FLUSH_INTERVAL           100  /* ms */
 
 
 /* -------------------------------------------------------------------------- */
 /* -------------- PRIVATE VARIABLES ----------------------------------------- */
 
-/* color output info */
-static const char *color_output_info[] = {
-        [ASSERT]  = SLOG_COLOR_ASSERT,
-        [ERROR]   = SLOG_COLOR_ERROR,
-        [WARN]    = SLOG_COLOR_WARN,
-        [INFO]    = SLOG_COLOR_INFO,
-        [DEBUG]   = SLOG_COLOR_DEBUG,
-        [VERBOSE] = SLOG_COLOR_VERBOSE,
-};
+/* registered ids of the built-in sinks */
+static int slog_builtin_sinks[SLOG_SINK_MAX] = { -1, -1, -1 };
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE FUNCTIONS DEFINITION ------------------------------ */
+
+static int slog_port_term_write(void *ctx, struct iovec *iov, int iovcnt)
+{
+    return slog_term_write_batch(iov, iovcnt);
+}
+
+/* OUTPUT_TERMINAL_ENABLE may be set at run time, the sink is there either way */
+static int slog_port_term_enabled(void *ctx)
+{
+    return slog_get_output_terminal_enabled();
+}
+
+static int slog_port_file_write(void *ctx, struct iovec *iov, int iovcnt)
+{
+    if (!slog_get_output_file_enabled()) {
+        return 0;
+    }
+
+    return slog_file_write_batch(iov, iovcnt);
+}
+
+static int slog_port_file_flush(void *ctx)
+{
+    slog_file_flush();
+
+    return 0;
+}
+
+static int slog_port_remote_write(void *ctx, struct iovec *iov, int iovcnt)
+{
+    if (!slog_get_output_remote_enabled()) {
+        return 0;
+    }
+
+    /* send errors only lose their own datagrams, remote output stays on */
+    return slog_remote_write_batch(iov, iovcnt);
+}
+
+static int slog_port_remote_flush(void *ctx)
+{
+    return slog_remote_flush();
+}
+
+/*
+ * register one built-in sink with its configured queue policy
+ */
+static int slog_port_register(int id, const char *name, uint8_t format, size_t queue_size,
+                              int (*write_batch)(void *, struct iovec *, int), int (*flush)(void *),
+                              int (*enabled)(void *), uint32_t flush_interval)
+{
+    slog_sink_desc_t desc;
+
+    memset(&desc, 0, sizeof(desc));
+    desc.name = name;
+    desc.ops.write_batch = write_batch;
+    desc.ops.flush = flush;
+    desc.ops.enabled = enabled;
+    desc.level = VERBOSE;
+    desc.format = format;
+    desc.queue_size = queue_size;
+    desc.drop_policy = slog_get_sink_drop_policy(id);
+    desc.shed_level = slog_get_sink_shed_level(id);
+    desc.flush_interval = flush_interval;
+
+    slog_builtin_sinks[id] = slog_sink_register(&desc);
+
+    return (slog_builtin_sinks[id] >= 0) ? 0 : -1;
+}
 
 
 /* -------------------------------------------------------------------------- */
 /* -------------- PUBLIC FUNCTIONS DEFINITION ------------------------------- */
 
 /**
- * slog port initialize
+ * slog port initialize, registers the built-in sinks
  *
  * @return result
  */
 int slog_port_init(void)
 {
-    /* close printf buffer */
-    setbuf(stdout, NULL);
+    bool terminal = true;
+
+    if (0 != slog_term_init()) {
+        slog_set_output_terminal_enabled(false);
+        terminal = false;
+    }
 
     if (0 != slog_file_init()) {
         return -1;
@@ -97,40 +136,89 @@ int slog_port_init(void)
         slog_set_output_remote_enabled(false);
     }
 
+    /* registered with a terminal to write to, OUTPUT_TERMINAL_ENABLE filters its logs */
+    if (terminal &&
+        (0 != slog_port_register(SLOG_SINK_TERMINAL, "terminal",
+                                 slog_term_is_color() ? SLOG_SINK_FORMAT_COLOR : SLOG_SINK_FORMAT_TEXT,
+                                 SLOG_TERMINAL_QUEUE_SIZE, slog_port_term_write, NULL, slog_port_term_enabled,
+                                 0))) {
+        return -1;
+    }
+
+    /* the file sink formats, or encodes, the events itself to index them */
+    if (slog_get_output_file_enabled() &&
+        (0 != slog_port_register(SLOG_SINK_FILE, "file", SLOG_SINK_FORMAT_RAW, SLOG_FILE_QUEUE_SIZE,
+                                 slog_port_file_write, slog_port_file_flush, NULL, 0))) {
+        return -1;
+    }
+
+    if (slog_get_output_remote_enabled() &&
+        (0 != slog_port_register(SLOG_SINK_REMOTE, "remote", SLOG_SINK_FORMAT_TEXT,
+                                 SLOG_REMOTE_QUEUE_SIZE, slog_port_remote_write, slog_port_remote_flush, NULL,
+                                 (SLOG_REMOTE_PROTO_TCP == slog_get_output_remote_proto()) ?
+                                 SLOG_REMOTE_FLUSH_INTERVAL : 0))) {
+        return -1;
+    }
+
     return 0;
 }
 
 void slog_port_deinit(void)
 {
+    int i;
+
+    /* drain every sink queue, registered ones included, before closing the outputs */
+    slog_sink_unregister_all();
+    for (i = 0; i < SLOG_SINK_MAX; ++i) {
+        slog_builtin_sinks[i] = -1;
+    }
+
+    slog_term_deinit();
+
     slog_file_deinit();
 
     slog_remote_deinit();
 }
 
 /**
- * output log port interface
+ * output log port interface, hands the event to every registered sink
  *
- * @param log output of log
- * @param size log size
+ * @param slog_event_buf log event
  */
-void slog_port_output(uint8_t level, const char *log, size_t size)
+void slog_port_output(const void *slog_event_buf)
 {
-    if (slog_get_output_terminal_enabled()) {
-        /* output to terminal with color */
-        printf(CSI_START"%s%.*s"CSI_END, color_output_info[level], (int)size, log);
-    }
+    slog_sink_dispatch(slog_event_buf);
+}
 
-    if (slog_get_output_file_enabled()) {
-        /* write the file */
-        slog_file_write(log, size);
+/**
+ * output a log of the flight recorder's history to the file sink, waiting
+ * for room in its queue. Without a file sink every sink gets it.
+ *
+ * @param slog_event_buf log event
+ * @param deadline CLOCK_MONOTONIC time to stop waiting for room at
+ *
+ * @return 0 output, 1 filtered, -1 dropped, no room in time
+ */
+int slog_port_dump(const void *slog_event_buf, const struct timespec *deadline)
+{
+    if (slog_builtin_sinks[SLOG_SINK_FILE] < 0) {
+        slog_sink_dispatch(slog_event_buf);
+        return 0;
     }
 
-    if (slog_get_output_remote_enabled()) {
-        /* output to remote */
-        if (-1 == slog_remote_write(log, size)) {
-            slog_set_output_remote_enabled(false);
-        }
-    }
+    return slog_sink_post_wait(slog_builtin_sinks[SLOG_SINK_FILE], slog_event_buf, deadline);
+}
+
+/**
+ * walk the events queued for the file sink, for the fatal signal handler
+ *
+ * @param slog_event_buf SLOG_EVENT_BUF_MAXLEN bytes each event is copied to
+ * @param walk called for each event
+ * @param arg passed to walk
+ */
+void slog_port_walk_file(void *slog_event_buf, void (*walk)(const void *slog_event_buf, void *arg), void *arg)
+{
+    slog_sink_walk(slog_builtin_sinks[SLOG_SINK_FILE], slog_event_buf, walk, arg);
 }
 
 
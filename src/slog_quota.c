@@ -0,0 +1,258 @@
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <time.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "logger.h"
+#include "slog_cfg.h"
+#include "slog_buf.h"
+#include "slog_event.h"
+#include "slog_inner.h"
+#include "slog_quota.h"
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE MACROS -------------------------------------------- */
+
+/* a rate quota lets a second's worth of bytes through in a burst */
+#define SLOG_QUOTA_BURST                     1000000000ULL  /* ns */
+
+/* ns between two reports of the logs a quota dropped */
+#define SLOG_QUOTA_REPORT_INTERVAL           1000000000LL
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE TYPES --------------------------------------------- */
+
+/* a tag's quota, the counters are the producers' and the output thread's */
+typedef struct slog_quota_s {
+    char tag[SLOG_FILTER_TAG_MAX_LEN + 1];
+    size_t tag_len;
+    uint32_t share;                          /* bytes of the bulk lane, 0 no limit */
+    unsigned int rate;                       /* bytes per second, 0 no limit */
+    unsigned long sample;                    /* one in sample over the quota kept, 0 none */
+    uint32_t used;                           /* bytes of the tag's logs in the ring */
+    uint64_t tat;                            /* ns the rate's bucket is full again */
+    unsigned long over;                      /* logs over the quota, sampled by it */
+    unsigned long dropped;
+    unsigned long reported;                  /* dropped at the last report */
+} slog_quota_t;
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE VARIABLES ----------------------------------------- */
+
+static slog_quota_t slog_quota[SLOG_TAG_QUOTA_MAX];
+
+static unsigned int slog_quotas;
+
+static int64_t slog_quota_reported;
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE FUNCTIONS DEFINITION ------------------------------ */
+
+static uint64_t slog_quota_now(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static slog_quota_t *slog_quota_find(const slog_event_head_t *head)
+{
+    const char *tag = (const char *)(head + 1);
+    unsigned int i;
+
+    for (i = 0; i < slog_quotas; ++i) {
+        if ((slog_quota[i].tag_len == head->slog_tag_len) && (0 == memcmp(slog_quota[i].tag, tag, head->slog_tag_len))) {
+            return &slog_quota[i];
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * take length bytes of the rate's bucket (GCRA), nothing taken when short
+ */
+static bool slog_quota_rate_take(slog_quota_t *quota, uint32_t length)
+{
+    uint64_t now, tat, base, cost;
+
+    if (0 == quota->rate) {
+        return true;
+    }
+
+    cost = (uint64_t)length * 1000000000 / quota->rate;
+    now = slog_quota_now();
+    tat = __atomic_load_n(&quota->tat, __ATOMIC_RELAXED);
+    do {
+        base = (tat > now) ? tat : now;
+        if (base + cost - now > SLOG_QUOTA_BURST) {
+            return false;
+        }
+    } while (!__atomic_compare_exchange_n(&quota->tat, &tat, base + cost, true,
+                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+    return true;
+}
+
+/*
+ * take length bytes of the share, nothing taken when short
+ */
+static bool slog_quota_share_take(slog_quota_t *quota, uint32_t length)
+{
+    if (0 == quota->share) {
+        return true;
+    }
+
+    if (__atomic_add_fetch(&quota->used, length, __ATOMIC_RELAXED) > quota->share) {
+        __atomic_sub_fetch(&quota->used, length, __ATOMIC_RELAXED);
+        return false;
+    }
+
+    return true;
+}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC FUNCTIONS DEFINITION ------------------------------- */
+
+/**
+ * tag quotas initialize, by the configured TAG_QUOTA lines, after the main
+ * ring is
+ */
+void slog_quota_init(void)
+{
+    const slog_tag_quota_t *cfg = NULL;
+    unsigned int i;
+
+    memset(slog_quota, 0, sizeof(slog_quota));
+    slog_quotas = slog_get_tag_quotas();
+    for (i = 0; i < slog_quotas; ++i) {
+        cfg = slog_get_tag_quota(i);
+        strcpy(slog_quota[i].tag, cfg->tag);
+        slog_quota[i].tag_len = strlen(cfg->tag);
+        slog_quota[i].share = (uint32_t)((uint64_t)slog_buffer_size() * cfg->share / 100);
+        slog_quota[i].rate = cfg->rate;
+        slog_quota[i].sample = cfg->sample;
+    }
+}
+
+/**
+ * charge a log to its tag's quota before it is put into the main ring
+ *
+ * @param slog_event_buf log event
+ *
+ * @return true within the quota or sampled, false the log is dropped
+ */
+bool slog_quota_charge(const void *slog_event_buf)
+{
+    const slog_event_head_t *head = (const slog_event_head_t *)slog_event_buf;
+    slog_quota_t *quota = NULL;
+
+    if ((0 == slog_quotas) || (head->slog_level <= ERROR)) {
+        return true;
+    }
+
+    quota = slog_quota_find(head);
+    if (NULL == quota) {
+        return true;
+    }
+
+    if (slog_quota_share_take(quota, head->slog_event_length)) {
+        if (slog_quota_rate_take(quota, head->slog_event_length)) {
+            return true;
+        }
+        if (0 != quota->share) {
+            __atomic_sub_fetch(&quota->used, head->slog_event_length, __ATOMIC_RELAXED);
+        }
+    }
+
+    /* a sampled log fills the share as any other, released as any other */
+    if ((0 != quota->sample) && (0 == __atomic_fetch_add(&quota->over, 1, __ATOMIC_RELAXED) % quota->sample)) {
+        if (0 != quota->share) {
+            __atomic_add_fetch(&quota->used, head->slog_event_length, __ATOMIC_RELAXED);
+        }
+        return true;
+    }
+
+    __atomic_add_fetch(&quota->dropped, 1, __ATOMIC_RELAXED);
+    return false;
+}
+
+/**
+ * give a log's bytes back to its tag's share, on the output thread as it
+ * takes the log out of the main ring, or when the ring had no room for it.
+ * Every log put into the ring was charged, a scope's ones at its commit.
+ */
+void slog_quota_release(const void *slog_event_buf)
+{
+    const slog_event_head_t *head = (const slog_event_head_t *)slog_event_buf;
+    slog_quota_t *quota = NULL;
+
+    if ((0 == slog_quotas) || (head->slog_level <= ERROR)) {
+        return;
+    }
+
+    quota = slog_quota_find(head);
+    if ((NULL == quota) || (0 == quota->share)) {
+        return;
+    }
+
+    __atomic_sub_fetch(&quota->used, head->slog_event_length, __ATOMIC_RELAXED);
+}
+
+/**
+ * report the logs the quotas dropped since the last report, on the output
+ * thread, once a second at most
+ */
+void slog_quota_poll(void)
+{
+    int64_t now;
+    unsigned long dropped;
+    unsigned int i;
+
+    if (0 == slog_quotas) {
+        return;
+    }
+
+    now = (int64_t)slog_quota_now();
+    if (now - slog_quota_reported < SLOG_QUOTA_REPORT_INTERVAL) {
+        return;
+    }
+    slog_quota_reported = now;
+
+    for (i = 0; i < slog_quotas; ++i) {
+        dropped = __atomic_load_n(&slog_quota[i].dropped, __ATOMIC_RELAXED);
+        if (dropped != slog_quota[i].reported) {
+            slog_warn_inner("log tag %s over its quota, %lu logs dropped", slog_quota[i].tag,
+                            dropped - slog_quota[i].reported);
+            slog_quota[i].reported = dropped;
+        }
+    }
+}
+
+/**
+ * logs the tag quotas dropped since log_init()
+ */
+unsigned long slog_quota_get_dropped(void)
+{
+    unsigned long dropped = 0;
+    unsigned int i;
+
+    for (i = 0; i < slog_quotas; ++i) {
+        dropped += __atomic_load_n(&slog_quota[i].dropped, __ATOMIC_RELAXED);
+    }
+
+    return dropped;
+}
+
+
+/* ============== EOF ======================================================= */
\ No newline at end of file
@@ -0,0 +1,187 @@
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include "slog_ring.h"
+#include "slog_event.h"
+#include "slog_crc32.h"
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE MACROS -------------------------------------------- */
+
+/* head field offsets */
+#define SLOG_RING_VERSION_OFFSET             8
+#define SLOG_RING_HEAD_SIZE_OFFSET           10
+#define SLOG_RING_EVENT_HEAD_OFFSET          12
+#define SLOG_RING_SIZE_OFFSET                16
+#define SLOG_RING_PID_OFFSET                 20
+#define SLOG_RING_TIME_OFFSET                24
+#define SLOG_RING_IN_OFFSET                  (SLOG_RING_FIFO_OFFSET)
+#define SLOG_RING_OUT_OFFSET                 (SLOG_RING_FIFO_OFFSET + 4)
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE FUNCTIONS DEFINITION ------------------------------ */
+
+/*
+ * copy n ring bytes from pos on, wrapping around the data's end
+ */
+static void slog_ring_copy(const slog_ring_t *ring, uint32_t pos, void *dst, uint32_t n)
+{
+    uint32_t off = pos & (ring->size - 1);
+    uint32_t first = ring->size - off;
+
+    if (first >= n) {
+        memcpy(dst, ring->data + off, n);
+    } else {
+        memcpy(dst, ring->data + off, first);
+        memcpy((char *)dst + first, ring->data, n - first);
+    }
+}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC FUNCTIONS DEFINITION ------------------------------- */
+
+/**
+ * set the head of a new ring file, the kfifo behind it sets in and out
+ *
+ * @param head SLOG_RING_HEAD_SIZE bytes, zeroed
+ * @param size data bytes
+ * @param event_head_size sizeof(slog_event_head_t) of the writer
+ */
+void slog_ring_head_set(void *head, uint32_t size, uint16_t event_head_size)
+{
+    char *p = (char *)head;
+    uint16_t version = SLOG_RING_VERSION, head_size = SLOG_RING_HEAD_SIZE;
+    uint32_t pid = (uint32_t)getpid();
+    int64_t start_time;
+    struct timeval now;
+
+    gettimeofday(&now, NULL);
+    start_time = (int64_t)now.tv_sec * 1000000 + now.tv_usec;
+
+    memcpy(p + SLOG_RING_VERSION_OFFSET, &version, 2);
+    memcpy(p + SLOG_RING_HEAD_SIZE_OFFSET, &head_size, 2);
+    memcpy(p + SLOG_RING_EVENT_HEAD_OFFSET, &event_head_size, 2);
+    memcpy(p + SLOG_RING_SIZE_OFFSET, &size, 4);
+    memcpy(p + SLOG_RING_PID_OFFSET, &pid, 4);
+    memcpy(p + SLOG_RING_TIME_OFFSET, &start_time, 8);
+
+    /* the magic last, a half written head is no ring */
+    memcpy(p, SLOG_RING_MAGIC, 8);
+}
+
+/**
+ * frame an event as a ring record
+ *
+ * @param record SLOG_RING_RECORD_HEAD_SIZE + event_len bytes
+ * @param event event of slog_event_buf_set()
+ * @param event_len its slog_event_length
+ */
+void slog_ring_record_set(void *record, const void *event, uint32_t event_len)
+{
+    uint32_t magic = SLOG_RING_RECORD_MAGIC;
+    uint32_t crc = slog_crc32c(0, event, event_len);
+
+    memcpy(record, &magic, 4);
+    memcpy((char *)record + 4, &crc, 4);
+    memcpy((char *)record + SLOG_RING_RECORD_HEAD_SIZE, event, event_len);
+}
+
+/**
+ * check a ring file's head
+ *
+ * @param file mapped file
+ * @param len file bytes
+ * @param event_head_size sizeof(slog_event_head_t) of the reader
+ * @param ring parsed ring out
+ *
+ * @return 0 ok, -1 not a ring file or one of another event layout
+ */
+int slog_ring_file_check(const void *file, size_t len, uint16_t event_head_size, slog_ring_t *ring)
+{
+    const char *p = (const char *)file;
+    uint16_t version, head_size, writer_event_head_size;
+
+    if ((len < SLOG_RING_HEAD_SIZE) || (0 != memcmp(p, SLOG_RING_MAGIC, 8))) {
+        return -1;
+    }
+
+    memcpy(&version, p + SLOG_RING_VERSION_OFFSET, 2);
+    memcpy(&head_size, p + SLOG_RING_HEAD_SIZE_OFFSET, 2);
+    memcpy(&writer_event_head_size, p + SLOG_RING_EVENT_HEAD_OFFSET, 2);
+    memcpy(&ring->size, p + SLOG_RING_SIZE_OFFSET, 4);
+    memcpy(&ring->pid, p + SLOG_RING_PID_OFFSET, 4);
+    memcpy(&ring->start_time, p + SLOG_RING_TIME_OFFSET, 8);
+    memcpy(&ring->in, p + SLOG_RING_IN_OFFSET, 4);
+    memcpy(&ring->out, p + SLOG_RING_OUT_OFFSET, 4);
+
+    if ((SLOG_RING_VERSION != version) || (SLOG_RING_HEAD_SIZE != head_size) ||
+        (event_head_size != writer_event_head_size)) {
+        return -1;
+    }
+
+    /* a power of 2 within the file */
+    if ((ring->size < 2) || (0 != (ring->size & (ring->size - 1))) ||
+        (ring->size > len - SLOG_RING_HEAD_SIZE) || (ring->in - ring->out > ring->size)) {
+        return -1;
+    }
+    ring->data = (const uint8_t *)p + SLOG_RING_HEAD_SIZE;
+
+    return 0;
+}
+
+/**
+ * read the record at ring byte pos
+ *
+ * @param ring checked ring
+ * @param pos ring byte, free running as in and out are
+ * @param end ring byte the records end at
+ * @param event SLOG_EVENT_BUF_MAXLEN bytes, the record's event out
+ *
+ * @return record bytes, 0 the record runs past end, -1 no valid record at pos
+ */
+int slog_ring_record_read(const slog_ring_t *ring, uint32_t pos, uint32_t end, void *event)
+{
+    uint8_t head[SLOG_RING_RECORD_HEAD_SIZE];
+    uint32_t magic, crc, length;
+    slog_event_head_t *event_head = (slog_event_head_t *)event;
+
+    if (end - pos < SLOG_RING_RECORD_HEAD_SIZE + sizeof(slog_event_head_t)) {
+        return 0;
+    }
+
+    slog_ring_copy(ring, pos, head, SLOG_RING_RECORD_HEAD_SIZE);
+    memcpy(&magic, head, 4);
+    memcpy(&crc, head + 4, 4);
+    if (SLOG_RING_RECORD_MAGIC != magic) {
+        return -1;
+    }
+
+    slog_ring_copy(ring, pos + SLOG_RING_RECORD_HEAD_SIZE, event, sizeof(slog_event_head_t));
+    length = event_head->slog_event_length;
+    if ((length < sizeof(slog_event_head_t)) || (length > SLOG_EVENT_BUF_MAXLEN) ||
+        ((uint32_t)event_head->slog_tag_len + event_head->slog_file_len + event_head->slog_func_len >
+         length - sizeof(slog_event_head_t))) {
+        return -1;
+    }
+    if (end - pos - SLOG_RING_RECORD_HEAD_SIZE < length) {
+        return 0;
+    }
+
+    slog_ring_copy(ring, pos + SLOG_RING_RECORD_HEAD_SIZE, event, length);
+    if (crc != slog_crc32c(0, event, length)) {
+        return -1;
+    }
+
+    return (int)(SLOG_RING_RECORD_HEAD_SIZE + length);
+}
+
+
+/* ============== EOF ======================================================= */
\ No newline at end of file
@@ -0,0 +1,254 @@
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "logger.h"
+#include "slog_buf.h"
+#include "slog_event.h"
+#include "slog_inner.h"
+#include "slog_quota.h"
+#include "slog_scope.h"
+#include "slog_stats.h"
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE MACROS -------------------------------------------- */
+
+/* scratch bytes of one thread's scope, records beyond it are dropped */
+#define SLOG_SCOPE_BUF_SIZE                  (64 * 1024)  /* 64KB */
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE TYPES --------------------------------------------- */
+
+/* scope of one thread, its DEBUG and VERBOSE logs wait in buf */
+typedef struct slog_scope_s {
+    bool open;
+    bool forced;                             /* an ERROR committed it, the end commits too */
+    unsigned int flags;                      /* SLOG_SCOPE_xxx */
+    char *buf;                               /* records as the main ring holds them */
+    uint32_t len;
+    unsigned long dropped;
+} slog_scope_t;
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE VARIABLES ----------------------------------------- */
+
+static __thread slog_scope_t slog_scope;
+
+/* frees a thread's scratch as it exits */
+static pthread_key_t slog_scope_key;
+static pthread_once_t slog_scope_once = PTHREAD_ONCE_INIT;
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE FUNCTIONS DEFINITION ------------------------------ */
+
+static void slog_scope_key_init(void)
+{
+    pthread_key_create(&slog_scope_key, free);
+}
+
+/*
+ * charge the kept records to their tags' quotas as slog() does, the ones
+ * over their quota are dropped from the scope
+ */
+static void slog_scope_charge(void)
+{
+    uint32_t offset = 0, kept = 0, size;
+    slog_event_head_t *head;
+
+    while (offset < slog_scope.len) {
+        head = (slog_event_head_t *)slog_buffer_record_event(slog_scope.buf + offset, &size);
+        if (slog_quota_charge(head)) {
+            if (kept != offset) {
+                memmove(slog_scope.buf + kept, slog_scope.buf + offset, size);
+            }
+            kept += size;
+        } else {
+            slog_stats_dropped(head->slog_level);
+        }
+        offset += size;
+    }
+
+    slog_scope.len = kept;
+}
+
+/*
+ * put the kept records one by one, when the ring has no room for them all,
+ * the spill takes the ones it has no room for
+ */
+static void slog_scope_spill(void)
+{
+    uint32_t offset = 0, size;
+    unsigned long dropped = 0;
+    slog_event_head_t *head;
+
+    while (offset < slog_scope.len) {
+        head = (slog_event_head_t *)slog_buffer_record_event(slog_scope.buf + offset, &size);
+        if (0 == slog_buffer_put(head)) {
+            slog_stats_enqueued(head->slog_level, head->slog_event_length);
+        } else {
+            slog_quota_release(head);
+            slog_stats_dropped(head->slog_level);
+            dropped++;
+        }
+        offset += size;
+    }
+
+    if (0 != dropped) {
+        slog_warn_inner("log scope commit dropped %lu logs the main ring had no room for", dropped);
+    }
+}
+
+/*
+ * move the kept records into the main ring in one reservation
+ */
+static void slog_scope_flush(void)
+{
+    uint32_t offset = 0, size;
+    slog_event_head_t *head;
+
+    slog_scope_charge();
+    if (0 == slog_scope.len) {
+        return;
+    }
+
+    if (0 == slog_buffer_put_records(slog_scope.buf, slog_scope.len)) {
+        while (offset < slog_scope.len) {
+            head = (slog_event_head_t *)slog_buffer_record_event(slog_scope.buf + offset, &size);
+            slog_stats_enqueued(head->slog_level, head->slog_event_length);
+            offset += size;
+        }
+    } else {
+        slog_scope_spill();
+    }
+    slog_scope.len = 0;
+}
+
+static void slog_scope_close(void)
+{
+    if (0 != slog_scope.dropped) {
+        slog_warn_inner("log scope dropped %lu logs beyond its %d bytes", slog_scope.dropped, SLOG_SCOPE_BUF_SIZE);
+    }
+
+    slog_scope.len = 0;
+    slog_scope.open = false;
+}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC FUNCTIONS DEFINITION ------------------------------- */
+
+/**
+ * open a log scope on the calling thread, its DEBUG and VERBOSE logs are
+ * kept aside until slog_scope_commit() or slog_scope_discard()
+ *
+ * @param flags SLOG_SCOPE_xxx
+ *
+ * @return result, -1 a scope is open already
+ */
+int slog_scope_begin(unsigned int flags)
+{
+    if (slog_scope.open) {
+        slog_error_inner("log scope is open already");
+        return -1;
+    }
+
+    if (NULL == slog_scope.buf) {
+        pthread_once(&slog_scope_once, slog_scope_key_init);
+        slog_scope.buf = (char *)malloc(SLOG_SCOPE_BUF_SIZE);
+        if (NULL == slog_scope.buf) {
+            slog_error_inner("log scope malloc error");
+            return -1;
+        }
+        pthread_setspecific(slog_scope_key, slog_scope.buf);
+    }
+
+    slog_scope.open = true;
+    slog_scope.forced = false;
+    slog_scope.flags = flags;
+    slog_scope.len = 0;
+    slog_scope.dropped = 0;
+
+    return 0;
+}
+
+/**
+ * close the calling thread's scope, its kept logs are output
+ */
+void slog_scope_commit(void)
+{
+    if (!slog_scope.open) {
+        return;
+    }
+
+    slog_scope_flush();
+    slog_scope_close();
+}
+
+/**
+ * close the calling thread's scope, its kept logs are dropped unless an
+ * ERROR forced a commit
+ */
+void slog_scope_discard(void)
+{
+    if (!slog_scope.open) {
+        return;
+    }
+
+    if (slog_scope.forced) {
+        slog_scope_flush();
+    }
+    slog_scope_close();
+}
+
+/**
+ * whether the calling thread has a scope open
+ */
+bool slog_scope_is_open(void)
+{
+    return slog_scope.open;
+}
+
+/**
+ * keep a log of the calling thread's scope aside
+ *
+ * @param slog_event_buf log event
+ *
+ * @return true kept, not to be put into the main ring now
+ */
+bool slog_scope_keep(const void *slog_event_buf)
+{
+    const slog_event_head_t *head = (const slog_event_head_t *)slog_event_buf;
+
+    if (!slog_scope.open) {
+        return false;
+    }
+
+    if (head->slog_level >= DEBUG) {
+        if (SLOG_SCOPE_BUF_SIZE - slog_scope.len < SLOG_RING_RECORD_HEAD_SIZE + head->slog_event_length) {
+            slog_scope.dropped++;
+        } else {
+            slog_scope.len += slog_buffer_record_set(slog_scope.buf + slog_scope.len, slog_event_buf);
+        }
+        return true;
+    }
+
+    /* the trail goes ahead of the error */
+    if ((head->slog_level <= ERROR) && (0 != (slog_scope.flags & SLOG_SCOPE_COMMIT_ON_ERROR))) {
+        slog_scope_flush();
+        slog_scope.forced = true;
+    }
+
+    return false;
+}
+
+
+/* ============== EOF ======================================================= */
\ No newline at end of file
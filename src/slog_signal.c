@@ -0,0 +1,334 @@
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <time.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "slog_event.h"
+#include "slog_inner.h"
+#include "slog_signal.h"
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE MACROS -------------------------------------------- */
+
+/* slots of the emergency ring, a power of 2 */
+#define SLOG_SIGNAL_SLOTS                    64
+
+/* bytes of one slot's event, longer messages are cut */
+#define SLOG_SIGNAL_EVENT_MAXLEN             1024
+
+/* digits of a 64 bit number in base 8 at least */
+#define SLOG_SIGNAL_NUM_MAX_LEN              24
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE TYPES --------------------------------------------- */
+
+/*
+ * a slot is free for the producer of ring position pos while seq is pos,
+ * and holds that position's event once seq is pos + 1
+ */
+typedef struct slog_signal_slot_s {
+    unsigned int seq;
+    char event[SLOG_SIGNAL_EVENT_MAXLEN];
+} slog_signal_slot_t;
+
+/* emergency ring of the signal handlers, any thread puts, the output thread gets */
+typedef struct slog_signal_ring_s {
+    unsigned int tail;                       /* next position a producer reserves */
+    unsigned int head;                       /* next position the output thread gets */
+    unsigned long dropped;                   /* logs the full ring had no slot for */
+    slog_signal_slot_t slots[SLOG_SIGNAL_SLOTS];
+} slog_signal_ring_t;
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE VARIABLES ----------------------------------------- */
+
+static slog_signal_ring_t slog_signal_ring;
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE FUNCTIONS DEFINITION ------------------------------ */
+
+/*
+ * put a number as width characters at least, padded with zeros or spaces
+ */
+static size_t slog_signal_put_num(char *buf, size_t size, unsigned long long value, bool negative,
+                                  unsigned int base, bool upper, int width, bool zero)
+{
+    const char *digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    char num[SLOG_SIGNAL_NUM_MAX_LEN];
+    int n = 0, len;
+    size_t pos = 0;
+
+    do {
+        num[n++] = digits[value % base];
+        value /= base;
+    } while (0 != value);
+
+    len = n + (negative ? 1 : 0);
+    if (negative && zero && (pos < size)) {
+        buf[pos++] = '-';
+        negative = false;
+    }
+    while ((width-- > len) && (pos < size)) {
+        buf[pos++] = zero ? '0' : ' ';
+    }
+    if (negative && (pos < size)) {
+        buf[pos++] = '-';
+    }
+    while ((n > 0) && (pos < size)) {
+        buf[pos++] = num[--n];
+    }
+
+    return pos;
+}
+
+/*
+ * vsnprintf() of %d %i %u %x %X %p %s %c %% only, with the 0 flag, a width
+ * and the l, ll, z and h modifiers. No locale, no allocation, no lock.
+ *
+ * @return bytes put, not terminated
+ */
+static size_t slog_signal_vformat(char *buf, size_t size, const char *format, va_list args)
+{
+    size_t pos = 0, len;
+    int width, length;
+    bool zero;
+    long long number;
+    unsigned long long unumber;
+    const char *str;
+
+    while (('\0' != *format) && (pos < size)) {
+        if ('%' != *format) {
+            buf[pos++] = *format++;
+            continue;
+        }
+        format++;
+
+        zero = ('0' == *format);
+        if (zero) {
+            format++;
+        }
+        for (width = 0; (*format >= '0') && (*format <= '9'); format++) {
+            if (width < SLOG_SIGNAL_NUM_MAX_LEN) {
+                width = width * 10 + (*format - '0');
+            }
+        }
+        for (length = 0; ('l' == *format) || ('z' == *format) || ('h' == *format); format++) {
+            if ('h' != *format) {
+                length++;
+            }
+        }
+
+        switch (*format) {
+        case 'd':
+        case 'i':
+            number = (length >= 2) ? va_arg(args, long long) : (1 == length) ? va_arg(args, long) : va_arg(args, int);
+            unumber = (number < 0) ? -(unsigned long long)number : (unsigned long long)number;
+            pos += slog_signal_put_num(buf + pos, size - pos, unumber, number < 0, 10, false, width, zero);
+            break;
+        case 'u':
+        case 'x':
+        case 'X':
+            unumber = (length >= 2) ? va_arg(args, unsigned long long) :
+                      (1 == length) ? va_arg(args, unsigned long) : va_arg(args, unsigned int);
+            pos += slog_signal_put_num(buf + pos, size - pos, unumber, false, ('u' == *format) ? 10 : 16,
+                                       ('X' == *format), width, zero);
+            break;
+        case 'p':
+            unumber = (uintptr_t)va_arg(args, void *);
+            if (size - pos >= 2) {
+                buf[pos++] = '0';
+                buf[pos++] = 'x';
+            }
+            pos += slog_signal_put_num(buf + pos, size - pos, unumber, false, 16, false, width, zero);
+            break;
+        case 's':
+            str = va_arg(args, const char *);
+            if (NULL == str) {
+                str = "(null)";
+            }
+            for (len = 0; ('\0' != str[len]) && (pos < size); len++) {
+                buf[pos++] = str[len];
+            }
+            break;
+        case 'c':
+            buf[pos++] = (char)va_arg(args, int);
+            break;
+        case '%':
+            buf[pos++] = '%';
+            break;
+        case '\0':
+            return pos;
+        default:
+            /* not supported, put as is */
+            buf[pos++] = '%';
+            if (pos < size) {
+                buf[pos++] = *format;
+            }
+            break;
+        }
+        format++;
+    }
+
+    return pos;
+}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC FUNCTIONS DEFINITION ------------------------------- */
+
+/**
+ * emergency ring initialize, before any signal handler may log
+ */
+void slog_signal_init(void)
+{
+    unsigned int i;
+
+    slog_signal_ring.tail = 0;
+    slog_signal_ring.head = 0;
+    slog_signal_ring.dropped = 0;
+    for (i = 0; i < SLOG_SIGNAL_SLOTS; ++i) {
+        __atomic_store_n(&slog_signal_ring.slots[i].seq, i, __ATOMIC_RELEASE);
+    }
+}
+
+/**
+ * reserve a slot of the emergency ring and set the event in place,
+ * async-signal-safe. The log is dropped and counted when the ring is full.
+ */
+void slog_signal_event_put(uint8_t level, const char *tag, uint8_t tag_len, const char *file, uint8_t file_len,
+                           const char *func, uint8_t func_len, uint32_t line, const char *format, va_list args)
+{
+    unsigned int pos = __atomic_load_n(&slog_signal_ring.tail, __ATOMIC_RELAXED);
+    slog_signal_slot_t *slot = NULL;
+    slog_event_head_t *head = NULL;
+    size_t offset = sizeof(slog_event_head_t) + tag_len + file_len + func_len;
+    struct timespec now;
+    int dif;
+
+    /* reserve the slot of position pos */
+    while (1) {
+        slot = &slog_signal_ring.slots[pos & (SLOG_SIGNAL_SLOTS - 1)];
+        dif = (int)(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) - pos);
+        if (0 == dif) {
+            if (__atomic_compare_exchange_n(&slog_signal_ring.tail, &pos, pos + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (dif < 0) {
+            __sync_fetch_and_add(&slog_signal_ring.dropped, 1);
+            return;
+        } else {
+            pos = __atomic_load_n(&slog_signal_ring.tail, __ATOMIC_RELAXED);
+        }
+    }
+
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    head = (slog_event_head_t *)slot->event;
+    head->slog_level = level;
+    head->slog_tag_len = tag_len;
+    head->slog_file_len = file_len;
+    head->slog_func_len = func_len;
+    head->slog_line = line;
+    head->slog_time.tv_sec = now.tv_sec;
+    head->slog_time.tv_usec = now.tv_nsec / 1000;
+
+    memcpy(slot->event + sizeof(slog_event_head_t), tag, tag_len);
+    memcpy(slot->event + sizeof(slog_event_head_t) + tag_len, file, file_len);
+    memcpy(slot->event + sizeof(slog_event_head_t) + tag_len + file_len, func, func_len);
+
+    head->slog_event_length = offset + slog_signal_vformat(slot->event + offset, SLOG_SIGNAL_EVENT_MAXLEN - offset,
+                                                           format, args);
+
+    /* publish */
+    __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * take the oldest event of the emergency ring, on the output thread
+ *
+ * @param slog_event_buf SLOG_EVENT_BUF_MAXLEN bytes
+ *
+ * @return event length, 0 none published
+ */
+size_t slog_signal_event_get(void *slog_event_buf)
+{
+    unsigned int pos = slog_signal_ring.head;
+    slog_signal_slot_t *slot = &slog_signal_ring.slots[pos & (SLOG_SIGNAL_SLOTS - 1)];
+    unsigned long dropped;
+    uint32_t length;
+
+    if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != pos + 1) {
+        return 0;
+    }
+
+    length = ((slog_event_head_t *)slot->event)->slog_event_length;
+    memcpy(slog_event_buf, slot->event, length);
+
+    /* free for the producer of the position a lap ahead */
+    __atomic_store_n(&slot->seq, pos + SLOG_SIGNAL_SLOTS, __ATOMIC_RELEASE);
+    __atomic_store_n(&slog_signal_ring.head, pos + 1, __ATOMIC_RELEASE);
+
+    dropped = __sync_lock_test_and_set(&slog_signal_ring.dropped, 0);
+    if (0 != dropped) {
+        slog_warn_inner("signal log ring full, %lu logs dropped", dropped);
+    }
+
+    return length;
+}
+
+/**
+ * ring position the signal handlers reserved up to, for slog_flush()
+ */
+unsigned int slog_signal_in(void)
+{
+    return __atomic_load_n(&slog_signal_ring.tail, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * ring position the output thread took events up to
+ */
+unsigned int slog_signal_out(void)
+{
+    return __atomic_load_n(&slog_signal_ring.head, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * walk the events of the emergency ring not taken yet, without taking them,
+ * for the fatal signal handler
+ *
+ * @param slog_event_buf SLOG_EVENT_BUF_MAXLEN bytes each event is copied to
+ * @param walk called for each event
+ * @param arg passed to walk
+ */
+void slog_signal_walk(void *slog_event_buf, slog_event_walk_t walk, void *arg)
+{
+    unsigned int pos = __atomic_load_n(&slog_signal_ring.head, __ATOMIC_ACQUIRE);
+    unsigned int end = pos + SLOG_SIGNAL_SLOTS;
+    slog_signal_slot_t *slot = NULL;
+    uint32_t length;
+
+    for (; pos != end; ++pos) {
+        slot = &slog_signal_ring.slots[pos & (SLOG_SIGNAL_SLOTS - 1)];
+        if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != pos + 1) {
+            break;
+        }
+
+        length = ((slog_event_head_t *)slot->event)->slog_event_length;
+        if ((length < sizeof(slog_event_head_t)) || (length > SLOG_SIGNAL_EVENT_MAXLEN)) {
+            break;
+        }
+        memcpy(slog_event_buf, slot->event, length);
+        walk(slog_event_buf, arg);
+    }
+}
+
+
+/* ============== EOF ======================================================= */
\ No newline at end of file
@@ -0,0 +1,789 @@
+
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "log2.h"
+#include "logger.h"
+#include "slog_fifo.h"
+#include "slog_sink_int.h"
+#include "slog_spec.h"
+#include "slog_stats.h"
+#include "slog_async.h"
+#include "slog_event.h"
+#include "slog_inner.h"
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE MACROS -------------------------------------------- */
+
+/* default queue size of a sink */
+#define SLOG_SINK_QUEUE_SIZE                 (1024 * 1024)  /* 1MB */
+
+/* bytes of events a worker takes from its queue at once */
+#define SLOG_SINK_BATCH_SIZE                 (64 * 1024)  /* 64KB */
+
+/* formatted bytes and logs of one write_batch */
+#define SLOG_SINK_OUTPUT_SIZE                (128 * 1024)  /* 128KB */
+#define SLOG_SINK_IOV_MAX                    256
+
+/* room one formatted log may take in the output buffer */
+#define SLOG_SINK_LINE_MAX                   (SLOG_FORMAT_BUF_SIZE + SLOG_FORMAT_COLOR_LEN)
+
+/* queue occupancy percent from which the sink sheds levels above its shed level */
+#define SLOG_SINK_LAG_PERCENT                75
+
+/* us slog_sink_post_wait() sleeps between two looks for room */
+#define SLOG_SINK_POST_WAIT_STEP             1000
+
+#define SLOG_SINK_NAME_MAX_LEN               12
+#define SLOG_SINK_THREAD_NAME_LEN            16
+
+/* sink slot state */
+#define SLOG_SINK_FREE                       0
+#define SLOG_SINK_ACTIVE                     1
+#define SLOG_SINK_STOPPING                   2
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE TYPES --------------------------------------------- */
+
+/* registered sink, owns a bounded queue of log events and a worker to drain it */
+typedef struct slog_sink_s {
+    slog_sink_desc_t desc;
+    char name[SLOG_SINK_NAME_MAX_LEN];
+    int state;
+    size_t tag_len;
+
+    struct kfifo queue;
+    char *queue_buf;
+    char *batch_buf;
+    char *output_buf;
+    struct iovec iov[SLOG_SINK_IOV_MAX];
+
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    pthread_cond_t written_cond;             /* written moved, for slog_sink_flush() */
+    pthread_t worker;
+    bool running;
+    bool waiting;
+    unsigned int written;                    /* queue position written up to */
+    int flushers;                            /* slog_sink_flush() callers waiting */
+    unsigned long dropped;
+    unsigned long errors;
+    slog_sink_stats_t stats;                 /* slog_get_stats() counters, writes counted by the worker, drops by the dispatcher */
+} slog_sink_t;
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE VARIABLES ----------------------------------------- */
+
+static slog_sink_t slog_sinks[SLOG_SINK_REGISTER_MAX];
+
+/* dispatch reads the sink table, register and unregister change it */
+static pthread_rwlock_t slog_sinks_lock = PTHREAD_RWLOCK_INITIALIZER;
+
+/* set by the fatal signal handler, the workers take no more events */
+static int slog_sinks_frozen;
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE FUNCTIONS DEFINITION ------------------------------ */
+
+/*
+ * count a log dropped, called with the sink locked
+ */
+static void slog_sink_drop(slog_sink_t *sink)
+{
+    sink->dropped++;
+    __atomic_add_fetch(&sink->stats.dropped, 1, __ATOMIC_RELAXED);
+}
+
+/*
+ * drop the oldest event of the queue, called with the sink locked
+ */
+static void slog_sink_drop_oldest(slog_sink_t *sink)
+{
+    slog_event_head_t head;
+
+    if (sizeof(head) != kfifo_out_peek(&sink->queue, &head, sizeof(head))) {
+        kfifo_reset_out(&sink->queue);
+        return;
+    }
+
+    sink->queue.kfifo.out += head.slog_event_length;
+    slog_sink_drop(sink);
+}
+
+/*
+ * move whole events from the queue into buf, called with the sink locked
+ *
+ * @return bytes taken
+ */
+static size_t slog_sink_take(slog_sink_t *sink, char *buf, size_t size)
+{
+    size_t len = 0;
+    slog_event_head_t head;
+
+    while (!kfifo_is_empty(&sink->queue)) {
+        if (sizeof(head) != kfifo_out_peek(&sink->queue, &head, sizeof(head))) {
+            break;
+        }
+        if (len + head.slog_event_length > size) {
+            break;
+        }
+        if (head.slog_event_length != kfifo_out(&sink->queue, buf + len, head.slog_event_length)) {
+            break;
+        }
+        len += head.slog_event_length;
+    }
+
+    return len;
+}
+
+/*
+ * format one event by the sink's formatter
+ *
+ * @return log length, -1 error
+ */
+static int slog_sink_format(slog_sink_t *sink, char *buf, const void *slog_event_buf)
+{
+    switch (sink->desc.format) {
+    case SLOG_SINK_FORMAT_COLOR:
+        return format_log_color(buf, slog_event_buf);
+    case SLOG_SINK_FORMAT_TEXT:
+    default:
+        return format_log(buf, slog_event_buf);
+    }
+}
+
+/*
+ * check the sink's level and tag filter, and whether it is enabled
+ */
+static bool slog_sink_accept(const slog_sink_t *sink, const slog_event_head_t *head)
+{
+    if (head->slog_level > sink->desc.level) {
+        return false;
+    }
+
+    if ((NULL != sink->desc.ops.enabled) && (0 == sink->desc.ops.enabled(sink->desc.ctx))) {
+        return false;
+    }
+
+    if (0 == sink->tag_len) {
+        return true;
+    }
+
+    return (head->slog_tag_len == sink->tag_len) &&
+           (0 == memcmp((const char *)head + sizeof(slog_event_head_t), sink->desc.tag, sink->tag_len));
+}
+
+/*
+ * write_batch duration's bucket, under 2^bucket us
+ */
+static int slog_sink_latency_bucket(const struct timespec *start, const struct timespec *end)
+{
+    uint64_t us = (uint64_t)(end->tv_sec - start->tv_sec) * 1000000 + (end->tv_nsec - start->tv_nsec) / 1000;
+    int bucket = (0 == us) ? 0 : 64 - __builtin_clzll(us);
+
+    return (bucket < SLOG_STATS_LATENCY_BUCKETS) ? bucket : SLOG_STATS_LATENCY_BUCKETS - 1;
+}
+
+static void slog_sink_write(slog_sink_t *sink, int iovcnt)
+{
+    int ret;
+    struct timespec start, end;
+
+    if (0 == iovcnt) {
+        return;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    ret = sink->desc.ops.write_batch(sink->desc.ctx, sink->iov, iovcnt);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    __atomic_add_fetch(&sink->stats.latency[slog_sink_latency_bucket(&start, &end)], 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&sink->stats.batches, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&sink->stats.written, iovcnt, __ATOMIC_RELAXED);
+    if (0 != ret) {
+        sink->errors++;
+        __atomic_add_fetch(&sink->stats.errors, 1, __ATOMIC_RELAXED);
+    }
+}
+
+/*
+ * wait for events, at most the sink's flush interval, called with the sink locked
+ *
+ * @return false when the interval passed without events
+ */
+static bool slog_sink_wait(slog_sink_t *sink)
+{
+    int ret = 0;
+    struct timespec deadline;
+
+    if (0 != sink->desc.flush_interval) {
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += sink->desc.flush_interval / 1000;
+        deadline.tv_nsec += (long)(sink->desc.flush_interval % 1000) * 1000000;
+        if (deadline.tv_nsec >= 1000000000) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000;
+        }
+    }
+
+    while (kfifo_is_empty(&sink->queue) && sink->running && (ETIMEDOUT != ret)) {
+        sink->waiting = true;
+        if (0 != sink->desc.flush_interval) {
+            ret = pthread_cond_timedwait(&sink->cond, &sink->lock, &deadline);
+        } else {
+            pthread_cond_wait(&sink->cond, &sink->lock);
+        }
+        sink->waiting = false;
+    }
+
+    return kfifo_is_empty(&sink->queue) ? (ETIMEDOUT != ret) : true;
+}
+
+static void *slog_sink_worker(void *arg)
+{
+    int ret, iovcnt;
+    unsigned int taken;
+    size_t pos, batch_len, output_len;
+    unsigned long dropped, errors;
+    slog_sink_t *sink = (slog_sink_t *)arg;
+    const slog_event_head_t *head = NULL;
+    char thread_name[SLOG_SINK_THREAD_NAME_LEN] = { 0 };
+
+    /* fatal signals belong to the application threads */
+    sigset_t sig_block;
+    sigemptyset(&sig_block);
+    sigaddset(&sig_block, SIGSEGV);
+    sigaddset(&sig_block, SIGABRT);
+    sigaddset(&sig_block, SIGTERM);
+    sigaddset(&sig_block, SIGBUS);
+    ret = pthread_sigmask(SIG_BLOCK, &sig_block, NULL);
+    if (0 != ret) {
+        slog_error_inner("log %s thread set sig mask error: %s", sink->name, strerror(ret));
+    }
+
+    snprintf(thread_name, SLOG_SINK_THREAD_NAME_LEN, "log_%s", sink->name);
+    pthread_setname_np(pthread_self(), thread_name);
+
+    while (1) {
+        pthread_mutex_lock(&sink->lock);
+        if (!slog_sink_wait(sink)) {
+            /* idle for a flush interval, let the sink do its background work */
+            pthread_mutex_unlock(&sink->lock);
+            if (NULL != sink->desc.ops.flush) {
+                sink->desc.ops.flush(sink->desc.ctx);
+            }
+            continue;
+        }
+
+        if (kfifo_is_empty(&sink->queue)) {
+            /* stopped and drained */
+            pthread_mutex_unlock(&sink->lock);
+            break;
+        }
+
+        if (__atomic_load_n(&slog_sinks_frozen, __ATOMIC_ACQUIRE)) {
+            /* the queue is the fatal signal handler's now, until the process dies */
+            pthread_mutex_unlock(&sink->lock);
+            usleep(1000);
+            continue;
+        }
+
+        batch_len = slog_sink_take(sink, sink->batch_buf, SLOG_SINK_BATCH_SIZE);
+        taken = sink->queue.kfifo.out;
+        dropped = sink->dropped;
+        sink->dropped = 0;
+        pthread_mutex_unlock(&sink->lock);
+
+        /* format the batch, handing it to the sink in as few calls as possible */
+        iovcnt = 0;
+        output_len = 0;
+        for (pos = 0; pos < batch_len; pos += head->slog_event_length) {
+            head = (const slog_event_head_t *)(sink->batch_buf + pos);
+
+            if ((SLOG_SINK_IOV_MAX == iovcnt) || (output_len + SLOG_SINK_LINE_MAX > SLOG_SINK_OUTPUT_SIZE)) {
+                slog_sink_write(sink, iovcnt);
+                iovcnt = 0;
+                output_len = 0;
+            }
+
+            if (SLOG_SINK_FORMAT_RAW == sink->desc.format) {
+                /* the event itself, straight from the batch */
+                sink->iov[iovcnt].iov_base = (void *)head;
+                sink->iov[iovcnt].iov_len = head->slog_event_length;
+                iovcnt++;
+                continue;
+            }
+
+            ret = slog_sink_format(sink, sink->output_buf + output_len, head);
+            if (ret > 0) {
+                sink->iov[iovcnt].iov_base = sink->output_buf + output_len;
+                sink->iov[iovcnt].iov_len = ret;
+                iovcnt++;
+                output_len += ret;
+            }
+        }
+        slog_sink_write(sink, iovcnt);
+
+        if (NULL != sink->desc.ops.flush) {
+            sink->desc.ops.flush(sink->desc.ctx);
+        }
+
+        pthread_mutex_lock(&sink->lock);
+        sink->written = taken;
+        if (0 != sink->flushers) {
+            pthread_cond_broadcast(&sink->written_cond);
+        }
+        pthread_mutex_unlock(&sink->lock);
+
+        errors = sink->errors;
+        sink->errors = 0;
+        if (dropped > 0 || errors > 0) {
+            slog_warn_inner("log %s output lags, %lu logs dropped, %lu batches failed",
+                            sink->name, dropped, errors);
+        }
+    }
+
+    return NULL;
+}
+
+static void slog_sink_free(slog_sink_t *sink)
+{
+    free(sink->queue_buf);
+    free(sink->batch_buf);
+    free(sink->output_buf);
+    sink->queue_buf = NULL;
+    sink->batch_buf = NULL;
+    sink->output_buf = NULL;
+}
+
+/*
+ * allocate the sink queue and start its worker
+ */
+static int slog_sink_start(slog_sink_t *sink)
+{
+    int ret = -1;
+    size_t queue_size = sink->desc.queue_size;
+    pthread_condattr_t cond_attr;
+
+    if (0 == queue_size) {
+        queue_size = SLOG_SINK_QUEUE_SIZE;
+    }
+    if (!is_power_of_2(queue_size)) {
+        queue_size = roundup_pow_of_two(queue_size);
+    }
+
+    sink->queue_buf = (char *)malloc(queue_size);
+    sink->batch_buf = (char *)malloc(SLOG_SINK_BATCH_SIZE);
+    sink->output_buf = (char *)malloc(SLOG_SINK_OUTPUT_SIZE);
+    if (NULL == sink->queue_buf || NULL == sink->batch_buf || NULL == sink->output_buf) {
+        slog_error_inner("log %s queue malloc error", sink->name);
+        goto err;
+    }
+
+    if (0 != kfifo_init(&sink->queue, sink->queue_buf, queue_size)) {
+        slog_error_inner("log %s queue init error", sink->name);
+        goto err;
+    }
+
+    /* flush interval deadlines are monotonic */
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&sink->lock, NULL);
+    pthread_cond_init(&sink->cond, &cond_attr);
+    pthread_cond_init(&sink->written_cond, &cond_attr);
+    pthread_condattr_destroy(&cond_attr);
+    sink->dropped = 0;
+    sink->errors = 0;
+    memset(&sink->stats, 0, sizeof(sink->stats));
+    memcpy(sink->stats.name, sink->name, sizeof(sink->name));
+    sink->written = 0;
+    sink->flushers = 0;
+    sink->waiting = false;
+    sink->running = true;
+
+    ret = pthread_create(&sink->worker, NULL, slog_sink_worker, sink);
+    if (0 != ret) {
+        slog_error_inner("log %s thread pthread_create error: %s", sink->name, strerror(ret));
+        sink->running = false;
+        goto err;
+    }
+
+    return 0;
+
+err:
+    slog_sink_free(sink);
+    return -1;
+}
+
+/*
+ * stop the sink after its worker drained the queue, then close it
+ */
+static void slog_sink_stop(slog_sink_t *sink)
+{
+    pthread_mutex_lock(&sink->lock);
+    sink->running = false;
+    pthread_cond_signal(&sink->cond);
+    pthread_mutex_unlock(&sink->lock);
+
+    pthread_join(sink->worker, NULL);
+
+    /* flushers still waiting give up, the last one out wakes this */
+    pthread_mutex_lock(&sink->lock);
+    pthread_cond_broadcast(&sink->written_cond);
+    while (0 != sink->flushers) {
+        pthread_cond_wait(&sink->written_cond, &sink->lock);
+    }
+    pthread_mutex_unlock(&sink->lock);
+
+    if (NULL != sink->desc.ops.close) {
+        sink->desc.ops.close(sink->desc.ctx);
+    }
+
+    slog_sink_free(sink);
+    pthread_cond_destroy(&sink->cond);
+    pthread_cond_destroy(&sink->written_cond);
+    pthread_mutex_destroy(&sink->lock);
+}
+
+/**
+ * queue one log event to the sink, never waits for the sink's output.
+ *
+ * when the sink lags behind, levels above its shed level are dropped first,
+ * and a full queue drops the newest or the oldest event by its drop policy.
+ */
+static void slog_sink_post(slog_sink_t *sink, const void *slog_event_buf)
+{
+    const slog_event_head_t *head = (const slog_event_head_t *)slog_event_buf;
+    uint32_t length = head->slog_event_length;
+
+    pthread_mutex_lock(&sink->lock);
+
+    if ((head->slog_level > sink->desc.shed_level) &&
+        (kfifo_len(&sink->queue) > kfifo_size(&sink->queue) / 100 * SLOG_SINK_LAG_PERCENT)) {
+        slog_sink_drop(sink);
+        pthread_mutex_unlock(&sink->lock);
+        return;
+    }
+
+    if (kfifo_avail(&sink->queue) < length) {
+        if (SLOG_SINK_DROP_OLDEST != sink->desc.drop_policy) {
+            slog_sink_drop(sink);
+            pthread_mutex_unlock(&sink->lock);
+            return;
+        }
+
+        while (!kfifo_is_empty(&sink->queue) && (kfifo_avail(&sink->queue) < length)) {
+            slog_sink_drop_oldest(sink);
+        }
+    }
+
+    kfifo_in(&sink->queue, slog_event_buf, length);
+
+    if (sink->waiting) {
+        pthread_cond_signal(&sink->cond);
+    }
+
+    pthread_mutex_unlock(&sink->lock);
+}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC FUNCTIONS DEFINITION ------------------------------- */
+
+/**
+ * register an output sink, it gets every log passing its filter from now on.
+ *
+ * @param desc sink description, copied
+ *
+ * @return sink id, -1 error
+ */
+int slog_sink_register(const slog_sink_desc_t *desc)
+{
+    int i, id = -1;
+    slog_sink_t *sink = NULL;
+
+    if (NULL == desc || NULL == desc->name || NULL == desc->ops.write_batch) {
+        slog_error_inner("sink register invalid argument");
+        return -1;
+    }
+
+    /* reserve a slot */
+    pthread_rwlock_wrlock(&slog_sinks_lock);
+    for (i = 0; i < SLOG_SINK_REGISTER_MAX; ++i) {
+        if (SLOG_SINK_FREE == slog_sinks[i].state) {
+            slog_sinks[i].state = SLOG_SINK_STOPPING;
+            id = i;
+            break;
+        }
+    }
+    pthread_rwlock_unlock(&slog_sinks_lock);
+
+    if (-1 == id) {
+        slog_error_inner("sink register %s error: no free slot", desc->name);
+        return -1;
+    }
+
+    sink = &slog_sinks[id];
+    sink->desc = *desc;
+    snprintf(sink->name, SLOG_SINK_NAME_MAX_LEN, "%s", desc->name);
+    sink->desc.name = sink->name;
+    sink->desc.tag[SLOG_SINK_TAG_MAX_LEN] = '\0';
+    sink->tag_len = strlen(sink->desc.tag);
+
+    if ((NULL != desc->ops.open) && (0 != desc->ops.open(desc->ctx))) {
+        slog_error_inner("sink %s open error", desc->name);
+        goto err;
+    }
+
+    if (0 != slog_sink_start(sink)) {
+        if (NULL != desc->ops.close) {
+            desc->ops.close(desc->ctx);
+        }
+        goto err;
+    }
+
+    pthread_rwlock_wrlock(&slog_sinks_lock);
+    sink->state = SLOG_SINK_ACTIVE;
+    pthread_rwlock_unlock(&slog_sinks_lock);
+
+    return id;
+
+err:
+    pthread_rwlock_wrlock(&slog_sinks_lock);
+    sink->state = SLOG_SINK_FREE;
+    pthread_rwlock_unlock(&slog_sinks_lock);
+    return -1;
+}
+
+/**
+ * unregister an output sink, the logs already queued are written first.
+ *
+ * @param sink_id id returned by slog_sink_register()
+ *
+ * @return result
+ */
+int slog_sink_unregister(int sink_id)
+{
+    slog_sink_t *sink = NULL;
+
+    if (sink_id < 0 || sink_id >= SLOG_SINK_REGISTER_MAX) {
+        return -1;
+    }
+    sink = &slog_sinks[sink_id];
+
+    pthread_rwlock_wrlock(&slog_sinks_lock);
+    if (SLOG_SINK_ACTIVE != sink->state) {
+        pthread_rwlock_unlock(&slog_sinks_lock);
+        return -1;
+    }
+    sink->state = SLOG_SINK_STOPPING;
+    pthread_rwlock_unlock(&slog_sinks_lock);
+
+    slog_sink_stop(sink);
+
+    pthread_rwlock_wrlock(&slog_sinks_lock);
+    sink->state = SLOG_SINK_FREE;
+    pthread_rwlock_unlock(&slog_sinks_lock);
+
+    return 0;
+}
+
+/**
+ * hand one log event to one sink, waiting while its queue is full instead
+ * of dropping or shedding it, for bursts no log of which may be lost. No
+ * lock is held while it sleeps.
+ *
+ * @param sink_id id returned by slog_sink_register()
+ * @param slog_event_buf log event
+ * @param deadline CLOCK_MONOTONIC time to give up at, the event is dropped then
+ *
+ * @return 0 queued, 1 no such sink or filtered, -1 dropped, no room in time
+ */
+int slog_sink_post_wait(int sink_id, const void *slog_event_buf, const struct timespec *deadline)
+{
+    int result = 1;
+    bool done = false;
+    slog_sink_t *sink = NULL;
+    struct timespec now;
+    const slog_event_head_t *head = (const slog_event_head_t *)slog_event_buf;
+
+    if (sink_id < 0 || sink_id >= SLOG_SINK_REGISTER_MAX) {
+        return 1;
+    }
+    sink = &slog_sinks[sink_id];
+
+    while (!done) {
+        pthread_rwlock_rdlock(&slog_sinks_lock);
+        if ((SLOG_SINK_ACTIVE != sink->state) || !slog_sink_accept(sink, head)) {
+            pthread_rwlock_unlock(&slog_sinks_lock);
+            break;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        pthread_mutex_lock(&sink->lock);
+        if (kfifo_avail(&sink->queue) >= head->slog_event_length) {
+            kfifo_in(&sink->queue, slog_event_buf, head->slog_event_length);
+            if (sink->waiting) {
+                pthread_cond_signal(&sink->cond);
+            }
+            result = 0;
+            done = true;
+        } else if ((head->slog_event_length > kfifo_size(&sink->queue)) || (now.tv_sec > deadline->tv_sec) ||
+                   ((now.tv_sec == deadline->tv_sec) && (now.tv_nsec >= deadline->tv_nsec))) {
+            slog_sink_drop(sink);
+            result = -1;
+            done = true;
+        }
+        pthread_mutex_unlock(&sink->lock);
+        pthread_rwlock_unlock(&slog_sinks_lock);
+
+        if (!done) {
+            usleep(SLOG_SINK_POST_WAIT_STEP);
+        }
+    }
+
+    return result;
+}
+
+/**
+ * wait until every sink wrote and flushed the events queued before the call.
+ * The sink table's lock is let go before the wait, the sink's flushers keep
+ * slog_sink_stop() from freeing it meanwhile.
+ *
+ * @param deadline CLOCK_MONOTONIC time to give up at
+ *
+ * @return 0 written, -1 a sink did not write them in time or was unregistered
+ */
+int slog_sink_flush(const struct timespec *deadline)
+{
+    int i, ret, result = 0;
+    unsigned int target;
+    slog_sink_t *sink = NULL;
+
+    for (i = 0; i < SLOG_SINK_REGISTER_MAX; ++i) {
+        sink = &slog_sinks[i];
+        pthread_rwlock_rdlock(&slog_sinks_lock);
+        if (SLOG_SINK_ACTIVE != sink->state) {
+            pthread_rwlock_unlock(&slog_sinks_lock);
+            continue;
+        }
+        pthread_mutex_lock(&sink->lock);
+        pthread_rwlock_unlock(&slog_sinks_lock);
+
+        ret = 0;
+        target = sink->queue.kfifo.in;
+        sink->flushers++;
+        while (sink->running && ((int)(target - sink->written) > 0) && (ETIMEDOUT != ret)) {
+            ret = pthread_cond_timedwait(&sink->written_cond, &sink->lock, deadline);
+        }
+        sink->flushers--;
+        if ((int)(target - sink->written) > 0) {
+            result = -1;
+        }
+
+        /* slog_sink_stop() waits for the last flusher before it destroys the conds */
+        if (!sink->running) {
+            pthread_cond_broadcast(&sink->written_cond);
+        }
+        pthread_mutex_unlock(&sink->lock);
+    }
+
+    return result;
+}
+
+/**
+ * stop every sink worker taking events, for the fatal signal handler to
+ * walk the queues as they are. A batch taken already is still written.
+ */
+void slog_sink_freeze(void)
+{
+    __atomic_store_n(&slog_sinks_frozen, 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * walk the events queued for one sink, not written yet, without taking
+ * them out or locking, for the fatal signal handler
+ *
+ * @param sink_id id returned by slog_sink_register()
+ * @param slog_event_buf SLOG_EVENT_BUF_MAXLEN bytes each event is copied to
+ * @param walk called for each event
+ * @param arg passed to walk
+ */
+void slog_sink_walk(int sink_id, void *slog_event_buf,
+                    void (*walk)(const void *slog_event_buf, void *arg), void *arg)
+{
+    if ((sink_id < 0) || (sink_id >= SLOG_SINK_REGISTER_MAX) || (SLOG_SINK_ACTIVE != slog_sinks[sink_id].state)) {
+        return;
+    }
+
+    slog_event_fifo_walk(&slog_sinks[sink_id].queue, 0, slog_event_buf, walk, arg);
+}
+
+/**
+ * copy the counters of the registered sinks
+ *
+ * @param stats SLOG_SINK_REGISTER_MAX of them
+ *
+ * @return sinks copied
+ */
+int slog_sink_stats(slog_sink_stats_t *stats)
+{
+    int i, sinks = 0;
+
+    pthread_rwlock_rdlock(&slog_sinks_lock);
+    for (i = 0; i < SLOG_SINK_REGISTER_MAX; ++i) {
+        if (SLOG_SINK_ACTIVE == slog_sinks[i].state) {
+            memcpy(&stats[sinks++], &slog_sinks[i].stats, sizeof(slog_sink_stats_t));
+        }
+    }
+    pthread_rwlock_unlock(&slog_sinks_lock);
+
+    return sinks;
+}
+
+void slog_sink_unregister_all(void)
+{
+    int i;
+
+    for (i = 0; i < SLOG_SINK_REGISTER_MAX; ++i) {
+        slog_sink_unregister(i);
+    }
+}
+
+/**
+ * hand one log event to every registered sink whose filter accepts it
+ *
+ * @param slog_event_buf log event
+ */
+void slog_sink_dispatch(const void *slog_event_buf)
+{
+    int i;
+    const slog_event_head_t *head = (const slog_event_head_t *)slog_event_buf;
+
+    pthread_rwlock_rdlock(&slog_sinks_lock);
+    for (i = 0; i < SLOG_SINK_REGISTER_MAX; ++i) {
+        if ((SLOG_SINK_ACTIVE == slog_sinks[i].state) && slog_sink_accept(&slog_sinks[i], head)) {
+            slog_sink_post(&slog_sinks[i], slog_event_buf);
+        }
+    }
+    pthread_rwlock_unlock(&slog_sinks_lock);
+}
+
+
+/* ============== EOF ======================================================= */
\ No newline at end of file
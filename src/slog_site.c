@@ -0,0 +1,159 @@
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <time.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "slog_site.h"
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE MACROS -------------------------------------------- */
+
+/* a tick of the coarse clock is a few ms, good enough to pace a site */
+#ifdef CLOCK_MONOTONIC_COARSE
+#define SLOG_SITE_CLOCK                      CLOCK_MONOTONIC_COARSE
+#else
+#define SLOG_SITE_CLOCK                      CLOCK_MONOTONIC
+#endif
+
+/* the sampler's sequence steps by it, 2^32 / golden ratio */
+#define SLOG_SITE_SAMPLE_STEP                0x9e3779b9UL
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE FUNCTIONS DEFINITION ------------------------------ */
+
+static uint64_t slog_site_now(void)
+{
+    struct timespec now;
+
+    clock_gettime(SLOG_SITE_CLOCK, &now);
+
+    return (uint64_t)now.tv_sec * 1000000 + (uint64_t)now.tv_nsec / 1000;
+}
+
+static bool slog_site_suppress(slog_site_t *site)
+{
+    __atomic_fetch_add(&site->suppressed, 1, __ATOMIC_RELAXED);
+
+    return false;
+}
+
+/*
+ * murmur3's finalizer, spreads the sequence over 32 bits
+ */
+static uint32_t slog_site_mix(uint32_t x)
+{
+    x ^= x >> 16;
+    x *= 0x85ebca6bU;
+    x ^= x >> 13;
+    x *= 0xc2b2ae35U;
+    x ^= x >> 16;
+
+    return x;
+}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC FUNCTIONS DEFINITION ------------------------------- */
+
+/**
+ * token bucket of burst tokens, refilled at burst per interval_ms. Kept as
+ * the time the bucket is full again (GCRA), one CAS per call output.
+ *
+ * @param site the site's state
+ * @param burst calls output back to back, 0 as 1
+ * @param interval_ms the bucket refills in it, 0 no limit
+ *
+ * @return true output the call
+ */
+bool slog_site_ratelimit(slog_site_t *site, unsigned int burst, unsigned int interval_ms)
+{
+    uint64_t now, tat, base;
+    uint64_t interval = (uint64_t)interval_ms * 1000;
+    uint64_t step, tolerance;
+
+    if (0 == interval) {
+        return true;
+    }
+    if (0 == burst) {
+        burst = 1;
+    }
+    step = interval / burst;
+    tolerance = interval - step;
+
+    now = slog_site_now();
+    tat = __atomic_load_n(&site->tat, __ATOMIC_RELAXED);
+    do {
+        base = (tat > now) ? tat : now;
+        if (base - now > tolerance) {
+            return slog_site_suppress(site);
+        }
+    } while (!__atomic_compare_exchange_n(&site->tat, &tat, base + step, true,
+                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+    return true;
+}
+
+/**
+ * output the 1st call and every n-th after it
+ *
+ * @param n 0 as 1
+ *
+ * @return true output the call
+ */
+bool slog_site_every_n(slog_site_t *site, unsigned long n)
+{
+    unsigned long count = __atomic_fetch_add(&site->count, 1, __ATOMIC_RELAXED);
+
+    if ((n > 1) && (0 != count % n)) {
+        return slog_site_suppress(site);
+    }
+
+    return true;
+}
+
+/**
+ * output the first n calls only
+ *
+ * @return true output the call
+ */
+bool slog_site_first_n(slog_site_t *site, unsigned long n)
+{
+    /* the count stops growing once past n, the later calls only read it */
+    if ((__atomic_load_n(&site->count, __ATOMIC_RELAXED) >= n) ||
+        (__atomic_fetch_add(&site->count, 1, __ATOMIC_RELAXED) >= n)) {
+        return slog_site_suppress(site);
+    }
+
+    return true;
+}
+
+/**
+ * output a call with probability p, by a hashed sequence of the site's so
+ * threads sharing the site draw apart
+ *
+ * @param p 0 never, 1 always
+ *
+ * @return true output the call
+ */
+bool slog_site_sample(slog_site_t *site, double p)
+{
+    uint32_t draw;
+
+    if (p >= 1.0) {
+        return true;
+    }
+
+    draw = slog_site_mix((uint32_t)__atomic_fetch_add(&site->count, SLOG_SITE_SAMPLE_STEP, __ATOMIC_RELAXED));
+    if ((p <= 0.0) || ((double)draw >= p * 4294967296.0)) {
+        return slog_site_suppress(site);
+    }
+
+    return true;
+}
+
+
+/* ============== EOF ======================================================= */
\ No newline at end of file
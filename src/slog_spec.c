@@ -24,6 +24,59 @@
 
 #define SLOG_DEF_SIGN                        ' '
 
+/**
+ * CSI(Control Sequence Introducer/Initiator) sign
+ */
+#define CSI_START                            "\033["
+#define CSI_END                              "\033[0m"
+
+/* output log front color */
+#define F_BLACK                              "30;"
+#define F_RED                                "31;"
+#define F_GREEN                              "32;"
+#define F_YELLOW                             "33;"
+#define F_BLUE                               "34;"
+#define F_MAGENTA                            "35;"
+#define F_CYAN                               "36;"
+#define F_WHITE                              "37;"
+
+/* output log background color */
+#define B_NULL
+#define B_BLACK                              "40;"
+#define B_RED                                "41;"
+#define B_GREEN                              "42;"
+#define B_YELLOW                             "43;"
+#define B_BLUE                               "44;"
+#define B_MAGENTA                            "45;"
+#define B_CYAN                               "46;"
+#define B_WHITE                              "47;"
+
+/* output log fonts style */
+#define S_BOLD                               "1m"
+#define S_UNDERLINE                          "4m"
+#define S_BLINK                              "5m"
+#define S_NORMAL                             "22m"
+/* output log default color definition: [front color] + [background color] + [show style] */
+
+#define SLOG_COLOR_ASSERT                    F_MAGENTA B_NULL S_BOLD
+#define SLOG_COLOR_ERROR                     F_RED B_NULL S_BOLD
+#define SLOG_COLOR_WARN                      F_YELLOW B_NULL S_NORMAL
+#define SLOG_COLOR_INFO                      F_CYAN B_NULL S_NORMAL
+#define SLOG_COLOR_DEBUG                     F_GREEN B_NULL S_NORMAL
+#define SLOG_COLOR_VERBOSE                   F_BLUE B_NULL S_NORMAL
+
+/* color prefix with its length, built at compile time */
+#define SLOG_COLOR_PREFIX(color)             { CSI_START color, sizeof(CSI_START color) - 1 }
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE TYPES --------------------------------------------- */
+
+typedef struct slog_color_s {
+    const char *str;
+    size_t len;
+} slog_color_t;
+
 
 /* -------------------------------------------------------------------------- */
 /* -------------- PRIVATE VARIABLES ----------------------------------------- */
@@ -38,6 +91,66 @@ static const char *level_output_info[] = {
         [VERBOSE] = "VERBOSE| ",
 };
 
+/* color prefix of each level */
+static const slog_color_t color_prefix[] = {
+        [ASSERT]  = SLOG_COLOR_PREFIX(SLOG_COLOR_ASSERT),
+        [ERROR]   = SLOG_COLOR_PREFIX(SLOG_COLOR_ERROR),
+        [WARN]    = SLOG_COLOR_PREFIX(SLOG_COLOR_WARN),
+        [INFO]    = SLOG_COLOR_PREFIX(SLOG_COLOR_INFO),
+        [DEBUG]   = SLOG_COLOR_PREFIX(SLOG_COLOR_DEBUG),
+        [VERBOSE] = SLOG_COLOR_PREFIX(SLOG_COLOR_VERBOSE),
+};
+
+
+/* broken down time of the last formatted second, per formatting thread */
+static __thread time_t cached_sec = -1;
+static __thread struct tm cached_tm;
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE FUNCTIONS DEFINITION ------------------------------ */
+
+/*
+ * put value as width digits at least, zero padded
+ */
+static int format_dec(char *buf, uint32_t value, int width)
+{
+    char digits[10];
+    int n = 0, len = 0;
+
+    do {
+        digits[n++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (0 != value);
+
+    while (width-- > n) {
+        buf[len++] = '0';
+    }
+    while (n > 0) {
+        buf[len++] = digits[--n];
+    }
+
+    return len;
+}
+
+/*
+ * broken down civil date of the days since 1970-01-01, localtime_r() takes
+ * a lock and may read files, a signal handler cannot call it
+ */
+static void format_civil_date(int64_t days, int64_t *year, uint32_t *month, uint32_t *day)
+{
+    int64_t z = days + 719468;
+    int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    uint32_t doe = (uint32_t)(z - era * 146097);
+    uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    uint32_t mp = (5 * doy + 2) / 153;
+
+    *day = doy - (153 * mp + 2) / 5 + 1;
+    *month = (mp < 10) ? mp + 3 : mp - 9;
+    *year = (int64_t)yoe + era * 400 + (*month <= 2);
+}
+
 
 /* -------------------------------------------------------------------------- */
 /* -------------- PUBLIC FUNCTIONS DEFINITION ------------------------------- */
@@ -58,11 +171,14 @@ int format_log(char *slog_format_buf, const void *slog_event_buf)
     /* log time */
     slog_format_buf[log_len++] = '[';
     char cur_system_time[SLOG_TIME_FORMAT_LEN] = { 0 };
-    struct tm *p = NULL;
+    struct tm *p = &cached_tm;
     time_t timep = (time_t)log_time.tv_sec;
-    p = localtime(&timep);
-    if (p == NULL) {
-        return -1;
+    if (timep != cached_sec) {
+        /* sinks format on their own threads, localtime() is not reentrant */
+        if (NULL == localtime_r(&timep, &cached_tm)) {
+            return -1;
+        }
+        cached_sec = timep;
     }
 
     int time_len = snprintf(cur_system_time, SLOG_TIME_FORMAT_LEN, "%04d-%02d-%02d %02d:%02d:%02d.%06ld", 
@@ -122,5 +238,116 @@ int format_log(char *slog_format_buf, const void *slog_event_buf)
     return log_len;
 }
 
+/**
+ * format log wrapped in its level's color, slog_format_buf needs
+ * SLOG_FORMAT_BUF_SIZE + SLOG_FORMAT_COLOR_LEN bytes
+ *
+ * @return log length, -1 error
+ */
+int format_log_color(char *slog_format_buf, const void *slog_event_buf)
+{
+    int ret;
+    uint8_t level = ((slog_event_head_t *)slog_event_buf)->slog_level;
+    int log_len = color_prefix[level].len;
+
+    memcpy(slog_format_buf, color_prefix[level].str, log_len);
+
+    ret = format_log(slog_format_buf + log_len, slog_event_buf);
+    if (ret < 0) {
+        return -1;
+    }
+    log_len += ret;
+
+    memcpy(slog_format_buf + log_len, CSI_END, sizeof(CSI_END) - 1);
+    log_len += sizeof(CSI_END) - 1;
+
+    return log_len;
+}
+
+/**
+ * format log as format_log() does, async-signal-safe: no locale, no stdio,
+ * no lock. The event may come from a ring being written, its lengths are
+ * checked.
+ *
+ * @param slog_format_buf SLOG_FORMAT_BUF_SIZE bytes
+ * @param slog_event_buf log event
+ * @param gmtoff seconds east of UTC of the local time, taken beforehand
+ *
+ * @return log length, -1 invalid event
+ */
+int format_log_safe(char *slog_format_buf, const void *slog_event_buf, long gmtoff)
+{
+    const slog_event_head_t *head = (const slog_event_head_t *)slog_event_buf;
+    const char *tag = (const char *)slog_event_buf + sizeof(slog_event_head_t);
+    const char *file = tag + head->slog_tag_len;
+    const char *func = file + head->slog_file_len;
+    const char *info = func + head->slog_func_len;
+    uint32_t strs_len = (uint32_t)head->slog_tag_len + head->slog_file_len + head->slog_func_len;
+    uint32_t info_len, level_len, month, day;
+    int64_t sec, days, year;
+    int log_len = 0;
+
+    if ((head->slog_level > VERBOSE) || (head->slog_event_length > SLOG_EVENT_BUF_MAXLEN) ||
+        (head->slog_event_length < sizeof(slog_event_head_t) + strs_len)) {
+        return -1;
+    }
+    info_len = head->slog_event_length - (sizeof(slog_event_head_t) + strs_len);
+
+    /* log time */
+    sec = (int64_t)head->slog_time.tv_sec + gmtoff;
+    days = (sec >= 0 ? sec : sec - 86399) / 86400;
+    sec -= days * 86400;
+    format_civil_date(days, &year, &month, &day);
+    if ((year < 0) || (year > 9999)) {
+        return -1;
+    }
+
+    slog_format_buf[log_len++] = '[';
+    log_len += format_dec(slog_format_buf + log_len, (uint32_t)year, 4);
+    slog_format_buf[log_len++] = '-';
+    log_len += format_dec(slog_format_buf + log_len, month, 2);
+    slog_format_buf[log_len++] = '-';
+    log_len += format_dec(slog_format_buf + log_len, day, 2);
+    slog_format_buf[log_len++] = ' ';
+    log_len += format_dec(slog_format_buf + log_len, (uint32_t)(sec / 3600), 2);
+    slog_format_buf[log_len++] = ':';
+    log_len += format_dec(slog_format_buf + log_len, (uint32_t)(sec / 60 % 60), 2);
+    slog_format_buf[log_len++] = ':';
+    log_len += format_dec(slog_format_buf + log_len, (uint32_t)(sec % 60), 2);
+    slog_format_buf[log_len++] = '.';
+    log_len += format_dec(slog_format_buf + log_len, (uint32_t)head->slog_time.tv_usec % 1000000, 6);
+    slog_format_buf[log_len++] = ']';
+    slog_format_buf[log_len++] = ' ';
+
+    /* log level, tag, file, func and line */
+    level_len = strlen(level_output_info[head->slog_level]);
+    memcpy(slog_format_buf + log_len, level_output_info[head->slog_level], level_len);
+    log_len += level_len;
+
+    memcpy(slog_format_buf + log_len, tag, head->slog_tag_len);
+    log_len += head->slog_tag_len;
+    slog_format_buf[log_len++] = ' ';
+    slog_format_buf[log_len++] = '(';
+    memcpy(slog_format_buf + log_len, file, head->slog_file_len);
+    log_len += head->slog_file_len;
+    slog_format_buf[log_len++] = ' ';
+    memcpy(slog_format_buf + log_len, func, head->slog_func_len);
+    log_len += head->slog_func_len;
+    slog_format_buf[log_len++] = ':';
+    log_len += format_dec(slog_format_buf + log_len, head->slog_line, 1);
+    slog_format_buf[log_len++] = ')';
+    slog_format_buf[log_len++] = ' ';
+
+    if (log_len + info_len >= SLOG_FORMAT_BUF_SIZE) {
+        return -1;
+    }
+
+    memcpy(slog_format_buf + log_len, info, info_len);
+    log_len += info_len;
+    slog_format_buf[log_len++] = '\n';
+
+    return log_len;
+}
+
 
 /* ============== EOF ======================================================= */
\ No newline at end of file
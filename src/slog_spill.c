@@ -0,0 +1,389 @@
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <stdio.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "logger.h"
+#include "slog_cfg.h"
+#include "slog_event.h"
+#include "slog_inner.h"
+#include "slog_quota.h"
+#include "slog_spill.h"
+#include "slog_stats.h"
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE MACROS -------------------------------------------- */
+
+/* the producers' logs are written to the file a chunk at a time, staged into one buf while the other is written */
+#define SLOG_SPILL_CHUNK                     (64 * 1024)  /* 64KB */
+
+#define SLOG_SPILL_NAME_MAX_LEN              64
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE TYPES --------------------------------------------- */
+
+typedef struct slog_spill_s {
+    int fd;                                  /* -1 no spill */
+    char name[SLOG_SPILL_NAME_MAX_LEN];
+    uint64_t cap;                            /* bytes the file grows to */
+    int active;                              /* logs wait in the spill, later ones join them */
+    pthread_mutex_t lock;                    /* the staged logs and the file's end, logs go in put order */
+    pthread_cond_t written;                  /* the write in flight is done */
+    int stage;                               /* buf the logs are staged in */
+    uint32_t len;                            /* bytes staged */
+    unsigned int count;                      /* logs staged */
+    uint32_t writing;                        /* bytes of the other buf being written, 0 none */
+    uint64_t size;                           /* bytes written */
+    uint64_t offset;                         /* bytes read back, the output thread's */
+    char *read_buf;                          /* the output thread's */
+    uint32_t read_len;
+    uint32_t read_pos;
+    unsigned int in;                         /* logs spilled */
+    unsigned int out;                        /* logs spilled and output or dropped */
+    unsigned long dropped;                   /* logs beyond the cap or lost to a write error */
+    unsigned long reported;                  /* dropped as the last spill ended */
+    char buf[2][SLOG_SPILL_CHUNK];           /* logs not written to the file yet */
+} slog_spill_t;
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE VARIABLES ----------------------------------------- */
+
+static slog_spill_t slog_spill = { .fd = -1 };
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE FUNCTIONS DEFINITION ------------------------------ */
+
+/*
+ * staged logs a write error lost after their put succeeded, they give their
+ * quota back and count as dropped
+ */
+static void slog_spill_lost(const char *buf, uint32_t len, unsigned int count)
+{
+    uint32_t pos = 0;
+    const slog_event_head_t *head = NULL;
+
+    while (pos < len) {
+        head = (const slog_event_head_t *)(buf + pos);
+        slog_quota_release(head);
+        slog_stats_lost(head->slog_level, head->slog_event_length);
+        pos += head->slog_event_length;
+    }
+
+    __atomic_add_fetch(&slog_spill.dropped, count, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&slog_spill.out, count, __ATOMIC_SEQ_CST);
+}
+
+/*
+ * write the staged logs to the file in one go, the lock held on the call
+ * and the return. The staged buf is swapped for the other one and written
+ * out of the lock, the producers stage into the other meanwhile. One write
+ * is in flight at a time, the file grows in put order.
+ */
+static void slog_spill_write(void)
+{
+    ssize_t written = 0;
+    uint32_t done = 0, len;
+    unsigned int count;
+    uint64_t offset;
+    const char *buf;
+
+    while (0 != slog_spill.writing) {
+        pthread_cond_wait(&slog_spill.written, &slog_spill.lock);
+    }
+    if (0 == slog_spill.len) {
+        return;
+    }
+
+    buf = slog_spill.buf[slog_spill.stage];
+    len = slog_spill.len;
+    count = slog_spill.count;
+    offset = slog_spill.size;
+    slog_spill.stage ^= 1;
+    slog_spill.len = 0;
+    slog_spill.count = 0;
+    slog_spill.writing = len;
+    pthread_mutex_unlock(&slog_spill.lock);
+
+    while (done < len) {
+        written = pwrite(slog_spill.fd, buf + done, len - done, offset + done);
+        if (written <= 0) {
+            break;
+        }
+        done += written;
+    }
+
+    pthread_mutex_lock(&slog_spill.lock);
+    if (done == len) {
+        __atomic_store_n(&slog_spill.size, offset + len, __ATOMIC_RELEASE);
+    } else {
+        /* a part written is overwritten by the next chunk, never read */
+        slog_error_inner("log spill file write error: %s, %u logs dropped", strerror(errno), count);
+        slog_spill_lost(buf, len, count);
+    }
+    slog_spill.writing = 0;
+    pthread_cond_broadcast(&slog_spill.written);
+}
+
+/*
+ * caught up with the file, write the staged logs to it, or end the spill
+ * when there are none. The later logs go into the ring again.
+ *
+ * @return true the spill ended
+ */
+static bool slog_spill_catch_up(void)
+{
+    bool staged = false, ended = false;
+    unsigned long dropped;
+
+    pthread_mutex_lock(&slog_spill.lock);
+
+    if ((0 != slog_spill.len) || (0 != slog_spill.writing)) {
+        slog_spill_write();
+        staged = true;
+    }
+
+    if (!staged && (slog_spill.offset == __atomic_load_n(&slog_spill.size, __ATOMIC_ACQUIRE))) {
+        if (0 != ftruncate(slog_spill.fd, 0)) {
+            slog_error_inner("log spill file truncate error: %s", strerror(errno));
+        }
+        slog_spill.size = 0;
+        slog_spill.offset = 0;
+        slog_spill.read_len = 0;
+        slog_spill.read_pos = 0;
+        __atomic_store_n(&slog_spill.active, 0, __ATOMIC_RELEASE);
+        dropped = __atomic_load_n(&slog_spill.dropped, __ATOMIC_RELAXED);
+        slog_warn_inner("log spill replayed, %lu logs over its cap dropped", dropped - slog_spill.reported);
+        slog_spill.reported = dropped;
+        ended = true;
+    }
+
+    pthread_mutex_unlock(&slog_spill.lock);
+
+    return ended;
+}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC FUNCTIONS DEFINITION ------------------------------- */
+
+/**
+ * spill initialize, by the configured SPILL_SIZE, the file is created empty
+ *
+ * @return result
+ */
+int slog_spill_init(void)
+{
+    slog_spill.cap = (uint64_t)slog_get_spill_size() * 1024 * 1024;
+    if (0 == slog_spill.cap) {
+        return 0;
+    }
+
+    slog_spill.read_buf = (char *)malloc(SLOG_SPILL_CHUNK + SLOG_EVENT_BUF_MAXLEN);
+    if (NULL == slog_spill.read_buf) {
+        slog_error_inner("log spill malloc error");
+        return -1;
+    }
+
+    snprintf(slog_spill.name, sizeof(slog_spill.name), "%s.%d", SLOG_SPILL_FILE_NAME, (int)getpid());
+    slog_spill.fd = open(slog_spill.name, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (slog_spill.fd < 0) {
+        slog_error_inner("log spill file %s open error: %s", slog_spill.name, strerror(errno));
+        free(slog_spill.read_buf);
+        slog_spill.read_buf = NULL;
+        return -1;
+    }
+
+    pthread_mutex_init(&slog_spill.lock, NULL);
+    pthread_cond_init(&slog_spill.written, NULL);
+    slog_spill.stage = 0;
+    slog_spill.len = 0;
+    slog_spill.count = 0;
+    slog_spill.writing = 0;
+
+    return 0;
+}
+
+/**
+ * whether logs wait in the spill, a producer's log then goes after them
+ */
+bool slog_spill_active(void)
+{
+    return 0 != __atomic_load_n(&slog_spill.active, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * put an event the main ring has no room for, or one to queue up behind
+ * the spilled ones, into the spill. The logs are replayed in put order.
+ *
+ * @param slog_event_buf log event
+ * @param ring_put the ring's put, tried again once the spill ended
+ *
+ * @return 0 put, into the spill or the ring, -1 no spill or no room below its cap
+ */
+int slog_spill_put(void *slog_event_buf, slog_spill_ring_put_t ring_put)
+{
+    uint32_t length = ((const slog_event_head_t *)slog_event_buf)->slog_event_length;
+
+    if (slog_spill.fd < 0) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&slog_spill.lock);
+
+    /* a write lets the lock go, the state is seen again after it */
+    while (1) {
+        /* the output thread ends the spill with the lock held */
+        if (!slog_spill_active()) {
+            if (0 == ring_put(slog_event_buf)) {
+                pthread_mutex_unlock(&slog_spill.lock);
+                return 0;
+            }
+            if (0 == __sync_lock_test_and_set(&slog_spill.active, 1)) {
+                slog_warn_inner("log ring is full, logs spill to %s", slog_spill.name);
+            }
+        }
+
+        /* decided here, the caller counts a log it returns -1 for */
+        if (slog_spill.size + slog_spill.writing + slog_spill.len + length > slog_spill.cap) {
+            __atomic_add_fetch(&slog_spill.dropped, 1, __ATOMIC_RELAXED);
+            pthread_mutex_unlock(&slog_spill.lock);
+            return -1;
+        }
+
+        if (SLOG_SPILL_CHUNK - slog_spill.len >= length) {
+            break;
+        }
+        slog_spill_write();
+    }
+    memcpy(slog_spill.buf[slog_spill.stage] + slog_spill.len, slog_event_buf, length);
+    slog_spill.len += length;
+    slog_spill.count++;
+    __atomic_add_fetch(&slog_spill.in, 1, __ATOMIC_SEQ_CST);
+
+    pthread_mutex_unlock(&slog_spill.lock);
+
+    return 0;
+}
+
+/**
+ * get the next spilled event, on the output thread once the main ring is
+ * drained
+ *
+ * @param slog_event_buf SLOG_EVENT_BUF_MAXLEN bytes
+ *
+ * @return event bytes, 0 the spill ended
+ */
+size_t slog_spill_get(void *slog_event_buf)
+{
+    const slog_event_head_t *head = NULL;
+    uint32_t length, carried;
+    uint64_t size;
+    ssize_t n;
+
+    if (!slog_spill_active()) {
+        return 0;
+    }
+
+    while (1) {
+        head = (const slog_event_head_t *)(slog_spill.read_buf + slog_spill.read_pos);
+        if (slog_spill.read_len - slog_spill.read_pos >= sizeof(slog_event_head_t)) {
+            length = head->slog_event_length;
+            if ((length < sizeof(slog_event_head_t)) || (length > SLOG_EVENT_BUF_MAXLEN)) {
+                slog_error_inner("log spill file is corrupt, the rest of it is dropped");
+                slog_spill.read_pos = slog_spill.read_len;
+                slog_spill.offset = __atomic_load_n(&slog_spill.size, __ATOMIC_ACQUIRE);
+                continue;
+            }
+            if (slog_spill.read_len - slog_spill.read_pos >= length) {
+                memcpy(slog_event_buf, head, length);
+                slog_spill.read_pos += length;
+                __atomic_add_fetch(&slog_spill.out, 1, __ATOMIC_SEQ_CST);
+                return length;
+            }
+        }
+
+        /* the part of an event read carries over ahead of the next chunk */
+        size = __atomic_load_n(&slog_spill.size, __ATOMIC_ACQUIRE);
+        if (slog_spill.offset < size) {
+            carried = slog_spill.read_len - slog_spill.read_pos;
+            memmove(slog_spill.read_buf, slog_spill.read_buf + slog_spill.read_pos, carried);
+
+            /* not past size, a chunk beyond it may be half written */
+            n = pread(slog_spill.fd, slog_spill.read_buf + carried,
+                      (size - slog_spill.offset < SLOG_SPILL_CHUNK) ? size - slog_spill.offset : SLOG_SPILL_CHUNK,
+                      slog_spill.offset);
+            if (n <= 0) {
+                slog_error_inner("log spill file read error: %s", strerror(errno));
+                return 0;
+            }
+            slog_spill.offset += n;
+            slog_spill.read_pos = 0;
+            slog_spill.read_len = carried + n;
+            continue;
+        }
+
+        /* a spill starting over at once goes after the logs the ring took meanwhile */
+        if (slog_spill_catch_up()) {
+            return 0;
+        }
+    }
+}
+
+/**
+ * logs spilled, for slog_flush()
+ */
+unsigned int slog_spill_in(void)
+{
+    return __atomic_load_n(&slog_spill.in, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * logs spilled and output or dropped, for slog_flush()
+ */
+unsigned int slog_spill_out(void)
+{
+    return __atomic_load_n(&slog_spill.out, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * logs the spill dropped beyond its cap or to a write error since log_init()
+ */
+unsigned long slog_spill_get_dropped(void)
+{
+    return __atomic_load_n(&slog_spill.dropped, __ATOMIC_RELAXED);
+}
+
+/**
+ * remove the spill file, after the output thread replayed it and exited
+ */
+void slog_spill_deinit(void)
+{
+    if (slog_spill.fd < 0) {
+        return;
+    }
+
+    close(slog_spill.fd);
+    slog_spill.fd = -1;
+    unlink(slog_spill.name);
+    free(slog_spill.read_buf);
+    slog_spill.read_buf = NULL;
+    slog_spill.active = 0;
+
+    pthread_cond_destroy(&slog_spill.written);
+    pthread_mutex_destroy(&slog_spill.lock);
+}
+
+
+/* ============== EOF ======================================================= */
\ No newline at end of file
@@ -0,0 +1,342 @@
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <time.h>
+#include <stdio.h>
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdbool.h>
+#include <sys/time.h>
+
+#include "logger.h"
+#include "slog_buf.h"
+#include "slog_cfg.h"
+#include "slog_tcp.h"
+#include "slog_sink_int.h"
+#include "slog_event.h"
+#include "slog_inner.h"
+#include "slog_quota.h"
+#include "slog_spill.h"
+#include "slog_stats.h"
+#include "slog_latency.h"
+#include "slog_throttle.h"
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE MACROS -------------------------------------------- */
+
+/* producer counter shards, threads beyond share them */
+#define SLOG_STATS_SHARDS                    32
+
+#define SLOG_STATS_ADD(counter, n)           __atomic_add_fetch(&(counter), (n), __ATOMIC_RELAXED)
+#define SLOG_STATS_LOAD(counter)             __atomic_load_n(&(counter), __ATOMIC_RELAXED)
+#define SLOG_STATS_STORE(counter, n)         __atomic_store_n(&(counter), (n), __ATOMIC_RELAXED)
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE TYPES --------------------------------------------- */
+
+/* the producers' counters, a cache line apart so threads do not share one */
+typedef struct slog_stats_shard_s {
+    unsigned long enqueued[SLOG_STATS_LEVELS];
+    uint64_t bytes[SLOG_STATS_LEVELS];
+    unsigned long dropped[SLOG_STATS_LEVELS];
+    unsigned long throttled[SLOG_STATS_LEVELS];
+} __attribute__((aligned(64))) slog_stats_shard_t;
+
+/* the output thread's counters, and its stats file */
+typedef struct slog_stats_consumer_s {
+    unsigned long consumed;
+    unsigned long batches;
+    unsigned long batch_max;
+    unsigned long batch;                     /* logs of the pass going on */
+    uint32_t ring_high;
+    unsigned int lag;                        /* ms */
+    FILE *file;                              /* NULL no stats file */
+    int64_t interval;                        /* us between two lines */
+    int64_t next;                            /* us the next line is due */
+} slog_stats_consumer_t;
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE VARIABLES ----------------------------------------- */
+
+static slog_stats_shard_t slog_stats_shards[SLOG_STATS_SHARDS];
+
+static slog_stats_consumer_t slog_stats_consumer;
+
+/* shard of the calling thread, -1 none yet */
+static __thread int slog_stats_shard = -1;
+static unsigned int slog_stats_next_shard;
+
+static const char *slog_stats_level_names[] = {
+        [ASSERT]  = "ASSERT",
+        [ERROR]   = "ERROR",
+        [WARN]    = "WARN",
+        [INFO]    = "INFO",
+        [DEBUG]   = "DEBUG",
+        [VERBOSE] = "VERBOSE",
+};
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE FUNCTIONS DEFINITION ------------------------------ */
+
+static slog_stats_shard_t *slog_stats_shard_get(uint8_t level)
+{
+    if (level >= SLOG_STATS_LEVELS) {
+        return NULL;
+    }
+
+    if (slog_stats_shard < 0) {
+        slog_stats_shard = __atomic_fetch_add(&slog_stats_next_shard, 1, __ATOMIC_RELAXED) % SLOG_STATS_SHARDS;
+    }
+
+    return &slog_stats_shards[slog_stats_shard];
+}
+
+static int64_t slog_stats_now(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+
+    return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+static void slog_stats_print_levels(const unsigned long *counts)
+{
+    int i;
+
+    for (i = 0; i < SLOG_STATS_LEVELS; ++i) {
+        fprintf(slog_stats_consumer.file, "%s%lu", (0 == i) ? "" : ",", counts[i]);
+    }
+}
+
+/*
+ * append a line of the stats to the stats file, per level counts go from
+ * ASSERT to VERBOSE, a sink's are written/dropped/errors, the sampled
+ * calls' latency p50/p99/p99.9/max
+ */
+static void slog_stats_write(void)
+{
+    slog_stats_t stats;
+    struct tm tm;
+    time_t now = time(NULL);
+    char when[32];
+    int i;
+
+    slog_stats_get(&stats);
+    localtime_r(&now, &tm);
+    strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", &tm);
+
+    fprintf(slog_stats_consumer.file, "%s enqueued=", when);
+    slog_stats_print_levels(stats.enqueued);
+    fprintf(slog_stats_consumer.file, " dropped=");
+    slog_stats_print_levels(stats.dropped);
+    fprintf(slog_stats_consumer.file, " throttled=");
+    slog_stats_print_levels(stats.throttled);
+    fprintf(slog_stats_consumer.file,
+            " quota_dropped=%lu spilled=%lu spill_dropped=%lu remote_dropped=%lu"
+            " ring=%u/%u ring_high=%u consumed=%lu batches=%lu batch_max=%lu lag=%ums level=%s",
+            stats.quota_dropped, stats.spilled, stats.spill_dropped, stats.remote_dropped,
+            stats.ring_used, stats.ring_size, stats.ring_high, stats.consumed, stats.batches,
+            stats.batch_max, stats.lag, slog_stats_level_names[stats.throttle_level]);
+    for (i = 0; i < stats.sinks; ++i) {
+        fprintf(slog_stats_consumer.file, " %s=%lu/%lu/%lu", stats.sink[i].name,
+                stats.sink[i].written, stats.sink[i].dropped, stats.sink[i].errors);
+    }
+    if (0 != stats.call.count) {
+        fprintf(slog_stats_consumer.file, " call_ns=%llu/%llu/%llu/%llu",
+                (unsigned long long)stats.call.p50, (unsigned long long)stats.call.p99,
+                (unsigned long long)stats.call.p999, (unsigned long long)stats.call.max);
+    }
+    fprintf(slog_stats_consumer.file, "\n");
+    fflush(slog_stats_consumer.file);
+}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC FUNCTIONS DEFINITION ------------------------------- */
+
+/**
+ * stats initialize, the counters start over and the stats file is opened
+ * by the configured STATS_INTERVAL
+ */
+void slog_stats_init(void)
+{
+    memset(slog_stats_shards, 0, sizeof(slog_stats_shards));
+    memset(&slog_stats_consumer, 0, sizeof(slog_stats_consumer));
+
+    slog_stats_consumer.interval = (int64_t)slog_get_stats_interval() * 1000000;
+    if (0 == slog_stats_consumer.interval) {
+        return;
+    }
+
+    slog_stats_consumer.file = fopen(SLOG_STATS_FILE_NAME, "a");
+    if (NULL == slog_stats_consumer.file) {
+        slog_error_inner("log stats file %s open error: %s", SLOG_STATS_FILE_NAME, strerror(errno));
+        return;
+    }
+    slog_stats_consumer.next = slog_stats_now() + slog_stats_consumer.interval;
+}
+
+/**
+ * count a log put into the main ring or the spill
+ */
+void slog_stats_enqueued(uint8_t level, uint32_t bytes)
+{
+    slog_stats_shard_t *shard = slog_stats_shard_get(level);
+
+    if (NULL != shard) {
+        SLOG_STATS_ADD(shard->enqueued[level], 1);
+        SLOG_STATS_ADD(shard->bytes[level], bytes);
+    }
+}
+
+/**
+ * count a log a full ring or a tag quota dropped
+ */
+void slog_stats_dropped(uint8_t level)
+{
+    slog_stats_shard_t *shard = slog_stats_shard_get(level);
+
+    if (NULL != shard) {
+        SLOG_STATS_ADD(shard->dropped[level], 1);
+    }
+}
+
+/**
+ * count a log enqueued then lost, as dropped
+ */
+void slog_stats_lost(uint8_t level, uint32_t bytes)
+{
+    slog_stats_shard_t *shard = slog_stats_shard_get(level);
+
+    /* the shards' sum is right even when this one goes below 0 */
+    if (NULL != shard) {
+        SLOG_STATS_ADD(shard->enqueued[level], -1UL);
+        SLOG_STATS_ADD(shard->bytes[level], -(uint64_t)bytes);
+        SLOG_STATS_ADD(shard->dropped[level], 1);
+    }
+}
+
+/**
+ * count a log the throttle filtered out
+ */
+void slog_stats_throttled(uint8_t level)
+{
+    slog_stats_shard_t *shard = slog_stats_shard_get(level);
+
+    if (NULL != shard) {
+        SLOG_STATS_ADD(shard->throttled[level], 1);
+    }
+}
+
+/**
+ * count a log the output thread took, on the output thread
+ */
+void slog_stats_consumed(void)
+{
+    uint32_t used = slog_buffer_used();
+
+    SLOG_STATS_STORE(slog_stats_consumer.consumed, slog_stats_consumer.consumed + 1);
+    slog_stats_consumer.batch++;
+    if (used > slog_stats_consumer.ring_high) {
+        SLOG_STATS_STORE(slog_stats_consumer.ring_high, used);
+    }
+}
+
+/**
+ * sample the output lag and append the stats line when due, on the output
+ * thread
+ *
+ * @param slog_event_buf event just taken, its age is the output lag, NULL the ring is drained
+ */
+void slog_stats_poll(const void *slog_event_buf)
+{
+    int64_t now;
+
+    if (NULL != slog_event_buf) {
+        const slog_event_head_t *head = (const slog_event_head_t *)slog_event_buf;
+        int64_t lag;
+
+        now = slog_stats_now();
+        lag = now - ((int64_t)head->slog_time.tv_sec * 1000000 + head->slog_time.tv_usec);
+        SLOG_STATS_STORE(slog_stats_consumer.lag, (lag > 0) ? (unsigned int)(lag / 1000) : 0);
+    } else {
+        if (0 != slog_stats_consumer.batch) {
+            SLOG_STATS_STORE(slog_stats_consumer.batches, slog_stats_consumer.batches + 1);
+            if (slog_stats_consumer.batch > slog_stats_consumer.batch_max) {
+                SLOG_STATS_STORE(slog_stats_consumer.batch_max, slog_stats_consumer.batch);
+            }
+            slog_stats_consumer.batch = 0;
+        }
+        SLOG_STATS_STORE(slog_stats_consumer.lag, 0);
+
+        if (NULL == slog_stats_consumer.file) {
+            return;
+        }
+        now = slog_stats_now();
+    }
+
+    if ((NULL != slog_stats_consumer.file) && (now >= slog_stats_consumer.next)) {
+        slog_stats_consumer.next = now + slog_stats_consumer.interval;
+        slog_stats_write();
+    }
+}
+
+/**
+ * sum the counters up, from any thread
+ */
+void slog_stats_get(slog_stats_t *stats)
+{
+    int i, level;
+
+    memset(stats, 0, sizeof(*stats));
+
+    for (i = 0; i < SLOG_STATS_SHARDS; ++i) {
+        for (level = 0; level < SLOG_STATS_LEVELS; ++level) {
+            stats->enqueued[level] += SLOG_STATS_LOAD(slog_stats_shards[i].enqueued[level]);
+            stats->bytes[level] += SLOG_STATS_LOAD(slog_stats_shards[i].bytes[level]);
+            stats->dropped[level] += SLOG_STATS_LOAD(slog_stats_shards[i].dropped[level]);
+            stats->throttled[level] += SLOG_STATS_LOAD(slog_stats_shards[i].throttled[level]);
+        }
+    }
+
+    stats->quota_dropped = slog_quota_get_dropped();
+    stats->spilled = slog_spill_in();
+    stats->spill_dropped = slog_spill_get_dropped();
+    stats->remote_dropped = slog_remote_get_dropped();
+
+    stats->ring_size = slog_buffer_size();
+    stats->ring_used = slog_buffer_used();
+    stats->ring_high = SLOG_STATS_LOAD(slog_stats_consumer.ring_high);
+    stats->consumed = SLOG_STATS_LOAD(slog_stats_consumer.consumed);
+    stats->batches = SLOG_STATS_LOAD(slog_stats_consumer.batches);
+    stats->batch_max = SLOG_STATS_LOAD(slog_stats_consumer.batch_max);
+    stats->lag = SLOG_STATS_LOAD(slog_stats_consumer.lag);
+    stats->throttle_level = slog_throttle_level();
+
+    stats->sinks = slog_sink_stats(stats->sink);
+
+    slog_latency_get(&stats->call);
+}
+
+/**
+ * append the last stats line and close the stats file, after the output
+ * thread exited
+ */
+void slog_stats_deinit(void)
+{
+    if (NULL != slog_stats_consumer.file) {
+        slog_stats_write();
+        fclose(slog_stats_consumer.file);
+        slog_stats_consumer.file = NULL;
+    }
+}
+
+
+/* ============== EOF ======================================================= */
\ No newline at end of file
@@ -1,38 +1,230 @@
-
-
 /* -------------------------------------------------------------------------- */
 /* -------------- DEPENDANCIES ---------------------------------------------- */
 
+#define _GNU_SOURCE
+
 #include <stdio.h>
+#include <poll.h>
 #include <unistd.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <stdint.h>
+#include <stdbool.h>
 #include <string.h>
+#include <time.h>
 #include <sys/types.h>
+#include <sys/stat.h>
 #include <arpa/inet.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 
+#include "slog_lz.h"
 #include "slog_tcp.h"
 #include "slog_cfg.h"
 #include "slog_inner.h"
 
+
 /* -------------------------------------------------------------------------- */
-/* -------------- PUBLIC FUNCTIONS DEFINITION ------------------------------- */
+/* -------------- PRIVATE MACROS -------------------------------------------- */
 
-/**
- * remote output mode initialize
+/* datagrams of one sendmmsg */
+#define SLOG_REMOTE_MMSG_MAX                 64
+
+/* lines packed in one datagram at most */
+#define SLOG_REMOTE_DGRAM_IOV_MAX            64
+
+/* backoff while the socket buffer is full, the rest of the batch is dropped past max */
+#define SLOG_REMOTE_BACKOFF_MIN              1   /* ms */
+#define SLOG_REMOTE_BACKOFF_MAX              64  /* ms */
+
+/* drops are reported at most once per interval */
+#define SLOG_REMOTE_REPORT_INTERVAL          10  /* s */
+
+/* tcp connection state */
+#define SLOG_REMOTE_TCP_CLOSED               0
+#define SLOG_REMOTE_TCP_CONNECTING           1
+#define SLOG_REMOTE_TCP_CONNECTED            2
+
+/* backoff between tcp reconnects, doubled on every failure */
+#define SLOG_REMOTE_RECONNECT_MIN            100    /* ms */
+#define SLOG_REMOTE_RECONNECT_MAX            30000  /* ms */
+
+/* spool file of the tcp collector, and bytes replayed from it at once */
+#define SLOG_REMOTE_SPOOL_NAME               "slog.spool"
+#define SLOG_REMOTE_SPOOL_TMP_NAME           "slog.spool.tmp"
+#define SLOG_REMOTE_SPOOL_CHUNK              (64 * 1024)
+
+/* how long deinit keeps replaying the spool to a connected collector */
+#define SLOG_REMOTE_CLOSE_WAIT               1000  /* ms */
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE TYPES --------------------------------------------- */
+
+/*
+ * tcp collector stream. Logs go straight to the socket only while the spool
+ * is empty, otherwise they are appended to the spool, so the collector always
+ * gets them in order. A compressed stream sends slog_lz frames, a frame the
+ * socket took only in part stays pending and its raw bytes stay in the spool
+ * until it is sent completely.
+ */
+typedef struct slog_remote_tcp_s {
+    int state;                               /* SLOG_REMOTE_TCP_xxx */
+    int backoff;                             /* ms before the next reconnect */
+    uint64_t retry_time;                     /* monotonic ms of the next reconnect */
+    bool line_open;                          /* stream stopped inside a line, the spool head ends it */
+    int spool_fd;
+    off_t spool_off;                         /* spool bytes already replayed */
+    off_t spool_len;                         /* spool bytes written */
+    bool compress;                           /* slog_lz frames instead of plain lines */
+    size_t frame_len;                        /* pending frame bytes, 0 none */
+    size_t frame_sent;                       /* pending frame bytes sent */
+    size_t frame_raw;                        /* spool bytes the pending frame carries */
+} slog_remote_tcp_t;
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE VARIABLES ----------------------------------------- */
+
+/* datagrams, or tcp logs, dropped since the last report, and in total */
+static unsigned long remote_dropped = 0;
+static unsigned long remote_dropped_total = 0;
+
+/* last send error and the time drops were last reported */
+static int remote_errno = 0;
+static time_t remote_report_time = 0;
+
+static slog_remote_tcp_t tcp = { .state = SLOG_REMOTE_TCP_CLOSED, .spool_fd = -1 };
+
+/* spool replay buffer */
+static char spool_buf[SLOG_REMOTE_SPOOL_CHUNK];
+
+/* compressed stream encoder and its pending frame */
+static slog_lz_t tcp_lz;
+static char frame_buf[SLOG_LZ_FRAME_MAX];
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE FUNCTIONS DEFINITION ------------------------------ */
+
+static uint64_t slog_remote_now(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+static void slog_remote_address(struct sockaddr_in *host)
+{
+    char host_address[SLOG_REMOTE_HOST_MAX_LEN] = { 0 };
+
+    slog_get_output_remote_host(host_address);
+
+    bzero(host, sizeof(*host));
+    host->sin_family = AF_INET;
+    host->sin_port = htons(slog_get_output_remote_port());
+    host->sin_addr.s_addr = inet_addr(host_address);
+}
+
+/*
+ * skip the sent bytes of the iovecs
  *
- * @return result
+ * @param partial set when the last iovec was only partly sent, may be NULL
+ *
+ * @return first iovec not sent completely
  */
-int slog_remote_init(void)
+static int slog_remote_advance(struct iovec *iov, int pos, int iovcnt, size_t sent, bool *partial)
 {
-    if (!slog_get_output_remote_enabled()) {
-        return 0;
+    bool split = false;
+
+    while ((sent > 0) && (pos < iovcnt)) {
+        if (sent < iov[pos].iov_len) {
+            iov[pos].iov_base = (char *)iov[pos].iov_base + sent;
+            iov[pos].iov_len -= sent;
+            split = true;
+            break;
+        }
+        sent -= iov[pos].iov_len;
+        pos++;
+    }
+
+    if (NULL != partial) {
+        *partial = split;
     }
 
+    return pos;
+}
+
+static void slog_remote_report(const char *what)
+{
     char host_address[SLOG_REMOTE_HOST_MAX_LEN] = { 0 };
+
+    if ((0 == remote_dropped) || (time(NULL) - remote_report_time < SLOG_REMOTE_REPORT_INTERVAL)) {
+        return;
+    }
+
+    slog_get_output_remote_host(host_address);
+    slog_error_inner("send message to remote: %s error: %s, %lu %s dropped",
+                     host_address, strerror(remote_errno), remote_dropped, what);
+    remote_dropped = 0;
+    remote_report_time = time(NULL);
+}
+
+/*
+ * send the datagrams, backing off while the socket buffer is full
+ *
+ * @return result
+ */
+static int slog_remote_send(struct mmsghdr *msgs, int cnt)
+{
+    int ret, sent = 0;
+    int backoff = SLOG_REMOTE_BACKOFF_MIN;
+    int sockfd = slog_get_output_remote_socket();
+    struct pollfd pfd = { .fd = sockfd, .events = POLLOUT };
+
+    while (sent < cnt) {
+        ret = sendmmsg(sockfd, msgs + sent, cnt - sent, 0);
+        if (ret > 0) {
+            sent += ret;
+            backoff = SLOG_REMOTE_BACKOFF_MIN;
+            continue;
+        }
+
+        if (errno == EINTR) {
+            continue;
+        }
+
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS) {
+            if (backoff > SLOG_REMOTE_BACKOFF_MAX) {
+                break;
+            }
+            poll(&pfd, 1, backoff);
+            backoff *= 2;
+            continue;
+        }
+
+        /* e.g. ECONNREFUSED while the collector is down, only this datagram is lost */
+        remote_errno = errno;
+        remote_dropped++;
+        remote_dropped_total++;
+        sent++;
+    }
+
+    if (sent < cnt) {
+        remote_errno = EAGAIN;
+        remote_dropped += cnt - sent;
+        remote_dropped_total += cnt - sent;
+    }
+
+    return (sent == cnt) ? 0 : -1;
+}
+
+static int slog_remote_udp_init(void)
+{
     struct sockaddr_in host;
+    char host_address[SLOG_REMOTE_HOST_MAX_LEN] = { 0 };
     int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
     if (-1 == sockfd) {
         slog_error_inner("create socket error: %s", strerror(errno));
@@ -48,50 +240,633 @@ int slog_remote_init(void)
         slog_error_inner("set remote socket nonblock failed: %s", strerror(errno));
     }
 
-    slog_get_output_remote_host(host_address);
-
-    bzero(&host, sizeof(host));
-    host.sin_family = AF_INET;
-    host.sin_port = htons(slog_get_output_remote_port());
-    host.sin_addr.s_addr = inet_addr(host_address);
+    slog_remote_address(&host);
 
     if (-1 == connect(sockfd, (struct sockaddr *)&host, sizeof(host))) {
+        slog_get_output_remote_host(host_address);
         slog_error_inner("connect %s:%d error: %s", host_address, slog_get_output_remote_port(), strerror(errno));
+        close(sockfd);
         return -1;
     }
 
     slog_set_output_remote_socket(sockfd);
 
+    if (SLOG_REMOTE_COMPRESS_NONE != slog_get_output_remote_compress()) {
+        slog_warn_inner("remote compression needs a tcp stream, udp datagrams are sent uncompressed");
+    }
+
     return 0;
 }
 
-/**
- * log remote output
+/*
+ * packs the lines into datagrams of at most the configured mtu and sends
+ * them with sendmmsg. A line longer than the mtu goes alone in its datagram.
+ */
+static int slog_remote_udp_write(struct iovec *iov, int iovcnt)
+{
+    int cnt, start, pos = 0, result = 0;
+    size_t len;
+    size_t mtu = slog_get_output_remote_mtu();
+    struct mmsghdr msgs[SLOG_REMOTE_MMSG_MAX];
+
+    if (-1 == slog_get_output_remote_socket()) {
+        return -1;
+    }
+
+    while (pos < iovcnt) {
+        for (cnt = 0; (cnt < SLOG_REMOTE_MMSG_MAX) && (pos < iovcnt); ++cnt) {
+            start = pos;
+            len = iov[pos++].iov_len;
+            while ((pos < iovcnt) && (pos - start < SLOG_REMOTE_DGRAM_IOV_MAX) &&
+                   (len + iov[pos].iov_len <= mtu)) {
+                len += iov[pos++].iov_len;
+            }
+
+            memset(&msgs[cnt], 0, sizeof(msgs[cnt]));
+            msgs[cnt].msg_hdr.msg_iov = &iov[start];
+            msgs[cnt].msg_hdr.msg_iovlen = pos - start;
+        }
+
+        if (0 != slog_remote_send(msgs, cnt)) {
+            result = -1;
+        }
+    }
+
+    slog_remote_report("datagrams");
+
+    return result;
+}
+
+/*
+ * skip the rest of the line a broken connection stopped in, the collector
+ * got its head already and a new connection must start on a line
+ */
+static void slog_remote_spool_skip_line(void)
+{
+    ssize_t len;
+    const char *eol = NULL;
+
+    while (tcp.spool_off < tcp.spool_len) {
+        len = pread(tcp.spool_fd, spool_buf, SLOG_REMOTE_SPOOL_CHUNK, tcp.spool_off);
+        if (len <= 0) {
+            break;
+        }
+
+        eol = memchr(spool_buf, '\n', len);
+        if (NULL != eol) {
+            tcp.spool_off += eol - spool_buf + 1;
+            break;
+        }
+        tcp.spool_off += len;
+    }
+
+    tcp.line_open = false;
+}
+
+static void slog_remote_tcp_close(void)
+{
+    int sockfd = slog_get_output_remote_socket();
+
+    if (-1 != sockfd) {
+        close(sockfd);
+        slog_set_output_remote_socket(-1);
+    }
+
+    if (SLOG_REMOTE_TCP_CONNECTED == tcp.state) {
+        slog_warn_inner("remote collector disconnected: %s, logs go to spool", strerror(remote_errno));
+        tcp.backoff = SLOG_REMOTE_RECONNECT_MIN;
+    }
+
+    /* a pending frame is sent again from the spool on the next connection */
+    tcp.frame_len = 0;
+    tcp.frame_sent = 0;
+    tcp.frame_raw = 0;
+
+    tcp.state = SLOG_REMOTE_TCP_CLOSED;
+    tcp.retry_time = slog_remote_now() + tcp.backoff;
+    tcp.backoff *= 2;
+    if (tcp.backoff > SLOG_REMOTE_RECONNECT_MAX) {
+        tcp.backoff = SLOG_REMOTE_RECONNECT_MAX;
+    }
+}
+
+static void slog_remote_tcp_connected(void)
+{
+    tcp.state = SLOG_REMOTE_TCP_CONNECTED;
+    tcp.backoff = SLOG_REMOTE_RECONNECT_MIN;
+
+    if (tcp.line_open) {
+        slog_remote_spool_skip_line();
+    }
+
+    /* every connection starts a new compressed stream */
+    if (tcp.compress) {
+        slog_lz_reset(&tcp_lz);
+    }
+
+    slog_debug_inner("remote collector connected, %ld spooled bytes to replay",
+                     (long)(tcp.spool_len - tcp.spool_off));
+}
+
+/*
+ * start a non-blocking connect, it completes in slog_remote_tcp_check()
+ */
+static void slog_remote_tcp_connect(void)
+{
+    struct sockaddr_in host;
+    int sockfd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+    if (-1 == sockfd) {
+        remote_errno = errno;
+        slog_remote_tcp_close();
+        return;
+    }
+    slog_set_output_remote_socket(sockfd);
+
+    slog_remote_address(&host);
+
+    if (0 == connect(sockfd, (struct sockaddr *)&host, sizeof(host))) {
+        slog_remote_tcp_connected();
+    } else if (EINPROGRESS == errno) {
+        tcp.state = SLOG_REMOTE_TCP_CONNECTING;
+    } else {
+        remote_errno = errno;
+        slog_remote_tcp_close();
+    }
+}
+
+/*
+ * drive the connection: reconnect once the backoff passed, and complete a
+ * pending connect without waiting for it
+ */
+static void slog_remote_tcp_check(void)
+{
+    int ret, err = 0;
+    socklen_t len = sizeof(err);
+    struct pollfd pfd = { .fd = slog_get_output_remote_socket(), .events = POLLOUT };
+
+    if ((SLOG_REMOTE_TCP_CLOSED == tcp.state) && (slog_remote_now() >= tcp.retry_time)) {
+        slog_remote_tcp_connect();
+        pfd.fd = slog_get_output_remote_socket();
+    }
+
+    if (SLOG_REMOTE_TCP_CONNECTING != tcp.state) {
+        return;
+    }
+
+    ret = poll(&pfd, 1, 0);
+    if (ret <= 0) {
+        return;
+    }
+
+    if (0 != getsockopt(pfd.fd, SOL_SOCKET, SO_ERROR, &err, &len)) {
+        err = errno;
+    }
+
+    if (0 == err) {
+        slog_remote_tcp_connected();
+    } else {
+        remote_errno = err;
+        slog_remote_tcp_close();
+    }
+}
+
+/*
+ * send without blocking, a broken connection is closed
  *
- * @return result
+ * @return bytes sent, -1 disconnected
  */
-int slog_remote_write(const char *log, size_t size)
+static ssize_t slog_remote_tcp_send(struct iovec *iov, int iovcnt)
 {
-    if (NULL == log || 0 == size) {
+    ssize_t ret;
+    struct msghdr msg;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = iovcnt;
+
+    do {
+        ret = sendmsg(slog_get_output_remote_socket(), &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+    } while (ret < 0 && errno == EINTR);
+
+    if (ret >= 0) {
+        return ret;
+    }
+
+    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS) {
+        /* slow collector, the rest waits in the spool */
         return 0;
     }
 
-    /* size - 1 means to ignore '\n' in the end */
-    if (-1 == send(slog_get_output_remote_socket(), log, size - 1, 0)) {
-        if (errno == EINTR) {
-            return 0;
+    remote_errno = errno;
+    slog_remote_tcp_close();
+
+    return -1;
+}
+
+/*
+ * send the rest of the pending frame
+ *
+ * @return true once it is sent completely
+ */
+static bool slog_remote_frame_send(void)
+{
+    ssize_t sent;
+    struct iovec rest = { .iov_base = frame_buf + tcp.frame_sent, .iov_len = tcp.frame_len - tcp.frame_sent };
+
+    sent = slog_remote_tcp_send(&rest, 1);
+    if (sent > 0) {
+        tcp.frame_sent += sent;
+    }
+
+    return (SLOG_REMOTE_TCP_CONNECTED == tcp.state) && (tcp.frame_sent == tcp.frame_len);
+}
+
+/*
+ * replay the spool as compressed frames, each one ends on a line when it
+ * can, so a reconnect resends whole lines
+ */
+static void slog_remote_spool_replay_frames(void)
+{
+    int ret;
+    ssize_t len;
+    const char *eol = NULL;
+    struct iovec chunk;
+
+    while (SLOG_REMOTE_TCP_CONNECTED == tcp.state) {
+        if (0 == tcp.frame_len) {
+            if (tcp.spool_off >= tcp.spool_len) {
+                break;
+            }
+
+            len = pread(tcp.spool_fd, spool_buf, SLOG_REMOTE_SPOOL_CHUNK, tcp.spool_off);
+            if (len < 0 && errno == EINTR) {
+                continue;
+            }
+            if (len <= 0) {
+                slog_error_inner("read remote spool error: %s, spool dropped", strerror(errno));
+                tcp.spool_off = tcp.spool_len;
+                break;
+            }
+            if ((tcp.spool_off + len < tcp.spool_len) && (NULL != (eol = memrchr(spool_buf, '\n', len)))) {
+                len = eol - spool_buf + 1;
+            }
+
+            chunk.iov_base = spool_buf;
+            chunk.iov_len = len;
+            ret = slog_lz_frame_encode(&tcp_lz, &chunk, 1, frame_buf);
+            if (ret <= 0) {
+                tcp.spool_off += len;
+                continue;
+            }
+            tcp.frame_len = ret;
+            tcp.frame_sent = 0;
+            tcp.frame_raw = len;
         }
-        char host_address[SLOG_REMOTE_HOST_MAX_LEN] = { 0 };
-        slog_get_output_remote_host(host_address);
-        slog_error_inner("send message to remote: %s error: %s", host_address, strerror(errno));
+
+        if (!slog_remote_frame_send()) {
+            break;
+        }
+        tcp.spool_off += tcp.frame_raw;
+        tcp.frame_len = 0;
+    }
+}
+
+/*
+ * replay the spool as far as the socket takes it
+ */
+static void slog_remote_spool_replay(void)
+{
+    ssize_t len, sent;
+    struct iovec chunk;
+
+    while ((SLOG_REMOTE_TCP_CONNECTED == tcp.state) && !tcp.compress && (tcp.spool_off < tcp.spool_len)) {
+        len = pread(tcp.spool_fd, spool_buf, SLOG_REMOTE_SPOOL_CHUNK, tcp.spool_off);
+        if (len < 0 && errno == EINTR) {
+            continue;
+        }
+        if (len <= 0) {
+            slog_error_inner("read remote spool error: %s, spool dropped", strerror(errno));
+            tcp.spool_off = tcp.spool_len;
+            break;
+        }
+
+        chunk.iov_base = spool_buf;
+        chunk.iov_len = len;
+        sent = slog_remote_tcp_send(&chunk, 1);
+        if (sent <= 0) {
+            break;
+        }
+        tcp.line_open = ('\n' != spool_buf[sent - 1]);
+        tcp.spool_off += sent;
+    }
+
+    if (tcp.compress) {
+        slog_remote_spool_replay_frames();
+    }
+
+    if ((tcp.spool_len > 0) && (tcp.spool_off >= tcp.spool_len)) {
+        if (0 != ftruncate(tcp.spool_fd, 0)) {
+            slog_error_inner("truncate remote spool error: %s", strerror(errno));
+        }
+        tcp.spool_off = 0;
+        tcp.spool_len = 0;
+    }
+}
+
+/*
+ * append the iovecs to the spool, the spool size bounds it
+ *
+ * @return result
+ */
+static int slog_remote_spool_write(struct iovec *iov, int pos, int iovcnt)
+{
+    int i;
+    ssize_t ret;
+    size_t len = 0;
+    off_t spool_max = (off_t)slog_get_output_remote_spool_size() * 1024 * 1024;
+
+    for (i = pos; i < iovcnt; ++i) {
+        len += iov[i].iov_len;
+    }
+
+    if ((-1 == tcp.spool_fd) || (tcp.spool_len + (off_t)len > spool_max)) {
+        remote_errno = ENOSPC;
+        remote_dropped += iovcnt - pos;
+        remote_dropped_total += iovcnt - pos;
+        return -1;
+    }
+
+    while (pos < iovcnt) {
+        ret = writev(tcp.spool_fd, iov + pos, iovcnt - pos);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            slog_error_inner("write remote spool error: %s", strerror(errno));
+            remote_errno = errno;
+            remote_dropped += iovcnt - pos;
+            remote_dropped_total += iovcnt - pos;
+            return -1;
+        }
+        tcp.spool_len += ret;
+        pos = slog_remote_advance(iov, pos, iovcnt, (size_t)ret, NULL);
+    }
+
+    return 0;
+}
+
+/*
+ * keep what the collector has not got yet for the next run, the spool is
+ * removed once empty
+ */
+static void slog_remote_spool_close(void)
+{
+    int fd;
+    ssize_t len;
+    off_t off;
+
+    if (-1 == tcp.spool_fd) {
+        return;
+    }
+
+    if (tcp.line_open) {
+        slog_remote_spool_skip_line();
+    }
+
+    if (tcp.spool_off >= tcp.spool_len) {
+        close(tcp.spool_fd);
+        unlink(SLOG_REMOTE_SPOOL_NAME);
+        tcp.spool_fd = -1;
+        tcp.spool_off = 0;
+        tcp.spool_len = 0;
+        return;
+    }
+
+    if (tcp.spool_off > 0) {
+        /* drop the replayed head, the next run replays from the start */
+        fd = open(SLOG_REMOTE_SPOOL_TMP_NAME, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (-1 != fd) {
+            for (off = tcp.spool_off; off < tcp.spool_len; off += len) {
+                len = pread(tcp.spool_fd, spool_buf, SLOG_REMOTE_SPOOL_CHUNK, off);
+                if ((len <= 0) || (len != write(fd, spool_buf, len))) {
+                    break;
+                }
+            }
+            close(fd);
+            if ((off < tcp.spool_len) || (0 != rename(SLOG_REMOTE_SPOOL_TMP_NAME, SLOG_REMOTE_SPOOL_NAME))) {
+                slog_error_inner("rewrite remote spool error: %s", strerror(errno));
+                unlink(SLOG_REMOTE_SPOOL_TMP_NAME);
+            }
+        }
+    }
+
+    slog_warn_inner("remote collector unreachable, %ld bytes kept in %s",
+                    (long)(tcp.spool_len - tcp.spool_off), SLOG_REMOTE_SPOOL_NAME);
+
+    close(tcp.spool_fd);
+    tcp.spool_fd = -1;
+    tcp.spool_off = 0;
+    tcp.spool_len = 0;
+}
+
+/*
+ * open the spool, what a previous run could not send is replayed first
+ */
+static int slog_remote_tcp_init(void)
+{
+    struct stat statbuf;
+
+    tcp.spool_fd = open(SLOG_REMOTE_SPOOL_NAME, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (-1 == tcp.spool_fd) {
+        slog_error_inner("open remote spool %s error: %s", SLOG_REMOTE_SPOOL_NAME, strerror(errno));
         return -1;
     }
 
+    tcp.spool_off = 0;
+    tcp.spool_len = 0;
+    if (0 == fstat(tcp.spool_fd, &statbuf)) {
+        tcp.spool_len = statbuf.st_size;
+    }
+
+    tcp.line_open = false;
+    tcp.compress = (SLOG_REMOTE_COMPRESS_LZ4 == slog_get_output_remote_compress());
+    tcp.frame_len = 0;
+    tcp.state = SLOG_REMOTE_TCP_CLOSED;
+    tcp.backoff = SLOG_REMOTE_RECONNECT_MIN;
+    tcp.retry_time = 0;
+
+    /* an unreachable collector is not an error, logs are spooled until it is back */
+    slog_remote_tcp_check();
+
+    return 0;
+}
+
+/*
+ * compress the batch into one frame and send it, the raw batch goes to the
+ * spool when the socket takes the frame only in part
+ *
+ * @return result
+ */
+static int slog_remote_frame_write(struct iovec *iov, int iovcnt)
+{
+    int ret = slog_lz_frame_encode(&tcp_lz, iov, iovcnt, frame_buf);
+
+    if (ret <= 0) {
+        return slog_remote_spool_write(iov, 0, iovcnt);
+    }
+
+    tcp.frame_len = ret;
+    tcp.frame_sent = 0;
+    tcp.frame_raw = 0;
+    if (slog_remote_frame_send()) {
+        tcp.frame_len = 0;
+        return 0;
+    }
+
+    if (SLOG_REMOTE_TCP_CONNECTED != tcp.state) {
+        return slog_remote_spool_write(iov, 0, iovcnt);
+    }
+
+    ret = slog_remote_spool_write(iov, 0, iovcnt);
+    if (0 == ret) {
+        tcp.frame_raw = tcp.spool_len - tcp.spool_off;
+    }
+
+    return ret;
+}
+
+/*
+ * newline framed, or compressed, stream that never waits for the collector:
+ * what the socket does not take right away goes to the spool and is
+ * replayed later
+ */
+static int slog_remote_tcp_write(struct iovec *iov, int iovcnt)
+{
+    int pos = 0, result;
+    ssize_t sent;
+    bool partial = false;
+
+    slog_remote_tcp_check();
+    slog_remote_spool_replay();
+
+    if ((SLOG_REMOTE_TCP_CONNECTED == tcp.state) && (tcp.spool_off >= tcp.spool_len) && (0 == tcp.frame_len)) {
+        if (tcp.compress) {
+            result = slog_remote_frame_write(iov, iovcnt);
+            slog_remote_report("logs");
+            return result;
+        }
+
+        sent = slog_remote_tcp_send(iov, iovcnt);
+        if (sent > 0) {
+            pos = slog_remote_advance(iov, 0, iovcnt, (size_t)sent, &partial);
+            tcp.line_open = partial;
+        }
+    }
+
+    result = (pos < iovcnt) ? slog_remote_spool_write(iov, pos, iovcnt) : 0;
+
+    slog_remote_report("logs");
+
+    return result;
+}
+
+/*
+ * replay the spool before deinit, for at most SLOG_REMOTE_CLOSE_WAIT
+ */
+static void slog_remote_tcp_drain(void)
+{
+    struct pollfd pfd;
+    uint64_t deadline = slog_remote_now() + SLOG_REMOTE_CLOSE_WAIT;
+
+    while ((tcp.spool_off < tcp.spool_len) && (SLOG_REMOTE_TCP_CLOSED != tcp.state) &&
+           (slog_remote_now() < deadline)) {
+        pfd.fd = slog_get_output_remote_socket();
+        pfd.events = POLLOUT;
+        poll(&pfd, 1, 10);
+
+        slog_remote_tcp_check();
+        slog_remote_spool_replay();
+    }
+}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC FUNCTIONS DEFINITION ------------------------------- */
+
+/**
+ * remote output mode initialize
+ *
+ * @return result
+ */
+int slog_remote_init(void)
+{
+    if (!slog_get_output_remote_enabled()) {
+        return 0;
+    }
+
+    if (SLOG_REMOTE_PROTO_TCP == slog_get_output_remote_proto()) {
+        return slog_remote_tcp_init();
+    }
+
+    return slog_remote_udp_init();
+}
+
+/**
+ * log remote output, every line keeps its '\n'.
+ *
+ * udp packs the lines into datagrams of at most the configured mtu, tcp
+ * streams them, compressed into slog_lz frames if configured, and spools
+ * what the collector cannot take now.
+ *
+ * @param iov one log per iovec
+ * @param iovcnt iovec count
+ *
+ * @return result
+ */
+int slog_remote_write_batch(struct iovec *iov, int iovcnt)
+{
+    if (SLOG_REMOTE_PROTO_TCP == slog_get_output_remote_proto()) {
+        return slog_remote_tcp_write(iov, iovcnt);
+    }
+
+    return slog_remote_udp_write(iov, iovcnt);
+}
+
+/**
+ * remote output background work while no log comes: tcp reconnects and
+ * replays its spool.
+ *
+ * @return result
+ */
+int slog_remote_flush(void)
+{
+    if (SLOG_REMOTE_PROTO_TCP != slog_get_output_remote_proto()) {
+        return 0;
+    }
+
+    slog_remote_tcp_check();
+    slog_remote_spool_replay();
+
     return 0;
 }
 
+/**
+ * datagrams, or tcp logs, the remote output has dropped so far
+ */
+unsigned long slog_remote_get_dropped(void)
+{
+    return remote_dropped_total;
+}
+
 void slog_remote_deinit(void)
 {
+    if (SLOG_REMOTE_PROTO_TCP == slog_get_output_remote_proto()) {
+        slog_remote_tcp_drain();
+        slog_remote_spool_close();
+        tcp.state = SLOG_REMOTE_TCP_CLOSED;
+    }
+
     if (-1 != slog_get_output_remote_socket()) {
         close(slog_get_output_remote_socket());
         slog_set_output_remote_socket(-1);
@@ -0,0 +1,194 @@
+
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <stdio.h>
+#include <errno.h>
+#include <poll.h>
+#include <limits.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <sys/stat.h>
+
+#include "logger.h"
+#include "slog_term.h"
+#include "slog_inner.h"
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE MACROS -------------------------------------------- */
+
+/* iovec count of one writev */
+#define SLOG_TERM_IOV_MAX              256
+
+/* max bytes of one writev when the terminal may block (pipe, tty, socket) */
+#define SLOG_TERM_WRITE_CHUNK          PIPE_BUF
+
+/* how long a batch may wait for a slow terminal before dropping lines */
+#define SLOG_TERM_FLUSH_WAIT           1000  /* ms */
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE TYPES --------------------------------------------- */
+
+typedef struct slog_term_s {
+    int fd;                                  /* terminal fd, -1 means closed */
+    bool color;                              /* terminal is a tty */
+    bool chunked;                            /* fd may block, bound each writev */
+    unsigned long dropped;                   /* lines dropped since last report */
+} slog_term_t;
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE VARIABLES ----------------------------------------- */
+
+static slog_term_t term = { .fd = -1 };
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE FUNCTIONS DEFINITION ------------------------------ */
+
+/*
+ * writev the iovecs from pos, at most limit bytes
+ */
+static ssize_t slog_term_writev(const struct iovec *iov, int pos, int iovcnt, size_t limit)
+{
+    int i, cnt = 0;
+    size_t total = 0;
+    struct iovec chunk[SLOG_TERM_IOV_MAX];
+
+    for (i = pos; (i < iovcnt) && (cnt < SLOG_TERM_IOV_MAX) && (total < limit); ++i) {
+        chunk[cnt] = iov[i];
+        if (total + chunk[cnt].iov_len > limit) {
+            chunk[cnt].iov_len = limit - total;
+        }
+        total += chunk[cnt].iov_len;
+        cnt++;
+    }
+
+    return writev(term.fd, chunk, cnt);
+}
+
+/*
+ * skip the written bytes of the iovecs
+ *
+ * @return first iovec not written completely
+ */
+static int slog_term_advance(struct iovec *iov, int pos, int iovcnt, size_t written)
+{
+    while ((written > 0) && (pos < iovcnt)) {
+        if (written < iov[pos].iov_len) {
+            iov[pos].iov_base = (char *)iov[pos].iov_base + written;
+            iov[pos].iov_len -= written;
+            break;
+        }
+        written -= iov[pos].iov_len;
+        pos++;
+    }
+
+    return pos;
+}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC FUNCTIONS DEFINITION ------------------------------- */
+
+/**
+ * terminal output initialize
+ *
+ * @return result
+ */
+int slog_term_init(void)
+{
+    struct stat statbuf;
+
+    term.fd = STDOUT_FILENO;
+    term.color = isatty(term.fd);
+    term.chunked = true;
+    if ((0 == fstat(term.fd, &statbuf)) && S_ISREG(statbuf.st_mode)) {
+        term.chunked = false;
+    }
+    term.dropped = 0;
+
+    return 0;
+}
+
+/**
+ * only a tty gets ANSI colors
+ */
+bool slog_term_is_color(void)
+{
+    return term.color;
+}
+
+/**
+ * write a batch of lines to the terminal with as few writev as possible.
+ *
+ * a pipe or tty is only written while poll reports it writable, and never
+ * more than PIPE_BUF bytes at once, so a stuck reader can hold the terminal
+ * thread no longer than SLOG_TERM_FLUSH_WAIT, its lines are dropped then.
+ *
+ * @param iov one line per iovec, consumed by the call
+ * @param iovcnt iovec count
+ *
+ * @return result
+ */
+int slog_term_write_batch(struct iovec *iov, int iovcnt)
+{
+    int ret, pos = 0;
+    ssize_t written;
+    struct pollfd pfd = { .fd = term.fd, .events = POLLOUT };
+
+    if (term.fd < 0) {
+        return -1;
+    }
+
+    while (pos < iovcnt) {
+        if (term.chunked) {
+            ret = poll(&pfd, 1, SLOG_TERM_FLUSH_WAIT);
+            if (ret < 0 && errno == EINTR) {
+                continue;
+            }
+            if (ret <= 0) {
+                break;
+            }
+            if (pfd.revents & (POLLERR | POLLHUP | POLLNVAL)) {
+                break;
+            }
+        }
+
+        written = slog_term_writev(iov, pos, iovcnt, term.chunked ? SLOG_TERM_WRITE_CHUNK : SIZE_MAX);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                slog_error_inner("write terminal error: %s", strerror(errno));
+            }
+            break;
+        }
+        pos = slog_term_advance(iov, pos, iovcnt, (size_t)written);
+    }
+
+    if (pos < iovcnt) {
+        /* terminal stuck or broken, drop the rest of the batch */
+        term.dropped += iovcnt - pos;
+        return -1;
+    }
+
+    if (term.dropped > 0) {
+        slog_warn_inner("terminal output too slow, %lu lines dropped", term.dropped);
+        term.dropped = 0;
+    }
+
+    return 0;
+}
+
+void slog_term_deinit(void)
+{
+    term.fd = -1;
+}
+
+
+/* ============== EOF ======================================================= */
\ No newline at end of file
@@ -0,0 +1,171 @@
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <stdint.h>
+#include <time.h>
+#include <stdbool.h>
+#include <sys/time.h>
+
+#include "logger.h"
+#include "slog_buf.h"
+#include "slog_cfg.h"
+#include "slog_event.h"
+#include "slog_inner.h"
+#include "slog_throttle.h"
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE MACROS -------------------------------------------- */
+
+/* us between two raises, the level climbs one step at a time */
+#define SLOG_THROTTLE_RAISE_INTERVAL         (100 * 1000)       /* 100ms */
+
+/* us the pressure must stay below the low marks before the level comes down a step */
+#define SLOG_THROTTLE_LOWER_INTERVAL         (1000 * 1000)      /* 1s */
+
+#define SLOG_THROTTLE_STEPS                  (sizeof(slog_throttle_caps) / sizeof(slog_throttle_caps[0]) - 1)
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE TYPES --------------------------------------------- */
+
+/* throttle state, the output thread's own but for the level slog() reads */
+typedef struct slog_throttle_s {
+    unsigned int high;                       /* ring usage percent, 0 no throttle */
+    unsigned int low;
+    int64_t lag;                             /* us, 0 ring usage only */
+    unsigned int step;                       /* index of slog_throttle_caps */
+    int64_t changed;                         /* monotonic us of the last step */
+    int64_t calm_since;                      /* monotonic us the pressure is below the low marks from, 0 it is not */
+} slog_throttle_t;
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE VARIABLES ----------------------------------------- */
+
+/* highest level slog() lets through at each step */
+static const uint8_t slog_throttle_caps[] = { VERBOSE, INFO, WARN };
+
+static const char *slog_throttle_names[] = {
+        [ASSERT]  = "ASSERT",
+        [ERROR]   = "ERROR",
+        [WARN]    = "WARN",
+        [INFO]    = "INFO",
+        [DEBUG]   = "DEBUG",
+        [VERBOSE] = "VERBOSE",
+};
+
+static slog_throttle_t slog_throttle;
+
+/* read by slog() */
+static uint8_t slog_throttle_cap = VERBOSE;
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE FUNCTIONS DEFINITION ------------------------------ */
+
+static void slog_throttle_step(unsigned int step, int64_t now, unsigned int usage, int64_t lag)
+{
+    const char *action = (step > slog_throttle.step) ? "raises" : "lowers";
+
+    slog_throttle.step = step;
+    slog_throttle.changed = now;
+    slog_throttle.calm_since = 0;
+    __atomic_store_n(&slog_throttle_cap, slog_throttle_caps[step], __ATOMIC_RELAXED);
+
+    slog_warn_inner("log throttle %s the level to %s, ring %u%% used, output lag %lldms",
+                    action, slog_throttle_names[slog_throttle_caps[step]],
+                    usage, (long long)(lag / 1000));
+}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC FUNCTIONS DEFINITION ------------------------------- */
+
+/**
+ * throttle initialize, by the configured THROTTLE_HIGH, THROTTLE_LOW and
+ * THROTTLE_LAG
+ */
+void slog_throttle_init(void)
+{
+    slog_throttle.high = slog_get_throttle_high();
+    slog_throttle.low = slog_get_throttle_low();
+    slog_throttle.lag = (int64_t)slog_get_throttle_lag() * 1000;
+    slog_throttle.step = 0;
+    slog_throttle.changed = 0;
+    slog_throttle.calm_since = 0;
+    __atomic_store_n(&slog_throttle_cap, VERBOSE, __ATOMIC_RELAXED);
+
+    if ((0 != slog_throttle.high) && (slog_throttle.low >= slog_throttle.high)) {
+        slog_error_inner("log config THROTTLE_LOW %u is not under THROTTLE_HIGH %u, use %u",
+                         slog_throttle.low, slog_throttle.high, slog_throttle.high / 2);
+        slog_throttle.low = slog_throttle.high / 2;
+    } else if (0 == slog_throttle.low) {
+        slog_throttle.low = slog_throttle.high / 2;
+    }
+}
+
+/**
+ * highest level the throttle lets through now
+ */
+uint8_t slog_throttle_level(void)
+{
+    return __atomic_load_n(&slog_throttle_cap, __ATOMIC_RELAXED);
+}
+
+/**
+ * sample the pressure and step the level, on the output thread
+ *
+ * @param slog_event_buf event just taken, its age is the output lag, NULL the ring is drained
+ */
+void slog_throttle_poll(const void *slog_event_buf)
+{
+    struct timeval tv;
+    struct timespec ts;
+    int64_t now, lag = 0;
+    unsigned int usage;
+    bool pressed, calm;
+
+    if (0 == slog_throttle.high) {
+        return;
+    }
+
+    /* the steps are timed on the monotonic clock, a wall clock step moves the lag only */
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    now = (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+    if (NULL != slog_event_buf) {
+        const slog_event_head_t *head = (const slog_event_head_t *)slog_event_buf;
+        gettimeofday(&tv, NULL);
+        lag = ((int64_t)tv.tv_sec * 1000000 + tv.tv_usec) -
+              ((int64_t)head->slog_time.tv_sec * 1000000 + head->slog_time.tv_usec);
+    }
+    usage = slog_buffer_usage();
+
+    pressed = (usage >= slog_throttle.high) || ((0 != slog_throttle.lag) && (lag >= slog_throttle.lag));
+    calm = (usage <= slog_throttle.low) && ((0 == slog_throttle.lag) || (lag < slog_throttle.lag / 2));
+
+    if (pressed) {
+        slog_throttle.calm_since = 0;
+        if ((slog_throttle.step < SLOG_THROTTLE_STEPS) &&
+            (now - slog_throttle.changed >= SLOG_THROTTLE_RAISE_INTERVAL)) {
+            slog_throttle_step(slog_throttle.step + 1, now, usage, lag);
+        }
+        return;
+    }
+
+    if (!calm || (0 == slog_throttle.step)) {
+        slog_throttle.calm_since = 0;
+        return;
+    }
+
+    /* hysteresis, a step down once the pressure stayed low for a while */
+    if (0 == slog_throttle.calm_since) {
+        slog_throttle.calm_since = now;
+    } else if ((now - slog_throttle.calm_since >= SLOG_THROTTLE_LOWER_INTERVAL) &&
+               (now - slog_throttle.changed >= SLOG_THROTTLE_LOWER_INTERVAL)) {
+        slog_throttle_step(slog_throttle.step - 1, now, usage, lag);
+    }
+}
+
+
+/* ============== EOF ======================================================= */
\ No newline at end of file
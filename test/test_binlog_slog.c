@@ -0,0 +1,131 @@
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "logger.h"
+#include "test_util.h"
+
+/*
+ * binary log file test: the same logs written as text, then as binary and
+ * rendered by slog-decode, read the same but for their times. Both runs
+ * have one lane, the urgent one may reorder the logs of one microsecond.
+ *
+ * "test_binlog_slog <slog-decode>"
+ */
+
+#define LINE_MAX_LEN        (16 * 1024)
+#define LONG_MSG_LEN        3000
+
+static char long_msg[LONG_MSG_LEN + 1];
+
+/*
+ * the same logs for both runs, from the same lines
+ */
+static int write_logs(const char *format)
+{
+    int i;
+
+    if (0 != test_config("OUTPUT_FILE_ENABLE=true;\nOUTPUT_FILE_FORMAT=%s;\nPRIORITY_LANE=0;\n", format) ||
+        0 != log_init()) {
+        fprintf(stderr, "log_init %s failed\n", format);
+        return -1;
+    }
+
+    for (i = 0; i < 100; ++i) {
+        slog_info("bin", "seq=%d of %u, %ld %lu %x %c %.3f", i, 100u, -1L - i, 1UL << 40, i * 4099, 'a' + i % 26,
+                  i / 7.0);
+    }
+    slog_assert("levels", "assert %d", ASSERT);
+    slog_error("levels", "error %d", ERROR);
+    slog_warn("levels", "warn %d", WARN);
+    slog_info("levels", "info %d", INFO);
+    slog_debug("levels", "debug %d", DEBUG);
+    slog_verbose("levels", "verbose %d", VERBOSE);
+    slog_info("", "no tag, 100%% \"quoted\" \\ %s", "");
+    slog_info("long", "%s", long_msg);
+
+    log_fini();
+    return 0;
+}
+
+/*
+ * @return the line after its "[time] " head, NULL none
+ */
+static const char *skip_time(const char *line)
+{
+    const char *end = ('[' == line[0]) ? strstr(line, "] ") : NULL;
+
+    return (NULL == end) ? NULL : end + 2;
+}
+
+int main(int argc, char **argv)
+{
+    int lines = 0, result = 1;
+    FILE *text = NULL, *decoded = NULL;
+    char cmd[1024];
+    static char text_line[LINE_MAX_LEN], decoded_line[LINE_MAX_LEN];
+    const char *text_body, *decoded_body;
+
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <slog-decode>\n", argv[0]);
+        return 1;
+    }
+    snprintf(cmd, sizeof(cmd), "'%s' slog.bin", argv[1]);
+
+    if (0 != test_dir_enter("binlog")) {
+        return 1;
+    }
+
+    memset(long_msg, 'x', LONG_MSG_LEN);
+    if (0 != write_logs("TEXT") || 0 != write_logs("BINARY")) {
+        goto out;
+    }
+
+    text = fopen("slog.log", "r");
+    decoded = popen(cmd, "r");
+    if (NULL == text || NULL == decoded) {
+        perror("open logs");
+        goto out;
+    }
+
+    while (NULL != fgets(text_line, sizeof(text_line), text)) {
+        lines++;
+        if (NULL == fgets(decoded_line, sizeof(decoded_line), decoded)) {
+            fprintf(stderr, "decoded %d lines, the text file has more\n", lines - 1);
+            goto out;
+        }
+        text_body = skip_time(text_line);
+        decoded_body = skip_time(decoded_line);
+        if (NULL == text_body || NULL == decoded_body || 0 != strcmp(text_body, decoded_body)) {
+            fprintf(stderr, "line %d differs:\ntext:    %sdecoded: %s", lines, text_line, decoded_line);
+            goto out;
+        }
+    }
+    if (NULL != fgets(decoded_line, sizeof(decoded_line), decoded)) {
+        fprintf(stderr, "decoded more lines than the text file's %d\n", lines);
+        goto out;
+    }
+    if (lines < 108) {
+        fprintf(stderr, "the text file has %d lines only\n", lines);
+        goto out;
+    }
+
+    printf("binlog: %d logs decoded as written\n", lines);
+    result = 0;
+
+out:
+    if (NULL != text) {
+        fclose(text);
+    }
+    if (NULL != decoded && 0 != pclose(decoded)) {
+        fprintf(stderr, "slog-decode failed\n");
+        result = 1;
+    }
+    test_dir_leave();
+
+    return result;
+}
@@ -0,0 +1,192 @@
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "logger.h"
+#include "slog_bloom.h"
+#include "slog_index.h"
+#include "test_util.h"
+
+/*
+ * bloom filters test: every log of a segment is found by its tag and by a
+ * word of its message in the record covering it, a tag or a word never
+ * logged rules out nearly every record, and the filters are finalized and
+ * renamed with their segment at the rotation.
+ */
+
+#define LOGS                60000 /* the segment rotated at 10MB */
+#define PACE                500   /* logs between two pauses, the file sink's queue never full */
+#define TAGS                7
+#define WORDS               1000
+#define INTERVAL            4     /* KB */
+#define MSG_LEN             150
+#define RECORD_MAX          8192
+#define LINE_MAX_LEN        1024
+
+/* text line: '[' time "] " level column "| " tag */
+#define LINE_TAG            38
+
+static const char *tags[TAGS] = { "alpha", "bravo", "charlie", "delta", "echo", "foxtrot", "golf" };
+
+static slog_bloom_record_t records[RECORD_MAX];
+static char msg[MSG_LEN + 1];
+
+/*
+ * read the filters of a segment
+ *
+ * @return filters file bytes to free(), NULL error
+ */
+static char *read_filters(const char *segment, int final, size_t *count, size_t *size)
+{
+    size_t i, len = 0;
+    int head, is_final = 0;
+    char *data = slog_index_read(segment, SLOG_BLOOM_SUFFIX, &len);
+
+    if (NULL == data) {
+        fprintf(stderr, "%s: no filters\n", segment);
+        return NULL;
+    }
+
+    head = slog_bloom_check(data, len, count, &is_final);
+    if ((head < 0) || (is_final != final) || (0 == *count) || (*count > RECORD_MAX)) {
+        fprintf(stderr, "%s: filters head %d, %zu records, %s\n", segment, head, *count,
+                is_final ? "finalized" : "live");
+        free(data);
+        return NULL;
+    }
+
+    *size = (len - head - (final ? SLOG_BLOOM_TRAILER_SIZE : 0)) / *count - SLOG_BLOOM_RECORD_HEAD_SIZE;
+    for (i = 0; i < *count; ++i) {
+        slog_bloom_record_decode(data + head + i * (SLOG_BLOOM_RECORD_HEAD_SIZE + *size), &records[i]);
+    }
+
+    return data;
+}
+
+/*
+ * each log covered by a record is found in it by its tag and its word
+ *
+ * @return result
+ */
+static int check_segment(const char *segment, size_t count, size_t size)
+{
+    FILE *fp = fopen(segment, "r");
+    char line[LINE_MAX_LEN];
+    const char *tag, *tag_end, *word, *word_end;
+    unsigned long long offset = 0;
+    size_t i = 0;
+    int lines = 0, covered = 0;
+
+    if (NULL == fp) {
+        perror(segment);
+        return -1;
+    }
+
+    while (NULL != fgets(line, sizeof(line), fp)) {
+        lines++;
+        while ((i < count) && (offset >= records[i].offset + records[i].length)) {
+            i++;
+        }
+        tag = line + LINE_TAG;
+        tag_end = strstr(tag, " (");
+        word = strstr(line, "key=");
+        if ((NULL == tag_end) || (NULL == word) || (NULL == (word_end = strchr(word + 4, ' ')))) {
+            fprintf(stderr, "%s: not a test log: %s", segment, line);
+            fclose(fp);
+            return -1;
+        }
+        word += 4;
+
+        if ((i < count) && (offset >= records[i].offset)) {
+            if (1 != slog_bloom_test(&records[i], size, tag, tag_end - tag, word, word_end - word)) {
+                fprintf(stderr, "%s: the record at %llu misses the log at %llu: %s", segment,
+                        (unsigned long long)records[i].offset, offset, line);
+                fclose(fp);
+                return -1;
+            }
+            covered++;
+        }
+        offset += strlen(line);
+    }
+    fclose(fp);
+
+    if (covered * 10 < lines * 9) {
+        fprintf(stderr, "%s: %d of %d logs covered by the filters\n", segment, covered, lines);
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+ * @return records that may hold the tag and term
+ */
+static size_t maybe(size_t count, size_t size, const char *tag, const char *term)
+{
+    size_t i, found = 0;
+
+    for (i = 0; i < count; ++i) {
+        found += slog_bloom_test(&records[i], size, tag, (NULL == tag) ? 0 : strlen(tag), term,
+                                 (NULL == term) ? 0 : strlen(term));
+    }
+
+    return found;
+}
+
+int main(void)
+{
+    int i, result = 1;
+    size_t count = 0, size = 0, absent_tag, absent_word, one_word;
+    char *data = NULL;
+
+    if (0 != test_init("bloom", "OUTPUT_FILE_ENABLE=true;\nOUTPUT_FILE_INDEX=%d;\nOUTPUT_FILE_BLOOM=true;\n",
+                       INTERVAL)) {
+        goto out;
+    }
+
+    memset(msg, 'b', MSG_LEN);
+    for (i = 0; i < LOGS; ++i) {
+        slog(INFO, tags[i % TAGS], strlen(tags[i % TAGS]), __FILENAME__, strlen(__FILENAME__), __func__,
+             sizeof(__func__) - 1, __LINE__, "key=w%04d seq=%d %s", (i * 7919) % WORDS, i, msg);
+        if (0 == (i + 1) % PACE) {
+            usleep(10000);
+        }
+    }
+    log_fini();
+
+    /* the rotated segment's filters are complete and beside it */
+    data = read_filters(SLOG_FILE_NAME ".0", 1, &count, &size);
+    if ((NULL == data) || (0 != check_segment(SLOG_FILE_NAME ".0", count, size))) {
+        goto out;
+    }
+
+    absent_tag = maybe(count, size, "hotel", NULL);
+    absent_word = maybe(count, size, NULL, "w9999");
+    one_word = maybe(count, size, NULL, "w0001");
+    if ((absent_tag * 10 > count) || (absent_word * 10 > count) || (one_word * 2 > count)) {
+        fprintf(stderr, "of %zu records, %zu may hold an absent tag, %zu an absent word, %zu one word\n", count,
+                absent_tag, absent_word, one_word);
+        goto out;
+    }
+    printf("bloom %s.0: %zu records, an absent tag in %zu, an absent word in %zu, one word in %zu\n",
+           SLOG_FILE_NAME, count, absent_tag, absent_word, one_word);
+    free(data);
+
+    /* the new segment has filters of its own */
+    data = read_filters(SLOG_FILE_NAME, 0, &count, &size);
+    if ((NULL == data) || (0 != check_segment(SLOG_FILE_NAME, count, size))) {
+        goto out;
+    }
+
+    result = 0;
+
+out:
+    free(data);
+    test_fini();
+
+    return result;
+}
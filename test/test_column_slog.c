@@ -0,0 +1,225 @@
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "logger.h"
+#include "test_util.h"
+
+/*
+ * columnar archive test: the rotated segment is converted to a columnar
+ * archive, slog-query prints its logs back as the segment has them, and
+ * counts them by tag and level, or of one tag up to a level, as they were
+ * logged.
+ *
+ * "test_column_slog <slog-query>"
+ */
+
+#define LOGS                50000 /* the segment rotated at 10MB */
+#define PACE                500   /* logs between two pauses, the file sink's queue never full */
+#define TAGS                3
+#define LEVELS              (VERBOSE + 1)
+#define MSG_LEN             200
+#define LINE_MAX_LEN        1024
+
+/* text line: '[' time "] " level column "| " tag */
+#define LINE_LEVEL          29
+#define LINE_TAG            38
+
+static const char *tags[TAGS] = { "net", "disk", "ui" };
+static const char *level_name[LEVELS] = { "ASSERT", "ERROR", "WARN", "INFO", "DEBUG", "VERBOSE" };
+
+/* logs of the segment by tag and level */
+static unsigned long counts[TAGS][LEVELS];
+static char msg[MSG_LEN + 1];
+
+/*
+ * count the segment's logs by tag and level
+ *
+ * @return logs, -1 error
+ */
+static int count_segment(const char *segment)
+{
+    FILE *fp = fopen(segment, "r");
+    char line[LINE_MAX_LEN];
+    int tag, level, logs = 0;
+
+    if (NULL == fp) {
+        perror(segment);
+        return -1;
+    }
+
+    while (NULL != fgets(line, sizeof(line), fp)) {
+        for (tag = 0; (tag < TAGS) && (0 != strncmp(line + LINE_TAG, tags[tag], strlen(tags[tag]))); ++tag) {
+        }
+        for (level = 0; (level < LEVELS) && (line[LINE_LEVEL] != level_name[level][0]); ++level) {
+        }
+        if ((TAGS == tag) || (LEVELS == level)) {
+            fprintf(stderr, "%s: not a test log: %s", segment, line);
+            fclose(fp);
+            return -1;
+        }
+        counts[tag][level]++;
+        logs++;
+    }
+    fclose(fp);
+
+    return logs;
+}
+
+/*
+ * "slog-query -p" prints the logs of the archive as the segment has them
+ *
+ * @return result
+ */
+static int check_print(const char *tool, const char *segment)
+{
+    FILE *text, *printed;
+    char cmd[1024], text_line[LINE_MAX_LEN], printed_line[LINE_MAX_LEN];
+    int lines = 0, result = -1;
+
+    snprintf(cmd, sizeof(cmd), "'%s' -p %s.col", tool, segment);
+    text = fopen(segment, "r");
+    printed = popen(cmd, "r");
+    if ((NULL == text) || (NULL == printed)) {
+        perror("open logs");
+        goto out;
+    }
+
+    while (NULL != fgets(text_line, sizeof(text_line), text)) {
+        lines++;
+        if ((NULL == fgets(printed_line, sizeof(printed_line), printed)) || (0 != strcmp(text_line, printed_line))) {
+            fprintf(stderr, "line %d differs:\nsegment: %sprinted: %s", lines, text_line, printed_line);
+            goto out;
+        }
+    }
+    if (NULL != fgets(printed_line, sizeof(printed_line), printed)) {
+        fprintf(stderr, "printed more lines than the segment's %d\n", lines);
+        goto out;
+    }
+    result = 0;
+
+out:
+    if (NULL != text) {
+        fclose(text);
+    }
+    if ((NULL != printed) && (0 != pclose(printed))) {
+        fprintf(stderr, "%s failed\n", cmd);
+        result = -1;
+    }
+
+    return result;
+}
+
+/*
+ * run a counting query, its "count" rows summed per the tag and level
+ * found in them
+ *
+ * @return result
+ */
+static int query(const char *cmd, unsigned long (*got)[LEVELS])
+{
+    FILE *fp = popen(cmd, "r");
+    char line[LINE_MAX_LEN], tag_name[32], level[16];
+    unsigned long count;
+    int tag, l;
+
+    if (NULL == fp) {
+        perror("popen");
+        return -1;
+    }
+
+    memset(got, 0, sizeof(counts));
+    while (NULL != fgets(line, sizeof(line), fp)) {
+        if (3 != sscanf(line, "%31s %15s %lu", tag_name, level, &count)) {
+            continue;
+        }
+        for (tag = 0; (tag < TAGS) && (0 != strcmp(tag_name, tags[tag])); ++tag) {
+        }
+        for (l = 0; (l < LEVELS) && (0 != strcmp(level, level_name[l])); ++l) {
+        }
+        if ((TAGS == tag) || (LEVELS == l)) {
+            fprintf(stderr, "%s: unknown row %s", cmd, line);
+            pclose(fp);
+            return -1;
+        }
+        got[tag][l] += count;
+    }
+
+    if (0 != pclose(fp)) {
+        fprintf(stderr, "%s failed\n", cmd);
+        return -1;
+    }
+
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    int i, tag, level, logs, result = 1;
+    unsigned long got[TAGS][LEVELS], expect;
+    char cmd[1024];
+
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <slog-query>\n", argv[0]);
+        return 1;
+    }
+
+    if (0 != test_init("column", "OUTPUT_FILE_ENABLE=true;\nOUTPUT_FILE_ARCHIVE=true;\n")) {
+        goto out;
+    }
+
+    memset(msg, 'c', MSG_LEN);
+    for (i = 0; i < LOGS; ++i) {
+        tag = i % TAGS;
+        level = (i / TAGS) % LEVELS;
+        slog(level, tags[tag], strlen(tags[tag]), __FILENAME__, strlen(__FILENAME__), __func__,
+             sizeof(__func__) - 1, __LINE__, "seq=%d %s", i, msg);
+        if (0 == (i + 1) % PACE) {
+            usleep(10000);
+        }
+    }
+    log_fini();
+
+    logs = count_segment(SLOG_FILE_NAME ".0");
+    if ((logs <= 0) || (0 != check_print(argv[1], SLOG_FILE_NAME ".0"))) {
+        goto out;
+    }
+
+    /* counted by tag and level, the default keys */
+    snprintf(cmd, sizeof(cmd), "'%s' %s.0.col", argv[1], SLOG_FILE_NAME);
+    if (0 != query(cmd, got)) {
+        goto out;
+    }
+    if (0 != memcmp(got, counts, sizeof(counts))) {
+        fprintf(stderr, "%s: counts differ from the segment's\n", cmd);
+        goto out;
+    }
+
+    /* one tag, up to a level */
+    snprintf(cmd, sizeof(cmd), "'%s' -t disk -l WARN %s.0.col", argv[1], SLOG_FILE_NAME);
+    if (0 != query(cmd, got)) {
+        goto out;
+    }
+    for (tag = 0; tag < TAGS; ++tag) {
+        for (level = 0; level < LEVELS; ++level) {
+            expect = ((1 == tag) && (level <= WARN)) ? counts[tag][level] : 0;
+            if (got[tag][level] != expect) {
+                fprintf(stderr, "%s: %s %s counted %lu, the segment has %lu\n", cmd, tags[tag], level_name[level],
+                        got[tag][level], expect);
+                goto out;
+            }
+        }
+    }
+
+    printf("column: %d logs of the rotated segment printed and counted back from its archive\n", logs);
+    result = 0;
+
+out:
+    test_fini();
+
+    return result;
+}
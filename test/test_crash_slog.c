@@ -0,0 +1,125 @@
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "logger.h"
+#include "test_util.h"
+
+/*
+ * crash flush test: a child with CRASH_FLUSH logs, half of it while its
+ * output thread is held, and dies of SIGSEGV. The log file then has every
+ * log in time order, the pending ones written by the fatal signal handler.
+ */
+
+#define LOGS                20000
+#define PACE                500   /* logs between two pauses, the file sink's queue never full */
+#define LINE_MAX_LEN        1024
+
+/*
+ * log and die of SIGSEGV without log_fini(), the second half pending
+ */
+static void child(void)
+{
+    int i;
+
+    if (0 != log_init()) {
+        _exit(1);
+    }
+
+    for (i = 0; i < LOGS / 2; ++i) {
+        slog_info("crash", "seq=%d", i);
+        if (0 == (i + 1) % PACE) {
+            usleep(10000);
+        }
+    }
+    if (0 != test_output_hold()) {
+        _exit(1);
+    }
+    for (i = LOGS / 2; i < LOGS; ++i) {
+        slog_info("crash", "seq=%d", i);
+    }
+
+    raise(SIGSEGV);
+}
+
+/*
+ * the "seq=N" logs of the file run from 0 to LOGS - 1, their "[time]"
+ * heads never going back
+ *
+ * @return result
+ */
+static int check_file(void)
+{
+    FILE *fp = fopen(SLOG_FILE_NAME, "r");
+    char line[LINE_MAX_LEN], last_time[64] = "";
+    const char *pos, *end;
+    int seq, next = 0;
+
+    if (NULL == fp) {
+        perror(SLOG_FILE_NAME);
+        return -1;
+    }
+
+    while (NULL != fgets(line, sizeof(line), fp)) {
+        pos = strstr(line, "seq=");
+        if (NULL == pos) {
+            continue;
+        }
+        end = strchr(line, ']');
+        if ((1 != sscanf(pos, "seq=%d", &seq)) || (seq != next) || ('[' != line[0]) || (NULL == end) ||
+            ((size_t)(end - line) >= sizeof(last_time)) || (strncmp(line, last_time, end - line) < 0)) {
+            fprintf(stderr, "expect seq=%d after time %s], got line: %s", next, last_time, line);
+            fclose(fp);
+            return -1;
+        }
+        memcpy(last_time, line, end - line);
+        last_time[end - line] = '\0';
+        next++;
+    }
+    fclose(fp);
+
+    if (LOGS != next) {
+        fprintf(stderr, "the file has %d of %d logs\n", next, LOGS);
+        return -1;
+    }
+
+    return 0;
+}
+
+int main(void)
+{
+    int status, result = 1;
+    pid_t pid;
+
+    if (0 != test_dir_enter("crash") || 0 != test_config("OUTPUT_FILE_ENABLE=true;\nCRASH_FLUSH=true;\n")) {
+        goto out;
+    }
+
+    pid = fork();
+    if (0 == pid) {
+        child();
+        _exit(1);
+    }
+    if ((-1 == pid) || (pid != waitpid(pid, &status, 0)) || !WIFSIGNALED(status) || (SIGSEGV != WTERMSIG(status))) {
+        fprintf(stderr, "the child did not die of SIGSEGV\n");
+        goto out;
+    }
+
+    if (0 != check_file()) {
+        goto out;
+    }
+
+    printf("crash: %d logs in time order after SIGSEGV, %d of them pending\n", LOGS, LOGS / 2);
+    result = 0;
+
+out:
+    test_dir_leave();
+
+    return result;
+}
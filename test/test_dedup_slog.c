@@ -0,0 +1,119 @@
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "logger.h"
+#include "test_util.h"
+
+/*
+ * repeated log collapsing test: a run of the same log is output once and
+ * then as "last message repeated N times", when another log ends the run
+ * and when the window closes it on its own.
+ */
+
+#define REPEATS             500
+#define WINDOW              300   /* ms */
+#define MSG_MAX             32
+#define MSG_MAX_LEN         64
+
+static char msgs[MSG_MAX][MSG_MAX_LEN];
+static int msg_count;
+
+/* keeps the message of each line, after the "(file func:line) " site */
+static int dedup_write(void *ctx, struct iovec *iov, int iovcnt)
+{
+    const char *line, *pos;
+    size_t len;
+    int i;
+
+    for (i = 0; i < iovcnt; ++i) {
+        line = (const char *)iov[i].iov_base;
+        pos = memchr(line, ')', iov[i].iov_len);
+        if ((NULL == pos) || (msg_count >= MSG_MAX)) {
+            continue;
+        }
+        pos += 2;
+        len = iov[i].iov_len - (pos - line);
+        while ((len > 0) && ('\n' == pos[len - 1])) {
+            len--;
+        }
+        if (len >= MSG_MAX_LEN) {
+            len = MSG_MAX_LEN - 1;
+        }
+        memcpy(msgs[msg_count], pos, len);
+        msgs[msg_count][len] = '\0';
+        msg_count++;
+    }
+
+    return 0;
+}
+
+static void repeat(const char *msg, int times)
+{
+    int i;
+
+    for (i = 0; i < times; ++i) {
+        slog_warn("dedup", "%s", msg);
+    }
+}
+
+int main(void)
+{
+    int i, result = 1;
+    const char *expect[] = {
+        "disk full",
+        "last message repeated 499 times",
+        "next",
+        "debug",
+        "debug",
+        "closed by the window",
+        "last message repeated 9 times",
+        "closed by the window",
+    };
+    int expect_count = sizeof(expect) / sizeof(expect[0]);
+
+    if ((0 != test_init("dedup", "DEDUP_WINDOW=%d;\nDEDUP_LEVELS=ERROR,WARN,INFO;\n", WINDOW)) ||
+        (test_sink_register("dedup", "dedup", dedup_write, NULL, 0) < 0)) {
+        goto out;
+    }
+
+    /* another log ends the run, a level not collapsed is output as is */
+    repeat("disk full", REPEATS);
+    slog_warn("dedup", "next");
+    slog_debug("dedup", "debug");
+    slog_debug("dedup", "debug");
+
+    /* the window closes the run, a repeat after it starts a new one */
+    repeat("closed by the window", 10);
+    usleep(WINDOW * 1000 * 2);
+    repeat("closed by the window", 1);
+
+    if (0 != test_flush()) {
+        goto out;
+    }
+
+    if (msg_count != expect_count) {
+        fprintf(stderr, "got %d lines, expect %d\n", msg_count, expect_count);
+    }
+    for (i = 0; i < msg_count && i < expect_count; ++i) {
+        if (0 != strcmp(msgs[i], expect[i])) {
+            fprintf(stderr, "line %d: got \"%s\", expect \"%s\"\n", i, msgs[i], expect[i]);
+            goto out;
+        }
+    }
+    if (msg_count != expect_count) {
+        goto out;
+    }
+
+    printf("dedup: %d logs collapsed into %d lines\n", REPEATS + 3 + 11, msg_count);
+    result = 0;
+
+out:
+    test_fini();
+
+    return result;
+}
@@ -0,0 +1,83 @@
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "logger.h"
+#include "test_util.h"
+
+/*
+ * log_fini race test: threads keep logging while log_fini() runs, round
+ * after round with log_init() again. log_fini() waits for the calls past
+ * its init check to leave before it drains and frees the ring, none of
+ * them writes to freed memory.
+ */
+
+#define THREADS             4
+#define ROUNDS              50
+#define LOGGING             2000  /* us before log_fini() */
+#define MSG_LEN             200
+
+static int stop;
+static unsigned long logged;
+
+static char msg[MSG_LEN + 1];
+
+static void *log_thread(void *arg)
+{
+    unsigned long n = 0;
+
+    while (!__atomic_load_n(&stop, __ATOMIC_ACQUIRE)) {
+        slog_info("fini", "thread %ld log %lu %s", (long)arg, n++, msg);
+    }
+    __atomic_add_fetch(&logged, n, __ATOMIC_RELAXED);
+
+    return NULL;
+}
+
+int main(void)
+{
+    pthread_t tid[THREADS];
+    long i;
+    int round, result = 1;
+
+    memset(msg, 'f', MSG_LEN);
+    if (0 != test_init("fini", NULL)) {
+        goto out;
+    }
+
+    for (round = 0; round < ROUNDS; ++round) {
+        __atomic_store_n(&stop, 0, __ATOMIC_RELEASE);
+        for (i = 0; i < THREADS; ++i) {
+            if (0 != pthread_create(&tid[i], NULL, log_thread, (void *)i)) {
+                perror("pthread_create");
+                goto out;
+            }
+        }
+
+        usleep(LOGGING);
+        log_fini();
+
+        __atomic_store_n(&stop, 1, __ATOMIC_RELEASE);
+        for (i = 0; i < THREADS; ++i) {
+            pthread_join(tid[i], NULL);
+        }
+
+        if (0 != log_init()) {
+            fprintf(stderr, "round %d: log_init failed\n", round);
+            goto out;
+        }
+    }
+
+    printf("fini: %d rounds of log_fini() under %d logging threads, %lu calls\n", ROUNDS, THREADS, logged);
+    result = 0;
+
+out:
+    test_fini();
+
+    return result;
+}
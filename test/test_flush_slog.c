@@ -0,0 +1,92 @@
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "logger.h"
+#include "test_util.h"
+
+/*
+ * flush test: once slog_flush() returns, a slow sink has written every log
+ * put before the call, those of a signal handler's slog_signal() too.
+ */
+
+#define THREADS             4
+#define THREAD_LOGS         500
+#define ROUNDS              5
+#define SIGNAL_LOGS         3
+
+static int got;
+
+/* a sink behind the output thread, each batch takes a while */
+static int slow_write(void *ctx, struct iovec *iov, int iovcnt)
+{
+    usleep(2000);
+    __atomic_add_fetch(&got, iovcnt, __ATOMIC_RELEASE);
+
+    return 0;
+}
+
+static void on_signal(int sig)
+{
+    slog_signal(WARN, "flush", "signal %d", sig);
+}
+
+static void *producer(void *arg)
+{
+    int i;
+
+    for (i = 0; i < THREAD_LOGS; ++i) {
+        slog_info("flush", "thread %ld seq=%d", (long)arg, i);
+    }
+
+    return NULL;
+}
+
+int main(void)
+{
+    int i, round, expect = 0, result = 1;
+    long t;
+    pthread_t threads[THREADS];
+
+    if ((0 != test_init("flush", NULL)) ||
+        (test_sink_register("slow", "flush", slow_write, NULL, 4 * 1024 * 1024) < 0)) {
+        goto out;
+    }
+    signal(SIGUSR1, on_signal);
+
+    for (round = 0; round < ROUNDS; ++round) {
+        for (t = 0; t < THREADS; ++t) {
+            pthread_create(&threads[t], NULL, producer, (void *)t);
+        }
+        for (i = 0; i < SIGNAL_LOGS; ++i) {
+            raise(SIGUSR1);
+        }
+        for (t = 0; t < THREADS; ++t) {
+            pthread_join(threads[t], NULL);
+        }
+        expect += THREADS * THREAD_LOGS + SIGNAL_LOGS;
+
+        if (0 != slog_flush(TEST_WAIT)) {
+            fprintf(stderr, "round %d: slog_flush timed out\n", round);
+            goto out;
+        }
+        if (expect != __atomic_load_n(&got, __ATOMIC_ACQUIRE)) {
+            fprintf(stderr, "round %d: slog_flush returned with %d of %d logs written\n", round, got, expect);
+            goto out;
+        }
+    }
+
+    printf("flush: %d logs written by each slog_flush() return\n", expect);
+    result = 0;
+
+out:
+    test_fini();
+
+    return result;
+}
@@ -0,0 +1,218 @@
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "logger.h"
+#include "test_util.h"
+
+/*
+ * parallel grep test: a segment of several chunks is searched with more
+ * threads than one, its logs spanning continuation lines and the pattern
+ * on either line. Every matching log is printed whole, once and in file
+ * order, as a plain scan of the segment finds them and as one thread does.
+ *
+ * "test_grep_slog <slog-grep>"
+ */
+
+#define LOGS                40000 /* about 9MB, under the rotation */
+#define MSG_LEN             150
+#define NEEDLE              "needle"
+#define THREADS             4
+#define CHUNK_SIZE          (4 * 1024 * 1024) /* slog-grep's */
+
+/* text line: '[' time "] " level column "| " tag */
+#define LINE_TAG            38
+
+/* the needle on the head line, on a continuation line or absent */
+static const char *formats[3] = {
+    "seq=%d " NEEDLE " %s\n  more",
+    "seq=%d %s\n  more " NEEDLE "\n  last",
+    "seq=%d %s\n  more",
+};
+
+static char msg[MSG_LEN + 1];
+
+/*
+ * read a whole file or command output
+ *
+ * @return bytes to free(), NULL error
+ */
+static char *read_all(FILE *fp, size_t *len)
+{
+    size_t cap = 1 << 20, n;
+    char *data = (char *)malloc(cap), *grown;
+
+    *len = 0;
+    while (NULL != data) {
+        n = fread(data + *len, 1, cap - *len, fp);
+        *len += n;
+        if (*len < cap) {
+            break;
+        }
+        cap *= 2;
+        grown = (char *)realloc(data, cap);
+        if (NULL == grown) {
+            free(data);
+        }
+        data = grown;
+    }
+
+    return data;
+}
+
+static int is_head(const char *line)
+{
+    return '[' == line[0];
+}
+
+/*
+ * the logs of the segment with the tag and the needle, as a scan finds them
+ *
+ * @return bytes to free(), NULL error
+ */
+static char *scan(const char *segment, const char *tag, size_t *len, int *logs)
+{
+    FILE *fp = fopen(segment, "r");
+    char *data, *expect, *p, *end, *next, *eol;
+    size_t size;
+
+    if (NULL == fp) {
+        perror(segment);
+        return NULL;
+    }
+    data = read_all(fp, &size);
+    fclose(fp);
+    expect = (NULL == data) ? NULL : (char *)malloc(size);
+    if (NULL == expect) {
+        free(data);
+        return NULL;
+    }
+
+    *len = 0;
+    *logs = 0;
+    for (p = data, end = data + size; p < end; p = next) {
+        next = p;
+        do {
+            eol = memchr(next, '\n', end - next);
+            next = (NULL == eol) ? end : eol + 1;
+        } while ((next < end) && !is_head(next));
+
+        if ((0 == strncmp(p + LINE_TAG, tag, strlen(tag))) && (' ' == p[LINE_TAG + strlen(tag)]) &&
+            (NULL != memmem(p, next - p, NEEDLE, strlen(NEEDLE)))) {
+            memcpy(expect + *len, p, next - p);
+            *len += next - p;
+            (*logs)++;
+        }
+    }
+    free(data);
+
+    return expect;
+}
+
+/*
+ * @return slog-grep's output to free(), NULL error
+ */
+static char *grep(const char *tool, int threads, const char *tag, size_t *len)
+{
+    char cmd[1024], *out;
+    FILE *fp;
+
+    snprintf(cmd, sizeof(cmd), "'%s' -j %d -t %s %s %s", tool, threads, tag, NEEDLE, SLOG_FILE_NAME);
+    fp = popen(cmd, "r");
+    if (NULL == fp) {
+        perror("popen");
+        return NULL;
+    }
+    out = read_all(fp, len);
+    if (0 != pclose(fp)) {
+        fprintf(stderr, "%s failed\n", cmd);
+        free(out);
+        return NULL;
+    }
+
+    return out;
+}
+
+static int check(const char *tool, const char *tag)
+{
+    char *expect = NULL, *parallel = NULL, *single = NULL;
+    size_t expect_len = 0, parallel_len = 0, single_len = 0;
+    int logs = 0, result = -1;
+
+    expect = scan(SLOG_FILE_NAME, tag, &expect_len, &logs);
+    parallel = grep(tool, THREADS, tag, &parallel_len);
+    single = grep(tool, 1, tag, &single_len);
+    if ((NULL == expect) || (NULL == parallel) || (NULL == single) || (0 == logs)) {
+        goto out;
+    }
+
+    if ((parallel_len != expect_len) || (0 != memcmp(parallel, expect, expect_len))) {
+        fprintf(stderr, "%s: -j %d printed %zu bytes, the scan found %zu in %d logs\n", tag, THREADS, parallel_len,
+                expect_len, logs);
+        goto out;
+    }
+    if ((single_len != parallel_len) || (0 != memcmp(single, parallel, parallel_len))) {
+        fprintf(stderr, "%s: -j 1 printed %zu bytes, -j %d %zu\n", tag, single_len, THREADS, parallel_len);
+        goto out;
+    }
+
+    printf("grep %s: %d logs, %zu bytes, alike with %d threads and one\n", tag, logs, expect_len, THREADS);
+    result = 0;
+
+out:
+    free(expect);
+    free(parallel);
+    free(single);
+
+    return result;
+}
+
+int main(int argc, char **argv)
+{
+    int i, result = 1;
+    const char *tag;
+    struct stat statbuf;
+
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <slog-grep>\n", argv[0]);
+        return 1;
+    }
+
+    if (0 != test_init("grep", "OUTPUT_FILE_ENABLE=true;\n")) {
+        goto out;
+    }
+
+    /* the needle on the head line, on the continuation line or absent */
+    memset(msg, 'g', MSG_LEN);
+    for (i = 0; i < LOGS; ++i) {
+        tag = (i & 4) ? "hit" : "miss";
+        slog(INFO, tag, strlen(tag), __FILENAME__, strlen(__FILENAME__), __func__, sizeof(__func__) - 1, __LINE__,
+             formats[i % 3], i, msg);
+    }
+    log_fini();
+
+    /* several chunks, not rotated */
+    if ((0 != stat(SLOG_FILE_NAME, &statbuf)) || (statbuf.st_size <= 2 * CHUNK_SIZE) ||
+        (0 == access(SLOG_FILE_NAME ".0", F_OK))) {
+        fprintf(stderr, "%s: not one segment of several chunks\n", SLOG_FILE_NAME);
+        goto out;
+    }
+
+    if ((0 != check(argv[1], "hit")) || (0 != check(argv[1], "miss"))) {
+        goto out;
+    }
+
+    result = 0;
+
+out:
+    test_fini();
+
+    return result;
+}
@@ -0,0 +1,268 @@
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "logger.h"
+#include "test_util.h"
+
+/*
+ * sparse file index test: a segment is written with its index, the next
+ * run appends to both, and the rotation finalizes the index beside the
+ * rotated segment. Each entry's levels are those of the lines it covers,
+ * and slog-index looking up the ERROR logs reads a part of the segment
+ * only and prints every one of them.
+ *
+ * "test_index_slog <slog-index>"
+ */
+
+#define FIRST_LOGS          20000
+#define SECOND_LOGS         40000 /* the segment rotated at 10MB */
+#define PACE                500   /* logs between two pauses, the file sink's queue never full */
+#define ERROR_EVERY         1000
+#define INTERVAL            4     /* KB */
+#define MSG_LEN             200
+#define ENTRY_MAX           8192
+#define LINE_MAX_LEN        1024
+
+/* text line: '[' time "] " level */
+#define LINE_LEVEL          29
+
+typedef struct test_entry_s {
+    unsigned long long offset;
+    unsigned int length;
+    unsigned int count;
+    char levels[64];
+} test_entry_t;
+
+static test_entry_t entries[ENTRY_MAX];
+static char msg[MSG_LEN + 1];
+
+static void write_logs(int first, int logs)
+{
+    int i;
+
+    for (i = first; i < first + logs; ++i) {
+        if (0 == i % ERROR_EVERY) {
+            slog_error("index", "seq=%d %s", i, msg);
+        } else {
+            slog_info("index", "seq=%d %s", i, msg);
+        }
+        if (0 == (i + 1) % PACE) {
+            usleep(10000);
+        }
+    }
+}
+
+/*
+ * read the index of a segment by "slog-index -d"
+ *
+ * @return entries, -1 error
+ */
+static int read_index(const char *tool, const char *segment, int final)
+{
+    FILE *fp;
+    char cmd[1024], line[LINE_MAX_LEN], state[16] = "";
+    const char *pos;
+    size_t count = 0;
+    int n = 0;
+
+    snprintf(cmd, sizeof(cmd), "'%s' -d %s", tool, segment);
+    fp = popen(cmd, "r");
+    if (NULL == fp) {
+        perror("popen");
+        return -1;
+    }
+
+    if ((NULL == fgets(line, sizeof(line), fp)) || (2 != sscanf(line, "# %zu entries, %15s", &count, state)) ||
+        (0 != strcmp(state, final ? "finalized" : "live"))) {
+        fprintf(stderr, "%s: index head %s", segment, line);
+        pclose(fp);
+        return -1;
+    }
+    while ((n < ENTRY_MAX) && (NULL != fgets(line, sizeof(line), fp))) {
+        pos = strchr(line, ']');
+        if ((3 != sscanf(line, "%llu %u %u", &entries[n].offset, &entries[n].length, &entries[n].count)) ||
+            (NULL == pos)) {
+            continue;
+        }
+        snprintf(entries[n].levels, sizeof(entries[n].levels), "%s", pos + 1);
+        n++;
+    }
+
+    if ((0 != pclose(fp)) || ((size_t)n != count)) {
+        fprintf(stderr, "%s: read %d of %zu entries\n", segment, n, count);
+        return -1;
+    }
+
+    return n;
+}
+
+/*
+ * every line an entry covers is counted by it and of one of its levels
+ *
+ * @return lines of the segment with level ERROR, -1 error
+ */
+static int check_segment(const char *segment, int count)
+{
+    FILE *fp = fopen(segment, "r");
+    char line[LINE_MAX_LEN], level[16];
+    unsigned long long offset = 0, indexed = 0;
+    unsigned int covered[ENTRY_MAX] = { 0 };
+    int i = 0, lines = 0, errors = 0;
+
+    if (NULL == fp) {
+        perror(segment);
+        return -1;
+    }
+
+    while (NULL != fgets(line, sizeof(line), fp)) {
+        lines++;
+        errors += ('E' == line[LINE_LEVEL]);
+        while ((i < count) && (offset >= entries[i].offset + entries[i].length)) {
+            i++;
+        }
+        if ((i < count) && (offset >= entries[i].offset)) {
+            snprintf(level, sizeof(level), " %s", ('E' == line[LINE_LEVEL]) ? "ERROR" : "INFO");
+            if (NULL == strstr(entries[i].levels, level)) {
+                fprintf(stderr, "%s: the entry at %llu has no%s, a line at %llu has\n", segment,
+                        entries[i].offset, level, offset);
+                fclose(fp);
+                return -1;
+            }
+            covered[i]++;
+            indexed++;
+        }
+        offset += strlen(line);
+    }
+    fclose(fp);
+
+    for (i = 0; i < count; ++i) {
+        if (covered[i] != entries[i].count) {
+            fprintf(stderr, "%s: the entry at %llu counts %u lines, covers %u\n", segment, entries[i].offset,
+                    entries[i].count, covered[i]);
+            return -1;
+        }
+    }
+    /* the entries dropped while the index lagged, if any, are few */
+    if (indexed * 10 < (unsigned long long)lines * 9) {
+        fprintf(stderr, "%s: %llu of %d lines indexed\n", segment, indexed, lines);
+        return -1;
+    }
+
+    return errors;
+}
+
+/*
+ * "slog-index -l ERROR" prints the ERROR logs only, "-p" reads a part of
+ * the segment for them
+ *
+ * @return result
+ */
+static int lookup(const char *tool, const char *segment, int errors)
+{
+    FILE *fp;
+    char cmd[1024], line[LINE_MAX_LEN];
+    unsigned long long offset, length, read = 0;
+    struct stat statbuf;
+    int got = 0;
+
+    snprintf(cmd, sizeof(cmd), "'%s' -l ERROR %s", tool, segment);
+    fp = popen(cmd, "r");
+    if (NULL == fp) {
+        perror("popen");
+        return -1;
+    }
+    while (NULL != fgets(line, sizeof(line), fp)) {
+        if ('E' != line[LINE_LEVEL]) {
+            fprintf(stderr, "%s: not an ERROR log: %s", cmd, line);
+            pclose(fp);
+            return -1;
+        }
+        got++;
+    }
+    if ((0 != pclose(fp)) || (got != errors)) {
+        fprintf(stderr, "%s: %d of %d ERROR logs\n", cmd, got, errors);
+        return -1;
+    }
+
+    snprintf(cmd, sizeof(cmd), "'%s' -p -l ERROR %s", tool, segment);
+    fp = popen(cmd, "r");
+    if (NULL == fp) {
+        perror("popen");
+        return -1;
+    }
+    while (NULL != fgets(line, sizeof(line), fp)) {
+        if (2 == sscanf(line, "%llu %llu", &offset, &length)) {
+            read += length;
+        }
+    }
+    if ((0 != pclose(fp)) || (0 != stat(segment, &statbuf)) || (read * 4 > (unsigned long long)statbuf.st_size)) {
+        fprintf(stderr, "%s: reads %llu bytes of %lld\n", cmd, read, (long long)statbuf.st_size);
+        return -1;
+    }
+
+    printf("index %s: %d ERROR logs looked up reading %llu of %lld bytes\n", segment, got, read,
+           (long long)statbuf.st_size);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    int first, count, errors, result = 1;
+    static test_entry_t live[ENTRY_MAX];
+
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <slog-index>\n", argv[0]);
+        return 1;
+    }
+    memset(msg, 'i', MSG_LEN);
+
+    if (0 != test_init("index", "OUTPUT_FILE_ENABLE=true;\nOUTPUT_FILE_INDEX=%d;\n", INTERVAL)) {
+        goto out;
+    }
+    write_logs(0, FIRST_LOGS);
+    log_fini();
+
+    /* the index of the segment still written has no trailer */
+    first = read_index(argv[1], SLOG_FILE_NAME, 0);
+    if ((first <= 0) || (check_segment(SLOG_FILE_NAME, first) < 0)) {
+        goto out;
+    }
+    memcpy(live, entries, first * sizeof(entries[0]));
+
+    /* the next run appends to the segment and its index, until the rotation */
+    if (0 != log_init()) {
+        fprintf(stderr, "log_init failed\n");
+        goto out;
+    }
+    write_logs(FIRST_LOGS, SECOND_LOGS);
+    log_fini();
+
+    count = read_index(argv[1], SLOG_FILE_NAME ".0", 1);
+    if ((count <= first) || (0 != memcmp(live, entries, first * sizeof(entries[0])))) {
+        fprintf(stderr, "the rotated index has %d entries, not the %d of the first run and more\n", count, first);
+        goto out;
+    }
+    errors = check_segment(SLOG_FILE_NAME ".0", count);
+    if ((errors <= 0) || (0 != lookup(argv[1], SLOG_FILE_NAME ".0", errors))) {
+        goto out;
+    }
+
+    /* the new segment has an index of its own */
+    count = read_index(argv[1], SLOG_FILE_NAME, 0);
+    if ((count <= 0) || (check_segment(SLOG_FILE_NAME, count) < 0)) {
+        goto out;
+    }
+
+    result = 0;
+
+out:
+    test_fini();
+
+    return result;
+}
@@ -0,0 +1,176 @@
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "logger.h"
+#include "test_util.h"
+
+/*
+ * urgent lane test: the output thread held, INFO logs fill the main ring
+ * until it drops them. The ERROR logs after them are dropped too with one
+ * lane for all, with PRIORITY_LANE they are kept and go out ahead of the
+ * backlog. ERROR logs within the 1ms reorder window of an INFO one keep
+ * their time order.
+ */
+
+#define FILL_LOGS           20000 /* over the 16MB main ring */
+#define URGENT_LOGS         10
+#define PAIRS               200
+#define MSG_LEN             1000
+#define LANE                256   /* KB */
+#define QUEUE_SIZE          (64 * 1024 * 1024)
+#define SEQ_MAX             (2 * FILL_LOGS)
+
+/* seq of the urgent logs and of the pairs */
+#define URGENT_SEQ          FILL_LOGS
+#define PAIR_SEQ            (FILL_LOGS + URGENT_LOGS)
+
+static int order[SEQ_MAX];
+static int got;
+
+static char msg[MSG_LEN + 1];
+
+static int lane_write(void *ctx, struct iovec *iov, int iovcnt)
+{
+    const char *pos;
+    int i, seq;
+
+    for (i = 0; i < iovcnt; ++i) {
+        pos = memmem(iov[i].iov_base, iov[i].iov_len, "seq=", 4);
+        if ((NULL == pos) || (1 != sscanf(pos, "seq=%d", &seq)) || (got >= SEQ_MAX)) {
+            continue;
+        }
+        order[got] = seq;
+        __atomic_add_fetch(&got, 1, __ATOMIC_RELEASE);
+    }
+
+    return 0;
+}
+
+static int start(int lane)
+{
+    got = 0;
+    if ((0 != test_config("PRIORITY_LANE=%d;\n", lane)) || (0 != log_init())) {
+        fprintf(stderr, "log_init failed\n");
+        return -1;
+    }
+    if (test_sink_register("lane", "lane", lane_write, NULL, QUEUE_SIZE) < 0) {
+        return -1;
+    }
+
+    /* the output thread named itself */
+    usleep(20000);
+    return 0;
+}
+
+/*
+ * fill the ring while the output thread is held, log the urgent ones after
+ * the INFO logs it dropped, then let it drain
+ *
+ * @return result
+ */
+static int flood(void)
+{
+    int i;
+
+    if (0 != test_output_hold()) {
+        return -1;
+    }
+
+    for (i = 0; i < FILL_LOGS; ++i) {
+        slog_info("lane", "seq=%d %s", i, msg);
+    }
+    /* the INFO logs older than the reorder window, no room for as long ERROR ones */
+    usleep(2000);
+    for (i = URGENT_SEQ; i < URGENT_SEQ + URGENT_LOGS; ++i) {
+        slog_error("lane", "seq=%d %s", i, msg);
+    }
+
+    test_output_release();
+    return test_flush();
+}
+
+/*
+ * @return output position of a seq, -1 not out
+ */
+static int position(int seq)
+{
+    int i;
+
+    for (i = 0; i < got; ++i) {
+        if (order[i] == seq) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+int main(void)
+{
+    int i, pos, last = -1, result = 1;
+
+    memset(msg, 'l', MSG_LEN);
+    if (0 != test_dir_enter("lane")) {
+        goto out;
+    }
+
+    /* one lane for all, the full ring drops the ERROR logs too */
+    if ((0 != start(0)) || (0 != flood())) {
+        goto out;
+    }
+    if (-1 != (pos = position(URGENT_SEQ))) {
+        fprintf(stderr, "one lane: an ERROR log out at %d of %d, not dropped\n", pos, got);
+        goto out;
+    }
+    log_fini();
+
+    /* the urgent lane keeps them, they go ahead of the backlog */
+    if ((0 != start(LANE)) || (0 != flood())) {
+        goto out;
+    }
+    for (i = URGENT_SEQ; i < URGENT_SEQ + URGENT_LOGS; ++i) {
+        pos = position(i);
+        if ((pos <= last) || (pos * 2 > got)) {
+            fprintf(stderr, "urgent lane: ERROR seq=%d out at %d of %d, after %d\n", i, pos, got, last);
+            goto out;
+        }
+        last = pos;
+    }
+    printf("lane: %d ERROR logs kept by a full ring, out at %d-%d of %d\n", URGENT_LOGS, position(URGENT_SEQ), last,
+           got);
+
+    /* an ERROR log right after an INFO one waits for it */
+    got = 0;
+    for (i = PAIR_SEQ; i < PAIR_SEQ + 2 * PAIRS; i += 2) {
+        slog_info("lane", "seq=%d", i);
+        slog_error("lane", "seq=%d", i + 1);
+        usleep(2000);
+    }
+    if (0 != test_flush()) {
+        goto out;
+    }
+    for (i = 0; i < got; ++i) {
+        if (order[i] != PAIR_SEQ + i) {
+            fprintf(stderr, "window: seq=%d out at %d\n", order[i], i);
+            goto out;
+        }
+    }
+    if (2 * PAIRS != got) {
+        fprintf(stderr, "window: %d of %d logs out\n", got, 2 * PAIRS);
+        goto out;
+    }
+
+    result = 0;
+
+out:
+    test_fini();
+
+    return result;
+}
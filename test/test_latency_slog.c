@@ -0,0 +1,137 @@
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "logger.h"
+#include "slog_stats.h"
+#include "test_util.h"
+
+/*
+ * call latency test, built with SLOG_LATENCY_STATS: each thread times one
+ * slog() call in LATENCY_SAMPLE of its own, slog_get_stats() merges them
+ * into one histogram and log_fini() reports it to the inner log. Without
+ * LATENCY_SAMPLE nothing is timed.
+ */
+
+#define THREADS             4
+#define LOGS                10000 /* per thread */
+#define SAMPLE              10
+#define LINE_MAX_LEN        1024
+
+static void *log_thread(void *arg)
+{
+    int i;
+
+    for (i = 0; i < LOGS; ++i) {
+        slog_info("latency", "thread %ld seq=%d", (long)arg, i);
+    }
+
+    return NULL;
+}
+
+static int run(void)
+{
+    pthread_t tid[THREADS];
+    long i;
+
+    for (i = 0; i < THREADS; ++i) {
+        if (0 != pthread_create(&tid[i], NULL, log_thread, (void *)i)) {
+            perror("pthread_create");
+            return -1;
+        }
+    }
+    for (i = 0; i < THREADS; ++i) {
+        pthread_join(tid[i], NULL);
+    }
+
+    return 0;
+}
+
+/*
+ * @return the calls log_fini() reported sampled to the inner log, -1 none
+ */
+static long reported(void)
+{
+    FILE *fp = fopen("log_inner.log", "r");
+    char line[LINE_MAX_LEN];
+    const char *pos;
+    long calls = -1;
+
+    if (NULL == fp) {
+        return -1;
+    }
+    while (NULL != fgets(line, sizeof(line), fp)) {
+        pos = strstr(line, "log call latency of ");
+        if (NULL != pos) {
+            calls = strtol(pos + strlen("log call latency of "), NULL, 10);
+        }
+    }
+    fclose(fp);
+
+    return calls;
+}
+
+int main(void)
+{
+    static slog_stats_t stats;
+    unsigned long sum = 0;
+    int i, result = 1;
+
+    /* off by default */
+    if ((0 != test_init("latency", NULL)) || (0 != run())) {
+        goto out;
+    }
+    slog_get_stats(&stats);
+    if (0 != stats.call.count) {
+        fprintf(stderr, "default: %lu calls sampled\n", stats.call.count);
+        goto out;
+    }
+    log_fini();
+    if (-1 != reported()) {
+        fprintf(stderr, "default: latency reported\n");
+        goto out;
+    }
+
+    /* one call in SAMPLE of each thread, its first one included */
+    if ((0 != test_config("LATENCY_SAMPLE=%d;\n", SAMPLE)) || (0 != log_init())) {
+        fprintf(stderr, "log_init failed\n");
+        goto out;
+    }
+    if (0 != run()) {
+        goto out;
+    }
+    slog_get_stats(&stats);
+    for (i = 0; i < SLOG_STATS_CALL_BUCKETS; ++i) {
+        sum += stats.call.buckets[i];
+    }
+    if ((THREADS * LOGS / SAMPLE != stats.call.count) || (sum != stats.call.count) || (0 == stats.call.max) ||
+        (stats.call.sum / stats.call.count > stats.call.max) || (stats.call.p50 > stats.call.p90) ||
+        (stats.call.p90 > stats.call.p99) || (stats.call.p99 > stats.call.p999)) {
+        fprintf(stderr, "%lu calls sampled of %d, %lu in the buckets, p50 %llu p90 %llu p99 %llu p99.9 %llu max %llu\n",
+                stats.call.count, THREADS * LOGS, sum, (unsigned long long)stats.call.p50,
+                (unsigned long long)stats.call.p90, (unsigned long long)stats.call.p99,
+                (unsigned long long)stats.call.p999, (unsigned long long)stats.call.max);
+        goto out;
+    }
+    log_fini();
+
+    if (reported() != (long)stats.call.count) {
+        fprintf(stderr, "log_fini reported %ld calls sampled, not %lu\n", reported(), stats.call.count);
+        goto out;
+    }
+
+    printf("latency: %lu calls sampled, p50 %lluns p99 %lluns max %lluns\n", stats.call.count,
+           (unsigned long long)stats.call.p50, (unsigned long long)stats.call.p99,
+           (unsigned long long)stats.call.max);
+    result = 0;
+
+out:
+    test_fini();
+
+    return result;
+}
@@ -0,0 +1,98 @@
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "logger.h"
+#include "test_util.h"
+
+/*
+ * tag quota test: a tag over its rate quota has the rest of its logs
+ * dropped, its scope commits too, each drop counted in the stats, and the
+ * logs of other tags all output.
+ */
+
+#define LOGS                2000
+#define RATE                100000  /* bytes per second */
+#define SCOPE_LOGS          100
+
+static int got_noisy, got_quiet;
+
+static int quota_write(void *ctx, struct iovec *iov, int iovcnt)
+{
+    int i;
+
+    for (i = 0; i < iovcnt; ++i) {
+        if (NULL != memmem(iov[i].iov_base, iov[i].iov_len, "| noisy ", 8)) {
+            got_noisy++;
+        } else if (NULL != memmem(iov[i].iov_base, iov[i].iov_len, "| quiet ", 8)) {
+            got_quiet++;
+        }
+    }
+
+    return 0;
+}
+
+int main(void)
+{
+    int i, result = 1;
+    unsigned long enqueued = 0, dropped = 0;
+    slog_stats_t stats;
+    char msg[200];
+
+    if ((0 != test_init("quota", "TAG_QUOTA=noisy:0:%d;\n", RATE)) ||
+        (test_sink_register("quota", NULL, quota_write, NULL, 4 * 1024 * 1024) < 0)) {
+        goto out;
+    }
+
+    /* a second's worth of the rate goes through, about RATE / 250 logs */
+    memset(msg, 'n', sizeof(msg) - 1);
+    msg[sizeof(msg) - 1] = '\0';
+    for (i = 0; i < LOGS; ++i) {
+        slog_info("noisy", "%s", msg);
+        slog_info("quiet", "%s", msg);
+    }
+
+    /* the scope's logs are charged at its commit, the quota is spent */
+    slog_scope_begin(0);
+    for (i = 0; i < SCOPE_LOGS; ++i) {
+        slog_debug("noisy", "%s", msg);
+    }
+    slog_scope_commit();
+
+    if (0 != test_flush()) {
+        goto out;
+    }
+    slog_get_stats(&stats);
+    for (i = 0; i < SLOG_STATS_LEVELS; ++i) {
+        enqueued += stats.enqueued[i];
+        dropped += stats.dropped[i];
+    }
+
+    if ((LOGS != got_quiet) || (0 == got_noisy) || (got_noisy >= LOGS)) {
+        fprintf(stderr, "got %d quiet logs of %d, %d noisy logs of %d\n", got_quiet, LOGS, got_noisy,
+                LOGS + SCOPE_LOGS);
+        goto out;
+    }
+    if ((stats.quota_dropped != (unsigned long)(LOGS + SCOPE_LOGS - got_noisy)) ||
+        (dropped != stats.quota_dropped) || (enqueued != (unsigned long)(got_noisy + got_quiet)) ||
+        (stats.consumed != enqueued)) {
+        fprintf(stderr, "stats: enqueued %lu, consumed %lu, dropped %lu, quota dropped %lu; %d noisy logs output\n",
+                enqueued, stats.consumed, dropped, stats.quota_dropped, got_noisy);
+        goto out;
+    }
+
+    printf("quota: %d of %d noisy logs output, %lu dropped, %d quiet logs output\n", got_noisy,
+           LOGS + SCOPE_LOGS, stats.quota_dropped, got_quiet);
+    result = 0;
+
+out:
+    test_fini();
+
+    return result;
+}
@@ -0,0 +1,132 @@
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "logger.h"
+#include "test_util.h"
+
+/*
+ * ring file recovery test: a child logs into a BUFFER_FILE ring and is
+ * killed, slog-recover then gets its logs back from the ring it left.
+ *
+ * "test_recover_slog <slog-recover>"
+ */
+
+#define LOGS                5000
+#define LINE_MAX_LEN        1024
+
+/*
+ * log and die without log_fini(), the ring file stays behind
+ */
+static void child(void)
+{
+    int i;
+
+    if (0 != log_init()) {
+        _exit(1);
+    }
+
+    for (i = 0; i < LOGS; ++i) {
+        slog_info("recover", "seq=%d", i);
+    }
+
+    raise(SIGKILL);
+}
+
+/*
+ * read the "seq=N" logs slog-recover prints, they run up to the last one
+ * logged without a gap
+ *
+ * @param first the first seq, -1 any
+ *
+ * @return logs read, -1 error
+ */
+static int recover(const char *cmd, int first)
+{
+    FILE *fp = popen(cmd, "r");
+    char line[LINE_MAX_LEN];
+    const char *pos;
+    int seq, next = first, logs = 0;
+
+    if (NULL == fp) {
+        perror("popen");
+        return -1;
+    }
+
+    while (NULL != fgets(line, sizeof(line), fp)) {
+        pos = strstr(line, "seq=");
+        if ((NULL == pos) || (1 != sscanf(pos, "seq=%d", &seq)) || ((-1 != next) && (seq != next))) {
+            fprintf(stderr, "%s: expect seq=%d, got line: %s", cmd, next, line);
+            pclose(fp);
+            return -1;
+        }
+        next = seq + 1;
+        logs++;
+    }
+
+    if (0 != pclose(fp)) {
+        fprintf(stderr, "%s failed\n", cmd);
+        return -1;
+    }
+    if ((0 != logs) && (LOGS != next)) {
+        fprintf(stderr, "%s: the last log is seq=%d of %d\n", cmd, next - 1, LOGS);
+        return -1;
+    }
+
+    return logs;
+}
+
+int main(int argc, char **argv)
+{
+    int status, all, unconsumed, result = 1;
+    pid_t pid;
+    char cmd[1024];
+
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <slog-recover>\n", argv[0]);
+        return 1;
+    }
+
+    if (0 != test_dir_enter("recover") || 0 != test_config("BUFFER_FILE=slog.ring;\n")) {
+        goto out;
+    }
+
+    pid = fork();
+    if (0 == pid) {
+        child();
+        _exit(1);
+    }
+    if ((-1 == pid) || (pid != waitpid(pid, &status, 0)) || !WIFSIGNALED(status) || (SIGKILL != WTERMSIG(status))) {
+        fprintf(stderr, "the child was not killed\n");
+        goto out;
+    }
+
+    /* every log is still in the ring, the consumed ones too */
+    snprintf(cmd, sizeof(cmd), "'%s' -a slog.ring", argv[1]);
+    all = recover(cmd, 0);
+    if (LOGS != all) {
+        fprintf(stderr, "recovered %d of %d logs\n", all, LOGS);
+        goto out;
+    }
+
+    /* the ones not output yet are the last logged */
+    snprintf(cmd, sizeof(cmd), "'%s' slog.ring", argv[1]);
+    unconsumed = recover(cmd, -1);
+    if (unconsumed < 0) {
+        goto out;
+    }
+
+    printf("recover: %d logs in the ring, %d of them not output\n", all, unconsumed);
+    result = 0;
+
+out:
+    test_dir_leave();
+
+    return result;
+}
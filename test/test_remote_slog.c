@@ -0,0 +1,234 @@
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "logger.h"
+#include "slog_lz.h"
+
+/*
+ * tcp remote output test, a local listener is the collector:
+ * logs written while it does not listen are spooled, and all of them
+ * reach it in order once it does.
+ *
+ * "test_remote_slog lz4" has the collector decode the compressed stream
+ * with the reference decoder, checking the round trip.
+ */
+
+#define SPOOLED_LOGS        2000
+#define LIVE_LOGS           2000
+#define RECV_WAIT           5000  /* ms */
+
+static char recv_buf[1024 * 1024];
+static char line_buf[1024 * 1024];
+static size_t line_len;
+static int next_seq;
+
+static slog_lz_t lz;
+static int compressed;
+static size_t wire_bytes, raw_bytes;
+
+static int write_config(int port)
+{
+    FILE *fp = fopen("slog.conf", "w");
+    if (NULL == fp) {
+        return -1;
+    }
+
+    fprintf(fp, "OUTPUT_ENABLE=true;\n");
+    fprintf(fp, "OUTPUT_FILE_ENABLE=false;\n");
+    fprintf(fp, "OUTPUT_TERMINAL_ENABLE=false;\n");
+    fprintf(fp, "FILTER_LEVEL=VERBOSE;\n");
+    fprintf(fp, "OUTPUT_REMOTE_ENABLE=true;\n");
+    fprintf(fp, "OUTPUT_REMOTE_HOST=127.0.0.1;\n");
+    fprintf(fp, "OUTPUT_REMOTE_PORT=%d;\n", port);
+    fprintf(fp, "OUTPUT_REMOTE_PROTO=TCP;\n");
+    fprintf(fp, "OUTPUT_REMOTE_SPOOL=8;\n");
+    fprintf(fp, "OUTPUT_REMOTE_DROP=NEWEST;\n");
+    fprintf(fp, "OUTPUT_REMOTE_SHED_LEVEL=VERBOSE;\n");
+    fprintf(fp, "OUTPUT_REMOTE_COMPRESS=%s;\n", compressed ? "LZ4" : "NONE");
+    fclose(fp);
+
+    return 0;
+}
+
+/*
+ * check the lines "seq=N" are in order, a partial line waits for the rest
+ *
+ * @return result
+ */
+static int check_lines(const char *data, size_t len)
+{
+    int seq;
+    char *line, *eol, *pos;
+
+    if (line_len + len >= sizeof(line_buf)) {
+        fprintf(stderr, "line buffer overflow\n");
+        return -1;
+    }
+    memcpy(line_buf + line_len, data, len);
+    line_len += len;
+    line_buf[line_len] = '\0';
+    raw_bytes += len;
+
+    line = line_buf;
+    while (NULL != (eol = strchr(line, '\n'))) {
+        *eol = '\0';
+        pos = strstr(line, "seq=");
+        if (NULL == pos || 1 != sscanf(pos, "seq=%d", &seq) || seq != next_seq) {
+            fprintf(stderr, "expect seq=%d, got line: %s\n", next_seq, line);
+            return -1;
+        }
+        next_seq++;
+        line = eol + 1;
+    }
+
+    line_len -= line - line_buf;
+    memmove(line_buf, line, line_len);
+
+    return 0;
+}
+
+/*
+ * receive until seq reaches count, decoding the frames of a compressed stream
+ *
+ * @return result
+ */
+static int collect(int fd, int count)
+{
+    int ret;
+    size_t len = 0, raw_len;
+    ssize_t n;
+    const char *raw = NULL;
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+
+    slog_lz_reset(&lz);
+
+    while (next_seq < count) {
+        if (poll(&pfd, 1, RECV_WAIT) <= 0) {
+            fprintf(stderr, "timeout, got %d of %d logs\n", next_seq, count);
+            return -1;
+        }
+
+        n = read(fd, recv_buf + len, sizeof(recv_buf) - len);
+        if (n <= 0) {
+            fprintf(stderr, "collector read error: %s\n", n ? strerror(errno) : "closed");
+            return -1;
+        }
+        wire_bytes += n;
+
+        if (!compressed) {
+            if (0 != check_lines(recv_buf, n)) {
+                return -1;
+            }
+            continue;
+        }
+
+        len += n;
+        while ((ret = slog_lz_frame_decode(&lz, recv_buf, len, &raw, &raw_len)) > 0) {
+            if (0 != check_lines(raw, raw_len)) {
+                return -1;
+            }
+            len -= ret;
+            memmove(recv_buf, recv_buf + ret, len);
+        }
+        if (ret < 0) {
+            fprintf(stderr, "corrupt compressed frame\n");
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    int i, lfd, cfd, result = 1;
+    struct stat statbuf;
+    struct sockaddr_in addr;
+    socklen_t addr_len = sizeof(addr);
+    char dir[] = "/tmp/slog_remote_XXXXXX";
+
+    compressed = (argc > 1) && (0 == strcmp(argv[1], "lz4"));
+
+    if (NULL == mkdtemp(dir) || 0 != chdir(dir)) {
+        perror("test dir");
+        return 1;
+    }
+
+    /* bound but not listening yet, connects are refused */
+    lfd = socket(AF_INET, SOCK_STREAM, 0);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (0 != bind(lfd, (struct sockaddr *)&addr, sizeof(addr)) ||
+        0 != getsockname(lfd, (struct sockaddr *)&addr, &addr_len) ||
+        0 != write_config(ntohs(addr.sin_port))) {
+        perror("collector setup");
+        return 1;
+    }
+
+    if (0 != log_init()) {
+        fprintf(stderr, "log_init failed\n");
+        return 1;
+    }
+
+    for (i = 0; i < SPOOLED_LOGS; ++i) {
+        slog_info("remote", "seq=%d", i);
+        if (0 == i % 256) {
+            usleep(1000);
+        }
+    }
+    usleep(300000);
+
+    if (0 != stat("slog.spool", &statbuf) || 0 == statbuf.st_size) {
+        fprintf(stderr, "logs were not spooled while the collector was down\n");
+        goto out;
+    }
+
+    if (0 != listen(lfd, 1)) {
+        perror("listen");
+        goto out;
+    }
+
+    for (i = SPOOLED_LOGS; i < SPOOLED_LOGS + LIVE_LOGS; ++i) {
+        slog_info("remote", "seq=%d", i);
+        if (0 == i % 256) {
+            usleep(1000);
+        }
+    }
+
+    struct pollfd pfd = { .fd = lfd, .events = POLLIN };
+    if (poll(&pfd, 1, RECV_WAIT) <= 0 || -1 == (cfd = accept(lfd, NULL, NULL))) {
+        fprintf(stderr, "slog did not reconnect\n");
+        goto out;
+    }
+
+    if (0 == collect(cfd, SPOOLED_LOGS + LIVE_LOGS)) {
+        printf("remote tcp%s: %d logs received in order, %zu bytes on the wire for %zu\n",
+               compressed ? " lz4" : "", SPOOLED_LOGS + LIVE_LOGS, wire_bytes, raw_bytes);
+        result = 0;
+    }
+    close(cfd);
+
+out:
+    log_fini();
+    close(lfd);
+    unlink("slog.spool");
+    unlink("slog.conf");
+    unlink("log_inner.log");
+    if (0 == chdir("/")) {
+        rmdir(dir);
+    }
+
+    return result;
+}
@@ -0,0 +1,200 @@
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "logger.h"
+#include "test_util.h"
+
+/*
+ * output sink test: a registered sink gets every log of its tag in order,
+ * and a stalled sink's full queue drops the newest or the oldest logs by
+ * its drop policy, each drop counted in its stats.
+ */
+
+#define LOGS                2000
+#define STALL_QUEUE         4096  /* bytes */
+
+/* a sink's view of the "seq=N" logs it got */
+typedef struct test_sink_s {
+    const char *name;
+    int stall;                               /* the first batch blocks until released */
+    int stalled;
+    int released;
+    int got;
+    int last;
+    int unordered;
+    char seen[LOGS];
+} test_sink_t;
+
+static test_sink_t order_sink = { .name = "order" };
+static test_sink_t newest_sink = { .name = "newest", .stall = 1 };
+static test_sink_t oldest_sink = { .name = "oldest", .stall = 1 };
+
+static int sink_write(void *ctx, struct iovec *iov, int iovcnt)
+{
+    test_sink_t *sink = (test_sink_t *)ctx;
+    const char *pos;
+    int i, seq;
+
+    if (sink->stall && !__atomic_load_n(&sink->stalled, __ATOMIC_ACQUIRE)) {
+        __atomic_store_n(&sink->stalled, 1, __ATOMIC_RELEASE);
+        while (!__atomic_load_n(&sink->released, __ATOMIC_ACQUIRE)) {
+            usleep(1000);
+        }
+    }
+
+    for (i = 0; i < iovcnt; ++i) {
+        pos = memmem(iov[i].iov_base, iov[i].iov_len, "seq=", 4);
+        if ((NULL == pos) || (1 != sscanf(pos, "seq=%d", &seq)) || (seq < 0) || (seq >= LOGS)) {
+            continue;
+        }
+        if (seq <= sink->last) {
+            sink->unordered++;
+        }
+        sink->last = seq;
+        sink->seen[seq] = 1;
+        __atomic_add_fetch(&sink->got, 1, __ATOMIC_RELEASE);
+    }
+
+    return 0;
+}
+
+static int sink_register(test_sink_t *sink, uint8_t drop_policy, size_t queue_size)
+{
+    slog_sink_desc_t desc;
+
+    memset(&desc, 0, sizeof(desc));
+    desc.name = sink->name;
+    desc.ops.write_batch = sink_write;
+    desc.ctx = sink;
+    desc.level = VERBOSE;
+    strcpy(desc.tag, "sink");
+    desc.format = SLOG_SINK_FORMAT_TEXT;
+    desc.queue_size = queue_size;
+    desc.drop_policy = drop_policy;
+    desc.shed_level = VERBOSE;
+    sink->last = -1;
+
+    return slog_sink_register(&desc);
+}
+
+static int wait_for(const int *flag, int value)
+{
+    int ms;
+
+    for (ms = 0; ms < TEST_WAIT; ++ms) {
+        if (__atomic_load_n(flag, __ATOMIC_ACQUIRE) >= value) {
+            return 0;
+        }
+        usleep(1000);
+    }
+
+    return -1;
+}
+
+static const slog_sink_stats_t *find_stats(const slog_stats_t *stats, const char *name)
+{
+    int i;
+
+    for (i = 0; i < stats->sinks; ++i) {
+        if (0 == strcmp(stats->sink[i].name, name)) {
+            return &stats->sink[i];
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * a stalled sink got an ordered part of the logs, the rest counted dropped
+ *
+ * @param keep_last whether the last log is kept, SLOG_SINK_DROP_OLDEST
+ *
+ * @return result
+ */
+static int check_stalled(const test_sink_t *sink, const slog_stats_t *stats, int keep_last)
+{
+    const slog_sink_stats_t *sink_stats = find_stats(stats, sink->name);
+
+    if (NULL == sink_stats) {
+        fprintf(stderr, "%s: no stats\n", sink->name);
+        return -1;
+    }
+    if ((0 != sink->unordered) || (0 == sink_stats->dropped) ||
+        ((unsigned long)sink->got + sink_stats->dropped != LOGS) || (sink_stats->written != (unsigned long)sink->got)) {
+        fprintf(stderr, "%s: got %d, %d out of order, written %lu, dropped %lu of %d\n", sink->name, sink->got,
+                sink->unordered, sink_stats->written, sink_stats->dropped, LOGS);
+        return -1;
+    }
+    if (!sink->seen[0] || (keep_last != sink->seen[LOGS - 1])) {
+        fprintf(stderr, "%s: first log %s, last log %s\n", sink->name, sink->seen[0] ? "kept" : "dropped",
+                sink->seen[LOGS - 1] ? "kept" : "dropped");
+        return -1;
+    }
+
+    printf("sink %s: %d logs written, %lu dropped\n", sink->name, sink->got, sink_stats->dropped);
+    return 0;
+}
+
+int main(void)
+{
+    int i, result = 1;
+    slog_stats_t stats;
+
+    if (0 != test_init("sink", NULL)) {
+        goto out;
+    }
+
+    if ((sink_register(&order_sink, SLOG_SINK_DROP_NEWEST, 0) < 0) ||
+        (sink_register(&newest_sink, SLOG_SINK_DROP_NEWEST, STALL_QUEUE) < 0) ||
+        (sink_register(&oldest_sink, SLOG_SINK_DROP_OLDEST, STALL_QUEUE) < 0)) {
+        fprintf(stderr, "sink register failed\n");
+        goto out;
+    }
+
+    /* both stalled sinks block in their first batch, their queues fill up */
+    slog_info("sink", "seq=%d", 0);
+    slog_info("other", "not for the sinks");
+    if ((0 != wait_for(&newest_sink.stalled, 1)) || (0 != wait_for(&oldest_sink.stalled, 1))) {
+        fprintf(stderr, "the stalled sinks got no batch\n");
+        goto out;
+    }
+
+    for (i = 1; i < LOGS; ++i) {
+        slog_info("sink", "seq=%d", i);
+    }
+    if (0 != wait_for(&order_sink.got, LOGS)) {
+        fprintf(stderr, "order: got %d of %d logs\n", order_sink.got, LOGS);
+        goto out;
+    }
+
+    __atomic_store_n(&newest_sink.released, 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&oldest_sink.released, 1, __ATOMIC_RELEASE);
+    if (0 != test_flush()) {
+        goto out;
+    }
+    slog_get_stats(&stats);
+
+    if ((order_sink.got != LOGS) || (0 != order_sink.unordered)) {
+        fprintf(stderr, "order: got %d of %d logs, %d out of order\n", order_sink.got, LOGS, order_sink.unordered);
+        goto out;
+    }
+    printf("sink order: %d logs written in order\n", order_sink.got);
+
+    if ((0 == check_stalled(&newest_sink, &stats, 0)) && (0 == check_stalled(&oldest_sink, &stats, 1))) {
+        result = 0;
+    }
+
+out:
+    __atomic_store_n(&newest_sink.released, 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&oldest_sink.released, 1, __ATOMIC_RELEASE);
+    test_fini();
+
+    return result;
+}
@@ -0,0 +1,181 @@
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "logger.h"
+#include "test_util.h"
+
+/*
+ * call site sampling test: slog_every_n() outputs the 1st call and every
+ * n-th after it, slog_first_n() the first n calls, alone and with threads
+ * sharing the site. An output line tells the calls skipped before it.
+ */
+
+#define CALLS               1000
+#define EVERY_N             10
+#define FIRST_N             5
+#define THREADS             4
+
+/* what the sink got of one site, by the message's name */
+typedef struct test_site_s {
+    const char *name;
+    int logs;
+    int last;                                /* seq of the last log */
+    int unordered;                           /* seq not the expected one, single threaded sites */
+    unsigned long suppressed;                /* sum of the "(suppressed N)" of the logs */
+} test_site_t;
+
+static test_site_t sites[] = {
+    { .name = "every" },
+    { .name = "first" },
+    { .name = "every_mt" },
+    { .name = "first_mt" },
+};
+
+#define SITE_EVERY          0
+#define SITE_FIRST          1
+#define SITE_EVERY_MT       2
+#define SITE_FIRST_MT       3
+
+static int site_write(void *ctx, struct iovec *iov, int iovcnt)
+{
+    char line[256];
+    char name[32];
+    const char *pos;
+    int i, seq, step;
+    size_t j, len;
+    unsigned long suppressed;
+    test_site_t *site;
+
+    for (i = 0; i < iovcnt; ++i) {
+        len = (iov[i].iov_len < sizeof(line)) ? iov[i].iov_len : sizeof(line) - 1;
+        memcpy(line, iov[i].iov_base, len);
+        line[len] = '\0';
+
+        pos = strstr(line, "site=");
+        if ((NULL == pos) || (2 != sscanf(pos, "site=%31s seq=%d", name, &seq))) {
+            continue;
+        }
+        for (j = 0, site = NULL; j < sizeof(sites) / sizeof(sites[0]); ++j) {
+            if (0 == strcmp(name, sites[j].name)) {
+                site = &sites[j];
+            }
+        }
+        if (NULL == site) {
+            continue;
+        }
+
+        pos = strstr(line, "(suppressed ");
+        suppressed = 0;
+        if ((NULL != pos) && (1 != sscanf(pos, "(suppressed %lu)", &suppressed))) {
+            suppressed = 0;
+        }
+
+        step = (site == &sites[SITE_EVERY]) ? EVERY_N : 1;
+        if ((site == &sites[SITE_EVERY]) || (site == &sites[SITE_FIRST])) {
+            if (seq != ((0 == site->logs) ? 0 : site->last + step)) {
+                site->unordered++;
+            }
+        }
+        site->last = seq;
+        site->suppressed += suppressed;
+        __atomic_add_fetch(&site->logs, 1, __ATOMIC_RELEASE);
+    }
+
+    return 0;
+}
+
+static void *every_producer(void *arg)
+{
+    int i;
+
+    for (i = 0; i < CALLS; ++i) {
+        slog_info_every_n("site", EVERY_N, "site=every_mt seq=%d", i);
+    }
+
+    return NULL;
+}
+
+static void *first_producer(void *arg)
+{
+    int i;
+
+    for (i = 0; i < CALLS; ++i) {
+        slog_info_first_n("site", FIRST_N, "site=first_mt seq=%d", i);
+    }
+
+    return NULL;
+}
+
+/*
+ * @param calls calls of the site
+ * @param suppressed skipped calls the logs tell, -1 calls - logs at most
+ *
+ * @return result
+ */
+static int check(const test_site_t *site, int calls, int logs, long suppressed)
+{
+    if ((site->logs != logs) || (0 != site->unordered) ||
+        ((-1 == suppressed) ? (site->suppressed > (unsigned long)(calls - logs)) :
+                              (site->suppressed != (unsigned long)suppressed))) {
+        fprintf(stderr, "%s: %d logs of %d, %d out of step, %lu suppressed told\n", site->name, site->logs,
+                logs, site->unordered, site->suppressed);
+        return -1;
+    }
+
+    printf("site %s: %d logs of %d calls, %lu suppressed told\n", site->name, site->logs, calls, site->suppressed);
+    return 0;
+}
+
+int main(void)
+{
+    int i, result = 1;
+    long t;
+    pthread_t threads[THREADS];
+
+    if ((0 != test_init("site", NULL)) || (test_sink_register("site", "site", site_write, NULL, 0) < 0)) {
+        goto out;
+    }
+
+    for (i = 0; i < CALLS; ++i) {
+        slog_info_every_n("site", EVERY_N, "site=every seq=%d", i);
+        slog_info_first_n("site", FIRST_N, "site=first seq=%d", i);
+    }
+
+    for (t = 0; t < THREADS; ++t) {
+        pthread_create(&threads[t], NULL, every_producer, NULL);
+    }
+    for (t = 0; t < THREADS; ++t) {
+        pthread_join(threads[t], NULL);
+    }
+    for (t = 0; t < THREADS; ++t) {
+        pthread_create(&threads[t], NULL, first_producer, NULL);
+    }
+    for (t = 0; t < THREADS; ++t) {
+        pthread_join(threads[t], NULL);
+    }
+
+    if (0 != test_flush()) {
+        goto out;
+    }
+
+    /* the calls skipped after the last log are not told, no log follows them */
+    if ((0 == check(&sites[SITE_EVERY], CALLS, CALLS / EVERY_N, CALLS - CALLS / EVERY_N - (EVERY_N - 1))) &&
+        (0 == check(&sites[SITE_FIRST], CALLS, FIRST_N, 0)) &&
+        (0 == check(&sites[SITE_EVERY_MT], CALLS * THREADS, CALLS * THREADS / EVERY_N, -1)) &&
+        (0 == check(&sites[SITE_FIRST_MT], CALLS * THREADS, FIRST_N, 0))) {
+        result = 0;
+    }
+
+out:
+    test_fini();
+
+    return result;
+}
@@ -0,0 +1,126 @@
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "logger.h"
+#include "test_util.h"
+
+/*
+ * spill test: producers sharing the output thread's core overrun the main
+ * ring, the logs it has no room for go through the spill file. Every log is
+ * output or counted dropped, and each thread's logs are output in order.
+ */
+
+#define THREADS             8
+#define THREAD_LOGS         4000
+#define MSG_LEN             4000
+#define SPILL_SIZE          8     /* MB */
+#define WAIT                20000 /* ms */
+
+static int got;
+static int unordered;
+static int last[THREADS];
+
+static char msg[MSG_LEN + 1];
+
+static int spill_write(void *ctx, struct iovec *iov, int iovcnt)
+{
+    const char *pos;
+    int i, thread, seq;
+
+    for (i = 0; i < iovcnt; ++i) {
+        pos = memmem(iov[i].iov_base, iov[i].iov_len, "thread=", 7);
+        if ((NULL == pos) || (2 != sscanf(pos, "thread=%d seq=%d", &thread, &seq)) ||
+            (thread < 0) || (thread >= THREADS)) {
+            continue;
+        }
+        if (seq <= last[thread]) {
+            unordered++;
+        }
+        last[thread] = seq;
+        got++;
+    }
+
+    return 0;
+}
+
+static void *producer(void *arg)
+{
+    long thread = (long)arg;
+    int i;
+    cpu_set_t mask;
+
+    CPU_ZERO(&mask);
+    CPU_SET(0, &mask);
+    pthread_setaffinity_np(pthread_self(), sizeof(mask), &mask);
+
+    for (i = 0; i < THREAD_LOGS; ++i) {
+        slog_info("spill", "thread=%ld seq=%d %s", thread, i, msg);
+    }
+
+    return NULL;
+}
+
+int main(void)
+{
+    int i, result = 1;
+    long t;
+    unsigned long enqueued = 0, dropped = 0, sink_dropped = 0;
+    pthread_t threads[THREADS];
+    slog_stats_t stats;
+
+    if ((0 != test_init("spill", "CPU_CORE=0;\nSPILL_SIZE=%d;\n", SPILL_SIZE)) ||
+        (test_sink_register("spill", "spill", spill_write, NULL, 64 * 1024 * 1024) < 0)) {
+        goto out;
+    }
+
+    memset(msg, 's', MSG_LEN);
+    for (t = 0; t < THREADS; ++t) {
+        last[t] = -1;
+        pthread_create(&threads[t], NULL, producer, (void *)t);
+    }
+    for (t = 0; t < THREADS; ++t) {
+        pthread_join(threads[t], NULL);
+    }
+
+    if (0 != slog_flush(WAIT)) {
+        fprintf(stderr, "slog_flush timed out\n");
+        goto out;
+    }
+    slog_get_stats(&stats);
+    for (i = 0; i < SLOG_STATS_LEVELS; ++i) {
+        enqueued += stats.enqueued[i];
+        dropped += stats.dropped[i];
+    }
+    for (i = 0; i < stats.sinks; ++i) {
+        if (0 == strcmp(stats.sink[i].name, "spill")) {
+            sink_dropped = stats.sink[i].dropped;
+        }
+    }
+
+    /* a log the spill took is enqueued, one over its cap dropped */
+    if ((0 != unordered) || (enqueued + dropped != THREADS * THREAD_LOGS) || (stats.consumed != enqueued) ||
+        ((unsigned long)got + sink_dropped != stats.consumed) || (stats.spill_dropped > dropped)) {
+        fprintf(stderr, "got %d, %d out of order; enqueued %lu, dropped %lu, consumed %lu, spilled %lu, "
+                "spill dropped %lu, sink dropped %lu of %d\n", got, unordered, enqueued, dropped, stats.consumed,
+                stats.spilled, stats.spill_dropped, sink_dropped, THREADS * THREAD_LOGS);
+        goto out;
+    }
+
+    printf("spill: %d of %d logs output in order, %lu spilled, %lu over its cap dropped\n", got,
+           THREADS * THREAD_LOGS, stats.spilled, stats.spill_dropped);
+    result = 0;
+
+out:
+    test_fini();
+
+    return result;
+}
@@ -0,0 +1,141 @@
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "logger.h"
+#include "test_util.h"
+
+/*
+ * stats test: slog_get_stats() counts by level the logs put and their
+ * bytes, none of those the level filter drops, as many consumed as put
+ * and written by a sink, and the stats file's last line tells the same.
+ */
+
+#define THREADS             4
+#define LEVEL_LOGS          100   /* level n logs (n + 1) * LEVEL_LOGS per thread */
+#define LINE_MAX_LEN        2048
+
+static int got;
+
+static int stats_write(void *ctx, struct iovec *iov, int iovcnt)
+{
+    __atomic_add_fetch(&got, iovcnt, __ATOMIC_RELEASE);
+
+    return 0;
+}
+
+static void *producer(void *arg)
+{
+    int level, i;
+
+    for (level = ASSERT; level <= VERBOSE; ++level) {
+        for (i = 0; i < (level + 1) * LEVEL_LOGS; ++i) {
+            slog(level, "stats", 5, __FILENAME__, strlen(__FILENAME__), __func__, sizeof(__func__) - 1, __LINE__,
+                 "level %d seq=%d", level, i);
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * the last line of the stats file tells the counters
+ *
+ * @return result
+ */
+static int check_file(unsigned long enqueued_debug, unsigned long consumed)
+{
+    FILE *fp = fopen(SLOG_STATS_FILE_NAME, "r");
+    char line[LINE_MAX_LEN], last[LINE_MAX_LEN] = "";
+    unsigned long counts[SLOG_STATS_LEVELS], file_consumed;
+    const char *pos;
+
+    if (NULL == fp) {
+        perror(SLOG_STATS_FILE_NAME);
+        return -1;
+    }
+    while (NULL != fgets(line, sizeof(line), fp)) {
+        strcpy(last, line);
+    }
+    fclose(fp);
+
+    pos = strstr(last, "enqueued=");
+    if ((NULL == pos) ||
+        (6 != sscanf(pos, "enqueued=%lu,%lu,%lu,%lu,%lu,%lu", &counts[0], &counts[1], &counts[2], &counts[3],
+                     &counts[4], &counts[5])) ||
+        (NULL == (pos = strstr(last, " consumed="))) || (1 != sscanf(pos, " consumed=%lu", &file_consumed)) ||
+        (counts[DEBUG] != enqueued_debug) || (0 != counts[VERBOSE]) || (file_consumed != consumed)) {
+        fprintf(stderr, "the stats file's last line does not match: %s", last);
+        return -1;
+    }
+
+    return 0;
+}
+
+int main(void)
+{
+    int level, sink, result = 1;
+    long t;
+    unsigned long expect, sum = 0;
+    pthread_t threads[THREADS];
+    slog_stats_t stats;
+
+    if ((0 != test_init("stats", "FILTER_LEVEL=DEBUG;\nSTATS_INTERVAL=1;\n")) ||
+        (test_sink_register("stats", NULL, stats_write, NULL, 8 * 1024 * 1024) < 0)) {
+        goto out;
+    }
+
+    for (t = 0; t < THREADS; ++t) {
+        pthread_create(&threads[t], NULL, producer, NULL);
+    }
+    for (t = 0; t < THREADS; ++t) {
+        pthread_join(threads[t], NULL);
+    }
+
+    if (0 != test_flush()) {
+        goto out;
+    }
+    slog_get_stats(&stats);
+
+    for (level = ASSERT; level <= VERBOSE; ++level) {
+        expect = (VERBOSE == level) ? 0 : (unsigned long)THREADS * (level + 1) * LEVEL_LOGS;
+        if ((stats.enqueued[level] != expect) || (0 != stats.dropped[level]) || (0 != stats.throttled[level]) ||
+            ((0 != expect) && (stats.bytes[level] < expect * (sizeof("level 0 seq=0") - 1)))) {
+            fprintf(stderr, "level %d: enqueued %lu of %lu, %llu bytes, dropped %lu, throttled %lu\n", level,
+                    stats.enqueued[level], expect, (unsigned long long)stats.bytes[level], stats.dropped[level],
+                    stats.throttled[level]);
+            goto out;
+        }
+        sum += expect;
+    }
+
+    /* the terminal sink is registered too, its logs filtered out */
+    for (sink = 0; (sink < stats.sinks) && (0 != strcmp(stats.sink[sink].name, "stats")); ++sink) {
+    }
+    if ((stats.consumed != sum) || (sink == stats.sinks) || (stats.sink[sink].written != sum) ||
+        (0 != stats.sink[sink].dropped) || ((unsigned long)got != sum) || (0 == stats.batches) ||
+        (0 == stats.ring_size)) {
+        fprintf(stderr, "consumed %lu of %lu, %d sinks, written %lu, sink got %d, batches %lu, ring %u\n",
+                stats.consumed, sum, stats.sinks, stats.sink[sink].written, got, stats.batches, stats.ring_size);
+        goto out;
+    }
+
+    /* a line at least once a second, the output thread idle */
+    usleep(1500000);
+    if (0 != check_file(stats.enqueued[DEBUG], stats.consumed)) {
+        goto out;
+    }
+
+    printf("stats: %lu logs enqueued, consumed and written, by level as put\n", sum);
+    result = 0;
+
+out:
+    test_fini();
+
+    return result;
+}
@@ -0,0 +1,107 @@
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "logger.h"
+#include "slog_cfg.h"
+#include "test_util.h"
+
+/*
+ * terminal toggle test: stdout is a file, the log starts with the terminal
+ * output off. Turned on at run time the terminal gets the logs, turned off
+ * again it gets none.
+ */
+
+#define LOGS                100
+#define TERM_FILE           "term.out"
+#define LINE_MAX_LEN        1024
+
+/*
+ * @return lines of the terminal file with the word
+ */
+static int lines(const char *word)
+{
+    FILE *fp = fopen(TERM_FILE, "r");
+    char line[LINE_MAX_LEN];
+    int count = 0;
+
+    if (NULL == fp) {
+        return -1;
+    }
+    while (NULL != fgets(line, sizeof(line), fp)) {
+        count += (NULL != strstr(line, word));
+    }
+    fclose(fp);
+
+    return count;
+}
+
+static int log_phase(const char *word)
+{
+    int i;
+
+    for (i = 0; i < LOGS; ++i) {
+        slog_info("term", "%s %d", word, i);
+    }
+
+    return test_flush();
+}
+
+int main(void)
+{
+    int fd, saved = -1, result = 1;
+
+    if ((0 != test_dir_enter("term")) || (0 != test_config(""))) {
+        goto out;
+    }
+
+    /* the terminal sink writes to stdout as log_init() found it */
+    fflush(stdout);
+    saved = dup(STDOUT_FILENO);
+    fd = open(TERM_FILE, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if ((saved < 0) || (fd < 0) || (dup2(fd, STDOUT_FILENO) < 0)) {
+        perror(TERM_FILE);
+        goto out;
+    }
+    close(fd);
+
+    if (0 != log_init()) {
+        fprintf(stderr, "log_init failed\n");
+        goto out;
+    }
+    if (0 != log_phase("off")) {
+        goto out;
+    }
+    slog_set_output_terminal_enabled(true);
+    if (0 != log_phase("on")) {
+        goto out;
+    }
+    slog_set_output_terminal_enabled(false);
+    if (0 != log_phase("again")) {
+        goto out;
+    }
+    log_fini();
+
+    if ((0 != lines("off")) || (LOGS != lines("on")) || (0 != lines("again"))) {
+        fprintf(stderr, "terminal lines: %d off, %d on, %d off again\n", lines("off"), lines("on"), lines("again"));
+        goto out;
+    }
+    result = 0;
+
+out:
+    if (saved >= 0) {
+        dup2(saved, STDOUT_FILENO);
+        close(saved);
+    }
+    if (0 == result) {
+        printf("term: %d logs out while the terminal was turned on at run time, none while off\n", LOGS);
+    }
+    test_fini();
+
+    return result;
+}
@@ -0,0 +1,139 @@
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "logger.h"
+#include "test_util.h"
+
+/*
+ * throttle test: the output thread held, the ring fills up past
+ * THROTTLE_HIGH. Once it runs again the level is raised and DEBUG logs
+ * dropped, and a while after the ring drained it comes back down. Without
+ * the THROTTLE options the level never moves.
+ */
+
+#define FILL_LOGS           3000  /* about 75% of the main ring */
+#define MSG_LEN             4000
+#define HIGH                50    /* percent */
+#define CALM                1500  /* ms, over the throttle's 1s */
+#define LINE_MAX_LEN        1024
+
+static int probes;
+
+static char msg[MSG_LEN + 1];
+
+static int probe_write(void *ctx, struct iovec *iov, int iovcnt)
+{
+    __atomic_add_fetch(&probes, iovcnt, __ATOMIC_RELEASE);
+
+    return 0;
+}
+
+/*
+ * fill the ring while the output thread is held, then let it drain
+ */
+static int fill(void)
+{
+    int i;
+
+    if (0 != test_output_hold()) {
+        return -1;
+    }
+
+    for (i = 0; i < FILL_LOGS; ++i) {
+        slog_info("fill", "seq=%d %s", i, msg);
+    }
+
+    test_output_release();
+    return test_flush();
+}
+
+/*
+ * @return DEBUG probes a sink got of 10 logged
+ */
+static int probe(void)
+{
+    int i;
+
+    __atomic_store_n(&probes, 0, __ATOMIC_RELEASE);
+    for (i = 0; i < 10; ++i) {
+        slog_debug("probe", "probe %d", i);
+    }
+    if (0 != test_flush()) {
+        return -1;
+    }
+
+    return __atomic_load_n(&probes, __ATOMIC_ACQUIRE);
+}
+
+/*
+ * @return the inner log's lines of the throttle stepping the given way
+ */
+static int steps(const char *action)
+{
+    FILE *fp = fopen("log_inner.log", "r");
+    char line[LINE_MAX_LEN], pattern[64];
+    int count = 0;
+
+    if (NULL == fp) {
+        return 0;
+    }
+    snprintf(pattern, sizeof(pattern), "log throttle %s", action);
+    while (NULL != fgets(line, sizeof(line), fp)) {
+        if (NULL != strstr(line, pattern)) {
+            count++;
+        }
+    }
+    fclose(fp);
+
+    return count;
+}
+
+int main(void)
+{
+    int got = 0, result = 1;
+
+    memset(msg, 't', MSG_LEN);
+
+    /* off by default, a full ring moves nothing */
+    if ((0 != test_init("throttle", NULL)) || (test_sink_register("probe", "probe", probe_write, NULL, 0) < 0)) {
+        goto out;
+    }
+    usleep(20000);
+    if ((0 != fill()) || (10 != (got = probe())) || (0 != steps("raises"))) {
+        fprintf(stderr, "default: %d of 10 probes, %d raises\n", got, steps("raises"));
+        goto out;
+    }
+    log_fini();
+
+    /* raised by the full ring, lowered once it stayed drained */
+    if ((0 != test_config("THROTTLE_HIGH=%d;\n", HIGH)) || (0 != log_init()) ||
+        (test_sink_register("probe", "probe", probe_write, NULL, 0) < 0)) {
+        fprintf(stderr, "log_init failed\n");
+        goto out;
+    }
+    usleep(20000);
+    if ((0 != fill()) || (0 != (got = probe())) || (0 == steps("raises"))) {
+        fprintf(stderr, "raised: %d of 10 probes, %d raises\n", got, steps("raises"));
+        goto out;
+    }
+
+    usleep(CALM * 1000);
+    if ((10 != (got = probe())) || (steps("lowers") != steps("raises"))) {
+        fprintf(stderr, "calm: %d of 10 probes, %d raises, %d lowers\n", got, steps("raises"), steps("lowers"));
+        goto out;
+    }
+
+    printf("throttle: raised %d step(s) by a %d%% full ring, lowered after %dms calm, off by default\n",
+           steps("raises"), HIGH, CALM);
+    result = 0;
+
+out:
+    test_fini();
+
+    return result;
+}
@@ -0,0 +1,286 @@
+#ifndef __TEST_UTIL_H
+#define __TEST_UTIL_H
+
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include "logger.h"
+
+/*
+ * what the tests share: each runs in a directory of its own, logs with the
+ * slog.conf it writes there to the sinks it registers, and leaves nothing
+ * behind.
+ */
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC MACROS --------------------------------------------- */
+
+/* ms a test waits for its logs */
+#define TEST_WAIT                            5000
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE VARIABLES ----------------------------------------- */
+
+static char test_dir[64];
+static int test_in_dir;
+
+/* the output thread held by test_output_hold() */
+static int test_output_held;
+static int test_output_released;
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC FUNCTIONS DEFINITION ------------------------------- */
+
+/**
+ * make /tmp/slog_<name>_XXXXXX and run in it
+ *
+ * @return -1 error, 0 success
+ */
+static int test_dir_enter(const char *name)
+{
+    snprintf(test_dir, sizeof(test_dir), "/tmp/slog_%s_XXXXXX", name);
+    if (NULL == mkdtemp(test_dir) || 0 != chdir(test_dir)) {
+        perror("test dir");
+        return -1;
+    }
+    test_in_dir = 1;
+
+    return 0;
+}
+
+/**
+ * write slog.conf: the output enabled to no built-in sink, every level, then
+ * the lines of the format, one given again overrides the above
+ *
+ * @param format config lines, NULL none
+ *
+ * @return -1 error, 0 success
+ */
+static int test_config(const char *format, ...)
+{
+    va_list args;
+    FILE *fp = fopen("slog.conf", "w");
+    if (NULL == fp) {
+        return -1;
+    }
+
+    fprintf(fp, "OUTPUT_ENABLE=true;\n");
+    fprintf(fp, "OUTPUT_FILE_ENABLE=false;\n");
+    fprintf(fp, "OUTPUT_TERMINAL_ENABLE=false;\n");
+    fprintf(fp, "FILTER_LEVEL=VERBOSE;\n");
+    if (NULL != format) {
+        va_start(args, format);
+        vfprintf(fp, format, args);
+        va_end(args);
+    }
+    fclose(fp);
+
+    return 0;
+}
+
+/**
+ * test_dir_enter(), slog.conf with the config lines given, then log_init()
+ *
+ * @return -1 error, 0 success
+ */
+static int test_init(const char *name, const char *format, ...)
+{
+    va_list args;
+    char config[1024] = "";
+
+    if (NULL != format) {
+        va_start(args, format);
+        vsnprintf(config, sizeof(config), format, args);
+        va_end(args);
+    }
+
+    if (0 != test_dir_enter(name)) {
+        return -1;
+    }
+    if (0 != test_config("%s", config) || 0 != log_init()) {
+        fprintf(stderr, "log_init failed\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * register a text sink of every level that drops the newest log when full
+ *
+ * @param tag only logs of this tag, NULL all
+ * @param queue_size queue bytes, 0 default
+ *
+ * @return sink id, -1 error
+ */
+static int test_sink_register(const char *name, const char *tag, int (*write_batch)(void *, struct iovec *, int),
+                              void *ctx, size_t queue_size)
+{
+    slog_sink_desc_t desc;
+    int id;
+
+    memset(&desc, 0, sizeof(desc));
+    desc.name = name;
+    desc.ops.write_batch = write_batch;
+    desc.ctx = ctx;
+    desc.level = VERBOSE;
+    if (NULL != tag) {
+        strcpy(desc.tag, tag);
+    }
+    desc.format = SLOG_SINK_FORMAT_TEXT;
+    desc.queue_size = queue_size;
+    desc.drop_policy = SLOG_SINK_DROP_NEWEST;
+    desc.shed_level = VERBOSE;
+
+    id = slog_sink_register(&desc);
+    if (id < 0) {
+        fprintf(stderr, "sink %s register failed\n", name);
+    }
+
+    return id;
+}
+
+/**
+ * slog_flush() for at most TEST_WAIT
+ *
+ * @return -1 timed out, 0 every log put before written
+ */
+static int test_flush(void)
+{
+    if (0 != slog_flush(TEST_WAIT)) {
+        fprintf(stderr, "slog_flush timed out\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+/* SIGUSR2 on the output thread only, it waits here until released */
+static void test_output_wait(int sig)
+{
+    struct timespec ts = { 0, 1000000 };
+
+    __atomic_store_n(&test_output_held, 1, __ATOMIC_RELEASE);
+    while (!__atomic_load_n(&test_output_released, __ATOMIC_ACQUIRE)) {
+        nanosleep(&ts, NULL);
+    }
+}
+
+/*
+ * @return the output thread's id, -1 none
+ */
+static pid_t test_output_thread(void)
+{
+    DIR *dir = opendir("/proc/self/task");
+    struct dirent *entry;
+    char path[300], comm[32];
+    FILE *fp;
+    pid_t tid = -1;
+
+    if (NULL == dir) {
+        return -1;
+    }
+    while ((-1 == tid) && (NULL != (entry = readdir(dir)))) {
+        snprintf(path, sizeof(path), "/proc/self/task/%s/comm", entry->d_name);
+        fp = fopen(path, "r");
+        if (NULL == fp) {
+            continue;
+        }
+        if ((NULL != fgets(comm, sizeof(comm), fp)) && (0 == strncmp(comm, "log_output", 10))) {
+            tid = atoi(entry->d_name);
+        }
+        fclose(fp);
+    }
+    closedir(dir);
+
+    return tid;
+}
+
+/**
+ * hold the output thread, the logs stay in the ring until
+ * test_output_release()
+ *
+ * @return -1 error, 0 held
+ */
+static int test_output_hold(void)
+{
+    pid_t tid;
+    int ms;
+
+    /* named once it runs */
+    for (ms = 0; (-1 == (tid = test_output_thread())) && (ms < TEST_WAIT); ++ms) {
+        usleep(1000);
+    }
+
+    __atomic_store_n(&test_output_held, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&test_output_released, 0, __ATOMIC_RELEASE);
+    signal(SIGUSR2, test_output_wait);
+    if ((-1 == tid) || (0 != syscall(SYS_tgkill, getpid(), tid, SIGUSR2))) {
+        fprintf(stderr, "no output thread to hold\n");
+        return -1;
+    }
+    while (!__atomic_load_n(&test_output_held, __ATOMIC_ACQUIRE)) {
+        usleep(1000);
+    }
+
+    return 0;
+}
+
+static void test_output_release(void)
+{
+    __atomic_store_n(&test_output_released, 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * remove every file of the test directory and the directory
+ */
+static void test_dir_leave(void)
+{
+    DIR *dir;
+    struct dirent *entry;
+
+    if (!test_in_dir) {
+        return;
+    }
+    test_in_dir = 0;
+
+    dir = opendir(".");
+    if (NULL != dir) {
+        while (NULL != (entry = readdir(dir))) {
+            if (DT_DIR != entry->d_type) {
+                unlink(entry->d_name);
+            }
+        }
+        closedir(dir);
+    }
+
+    if (0 == chdir("/")) {
+        rmdir(test_dir);
+    }
+}
+
+/**
+ * log_fini() then test_dir_leave()
+ */
+static void test_fini(void)
+{
+    test_output_release();
+    log_fini();
+    test_dir_leave();
+}
+
+
+#endif  /* __TEST_UTIL_H */
@@ -0,0 +1,110 @@
+
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <sys/stat.h>
+
+#include "slog_index.h"
+#include "slog_bloom.h"
+#include "slog_column.h"
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE FUNCTIONS DEFINITION ------------------------------ */
+
+static void usage(const char *name)
+{
+    fprintf(stderr,
+            "usage: %s [-o archive] segment...\n"
+            "  convert text or binary slog files into columnar archives for slog-query\n"
+            "  -o archive  archive name of a single segment, segment.col by default\n", name);
+}
+
+static int has_suffix(const char *name, const char *suffix)
+{
+    size_t len = strlen(name), suffix_len = strlen(suffix);
+
+    return (len > suffix_len) && (0 == strcmp(name + len - suffix_len, suffix));
+}
+
+/*
+ * @return result
+ */
+static int archive_file(const char *segment, const char *archive)
+{
+    struct stat before, after;
+
+    if (0 != stat(segment, &before)) {
+        fprintf(stderr, "%s: %s\n", segment, strerror(errno));
+        return -1;
+    }
+
+    if ((0 != slog_column_convert(segment, archive)) || (0 != stat(archive, &after))) {
+        fprintf(stderr, "%s: conversion failed: %s\n", segment, strerror(errno));
+        return -1;
+    }
+
+    printf("%s: %lld -> %lld bytes", archive, (long long)before.st_size, (long long)after.st_size);
+    if (after.st_size > 0) {
+        printf(", %.1fx", (double)before.st_size / after.st_size);
+    }
+    putchar('\n');
+
+    return 0;
+}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC FUNCTIONS DEFINITION ------------------------------- */
+
+int main(int argc, char **argv)
+{
+    int c, i, result = 0;
+    const char *output = NULL;
+    char archive[PATH_MAX];
+
+    while (-1 != (c = getopt(argc, argv, "o:h"))) {
+        switch (c) {
+        case 'o':
+            output = optarg;
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if ((optind >= argc) || ((NULL != output) && (argc - optind > 1))) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    for (i = optind; i < argc; ++i) {
+        /* slog.log* names the files beside the segments too */
+        if (has_suffix(argv[i], SLOG_INDEX_SUFFIX) || has_suffix(argv[i], SLOG_BLOOM_SUFFIX) ||
+            has_suffix(argv[i], SLOG_COLUMN_SUFFIX)) {
+            continue;
+        }
+
+        if (NULL == output) {
+            snprintf(archive, sizeof(archive), "%s%s", argv[i], SLOG_COLUMN_SUFFIX);
+        }
+        if (0 != archive_file(argv[i], (NULL != output) ? output : archive)) {
+            result = 1;
+        }
+    }
+
+    return result;
+}
+
+
+/* ============== EOF ======================================================= */
\ No newline at end of file
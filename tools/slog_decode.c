@@ -0,0 +1,407 @@
+
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <ctype.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "logger.h"
+#include "slog_spec.h"
+#include "slog_async.h"
+#include "slog_event.h"
+#include "slog_index.h"
+#include "slog_binlog.h"
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE MACROS -------------------------------------------- */
+
+#define SLOG_DECODE_TZ_LEN                   32
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE TYPES --------------------------------------------- */
+
+/* decode options */
+typedef struct slog_decode_opt_s {
+    int json;                                /* JSON lines instead of text */
+    int64_t start;                           /* us, records before it are skipped */
+    int64_t end;                             /* us, records after it are skipped */
+    uint8_t level;                           /* levels above it are skipped */
+    const char *tag;                         /* only this tag, NULL all */
+    size_t tag_len;
+} slog_decode_opt_t;
+
+/* file being decoded */
+typedef struct slog_decode_file_s {
+    const char *name;
+    const char *data;
+    int result;
+} slog_decode_file_t;
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE VARIABLES ----------------------------------------- */
+
+static const char *level_name[] = {
+        [ASSERT]  = "ASSERT",
+        [ERROR]   = "ERROR",
+        [WARN]    = "WARN",
+        [INFO]    = "INFO",
+        [DEBUG]   = "DEBUG",
+        [VERBOSE] = "VERBOSE",
+};
+
+static slog_decode_opt_t opt = { .start = INT64_MIN, .end = INT64_MAX, .level = VERBOSE };
+
+/* zone the text formatter renders in, the writer's one */
+static int32_t current_gmtoff = INT32_MIN;
+
+static char event_buf[SLOG_EVENT_BUF_MAXLEN];
+static char format_buf[SLOG_FORMAT_BUF_SIZE];
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE FUNCTIONS DEFINITION ------------------------------ */
+
+static void usage(const char *name)
+{
+    fprintf(stderr,
+            "usage: %s [-j] [-s start] [-e end] [-l level] [-t tag] file...\n"
+            "  render binary slog files as text, as the text file sink writes them\n"
+            "  -j        one JSON object per log instead of text\n"
+            "  -s start  skip logs before start\n"
+            "  -e end    skip logs after end\n"
+            "            times are \"YYYY-MM-DD HH:MM:SS\" in local time or @epoch seconds\n"
+            "  -l level  skip levels above it: ASSERT ERROR WARN INFO DEBUG VERBOSE\n"
+            "  -t tag    only logs of this tag\n"
+            "  a file's .idx index, when there is one, narrows what -s -e -l read\n", name);
+}
+
+/*
+ * @return us since the epoch, -1 invalid
+ */
+static int64_t parse_time(const char *value)
+{
+    struct tm tm;
+    char *end = NULL;
+    double sec;
+
+    if ('@' == value[0]) {
+        sec = strtod(value + 1, &end);
+        if (end == value + 1 || '\0' != *end) {
+            return -1;
+        }
+        return (int64_t)(sec * 1000000);
+    }
+
+    memset(&tm, 0, sizeof(tm));
+    end = strptime(value, "%Y-%m-%d %H:%M:%S", &tm);
+    if (NULL == end || '\0' != *end) {
+        return -1;
+    }
+    tm.tm_isdst = -1;
+
+    return (int64_t)mktime(&tm) * 1000000;
+}
+
+static int parse_level(const char *value)
+{
+    int i;
+
+    for (i = ASSERT; i <= VERBOSE; ++i) {
+        if (0 == strcasecmp(value, level_name[i])) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/*
+ * render the text in the zone the log was written in
+ */
+static void set_zone(int32_t gmtoff)
+{
+    char tz[SLOG_DECODE_TZ_LEN];
+    int32_t off = (gmtoff < 0) ? -gmtoff : gmtoff;
+
+    if (gmtoff == current_gmtoff) {
+        return;
+    }
+
+    /* POSIX TZ offsets count west of UTC */
+    snprintf(tz, sizeof(tz), "UTC%c%02d:%02d:%02d", (gmtoff < 0) ? '+' : '-',
+             off / 3600, off / 60 % 60, off % 60);
+    setenv("TZ", tz, 1);
+    tzset();
+    current_gmtoff = gmtoff;
+}
+
+static void json_string(const char *key, const char *str, size_t len)
+{
+    size_t i;
+    unsigned char c;
+
+    printf("\"%s\":\"", key);
+    for (i = 0; i < len; ++i) {
+        c = (unsigned char)str[i];
+        if ('"' == c || '\\' == c) {
+            putchar('\\');
+            putchar(c);
+        } else if ('\n' == c) {
+            fputs("\\n", stdout);
+        } else if ('\t' == c) {
+            fputs("\\t", stdout);
+        } else if (c < 0x20) {
+            printf("\\u%04x", c);
+        } else {
+            putchar(c);
+        }
+    }
+    putchar('"');
+}
+
+static void print_json(const slog_binlog_record_t *record, int32_t gmtoff)
+{
+    struct tm tm;
+    char time_str[SLOG_TIME_FORMAT_LEN];
+    time_t sec = (time_t)(record->time / 1000000) + gmtoff;
+
+    gmtime_r(&sec, &tm);
+    snprintf(time_str, sizeof(time_str), "%04d-%02d-%02d %02d:%02d:%02d.%06ld",
+             tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec,
+             (long)(record->time % 1000000));
+
+    printf("{\"time\":\"%s\",\"ts_us\":%lld,\"level\":\"%s\",", time_str,
+           (long long)record->time, level_name[record->level]);
+    json_string("tag", record->tag, record->tag_len);
+    putchar(',');
+    json_string("file", record->file, record->file_len);
+    putchar(',');
+    json_string("func", record->func, record->func_len);
+    printf(",\"line\":%u,", record->line);
+    json_string("msg", record->msg, record->msg_len);
+    fputs("}\n", stdout);
+}
+
+static void print_text(const slog_binlog_record_t *record, int32_t gmtoff)
+{
+    int len;
+
+    set_zone(gmtoff);
+    slog_binlog_record_event(record, event_buf);
+
+    len = format_log(format_buf, event_buf);
+    if (len > 0) {
+        fwrite(format_buf, 1, len, stdout);
+    }
+}
+
+static int block_wanted(const slog_binlog_block_t *block)
+{
+    if ((block->max_time < opt.start) || (block->min_time > opt.end)) {
+        return 0;
+    }
+
+    /* levels up to opt.level */
+    return 0 != (block->level_mask & ((2 << opt.level) - 1));
+}
+
+static int record_wanted(const slog_binlog_record_t *record)
+{
+    if ((record->time < opt.start) || (record->time > opt.end) || (record->level > opt.level)) {
+        return 0;
+    }
+
+    return (NULL == opt.tag) ||
+           ((record->tag_len == opt.tag_len) && (0 == memcmp(record->tag, opt.tag, opt.tag_len)));
+}
+
+/*
+ * decode the records of one verified block
+ *
+ * @return result
+ */
+static int decode_block(const slog_binlog_block_t *block)
+{
+    int ret;
+    size_t pos = 0;
+    int64_t time = 0;
+    slog_binlog_record_t record;
+
+    while (1 == (ret = slog_binlog_record_next(block, &pos, &time, &record))) {
+        if (!record_wanted(&record)) {
+            continue;
+        }
+        if (opt.json) {
+            print_json(&record, block->gmtoff);
+        } else {
+            print_text(&record, block->gmtoff);
+        }
+    }
+
+    return ret;
+}
+
+/*
+ * decode the blocks in one range of a file, a corrupt block is reported and
+ * skipped
+ */
+static void decode_range(uint64_t offset, uint64_t length, void *arg)
+{
+    int ret;
+    slog_decode_file_t *file = (slog_decode_file_t *)arg;
+    size_t pos = offset, end = offset + length;
+    const char *data = file->data, *next = NULL;
+    slog_binlog_block_t block;
+
+    while (pos < end) {
+        ret = slog_binlog_block_parse(data + pos, end - pos, &block);
+        if (0 == ret) {
+            /* the writer may still be in this block */
+            fprintf(stderr, "%s: incomplete block at %zu\n", file->name, pos);
+            break;
+        }
+
+        if ((ret < 0) || (block_wanted(&block) && (0 != decode_block(&block)))) {
+            fprintf(stderr, "%s: corrupt block at %zu, skipped\n", file->name, pos);
+            file->result = -1;
+
+            next = memmem(data + pos + 1, end - pos - 1, SLOG_BINLOG_BLOCK_MAGIC, 4);
+            if (NULL == next) {
+                break;
+            }
+            pos = next - data;
+            continue;
+        }
+
+        pos += ret;
+    }
+}
+
+/*
+ * decode one binary log file, a filtered one only in the ranges its index
+ * selects
+ *
+ * @return result
+ */
+static int decode_file(const char *name)
+{
+    int fd, ret;
+    size_t size, index_len = 0;
+    struct stat statbuf;
+    const char *data = NULL;
+    char *index = NULL;
+    slog_index_query_t query = { .start = opt.start, .end = opt.end,
+                                 .level_mask = (uint8_t)((2 << opt.level) - 1) };
+    slog_decode_file_t file = { .name = name };
+
+    fd = open(name, O_RDONLY);
+    if (-1 == fd || 0 != fstat(fd, &statbuf)) {
+        fprintf(stderr, "%s: %s\n", name, strerror(errno));
+        if (-1 != fd) {
+            close(fd);
+        }
+        return -1;
+    }
+
+    size = statbuf.st_size;
+    if (0 == size) {
+        close(fd);
+        return 0;
+    }
+
+    data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (MAP_FAILED == data) {
+        fprintf(stderr, "%s: mmap: %s\n", name, strerror(errno));
+        return -1;
+    }
+
+    ret = slog_binlog_file_check(data, size);
+    if (ret < 0) {
+        fprintf(stderr, "%s: not a binary slog file\n", name);
+        munmap((void *)data, size);
+        return -1;
+    }
+    file.data = data;
+
+    if ((INT64_MIN != opt.start) || (INT64_MAX != opt.end) || (VERBOSE != opt.level)) {
+        index = slog_index_read(name, SLOG_INDEX_SUFFIX, &index_len);
+    }
+    if ((NULL == index) || (slog_index_select(index, index_len, size, ret, &query, decode_range, &file) < 0)) {
+        decode_range(ret, size - ret, &file);
+    }
+
+    free(index);
+    munmap((void *)data, size);
+
+    return file.result;
+}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC FUNCTIONS DEFINITION ------------------------------- */
+
+int main(int argc, char **argv)
+{
+    int c, level, i, result = 0;
+
+    while (-1 != (c = getopt(argc, argv, "js:e:l:t:h"))) {
+        switch (c) {
+        case 'j':
+            opt.json = 1;
+            break;
+        case 's':
+        case 'e':
+            if (-1 == (c == 's' ? (opt.start = parse_time(optarg)) : (opt.end = parse_time(optarg)))) {
+                fprintf(stderr, "invalid time: %s\n", optarg);
+                return 2;
+            }
+            break;
+        case 'l':
+            if (-1 == (level = parse_level(optarg))) {
+                fprintf(stderr, "invalid level: %s\n", optarg);
+                return 2;
+            }
+            opt.level = (uint8_t)level;
+            break;
+        case 't':
+            opt.tag = optarg;
+            opt.tag_len = strlen(optarg);
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (optind >= argc) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    for (i = optind; i < argc; ++i) {
+        if (0 != decode_file(argv[i])) {
+            result = 1;
+        }
+    }
+
+    return result;
+}
+
+
+/* ============== EOF ======================================================= */
\ No newline at end of file
@@ -0,0 +1,872 @@
+
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "logger.h"
+#include "slog_spec.h"
+#include "slog_index.h"
+#include "slog_bloom.h"
+#include "slog_binlog.h"
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE MACROS -------------------------------------------- */
+
+/* bytes searched by one thread at a time */
+#define SLOG_GREP_CHUNK_SIZE                 (4 * 1024 * 1024)
+
+#define SLOG_GREP_THREAD_MAX                 64
+
+/*
+ * format_log() line: '[' time "] " level column "| " tag " (" file ' ' func
+ * ':' line ") " message, the time "YYYY-MM-DD HH:MM:SS.uuuuuu" is fixed width
+ * and the level column is padded to 7
+ */
+#define SLOG_GREP_TIME_LEN                   26
+#define SLOG_GREP_LINE_TIME                  1
+#define SLOG_GREP_LINE_LEVEL                 (SLOG_GREP_TIME_LEN + 3)
+#define SLOG_GREP_LINE_TAG                   (SLOG_GREP_LINE_LEVEL + 9)
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE TYPES --------------------------------------------- */
+
+/* search options */
+typedef struct slog_grep_opt_s {
+    const char *pattern;                     /* literal, NULL any */
+    size_t pattern_len;
+    int word;                                /* pattern matches whole words of the message */
+    uint8_t level;                           /* levels above it are skipped */
+    const char *tag;                         /* only this tag, NULL all */
+    size_t tag_len;
+    const char *file;                        /* only this source file, NULL all */
+    size_t file_len;
+    uint32_t line;                           /* only this source line, 0 all */
+    slog_index_query_t query;                /* what the index selects */
+    char start[SLOG_TIME_FORMAT_LEN];        /* text time bounds, "" none */
+    char end[SLOG_TIME_FORMAT_LEN];
+    int count;                               /* print the match count only */
+    int with_name;                           /* prefix each log with its file name */
+    int threads;
+} slog_grep_opt_t;
+
+/* one matching log, its head line and continuation lines */
+typedef struct slog_grep_match_s {
+    const char *log;
+    uint32_t len;
+    uint32_t seq;                            /* file order, for logs of the same time */
+} slog_grep_match_t;
+
+/* part of a segment searched by one thread, starts at a log */
+typedef struct slog_grep_chunk_s {
+    const char *name;
+    const char *start;
+    const char *end;
+    slog_grep_match_t *matches;
+    size_t count;
+    size_t cap;
+    size_t pos;                              /* merge cursor */
+} slog_grep_chunk_t;
+
+/* head line fields */
+typedef struct slog_grep_head_s {
+    int level;
+    const char *tag;
+    size_t tag_len;
+    const char *file;
+    size_t file_len;
+    uint32_t line;
+    const char *msg;
+} slog_grep_head_t;
+
+/* ranges an index or filters file selects, in file order */
+typedef struct slog_grep_ranges_s {
+    uint64_t (*range)[2];                    /* start, end */
+    size_t count;
+    size_t cap;
+} slog_grep_ranges_t;
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE VARIABLES ----------------------------------------- */
+
+static const char *level_name[] = {
+        [ASSERT]  = "ASSERT",
+        [ERROR]   = "ERROR",
+        [WARN]    = "WARN",
+        [INFO]    = "INFO",
+        [DEBUG]   = "DEBUG",
+        [VERBOSE] = "VERBOSE",
+};
+
+static slog_grep_opt_t opt = {
+        .level = VERBOSE,
+        .query = { .start = INT64_MIN, .end = INT64_MAX, .level_mask = 0xff },
+};
+
+static slog_grep_chunk_t *chunks = NULL;
+static size_t chunk_count = 0;
+static size_t chunk_cap = 0;
+
+/* next chunk a thread takes */
+static size_t chunk_next = 0;
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE FUNCTIONS DEFINITION ------------------------------ */
+
+static void usage(const char *name)
+{
+    fprintf(stderr,
+            "usage: %s [-c] [-H] [-w] [-j threads] [-s start] [-e end] [-l level] [-t tag]\n"
+            "       [-f file[:line]] pattern file...\n"
+            "  search text slog files in parallel and print the matching logs in time order\n"
+            "  pattern   literal the log contains, \"\" any log\n"
+            "  -c        print the number of matching logs only\n"
+            "  -H        prefix each log with its file name\n"
+            "  -w        pattern matches whole words of the message only\n"
+            "  -j n      search threads, the online cpus by default\n"
+            "  -s start  skip logs before start\n"
+            "  -e end    skip logs after end\n"
+            "            times are \"YYYY-MM-DD HH:MM:SS\" in local time or @epoch seconds\n"
+            "  -l level  skip levels above it: ASSERT ERROR WARN INFO DEBUG VERBOSE\n"
+            "  -t tag    only logs of this tag\n"
+            "  -f file   only logs of this source file, or file:line\n"
+            "  a file's .idx index, when there is one, narrows what -s -e -l read,\n"
+            "  its .bloom filters what -w and -t read\n", name);
+}
+
+/*
+ * @return us since the epoch, -1 invalid
+ */
+static int64_t parse_time(const char *value)
+{
+    struct tm tm;
+    char *end = NULL;
+    double sec;
+
+    if ('@' == value[0]) {
+        sec = strtod(value + 1, &end);
+        if (end == value + 1 || '\0' != *end) {
+            return -1;
+        }
+        return (int64_t)(sec * 1000000);
+    }
+
+    memset(&tm, 0, sizeof(tm));
+    end = strptime(value, "%Y-%m-%d %H:%M:%S", &tm);
+    if (NULL == end || '\0' != *end) {
+        return -1;
+    }
+    tm.tm_isdst = -1;
+
+    return (int64_t)mktime(&tm) * 1000000;
+}
+
+static int parse_level(const char *value)
+{
+    int i;
+
+    for (i = ASSERT; i <= VERBOSE; ++i) {
+        if (0 == strcasecmp(value, level_name[i])) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/*
+ * the time of a text line as the file sink renders it, in local time
+ */
+static void format_time(char *buf, int64_t time)
+{
+    struct tm tm;
+    time_t sec = (time_t)(time / 1000000);
+
+    localtime_r(&sec, &tm);
+    snprintf(buf, SLOG_TIME_FORMAT_LEN, "%04d-%02d-%02d %02d:%02d:%02d.%06ld",
+             tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec,
+             (long)(time % 1000000));
+}
+
+/*
+ * find a literal, 16 candidate positions at a time: a position is compared
+ * whole only when its first and last bytes both match
+ *
+ * @return first match, NULL none
+ */
+static const char *find_literal(const char *hay, size_t len, const char *needle, size_t needle_len)
+{
+#ifdef __SSE2__
+    const char *p = hay;
+    const char *last = hay + len - needle_len;   /* last position a match may start */
+    __m128i first_byte, last_byte, a, b;
+    unsigned int mask;
+    int bit;
+
+    if ((needle_len < 2) || (len < needle_len + 16)) {
+        return memmem(hay, len, needle, needle_len);
+    }
+
+    first_byte = _mm_set1_epi8(needle[0]);
+    last_byte = _mm_set1_epi8(needle[needle_len - 1]);
+
+    for (; p + 16 <= last + 1; p += 16) {
+        a = _mm_loadu_si128((const __m128i *)p);
+        b = _mm_loadu_si128((const __m128i *)(p + needle_len - 1));
+        mask = (unsigned int)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first_byte),
+                                                             _mm_cmpeq_epi8(b, last_byte)));
+        while (0 != mask) {
+            bit = __builtin_ctz(mask);
+            if (0 == memcmp(p + bit + 1, needle + 1, needle_len - 2)) {
+                return p + bit;
+            }
+            mask &= mask - 1;
+        }
+    }
+
+    return memmem(p, last + needle_len - p, needle, needle_len);
+#else
+    return memmem(hay, len, needle, needle_len);
+#endif
+}
+
+/*
+ * @return level of a level column's first letter, -1 none
+ */
+static int column_level(char c)
+{
+    int i;
+
+    for (i = ASSERT; i <= VERBOSE; ++i) {
+        if (c == level_name[i][0]) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/*
+ * @return 1 a head line in format_log() layout, its level parsed, 0 a
+ *         continuation line of a multi-line message
+ */
+static int is_head(const char *p, const char *end)
+{
+    return (end - p > SLOG_GREP_LINE_TAG) && ('[' == p[0]) && (']' == p[SLOG_GREP_TIME_LEN + 1]) &&
+           ('|' == p[SLOG_GREP_LINE_LEVEL + 7]) && (-1 != column_level(p[SLOG_GREP_LINE_LEVEL]));
+}
+
+/*
+ * parse tag, file and line of a head line, without regex
+ *
+ * @return -1 the line does not have them all
+ */
+static int parse_head(const char *p, const char *end, slog_grep_head_t *head)
+{
+    const char *q = p + SLOG_GREP_LINE_TAG, *eol = memchr(q, '\n', end - q);
+    const char *paren = NULL, *space = NULL, *colon = NULL;
+
+    eol = (NULL == eol) ? end : eol;
+    paren = memchr(q, '(', eol - q);
+    if ((NULL == paren) || (paren == q)) {
+        return -1;
+    }
+    head->tag = q;
+    head->tag_len = paren - 1 - q;
+
+    space = memchr(paren, ' ', eol - paren);
+    if (NULL == space) {
+        return -1;
+    }
+    head->file = paren + 1;
+    head->file_len = space - head->file;
+
+    colon = memchr(space, ':', eol - space);
+    if (NULL == colon) {
+        return -1;
+    }
+    head->line = (uint32_t)strtoul(colon + 1, NULL, 10);
+
+    paren = memchr(colon, ')', eol - colon);
+    if ((NULL == paren) || (eol - paren < 2)) {
+        return -1;
+    }
+    head->msg = paren + 2;
+
+    return 0;
+}
+
+/*
+ * check the structured predicates on a log's head line
+ */
+static int log_wanted(const char *p, const char *end)
+{
+    slog_grep_head_t head;
+
+    if (column_level(p[SLOG_GREP_LINE_LEVEL]) > opt.level) {
+        return 0;
+    }
+
+    /* the fixed width time compares as text */
+    if (('\0' != opt.start[0]) && (memcmp(p + SLOG_GREP_LINE_TIME, opt.start, SLOG_GREP_TIME_LEN) < 0)) {
+        return 0;
+    }
+    if (('\0' != opt.end[0]) && (memcmp(p + SLOG_GREP_LINE_TIME, opt.end, SLOG_GREP_TIME_LEN) > 0)) {
+        return 0;
+    }
+
+    if ((NULL == opt.tag) && (NULL == opt.file)) {
+        return 1;
+    }
+
+    if (0 != parse_head(p, end, &head)) {
+        return 0;
+    }
+    if ((NULL != opt.tag) && ((head.tag_len != opt.tag_len) || (0 != memcmp(head.tag, opt.tag, opt.tag_len)))) {
+        return 0;
+    }
+    if ((NULL != opt.file) &&
+        ((head.file_len != opt.file_len) || (0 != memcmp(head.file, opt.file, opt.file_len)) ||
+         ((0 != opt.line) && (head.line != opt.line)))) {
+        return 0;
+    }
+
+    return 1;
+}
+
+/*
+ * @return 1 the pattern hit at pos is a whole word of the log's message
+ */
+static int word_hit(const char *log, const char *pos, const char *end)
+{
+    slog_grep_head_t head;
+    const char *after = pos + opt.pattern_len;
+
+    if (slog_bloom_token_char(pos[-1]) || ((after < end) && slog_bloom_token_char(*after))) {
+        return 0;
+    }
+
+    return (0 == parse_head(log, end, &head)) && (pos >= head.msg);
+}
+
+/*
+ * @return head line of the log pos is in, NULL it started before from
+ */
+static const char *log_start(const char *from, const char *pos, const char *end)
+{
+    const char *line = pos;
+
+    while (1) {
+        while ((line > from) && ('\n' != line[-1])) {
+            line--;
+        }
+        if (is_head(line, end)) {
+            return line;
+        }
+        if (line == from) {
+            return NULL;
+        }
+        /* the line before, from its newline */
+        line--;
+    }
+}
+
+/*
+ * @return end of the log starting at p, its continuation lines included
+ */
+static const char *log_end(const char *p, const char *end)
+{
+    const char *eol = NULL;
+
+    do {
+        eol = memchr(p, '\n', end - p);
+        p = (NULL == eol) ? end : eol + 1;
+    } while ((p < end) && !is_head(p, end));
+
+    return p;
+}
+
+static void chunk_add_match(slog_grep_chunk_t *chunk, const char *log, const char *end)
+{
+    slog_grep_match_t *matches = NULL;
+
+    if (chunk->count == chunk->cap) {
+        chunk->cap = chunk->cap ? chunk->cap * 2 : 256;
+        matches = (slog_grep_match_t *)realloc(chunk->matches, chunk->cap * sizeof(slog_grep_match_t));
+        if (NULL == matches) {
+            fprintf(stderr, "out of memory\n");
+            exit(2);
+        }
+        chunk->matches = matches;
+    }
+
+    chunk->matches[chunk->count].log = log;
+    chunk->matches[chunk->count].len = (uint32_t)(end - log);
+    chunk->matches[chunk->count].seq = (uint32_t)chunk->count;
+    chunk->count++;
+}
+
+static int match_cmp(const void *a, const void *b)
+{
+    const slog_grep_match_t *x = (const slog_grep_match_t *)a, *y = (const slog_grep_match_t *)b;
+    int ret = memcmp(x->log + SLOG_GREP_LINE_TIME, y->log + SLOG_GREP_LINE_TIME, SLOG_GREP_TIME_LEN);
+
+    if (0 != ret) {
+        return ret;
+    }
+
+    return (x->seq < y->seq) ? -1 : (x->seq > y->seq);
+}
+
+/*
+ * collect the matching logs of a chunk. With a pattern only the logs around
+ * its hits are parsed, otherwise every head line.
+ */
+static void chunk_search(slog_grep_chunk_t *chunk)
+{
+    const char *p = chunk->start, *end = chunk->end, *hit = NULL, *log = NULL, *next = NULL;
+    const char *from = p;
+
+    while (p < end) {
+        if (NULL != opt.pattern) {
+            hit = find_literal(from, end - from, opt.pattern, opt.pattern_len);
+            if (NULL == hit) {
+                break;
+            }
+
+            log = log_start(p, hit, end);
+            if (NULL == log) {
+                p = from = log_end(hit, end);
+                continue;
+            }
+            if (opt.word && !word_hit(log, hit, end)) {
+                /* a later hit may be in the same log */
+                from = hit + 1;
+                continue;
+            }
+        } else {
+            log = p;
+        }
+
+        next = log_end(log, end);
+        if (is_head(log, end) && log_wanted(log, end)) {
+            chunk_add_match(chunk, log, next);
+        }
+        p = from = next;
+    }
+
+    /* a chunk is nearly in time order already */
+    if (chunk->count > 1) {
+        qsort(chunk->matches, chunk->count, sizeof(slog_grep_match_t), match_cmp);
+    }
+}
+
+static void *search_thread(void *arg)
+{
+    size_t i;
+
+    while ((i = __atomic_fetch_add(&chunk_next, 1, __ATOMIC_RELAXED)) < chunk_count) {
+        chunk_search(&chunks[i]);
+    }
+
+    return NULL;
+}
+
+static void chunk_add(const char *name, const char *start, const char *end)
+{
+    slog_grep_chunk_t *grown = NULL;
+
+    if (chunk_count == chunk_cap) {
+        chunk_cap = chunk_cap ? chunk_cap * 2 : 64;
+        grown = (slog_grep_chunk_t *)realloc(chunks, chunk_cap * sizeof(slog_grep_chunk_t));
+        if (NULL == grown) {
+            fprintf(stderr, "out of memory\n");
+            exit(2);
+        }
+        chunks = grown;
+    }
+
+    memset(&chunks[chunk_count], 0, sizeof(slog_grep_chunk_t));
+    chunks[chunk_count].name = name;
+    chunks[chunk_count].start = start;
+    chunks[chunk_count].end = end;
+    chunk_count++;
+}
+
+/* segment a range is split from */
+typedef struct slog_grep_file_s {
+    const char *name;
+    const char *data;
+} slog_grep_file_t;
+
+/*
+ * split a range of a segment into chunks that start at head lines
+ */
+static void split_range(uint64_t offset, uint64_t length, void *arg)
+{
+    const slog_grep_file_t *file = (const slog_grep_file_t *)arg;
+    const char *p = file->data + offset, *end = p + length, *cut = NULL;
+
+    while (p < end) {
+        cut = ((size_t)(end - p) > SLOG_GREP_CHUNK_SIZE) ? p + SLOG_GREP_CHUNK_SIZE : end;
+        while (cut < end) {
+            cut = memchr(cut, '\n', end - cut);
+            if (NULL == cut) {
+                cut = end;
+                break;
+            }
+            if (is_head(++cut, end)) {
+                break;
+            }
+        }
+
+        chunk_add(file->name, p, cut);
+        p = cut;
+    }
+}
+
+static void range_collect(uint64_t offset, uint64_t length, void *arg)
+{
+    slog_grep_ranges_t *ranges = (slog_grep_ranges_t *)arg;
+    uint64_t (*grown)[2] = NULL;
+
+    if (ranges->count == ranges->cap) {
+        ranges->cap = ranges->cap ? ranges->cap * 2 : 64;
+        grown = (uint64_t (*)[2])realloc(ranges->range, ranges->cap * sizeof(*grown));
+        if (NULL == grown) {
+            fprintf(stderr, "out of memory\n");
+            exit(2);
+        }
+        ranges->range = grown;
+    }
+
+    ranges->range[ranges->count][0] = offset;
+    ranges->range[ranges->count][1] = offset + length;
+    ranges->count++;
+}
+
+/*
+ * split the ranges both the index and the filters select
+ */
+static void split_ranges(const slog_grep_ranges_t *a, const slog_grep_ranges_t *b, slog_grep_file_t *file)
+{
+    size_t i = 0, j = 0;
+    uint64_t start, end;
+
+    while ((i < a->count) && (j < b->count)) {
+        start = (a->range[i][0] > b->range[j][0]) ? a->range[i][0] : b->range[j][0];
+        end = (a->range[i][1] < b->range[j][1]) ? a->range[i][1] : b->range[j][1];
+        if (start < end) {
+            split_range(start, end - start, file);
+        }
+
+        if (a->range[i][1] < b->range[j][1]) {
+            i++;
+        } else {
+            j++;
+        }
+    }
+}
+
+/*
+ * map a text segment and split it into chunks, through its index when
+ * the time or level narrows the search and through its filters when a
+ * word or tag does
+ *
+ * @return result
+ */
+static int map_file(const char *name)
+{
+    int fd;
+    size_t size, index_len = 0, bloom_len = 0;
+    struct stat statbuf;
+    char *index = NULL, *bloom = NULL;
+    slog_grep_file_t file = { .name = name };
+    slog_grep_ranges_t by_index = { 0 }, by_bloom = { 0 };
+    const char *term = opt.word ? opt.pattern : NULL;
+
+    fd = open(name, O_RDONLY);
+    if (-1 == fd || 0 != fstat(fd, &statbuf)) {
+        fprintf(stderr, "%s: %s\n", name, strerror(errno));
+        if (-1 != fd) {
+            close(fd);
+        }
+        return -1;
+    }
+
+    size = statbuf.st_size;
+    if (0 == size) {
+        close(fd);
+        return 0;
+    }
+
+    /* stays mapped until the logs are printed */
+    file.data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (MAP_FAILED == file.data) {
+        fprintf(stderr, "%s: mmap: %s\n", name, strerror(errno));
+        return -1;
+    }
+    madvise((void *)file.data, size, MADV_SEQUENTIAL);
+
+    if (slog_binlog_file_check(file.data, size) > 0) {
+        fprintf(stderr, "%s: binary slog file, read it with slog-decode\n", name);
+        munmap((void *)file.data, size);
+        return -1;
+    }
+
+    if (('\0' != opt.start[0]) || ('\0' != opt.end[0]) || (VERBOSE != opt.level)) {
+        index = slog_index_read(name, SLOG_INDEX_SUFFIX, &index_len);
+    }
+    if ((NULL != term) || (NULL != opt.tag)) {
+        bloom = slog_index_read(name, SLOG_BLOOM_SUFFIX, &bloom_len);
+    }
+
+    /* a missing or stale file selects the whole segment */
+    if ((NULL == index) || (slog_index_select(index, index_len, size, 0, &opt.query, range_collect, &by_index) < 0)) {
+        by_index.count = 0;
+        range_collect(0, size, &by_index);
+    }
+    if ((NULL == bloom) || (slog_bloom_select(bloom, bloom_len, size, 0, opt.tag, opt.tag_len,
+                                              term, opt.pattern_len, range_collect, &by_bloom) < 0)) {
+        by_bloom.count = 0;
+        range_collect(0, size, &by_bloom);
+    }
+    split_ranges(&by_index, &by_bloom, &file);
+
+    free(by_index.range);
+    free(by_bloom.range);
+    free(index);
+    free(bloom);
+
+    return 0;
+}
+
+/*
+ * @return chunk a holds the earlier log at its cursor
+ */
+static int chunk_before(const slog_grep_chunk_t *a, const slog_grep_chunk_t *b)
+{
+    int ret = memcmp(a->matches[a->pos].log + SLOG_GREP_LINE_TIME, b->matches[b->pos].log + SLOG_GREP_LINE_TIME,
+                     SLOG_GREP_TIME_LEN);
+
+    /* chunks are in file order */
+    return (ret < 0) || ((0 == ret) && (a < b));
+}
+
+static void heap_down(slog_grep_chunk_t **heap, size_t n, size_t i)
+{
+    size_t child;
+    slog_grep_chunk_t *tmp = NULL;
+
+    while ((child = 2 * i + 1) < n) {
+        if ((child + 1 < n) && chunk_before(heap[child + 1], heap[child])) {
+            child++;
+        }
+        if (!chunk_before(heap[child], heap[i])) {
+            break;
+        }
+        tmp = heap[i];
+        heap[i] = heap[child];
+        heap[child] = tmp;
+        i = child;
+    }
+}
+
+/*
+ * merge the sorted chunks, print the logs in time order
+ */
+static void print_merged(void)
+{
+    size_t i, n = 0;
+    slog_grep_chunk_t **heap = (slog_grep_chunk_t **)malloc((chunk_count + 1) * sizeof(slog_grep_chunk_t *));
+    slog_grep_chunk_t *top = NULL;
+    const slog_grep_match_t *match = NULL;
+
+    if (NULL == heap) {
+        fprintf(stderr, "out of memory\n");
+        exit(2);
+    }
+
+    for (i = 0; i < chunk_count; ++i) {
+        if (chunks[i].count > 0) {
+            heap[n++] = &chunks[i];
+        }
+    }
+    for (i = n / 2; i-- > 0;) {
+        heap_down(heap, n, i);
+    }
+
+    while (n > 0) {
+        top = heap[0];
+        match = &top->matches[top->pos++];
+        if (opt.with_name) {
+            fputs(top->name, stdout);
+            putchar(':');
+        }
+        fwrite(match->log, 1, match->len, stdout);
+
+        if (top->pos == top->count) {
+            heap[0] = heap[--n];
+        }
+        heap_down(heap, n, 0);
+    }
+
+    free(heap);
+}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC FUNCTIONS DEFINITION ------------------------------- */
+
+int main(int argc, char **argv)
+{
+    int c, level, i, result = 0;
+    size_t len, total = 0;
+    char *colon = NULL;
+    pthread_t tid[SLOG_GREP_THREAD_MAX];
+
+    opt.threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+
+    while (-1 != (c = getopt(argc, argv, "cHwj:s:e:l:t:f:h"))) {
+        switch (c) {
+        case 'c':
+            opt.count = 1;
+            break;
+        case 'H':
+            opt.with_name = 1;
+            break;
+        case 'w':
+            opt.word = 1;
+            break;
+        case 'j':
+            opt.threads = atoi(optarg);
+            break;
+        case 's':
+            if (-1 == (opt.query.start = parse_time(optarg))) {
+                fprintf(stderr, "invalid time: %s\n", optarg);
+                return 2;
+            }
+            format_time(opt.start, opt.query.start);
+            break;
+        case 'e':
+            if (-1 == (opt.query.end = parse_time(optarg))) {
+                fprintf(stderr, "invalid time: %s\n", optarg);
+                return 2;
+            }
+            format_time(opt.end, opt.query.end);
+            break;
+        case 'l':
+            if (-1 == (level = parse_level(optarg))) {
+                fprintf(stderr, "invalid level: %s\n", optarg);
+                return 2;
+            }
+            opt.level = (uint8_t)level;
+            opt.query.level_mask = (uint8_t)((2 << level) - 1);
+            break;
+        case 't':
+            opt.tag = optarg;
+            opt.tag_len = strlen(optarg);
+            break;
+        case 'f':
+            colon = strrchr(optarg, ':');
+            if (NULL != colon) {
+                *colon = '\0';
+                opt.line = (uint32_t)strtoul(colon + 1, NULL, 10);
+            }
+            opt.file = optarg;
+            opt.file_len = strlen(optarg);
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (argc - optind < 2) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    opt.pattern = argv[optind++];
+    opt.pattern_len = strlen(opt.pattern);
+    if (0 == opt.pattern_len) {
+        opt.pattern = NULL;
+    }
+
+    if (optind >= argc) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    if (opt.threads < 1) {
+        opt.threads = 1;
+    } else if (opt.threads > SLOG_GREP_THREAD_MAX) {
+        opt.threads = SLOG_GREP_THREAD_MAX;
+    }
+
+    for (i = optind; i < argc; ++i) {
+        /* slog.log* names the indexes and filters too */
+        len = strlen(argv[i]);
+        if (((len > strlen(SLOG_INDEX_SUFFIX)) &&
+             (0 == strcmp(argv[i] + len - strlen(SLOG_INDEX_SUFFIX), SLOG_INDEX_SUFFIX))) ||
+            ((len > strlen(SLOG_BLOOM_SUFFIX)) &&
+             (0 == strcmp(argv[i] + len - strlen(SLOG_BLOOM_SUFFIX), SLOG_BLOOM_SUFFIX)))) {
+            continue;
+        }
+        if (0 != map_file(argv[i])) {
+            result = 1;
+        }
+    }
+
+    for (i = 0; i < opt.threads; ++i) {
+        if (0 != pthread_create(&tid[i], NULL, search_thread, NULL)) {
+            break;
+        }
+    }
+    if (0 == i) {
+        search_thread(NULL);
+    }
+    while (i-- > 0) {
+        pthread_join(tid[i], NULL);
+    }
+
+    for (i = 0; i < (int)chunk_count; ++i) {
+        total += chunks[i].count;
+    }
+
+    if (opt.count) {
+        printf("%zu\n", total);
+    } else {
+        print_merged();
+    }
+
+    if (0 == total) {
+        result = result ? result : 1;
+    }
+
+    return result;
+}
+
+
+/* ============== EOF ======================================================= */
\ No newline at end of file
@@ -0,0 +1,364 @@
+
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "logger.h"
+#include "slog_spec.h"
+#include "slog_index.h"
+#include "slog_binlog.h"
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE MACROS -------------------------------------------- */
+
+/* "YYYY-MM-DD HH:MM:SS.uuuuuu" as the text file sink writes it */
+#define SLOG_INDEX_TIME_LEN                  26
+
+/* text line: '[' time "] " level */
+#define SLOG_INDEX_LINE_TIME                 1
+#define SLOG_INDEX_LINE_LEVEL                (SLOG_INDEX_TIME_LEN + 3)
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE TYPES --------------------------------------------- */
+
+/* lookup options */
+typedef struct slog_index_opt_s {
+    int ranges;                              /* print byte ranges instead of logs */
+    int dump;                                /* print the index entries */
+    slog_index_query_t query;
+    uint8_t level;                           /* levels above it are skipped */
+    char start[SLOG_TIME_FORMAT_LEN];        /* text time bounds, "" none */
+    char end[SLOG_TIME_FORMAT_LEN];
+} slog_index_opt_t;
+
+/* segment being read */
+typedef struct slog_index_file_s {
+    const char *data;
+    int binary;
+} slog_index_file_t;
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE VARIABLES ----------------------------------------- */
+
+static const char *level_name[] = {
+        [ASSERT]  = "ASSERT",
+        [ERROR]   = "ERROR",
+        [WARN]    = "WARN",
+        [INFO]    = "INFO",
+        [DEBUG]   = "DEBUG",
+        [VERBOSE] = "VERBOSE",
+};
+
+static slog_index_opt_t opt = {
+        .query = { .start = INT64_MIN, .end = INT64_MAX, .level_mask = 0xff },
+        .level = VERBOSE,
+};
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE FUNCTIONS DEFINITION ------------------------------ */
+
+static void usage(const char *name)
+{
+    fprintf(stderr,
+            "usage: %s [-p] [-d] [-s start] [-e end] [-l level] file...\n"
+            "  print the logs of text slog files in a time range or up to a level,\n"
+            "  reading only the parts the file's .idx index selects\n"
+            "  -p        print the byte ranges to read, \"offset length\", text or binary files\n"
+            "  -d        print the index entries\n"
+            "  -s start  skip logs before start\n"
+            "  -e end    skip logs after end\n"
+            "            times are \"YYYY-MM-DD HH:MM:SS\" in local time or @epoch seconds\n"
+            "  -l level  skip levels above it: ASSERT ERROR WARN INFO DEBUG VERBOSE\n", name);
+}
+
+/*
+ * @return us since the epoch, -1 invalid
+ */
+static int64_t parse_time(const char *value)
+{
+    struct tm tm;
+    char *end = NULL;
+    double sec;
+
+    if ('@' == value[0]) {
+        sec = strtod(value + 1, &end);
+        if (end == value + 1 || '\0' != *end) {
+            return -1;
+        }
+        return (int64_t)(sec * 1000000);
+    }
+
+    memset(&tm, 0, sizeof(tm));
+    end = strptime(value, "%Y-%m-%d %H:%M:%S", &tm);
+    if (NULL == end || '\0' != *end) {
+        return -1;
+    }
+    tm.tm_isdst = -1;
+
+    return (int64_t)mktime(&tm) * 1000000;
+}
+
+static int parse_level(const char *value)
+{
+    int i;
+
+    for (i = ASSERT; i <= VERBOSE; ++i) {
+        if (0 == strcasecmp(value, level_name[i])) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/*
+ * the time of a text line as the file sink renders it, in local time
+ */
+static void format_time(char *buf, int64_t time)
+{
+    struct tm tm;
+    time_t sec = (time_t)(time / 1000000);
+
+    localtime_r(&sec, &tm);
+    snprintf(buf, SLOG_TIME_FORMAT_LEN, "%04d-%02d-%02d %02d:%02d:%02d.%06ld",
+             tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec,
+             (long)(time % 1000000));
+}
+
+/*
+ * @return level of a level column's first letter, -1 none
+ */
+static int line_level(char c)
+{
+    int i;
+
+    for (i = ASSERT; i <= VERBOSE; ++i) {
+        if (c == level_name[i][0]) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/*
+ * a line with no time of its own continues the message of the line before
+ */
+static int line_wanted(const char *line, size_t len, int prev)
+{
+    int level;
+
+    if ((len <= SLOG_INDEX_LINE_LEVEL) || ('[' != line[0]) || (']' != line[SLOG_INDEX_TIME_LEN + 1]) ||
+        (-1 == (level = line_level(line[SLOG_INDEX_LINE_LEVEL])))) {
+        return prev;
+    }
+
+    /* the fixed width time compares as text */
+    if (('\0' != opt.start[0]) && (memcmp(line + SLOG_INDEX_LINE_TIME, opt.start, SLOG_INDEX_TIME_LEN) < 0)) {
+        return 0;
+    }
+    if (('\0' != opt.end[0]) && (memcmp(line + SLOG_INDEX_LINE_TIME, opt.end, SLOG_INDEX_TIME_LEN) > 0)) {
+        return 0;
+    }
+
+    return level <= opt.level;
+}
+
+/*
+ * print the wanted lines of one range of a text file
+ */
+static void read_range(uint64_t offset, uint64_t length, void *arg)
+{
+    const slog_index_file_t *file = (const slog_index_file_t *)arg;
+    const char *p = file->data + offset, *end = p + length, *eol = NULL;
+    int wanted = 0;
+
+    if (opt.ranges) {
+        printf("%llu %llu\n", (unsigned long long)offset, (unsigned long long)length);
+        return;
+    }
+
+    while (p < end) {
+        eol = memchr(p, '\n', end - p);
+        eol = (NULL == eol) ? end : eol + 1;
+
+        wanted = line_wanted(p, eol - p, wanted);
+        if (wanted) {
+            fwrite(p, 1, eol - p, stdout);
+        }
+        p = eol;
+    }
+}
+
+static void dump_index(const char *index, size_t len)
+{
+    int head, final;
+    size_t i, count;
+    int level;
+    slog_index_entry_t entry;
+    char min[SLOG_TIME_FORMAT_LEN], max[SLOG_TIME_FORMAT_LEN];
+
+    head = slog_index_check(index, len, &count, &final);
+    if (head < 0) {
+        return;
+    }
+
+    printf("# %zu entries, %s\n", count, final ? "finalized" : "live");
+    for (i = 0; i < count; ++i) {
+        slog_index_entry_decode(index + head + i * SLOG_INDEX_ENTRY_SIZE, &entry);
+        format_time(min, entry.min_time);
+        format_time(max, entry.max_time);
+        printf("%llu %u %u [%s, %s]", (unsigned long long)entry.offset, entry.length, entry.count, min, max);
+        for (level = ASSERT; level <= VERBOSE; ++level) {
+            if (entry.level_mask & (1 << level)) {
+                printf(" %s", level_name[level]);
+            }
+        }
+        putchar('\n');
+    }
+}
+
+/*
+ * read one segment through its index, all of it when the index is missing
+ * or does not match the segment
+ *
+ * @return result
+ */
+static int index_file(const char *name)
+{
+    int fd, head = 0, result = 0;
+    size_t size, index_len = 0;
+    struct stat statbuf;
+    char *index = NULL;
+    slog_index_file_t file = { .data = NULL };
+
+    fd = open(name, O_RDONLY);
+    if (-1 == fd || 0 != fstat(fd, &statbuf)) {
+        fprintf(stderr, "%s: %s\n", name, strerror(errno));
+        if (-1 != fd) {
+            close(fd);
+        }
+        return -1;
+    }
+
+    size = statbuf.st_size;
+    if (0 == size) {
+        close(fd);
+        return 0;
+    }
+
+    file.data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (MAP_FAILED == file.data) {
+        fprintf(stderr, "%s: mmap: %s\n", name, strerror(errno));
+        return -1;
+    }
+
+    head = slog_binlog_file_check(file.data, size);
+    file.binary = (head > 0);
+    if (file.binary && !opt.ranges && !opt.dump) {
+        fprintf(stderr, "%s: binary slog file, read it with slog-decode or -p\n", name);
+        munmap((void *)file.data, size);
+        return -1;
+    }
+    head = file.binary ? head : 0;
+
+    index = slog_index_read(name, SLOG_INDEX_SUFFIX, &index_len);
+    if (opt.dump) {
+        if (NULL != index) {
+            dump_index(index, index_len);
+        }
+    } else if ((NULL == index) ||
+               (slog_index_select(index, index_len, size, head, &opt.query, read_range, &file) < 0)) {
+        fprintf(stderr, "%s: no usable index, scanning it all\n", name);
+        read_range(head, size - head, &file);
+    }
+
+    if (opt.dump && (NULL == index)) {
+        fprintf(stderr, "%s: no index\n", name);
+        result = -1;
+    }
+
+    free(index);
+    munmap((void *)file.data, size);
+
+    return result;
+}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC FUNCTIONS DEFINITION ------------------------------- */
+
+int main(int argc, char **argv)
+{
+    int c, level, i, result = 0;
+
+    while (-1 != (c = getopt(argc, argv, "pds:e:l:h"))) {
+        switch (c) {
+        case 'p':
+            opt.ranges = 1;
+            break;
+        case 'd':
+            opt.dump = 1;
+            break;
+        case 's':
+            if (-1 == (opt.query.start = parse_time(optarg))) {
+                fprintf(stderr, "invalid time: %s\n", optarg);
+                return 2;
+            }
+            format_time(opt.start, opt.query.start);
+            break;
+        case 'e':
+            if (-1 == (opt.query.end = parse_time(optarg))) {
+                fprintf(stderr, "invalid time: %s\n", optarg);
+                return 2;
+            }
+            format_time(opt.end, opt.query.end);
+            break;
+        case 'l':
+            if (-1 == (level = parse_level(optarg))) {
+                fprintf(stderr, "invalid level: %s\n", optarg);
+                return 2;
+            }
+            opt.level = (uint8_t)level;
+            opt.query.level_mask = (uint8_t)((2 << level) - 1);
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (optind >= argc) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    for (i = optind; i < argc; ++i) {
+        if (0 != index_file(argv[i])) {
+            result = 1;
+        }
+    }
+
+    return result;
+}
+
+
+/* ============== EOF ======================================================= */
\ No newline at end of file
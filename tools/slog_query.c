@@ -0,0 +1,716 @@
+
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "logger.h"
+#include "slog_spec.h"
+#include "slog_async.h"
+#include "slog_event.h"
+#include "slog_binlog.h"
+#include "slog_column.h"
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE MACROS -------------------------------------------- */
+
+#define SLOG_QUERY_TZ_LEN                    32
+
+/* group by keys */
+#define SLOG_QUERY_KEY_TIME                  0
+#define SLOG_QUERY_KEY_LEVEL                 1
+#define SLOG_QUERY_KEY_TAG                   2
+#define SLOG_QUERY_KEY_SITE                  3
+#define SLOG_QUERY_KEY_COUNT                 4
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE TYPES --------------------------------------------- */
+
+/* query options */
+typedef struct slog_query_opt_s {
+    int print;                               /* print the logs instead of counting */
+    int64_t start;                           /* us, rows before it are skipped */
+    int64_t end;                             /* us, rows after it are skipped */
+    uint8_t level;                           /* levels above it are skipped */
+    const char *tag;                         /* only this tag, NULL all */
+    size_t tag_len;
+    int keys[SLOG_QUERY_KEY_COUNT];          /* SLOG_QUERY_KEY_xxx in output order */
+    int key_count;
+    int64_t bucket;                          /* us per time key */
+} slog_query_opt_t;
+
+/* interned tag or site, ids are the same across groups and files */
+typedef struct slog_query_string_s {
+    char *str;
+    size_t len;
+} slog_query_string_t;
+
+/* one output row */
+typedef struct slog_query_agg_s {
+    int64_t time;                            /* bucket start */
+    uint32_t level;
+    uint32_t tag;                            /* string id */
+    uint32_t site;
+    uint64_t count;                          /* 0 empty slot */
+} slog_query_agg_t;
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE VARIABLES ----------------------------------------- */
+
+static const char *level_name[] = {
+        [ASSERT]  = "ASSERT",
+        [ERROR]   = "ERROR",
+        [WARN]    = "WARN",
+        [INFO]    = "INFO",
+        [DEBUG]   = "DEBUG",
+        [VERBOSE] = "VERBOSE",
+};
+
+static const char *key_name[] = {
+        [SLOG_QUERY_KEY_TIME]  = "time",
+        [SLOG_QUERY_KEY_LEVEL] = "level",
+        [SLOG_QUERY_KEY_TAG]   = "tag",
+        [SLOG_QUERY_KEY_SITE]  = "site",
+};
+
+static slog_query_opt_t opt = {
+        .start = INT64_MIN, .end = INT64_MAX, .level = VERBOSE,
+        .bucket = 60 * 1000000LL,
+};
+
+/* interned strings, and their hash slots: id + 1, 0 empty */
+static slog_query_string_t *strings = NULL;
+static size_t string_count = 0;
+static uint32_t *string_slot = NULL;
+static size_t string_slots = 0;
+
+/* output rows, an open addressing table */
+static slog_query_agg_t *aggs = NULL;
+static size_t agg_count = 0;
+static size_t agg_slots = 0;
+
+/* decoder stream, shared by all columns */
+static slog_lz_t lz;
+
+/* zone the text formatter renders in, the writer's one */
+static int32_t current_gmtoff = INT32_MIN;
+
+static char event_buf[SLOG_EVENT_BUF_MAXLEN];
+static char format_buf[SLOG_FORMAT_BUF_SIZE];
+static char strings_buf[SLOG_EVENT_BUF_MAXLEN];
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE FUNCTIONS DEFINITION ------------------------------ */
+
+static void usage(const char *name)
+{
+    fprintf(stderr,
+            "usage: %s [-p] [-g keys] [-b seconds] [-s start] [-e end] [-l level] [-t tag] file.col...\n"
+            "  count the logs of columnar archives written by slog-archive, reading only\n"
+            "  the columns the query needs\n"
+            "  -g keys     count per comma separated keys: time level tag site, tag,level by default\n"
+            "  -b seconds  time key bucket, 60 by default\n"
+            "  -p          print the logs as text instead of counting\n"
+            "  -s start    skip logs before start\n"
+            "  -e end      skip logs after end\n"
+            "              times are \"YYYY-MM-DD HH:MM:SS\" in local time or @epoch seconds\n"
+            "  -l level    skip levels above it: ASSERT ERROR WARN INFO DEBUG VERBOSE\n"
+            "  -t tag      only logs of this tag\n", name);
+}
+
+/*
+ * @return us since the epoch, -1 invalid
+ */
+static int64_t parse_time(const char *value)
+{
+    struct tm tm;
+    char *end = NULL;
+    double sec;
+
+    if ('@' == value[0]) {
+        sec = strtod(value + 1, &end);
+        if (end == value + 1 || '\0' != *end) {
+            return -1;
+        }
+        return (int64_t)(sec * 1000000);
+    }
+
+    memset(&tm, 0, sizeof(tm));
+    end = strptime(value, "%Y-%m-%d %H:%M:%S", &tm);
+    if (NULL == end || '\0' != *end) {
+        return -1;
+    }
+    tm.tm_isdst = -1;
+
+    return (int64_t)mktime(&tm) * 1000000;
+}
+
+static int parse_level(const char *value)
+{
+    int i;
+
+    for (i = ASSERT; i <= VERBOSE; ++i) {
+        if (0 == strcasecmp(value, level_name[i])) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/*
+ * @return result
+ */
+static int parse_keys(char *value)
+{
+    int i;
+    char *key = NULL, *save = NULL;
+
+    opt.key_count = 0;
+    for (key = strtok_r(value, ",", &save); NULL != key; key = strtok_r(NULL, ",", &save)) {
+        for (i = 0; i < SLOG_QUERY_KEY_COUNT; ++i) {
+            if (0 == strcasecmp(key, key_name[i])) {
+                break;
+            }
+        }
+        if ((SLOG_QUERY_KEY_COUNT == i) || (SLOG_QUERY_KEY_COUNT == opt.key_count)) {
+            return -1;
+        }
+        opt.keys[opt.key_count++] = i;
+    }
+
+    return (opt.key_count > 0) ? 0 : -1;
+}
+
+static int has_key(int key)
+{
+    int i;
+
+    for (i = 0; i < opt.key_count; ++i) {
+        if (key == opt.keys[i]) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * render the text in the zone the log was written in
+ */
+static void set_zone(int32_t gmtoff)
+{
+    char tz[SLOG_QUERY_TZ_LEN];
+    int32_t off = (gmtoff < 0) ? -gmtoff : gmtoff;
+
+    if (gmtoff == current_gmtoff) {
+        return;
+    }
+
+    /* POSIX TZ offsets count west of UTC */
+    snprintf(tz, sizeof(tz), "UTC%c%02d:%02d:%02d", (gmtoff < 0) ? '+' : '-',
+             off / 3600, off / 60 % 60, off % 60);
+    setenv("TZ", tz, 1);
+    tzset();
+    current_gmtoff = gmtoff;
+}
+
+static void *grow(void *ptr, size_t size)
+{
+    void *grown = realloc(ptr, size);
+
+    if (NULL == grown) {
+        fprintf(stderr, "out of memory\n");
+        exit(2);
+    }
+
+    return grown;
+}
+
+static uint64_t hash_bytes(const char *p, size_t len, uint64_t hash)
+{
+    while (len-- > 0) {
+        hash = (hash ^ (uint8_t)*p++) * 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+/*
+ * @return id of a tag or site, the same for equal strings
+ */
+static uint32_t intern(const char *str, size_t len)
+{
+    size_t i, slot;
+    uint32_t id;
+    uint32_t *old = string_slot;
+    size_t old_slots = string_slots;
+
+    if (2 * (string_count + 1) > string_slots) {
+        string_slots = string_slots ? string_slots * 2 : 1024;
+        string_slot = (uint32_t *)calloc(string_slots, sizeof(uint32_t));
+        if (NULL == string_slot) {
+            fprintf(stderr, "out of memory\n");
+            exit(2);
+        }
+        for (i = 0; i < old_slots; ++i) {
+            if (0 != old[i]) {
+                id = old[i] - 1;
+                slot = hash_bytes(strings[id].str, strings[id].len, 14695981039346656037ULL) % string_slots;
+                while (0 != string_slot[slot]) {
+                    slot = (slot + 1) % string_slots;
+                }
+                string_slot[slot] = id + 1;
+            }
+        }
+        free(old);
+        strings = (slog_query_string_t *)grow(strings, string_slots / 2 * sizeof(slog_query_string_t));
+    }
+
+    slot = hash_bytes(str, len, 14695981039346656037ULL) % string_slots;
+    while (0 != string_slot[slot]) {
+        id = string_slot[slot] - 1;
+        if ((strings[id].len == len) && (0 == memcmp(strings[id].str, str, len))) {
+            return id;
+        }
+        slot = (slot + 1) % string_slots;
+    }
+
+    id = (uint32_t)string_count++;
+    strings[id].str = (char *)grow(NULL, len + 1);
+    memcpy(strings[id].str, str, len);
+    strings[id].str[len] = '\0';
+    strings[id].len = len;
+    string_slot[slot] = id + 1;
+
+    return id;
+}
+
+static size_t agg_hash(const slog_query_agg_t *agg)
+{
+    uint64_t hash = 14695981039346656037ULL;
+
+    hash = (hash ^ (uint64_t)agg->time) * 1099511628211ULL;
+    hash = (hash ^ agg->level) * 1099511628211ULL;
+    hash = (hash ^ agg->tag) * 1099511628211ULL;
+    hash = (hash ^ agg->site) * 1099511628211ULL;
+
+    return (size_t)(hash ^ (hash >> 29));
+}
+
+static slog_query_agg_t *agg_find(slog_query_agg_t *table, size_t slots, const slog_query_agg_t *key)
+{
+    size_t slot = agg_hash(key) % slots;
+
+    while ((0 != table[slot].count) &&
+           ((table[slot].time != key->time) || (table[slot].level != key->level) ||
+            (table[slot].tag != key->tag) || (table[slot].site != key->site))) {
+        slot = (slot + 1) % slots;
+    }
+
+    return &table[slot];
+}
+
+static void agg_add(const slog_query_agg_t *key)
+{
+    size_t i, old_slots = agg_slots;
+    slog_query_agg_t *old = aggs, *agg = NULL;
+
+    if (2 * (agg_count + 1) > agg_slots) {
+        agg_slots = agg_slots ? agg_slots * 2 : 4096;
+        aggs = (slog_query_agg_t *)calloc(agg_slots, sizeof(slog_query_agg_t));
+        if (NULL == aggs) {
+            fprintf(stderr, "out of memory\n");
+            exit(2);
+        }
+        for (i = 0; i < old_slots; ++i) {
+            if (0 != old[i].count) {
+                *agg_find(aggs, agg_slots, &old[i]) = old[i];
+            }
+        }
+        free(old);
+    }
+
+    agg = agg_find(aggs, agg_slots, key);
+    if (0 == agg->count) {
+        *agg = *key;
+        agg_count++;
+    }
+    agg->count++;
+}
+
+static int agg_cmp(const void *a, const void *b)
+{
+    int i, ret = 0;
+    const slog_query_agg_t *x = (const slog_query_agg_t *)a, *y = (const slog_query_agg_t *)b;
+
+    for (i = 0; (i < opt.key_count) && (0 == ret); ++i) {
+        switch (opt.keys[i]) {
+        case SLOG_QUERY_KEY_TIME:
+            ret = (x->time < y->time) ? -1 : (x->time > y->time);
+            break;
+        case SLOG_QUERY_KEY_LEVEL:
+            ret = (x->level < y->level) ? -1 : (x->level > y->level);
+            break;
+        case SLOG_QUERY_KEY_TAG:
+            ret = strcmp(strings[x->tag].str, strings[y->tag].str);
+            break;
+        default:
+            ret = strcmp(strings[x->site].str, strings[y->site].str);
+            break;
+        }
+    }
+
+    return ret;
+}
+
+static void print_aggs(void)
+{
+    int i;
+    size_t n = 0, j;
+    struct tm tm;
+    time_t sec;
+    slog_query_agg_t *rows = (slog_query_agg_t *)grow(NULL, (agg_count + 1) * sizeof(slog_query_agg_t));
+
+    for (j = 0; j < agg_slots; ++j) {
+        if (0 != aggs[j].count) {
+            rows[n++] = aggs[j];
+        }
+    }
+    if (n > 1) {
+        qsort(rows, n, sizeof(slog_query_agg_t), agg_cmp);
+    }
+
+    for (i = 0; i < opt.key_count; ++i) {
+        printf("%s\t", key_name[opt.keys[i]]);
+    }
+    printf("count\n");
+
+    for (j = 0; j < n; ++j) {
+        for (i = 0; i < opt.key_count; ++i) {
+            switch (opt.keys[i]) {
+            case SLOG_QUERY_KEY_TIME:
+                sec = (time_t)(rows[j].time / 1000000);
+                localtime_r(&sec, &tm);
+                printf("%04d-%02d-%02d %02d:%02d:%02d\t", tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
+                       tm.tm_hour, tm.tm_min, tm.tm_sec);
+                break;
+            case SLOG_QUERY_KEY_LEVEL:
+                printf("%s\t", level_name[rows[j].level]);
+                break;
+            case SLOG_QUERY_KEY_TAG:
+                printf("%s\t", strings[rows[j].tag].str);
+                break;
+            default:
+                printf("%s\t", strings[rows[j].site].str);
+                break;
+            }
+        }
+        printf("%llu\n", (unsigned long long)rows[j].count);
+    }
+
+    free(rows);
+}
+
+static void print_row(const slog_column_row_t *row, int32_t gmtoff)
+{
+    int len;
+    char *p = strings_buf;
+    slog_binlog_record_t record;
+
+    /* the event keeps tag, file, func and message back to back */
+    record.time = row->time;
+    record.level = row->level;
+    record.line = row->line;
+    record.tag_len = row->tag_len;
+    record.file_len = row->file_len;
+    record.func_len = row->func_len;
+    record.msg_len = row->msg_len;
+    if (record.msg_len > sizeof(strings_buf) - 3 * 255) {
+        record.msg_len = sizeof(strings_buf) - 3 * 255;
+    }
+
+    record.tag = memcpy(p, row->tag, row->tag_len);
+    p += row->tag_len;
+    record.file = memcpy(p, row->file, row->file_len);
+    p += row->file_len;
+    record.func = memcpy(p, row->func, row->func_len);
+    p += row->func_len;
+    record.msg = memcpy(p, row->msg, record.msg_len);
+
+    set_zone(gmtoff);
+    slog_binlog_record_event(&record, event_buf);
+
+    len = format_log(format_buf, event_buf);
+    if (len > 0) {
+        fwrite(format_buf, 1, len, stdout);
+    }
+}
+
+/*
+ * the group's own id of the tag asked for
+ *
+ * @return -1 the group has no logs of it
+ */
+static int64_t tag_id(const slog_column_cursor_t *cursor)
+{
+    uint32_t i;
+    const char *entry = NULL;
+
+    for (i = 0; i < cursor->tags.count; ++i) {
+        entry = cursor->raw[SLOG_COLUMN_TAG_DICT] + cursor->tags.offset[i];
+        if (((uint8_t)entry[0] == opt.tag_len) && (0 == memcmp(entry + 1, opt.tag, opt.tag_len))) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/*
+ * count or print the wanted rows of one group
+ *
+ * @return result
+ */
+static int query_group(const slog_column_group_t *group)
+{
+    int ret;
+    int64_t want_tag = -1;
+    unsigned int columns = 0;
+    uint32_t *tag_ids = NULL, *site_ids = NULL;
+    char site[2 * 256 + 16];
+    slog_column_cursor_t cursor;
+    slog_column_row_t row;
+    slog_query_agg_t key;
+
+    /* the group head rules out whole groups */
+    if ((group->max_time < opt.start) || (group->min_time > opt.end) ||
+        (0 == (group->level_mask & ((2 << opt.level) - 1)))) {
+        return 0;
+    }
+
+    if (opt.print) {
+        columns = SLOG_COLUMN_READ_ALL;
+    } else {
+        if ((INT64_MIN != opt.start) || (INT64_MAX != opt.end) || has_key(SLOG_QUERY_KEY_TIME)) {
+            columns |= SLOG_COLUMN_READ_TIME;
+        }
+        if ((VERBOSE != opt.level) || has_key(SLOG_QUERY_KEY_LEVEL)) {
+            columns |= SLOG_COLUMN_READ_LEVEL;
+        }
+        if ((NULL != opt.tag) || has_key(SLOG_QUERY_KEY_TAG)) {
+            columns |= SLOG_COLUMN_READ_TAG;
+        }
+        if (has_key(SLOG_QUERY_KEY_SITE)) {
+            columns |= SLOG_COLUMN_READ_SITE;
+        }
+    }
+
+    if (0 != slog_column_cursor_open(&cursor, group, columns, &lz)) {
+        return -1;
+    }
+
+    if ((NULL != opt.tag) && (-1 == (want_tag = tag_id(&cursor)))) {
+        slog_column_cursor_close(&cursor);
+        return 0;
+    }
+
+    /* group ids to interned ids, looked up once per group */
+    tag_ids = (uint32_t *)grow(NULL, (cursor.tags.count + 1) * sizeof(uint32_t));
+    site_ids = (uint32_t *)grow(NULL, (cursor.sites.count + 1) * sizeof(uint32_t));
+    memset(tag_ids, 0xff, (cursor.tags.count + 1) * sizeof(uint32_t));
+    memset(site_ids, 0xff, (cursor.sites.count + 1) * sizeof(uint32_t));
+
+    memset(&key, 0, sizeof(key));
+    while (1 == (ret = slog_column_row_next(&cursor, &row))) {
+        if ((row.time < opt.start) || (row.time > opt.end) || (row.level > opt.level) ||
+            ((-1 != want_tag) && (row.tag_id != want_tag))) {
+            continue;
+        }
+
+        if (opt.print) {
+            print_row(&row, group->gmtoff);
+            continue;
+        }
+
+        if (has_key(SLOG_QUERY_KEY_TIME)) {
+            key.time = row.time - ((row.time % opt.bucket) + opt.bucket) % opt.bucket;
+        }
+        if (has_key(SLOG_QUERY_KEY_LEVEL)) {
+            key.level = row.level;
+        }
+        if (has_key(SLOG_QUERY_KEY_TAG)) {
+            if (UINT32_MAX == tag_ids[row.tag_id]) {
+                tag_ids[row.tag_id] = intern(row.tag, row.tag_len);
+            }
+            key.tag = tag_ids[row.tag_id];
+        }
+        if (has_key(SLOG_QUERY_KEY_SITE)) {
+            if (UINT32_MAX == site_ids[row.site_id]) {
+                ret = snprintf(site, sizeof(site), "%.*s %.*s:%u", row.file_len, row.file, row.func_len, row.func,
+                               row.line);
+                site_ids[row.site_id] = intern(site, ret);
+            }
+            key.site = site_ids[row.site_id];
+        }
+        agg_add(&key);
+    }
+
+    free(tag_ids);
+    free(site_ids);
+    slog_column_cursor_close(&cursor);
+
+    return ret;
+}
+
+/*
+ * query one archive, a corrupt group is reported and skipped
+ *
+ * @return result
+ */
+static int query_file(const char *name)
+{
+    int fd, ret, result = 0;
+    size_t size, pos;
+    struct stat statbuf;
+    const char *data = NULL, *next = NULL;
+    slog_column_group_t group;
+
+    fd = open(name, O_RDONLY);
+    if (-1 == fd || 0 != fstat(fd, &statbuf)) {
+        fprintf(stderr, "%s: %s\n", name, strerror(errno));
+        if (-1 != fd) {
+            close(fd);
+        }
+        return -1;
+    }
+
+    size = statbuf.st_size;
+    data = (size > 0) ? mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0) : NULL;
+    close(fd);
+    if (MAP_FAILED == data) {
+        fprintf(stderr, "%s: mmap: %s\n", name, strerror(errno));
+        return -1;
+    }
+
+    ret = slog_column_file_check(data, size);
+    if (ret < 0) {
+        fprintf(stderr, "%s: not a slog archive, convert it with slog-archive\n", name);
+        if (NULL != data) {
+            munmap((void *)data, size);
+        }
+        return -1;
+    }
+
+    for (pos = ret; pos < size; pos += ret) {
+        ret = slog_column_group_parse(data + pos, size - pos, &group);
+        if ((ret > 0) && (0 == query_group(&group))) {
+            continue;
+        }
+
+        fprintf(stderr, "%s: %s group at %zu, skipped\n", name, (0 == ret) ? "truncated" : "corrupt", pos);
+        result = -1;
+        if (0 == ret) {
+            break;
+        }
+        next = memmem(data + pos + 1, size - pos - 1, SLOG_COLUMN_GROUP_MAGIC, 4);
+        if (NULL == next) {
+            break;
+        }
+        ret = (int)(next - data - pos);
+    }
+
+    munmap((void *)data, size);
+
+    return result;
+}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC FUNCTIONS DEFINITION ------------------------------- */
+
+int main(int argc, char **argv)
+{
+    int c, level, i, result = 0;
+    char default_keys[] = "tag,level";
+
+    parse_keys(default_keys);
+
+    while (-1 != (c = getopt(argc, argv, "pg:b:s:e:l:t:h"))) {
+        switch (c) {
+        case 'p':
+            opt.print = 1;
+            break;
+        case 'g':
+            if (0 != parse_keys(optarg)) {
+                fprintf(stderr, "invalid keys: %s\n", optarg);
+                return 2;
+            }
+            break;
+        case 'b':
+            opt.bucket = (int64_t)(strtod(optarg, NULL) * 1000000);
+            if (opt.bucket <= 0) {
+                fprintf(stderr, "invalid bucket: %s\n", optarg);
+                return 2;
+            }
+            break;
+        case 's':
+        case 'e':
+            if (-1 == (c == 's' ? (opt.start = parse_time(optarg)) : (opt.end = parse_time(optarg)))) {
+                fprintf(stderr, "invalid time: %s\n", optarg);
+                return 2;
+            }
+            break;
+        case 'l':
+            if (-1 == (level = parse_level(optarg))) {
+                fprintf(stderr, "invalid level: %s\n", optarg);
+                return 2;
+            }
+            opt.level = (uint8_t)level;
+            break;
+        case 't':
+            opt.tag = optarg;
+            opt.tag_len = strlen(optarg);
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (optind >= argc) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    for (i = optind; i < argc; ++i) {
+        if (0 != query_file(argv[i])) {
+            result = 1;
+        }
+    }
+
+    if (!opt.print) {
+        print_aggs();
+    }
+
+    return result;
+}
+
+
+/* ============== EOF ======================================================= */
\ No newline at end of file
@@ -0,0 +1,185 @@
+
+/* -------------------------------------------------------------------------- */
+/* -------------- DEPENDANCIES ---------------------------------------------- */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "slog_spec.h"
+#include "slog_ring.h"
+#include "slog_async.h"
+#include "slog_event.h"
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE TYPES --------------------------------------------- */
+
+/* what one ring file gave */
+typedef struct slog_recover_count_s {
+    unsigned long unconsumed;                /* records */
+    unsigned long consumed;
+    unsigned long skipped;                   /* bytes of no valid record */
+} slog_recover_count_t;
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE VARIABLES ----------------------------------------- */
+
+/* consumed records still in the ring too */
+static int all;
+
+static char event_buf[SLOG_EVENT_BUF_MAXLEN];
+static char format_buf[SLOG_FORMAT_BUF_SIZE];
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PRIVATE FUNCTIONS DEFINITION ------------------------------ */
+
+static void usage(const char *name)
+{
+    fprintf(stderr,
+            "usage: %s [-a] ring...\n"
+            "  print the logs a process left in its BUFFER_FILE ring as text\n"
+            "  -a  the records it had handed to the sinks too, oldest first, they\n"
+            "      may not have reached a file when it died\n"
+            "  a ring in use is moved to ring" SLOG_RING_PREV_SUFFIX " as the next log_init() starts\n", name);
+}
+
+static void print_text(void)
+{
+    int len = format_log(format_buf, event_buf);
+
+    if (len > 0) {
+        fwrite(format_buf, 1, len, stdout);
+    }
+}
+
+/*
+ * walk the records from start up to the ring's in, a corrupt one is skipped
+ * byte by byte to the next valid record
+ */
+static void recover_ring(const slog_ring_t *ring, uint32_t start, slog_recover_count_t *count)
+{
+    int ret;
+    int synced = 1;
+    uint32_t pos = start;
+
+    while (pos != ring->in) {
+        ret = slog_ring_record_read(ring, pos, ring->in, event_buf);
+        if (ret > 0) {
+            if (pos - start >= ring->out - start) {
+                count->unconsumed++;
+            } else {
+                count->consumed++;
+            }
+            print_text();
+            pos += ret;
+            synced = 1;
+            continue;
+        }
+
+        /* an incomplete record only ends the ring once in step with it */
+        if ((0 == ret) && synced) {
+            count->skipped += ring->in - pos;
+            break;
+        }
+
+        synced = 0;
+        count->skipped++;
+        pos++;
+    }
+}
+
+/*
+ * @return result
+ */
+static int recover_file(const char *name)
+{
+    int fd;
+    size_t size;
+    struct stat statbuf;
+    const char *data = NULL;
+    slog_ring_t ring;
+    slog_recover_count_t count = { 0 };
+    uint32_t start;
+
+    fd = open(name, O_RDONLY);
+    if (-1 == fd || 0 != fstat(fd, &statbuf)) {
+        fprintf(stderr, "%s: %s\n", name, strerror(errno));
+        if (-1 != fd) {
+            close(fd);
+        }
+        return -1;
+    }
+
+    size = statbuf.st_size;
+    data = (0 == size) ? MAP_FAILED : mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if ((MAP_FAILED == data) || (0 != slog_ring_file_check(data, size, sizeof(slog_event_head_t), &ring))) {
+        fprintf(stderr, "%s: not a slog ring file\n", name);
+        if (MAP_FAILED != data) {
+            munmap((void *)data, size);
+        }
+        return -1;
+    }
+
+    /* the oldest byte the ring still holds, bytes never written are zero */
+    start = all ? ring.in - ring.size : ring.out;
+    recover_ring(&ring, start, &count);
+
+    fprintf(stderr, "%s: pid %u, %lu unconsumed logs", name, ring.pid, count.unconsumed);
+    if (all) {
+        fprintf(stderr, ", %lu handed to the sinks", count.consumed);
+    }
+    fprintf(stderr, ", %lu bytes skipped\n", count.skipped);
+
+    munmap((void *)data, size);
+
+    /* skipped bytes before out are overwritten records, not corruption */
+    return ((0 != count.skipped) && !all) ? -1 : 0;
+}
+
+
+/* -------------------------------------------------------------------------- */
+/* -------------- PUBLIC FUNCTIONS DEFINITION ------------------------------- */
+
+int main(int argc, char **argv)
+{
+    int c, i, result = 0;
+
+    while (-1 != (c = getopt(argc, argv, "ah"))) {
+        switch (c) {
+        case 'a':
+            all = 1;
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (optind >= argc) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    for (i = optind; i < argc; ++i) {
+        if (0 != recover_file(argv[i])) {
+            result = 1;
+        }
+    }
+
+    return result;
+}
+
+
+/* ============== EOF ======================================================= */
\ No newline at end of file